@@ -0,0 +1,849 @@
+/**
+* @brief ʂg킸ɌvZsob`sp̃Gg|Cg
+* 2ł3ł̋ʕ batch1.c  batch3.c ꂼ gravity*.h ȂǂBATCH_SCREEN`ɃCN[h
+* @detail
+* DxLibƃt[[vgȂ̂, CPŰ̑ŃXebvi߂.
+* g : gravity3d f[^t@C [IvV] (2ł gravity2d)
+*   --dt dt       1Xebv̎̕ω (ȗ̓oCi`̃f[^t@CɋL^ꂽl, Ȃ1.0)
+*   --steps n     nXebvi߂I
+*   --end t       tɒBI
+*   --bound r     SĂ̐_𒆐SƂ2r̗ (2ł͐`) oI
+*   --every k     kXebvƂɏԂo͂ (ȗ͍Ō̏Ԃ)
+*   --output p    Ԃt@C p00000010.txt Ȃǂ֏o͂ (ȗ͕Wo)
+*   --format f    o͂̌` txt:f[^t@CƓ bin:oCi` p00000010.bin (ȗtxt)
+*                 bin̂Ƃ͕ʂ̃XbhôŌvZ͏݂҂Ȃ. --outputKv
+*   --convert f   f[^t@CoCi`f֏oďI
+*   --method m    ϕ@ rk4:QENb^@ dopri:ݕŒh}EvX@
+*                 hermite:Ƃɍ݂IԃG~[g@ euler:IC[@ leapfrog:[vtbO@
+*                 yoshida4, yoshida6:[vtbO@gݍ킹4, 6̋gc̕@ (ȗrk4)
+*                 doprîƂ--dt͍ŏɎݕ, Xebv͎󗝂݂̐
+*                 hermitêƂ--dt͐Ƃ݂̍̏, SĂ̐Ԋu
+*   --rtol r, --atol a  dopri1Xebv̌덷̋el (ȗ͂ǂ1e-8)
+*   --eta e       hermite̍ݕ߂鐸x̌W (ȗ0.02)
+*   --checkpoint f vZĊJ邽߂̃`FbN|Cgf֒Iɏo. Iɂo
+*   --interval k  `FbN|CgoXebv̊Ԋu (ȗ1000)
+*   --precision p ڑa̐x double:Sdouble mixed:gƂ̌vZ64g̘afloat, Ŝ̘adouble (ȗdouble)
+*   --accuracy n  ŏ̏Ԃōx̉xdoubleƔ, 덷1̌vZɂ鎞(n̕)\ďI
+*   --diagnostics k  kXebvƂƍŏƍŌɃGlM[, ^, p^ʂo. ̂o
+*                 ʒuGlM[͉xƓǧvZŋ߂̂, rk4eulerł͗]ȉx̌vZȂ
+*   --log f       --diagnostics̏o (ȗ͕WG[o)
+*   --profile f   ԂƂ̎ԂƉ񐔂̕\WG[o͂, Chrome tracing`JSONf֏o
+*                 make PROFILE=1 Ōvgݍ񂾂Ƃg
+*   --render p    `摜 p00000010.png Ȃǂ֏o. `Əo͕ʂ̃Xbhs
+*   --pipe c      摜t@CłȂPPM̗ƂăR}hc̕W͂֗ (ffmpeg -f image2pipe -i - Ȃ)
+*   --frames k    摜`Xebv̊Ԋu (ȗ1)
+*   --image f     摜̌` png:kPNG ppm:PPM (ȗpng)
+*   --width w, --height h  摜̑傫 (ȗGUỈʂƓ BATCH_SCREEN ̐`)
+*   --unit u      1\f (ȗ10). eGUI̕\Ɠ
+*   --render-threads n  ꖇ̕`ɎgXbh̐ (ȗ--threadsƓ)
+*   --escape r    ꂽ̏dSr艓, O֌, ĂȂ͂̌vZƏՓ˂̔肩O
+*                 O͎c̐̒PɎqƎldɎq̏d͂̒i, Ȍd͈͂lȍƒ̍Ŏc̐ɉ
+*                 hermiteł͎gȂ. --diagnosticŝƂ͊Oۑʂo, O escape ̍sŏo
+*   --escape-every k  o𒲂ׂXebv̊Ԋu (ȗ100)
+*                 `FbN|Cgɂ͔o̐ƎʂL^, --escapeōĊJΓ瑱
+*   --softening e . ߂g̏d͂߂ċߐڑłLɂ (ȗ0œȂ)
+*                 ڑa, , FMM̋ߖT, G~[g@̉xɌ. FMM̉̓WJ͓Ȃ
+*   --softening-kernel k  ̌` plummer:SĂ̋ (r^2 + e^2)^-3/2 spline:2.8e艓΃j[g̏d͂ƈv3XvC (ȗplummer)
+*   --regularize r  r߂, , ̐̒ア̐AƂďdS̐Ői,
+*                 Ή^͐W2̖̉ƒ̏RŐi߂. A̓͍̐̂Ȃ
+*                 hermiteł͎gȂ. --diagnosticŝƂ͑gςXebv binary ̍sŏo
+*                 `FbN|Cgɂ͑ÕXebv̑gL^, --regularizeōĊJΓg瑱
+*   --theta , --order n, --fmm p, --threads n  SimulatorƓ. --fmm3ł
+* I͏ȂƂw肷邱. o͂̓f[^t@CƓ`Ȃ̂ŏlƂēǂݒ.
+* f[^t@C̓eLXg`ƃoCi`̂ǂł悢.
+* `FbN|Cgf[^t@CɎw肷, L^ꂽXebv瓯vZrbgPʂœʂ̂܂ܑ.
+* G~[g@݂̍Ȃ, ϕ@g񂷒l`FbN|CgɋL^.
+* ĨXebvƎ͍ŏ̒ʎZȂ̂, ŏƓIvVŋN΂悢.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "pool.h"
+#include "profile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/**
+* ob`s̐ݒ
+*/
+struct BatchOptions {
+    double dt;          // time step
+    long steps;         // stop after this number of steps, < 0 for no limit
+    double end;         // stop when the time reaches this, < 0 for no limit
+    double bound;       // stop when every star is out of this range, < 0 for no limit
+    long every;         // output cadence in steps, 0 for the final state only
+    const char* output; // prefix of the output files, NULL for stdout
+    int binary;         // 1 to write snapshots in the binary format on the writer thread
+    const char* convert; // binary file to write the initial state to, NULL to run
+    const char* checkpoint; // file to write checkpoints to, NULL for none
+    long interval;      // checkpoint cadence in steps
+    int method;         // METHOD_*
+    double rtol;        // tolerances of Dormand-Prince
+    double atol;
+    double eta;         // accuracy parameter of Hermite
+    int precision;      // FORCE_PRECISION_*
+    long accuracy;      // evaluations to time in the accuracy report, 0 to run
+    long diagnostics;   // cadence of the conservation diagnostics in steps, 0 for none
+    const char* log;    // file to write the diagnostics to, NULL for stderr
+    const char* profile; // file to write the trace of the profiler to, NULL for none
+    struct RenderOptions render; // frames are drawn when prefix or pipe is set
+    long frames;        // frame cadence in steps
+    double escape;      // radius beyond which unbound stars leave the force loop, <= 0 to keep every star
+    long escape_every;  // cadence of the escape check in steps
+    double softening;   // softening length, 0 for Newtonian gravity
+    int softening_kind; // FORCE_SOFTENING_*
+    double regularize;  // radius below which bound pairs are regularized, <= 0 for none
+    double theta;       // opening angle of Barnes-Hut, < 0 for direct summation
+    int order;
+    int fmm_order;      // expansion order of FMM, 0 for Barnes-Hut or direct summation, always 0 in 2D
+    int threads;
+};
+
+/**
+* @fn oߎԂbŕԂ.
+*/
+static double wall_time(void) {
+#ifdef _WIN32
+    return GetTickCount64() / 1000.0;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+* @fn f[^t@CɑR}hCǂݍ.
+* @return ǂ߂Ƃ1 肪Ƃ0
+*/
+static int parse_options(int argc, char **argv, struct BatchOptions *options) {
+    int i;
+    options->dt = 0;
+    options->steps = -1;
+    options->end = -1;
+    options->bound = -1;
+    options->every = 0;
+    options->output = NULL;
+    options->binary = 0;
+    options->convert = NULL;
+    options->checkpoint = NULL;
+    options->interval = 1000;
+    options->method = METHOD_RK4;
+    options->rtol = 1e-8;
+    options->atol = 1e-8;
+    options->eta = HERMITE_ETA;
+    options->precision = FORCE_PRECISION_DOUBLE;
+    options->accuracy = 0;
+    options->diagnostics = 0;
+    options->log = NULL;
+    options->profile = NULL;
+    options->render.width = BATCH_SCREEN;
+    options->render.height = BATCH_SCREEN;
+    options->render.unit = 10;
+    options->render.format = RENDER_PNG;
+    options->render.prefix = NULL;
+    options->render.pipe = NULL;
+    options->render.threads = 0;
+    options->frames = 1;
+    options->escape = 0;
+    options->escape_every = 100;
+    options->softening = 0;
+    options->softening_kind = FORCE_SOFTENING_PLUMMER;
+    options->regularize = 0;
+    options->theta = -1;
+    options->order = TREE_QUADRUPOLE;
+    options->fmm_order = 0;
+    options->threads = hardware_threads();
+    for ( i = 2; i < argc; i++ ) {
+        if ( i + 1 >= argc ) {
+            fprintf(stderr, "error: option %s needs a value.\n", argv[i]);
+            return 0;
+        } else if ( strcmp(argv[i], "--dt") == 0 ) {
+            options->dt = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--steps") == 0 ) {
+            options->steps = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--end") == 0 ) {
+            options->end = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--bound") == 0 ) {
+            options->bound = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--every") == 0 ) {
+            options->every = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--output") == 0 ) {
+            options->output = argv[++i];
+        } else if ( strcmp(argv[i], "--format") == 0 ) {
+            options->binary = strcmp(argv[++i], "bin") == 0;
+        } else if ( strcmp(argv[i], "--convert") == 0 ) {
+            options->convert = argv[++i];
+        } else if ( strcmp(argv[i], "--checkpoint") == 0 ) {
+            options->checkpoint = argv[++i];
+        } else if ( strcmp(argv[i], "--interval") == 0 ) {
+            options->interval = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--method") == 0 ) {
+            options->method = find_method(argv[++i]);
+            if ( options->method < 0 ) {
+                fprintf(stderr, "error: unknown method %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--rtol") == 0 ) {
+            options->rtol = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--atol") == 0 ) {
+            options->atol = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--eta") == 0 ) {
+            options->eta = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--precision") == 0 ) {
+            ++i;
+            if ( strcmp(argv[i], "double") == 0 ) {
+                options->precision = FORCE_PRECISION_DOUBLE;
+            } else if ( strcmp(argv[i], "mixed") == 0 ) {
+                options->precision = FORCE_PRECISION_MIXED;
+            } else {
+                fprintf(stderr, "error: unknown precision %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--accuracy") == 0 ) {
+            options->accuracy = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--diagnostics") == 0 ) {
+            options->diagnostics = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--log") == 0 ) {
+            options->log = argv[++i];
+        } else if ( strcmp(argv[i], "--profile") == 0 ) {
+            options->profile = argv[++i];
+        } else if ( strcmp(argv[i], "--render") == 0 ) {
+            options->render.prefix = argv[++i];
+        } else if ( strcmp(argv[i], "--pipe") == 0 ) {
+            options->render.pipe = argv[++i];
+        } else if ( strcmp(argv[i], "--frames") == 0 ) {
+            options->frames = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--image") == 0 ) {
+            if ( strcmp(argv[++i], "png") == 0 ) {
+                options->render.format = RENDER_PNG;
+            } else if ( strcmp(argv[i], "ppm") == 0 ) {
+                options->render.format = RENDER_PPM;
+            } else {
+                fprintf(stderr, "error: unknown image format %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--width") == 0 ) {
+            options->render.width = atoi(argv[++i]);
+        } else if ( strcmp(argv[i], "--height") == 0 ) {
+            options->render.height = atoi(argv[++i]);
+        } else if ( strcmp(argv[i], "--unit") == 0 ) {
+            options->render.unit = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--render-threads") == 0 ) {
+            options->render.threads = atoi(argv[++i]);
+        } else if ( strcmp(argv[i], "--escape") == 0 ) {
+            options->escape = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--escape-every") == 0 ) {
+            options->escape_every = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--softening") == 0 ) {
+            options->softening = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--softening-kernel") == 0 ) {
+            if ( strcmp(argv[++i], "plummer") == 0 ) {
+                options->softening_kind = FORCE_SOFTENING_PLUMMER;
+            } else if ( strcmp(argv[i], "spline") == 0 ) {
+                options->softening_kind = FORCE_SOFTENING_SPLINE;
+            } else {
+                fprintf(stderr, "error: unknown softening kernel %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--regularize") == 0 ) {
+            options->regularize = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--theta") == 0 ) {
+            options->theta = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--order") == 0 ) {
+            options->order = atoi(argv[++i]) >= TREE_QUADRUPOLE ? TREE_QUADRUPOLE : TREE_MONOPOLE;
+#if GRAVITY_DIM == 3
+        } else if ( strcmp(argv[i], "--fmm") == 0 ) {
+            options->fmm_order = atoi(argv[++i]);
+#endif
+        } else if ( strcmp(argv[i], "--threads") == 0 ) {
+            options->threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "error: unknown option %s.\n", argv[i]);
+            return 0;
+        }
+    }
+    if ( options->dt < 0 ) {
+        fprintf(stderr, "error: dt must be positive.\n");
+        return 0;
+    }
+    if ( options->rtol < 0 || options->atol < 0 || options->rtol + options->atol <= 0 ) {
+        fprintf(stderr, "error: tolerances must be positive.\n");
+        return 0;
+    }
+    if ( options->eta <= 0 ) {
+        fprintf(stderr, "error: eta must be positive.\n");
+        return 0;
+    }
+    if ( options->interval <= 0 ) {
+        fprintf(stderr, "error: interval must be positive.\n");
+        return 0;
+    }
+    if ( options->binary && options->output == NULL ) {
+        fprintf(stderr, "error: --format bin needs --output.\n");
+        return 0;
+    }
+    if ( options->accuracy < 0 ) {
+        fprintf(stderr, "error: accuracy must be a positive count.\n");
+        return 0;
+    }
+    if ( options->diagnostics < 0 ) {
+        fprintf(stderr, "error: diagnostics must be a positive cadence.\n");
+        return 0;
+    }
+    if ( options->log != NULL && options->diagnostics == 0 ) {
+        fprintf(stderr, "error: --log needs --diagnostics.\n");
+        return 0;
+    }
+    if ( options->render.prefix != NULL && options->render.pipe != NULL ) {
+        fprintf(stderr, "error: specify only one of --render and --pipe.\n");
+        return 0;
+    }
+    if ( options->frames <= 0 ) {
+        fprintf(stderr, "error: frames must be a positive cadence.\n");
+        return 0;
+    }
+    if ( options->render.width <= 0 || options->render.height <= 0 || options->render.unit <= 0 ) {
+        fprintf(stderr, "error: width, height and unit must be positive.\n");
+        return 0;
+    }
+    if ( options->escape_every <= 0 ) {
+        fprintf(stderr, "error: escape-every must be a positive cadence.\n");
+        return 0;
+    }
+    if ( options->escape > 0 && options->method == METHOD_HERMITE ) {
+        //the jerk of Hermite has no external term
+        fprintf(stderr, "warning: hermite keeps every star in the force. --escape is ignored.\n");
+        options->escape = 0;
+    }
+    if ( options->softening < 0 ) {
+        fprintf(stderr, "error: softening must not be negative.\n");
+        return 0;
+    }
+    if ( options->regularize > 0 && options->method == METHOD_HERMITE ) {
+        //Hermite chooses its own step for each star, a close pair only shortens its own steps
+        fprintf(stderr, "warning: hermite integrates every star directly. --regularize is ignored.\n");
+        options->regularize = 0;
+    }
+    if ( options->render.threads <= 0 ) {
+        options->render.threads = options->threads;
+    }
+    if ( options->profile != NULL && !profile_enabled() ) {
+        fprintf(stderr, "warning: --profile needs a build with make PROFILE=1. nothing is measured.\n");
+        options->profile = NULL;
+    }
+    if ( options->steps < 0 && options->end < 0 && options->bound < 0 && options->convert == NULL && options->accuracy == 0 ) {
+        fprintf(stderr, "error: specify at least one of --steps, --end and --bound.\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+* @fn SĂ͈̐͂̊Oɂ邩ׂ.
+* @param bound _𒆐SƂ闧 (2ł͐`) ̈ӂ̔
+*/
+static int is_all_out(const int size, struct Stars const *stars, const double bound) {
+    int i;
+#define AXIS_OUT(X) ( fabs(stars->X[i]) >= bound )
+    for ( i = 0; i < size; i++ ) {
+        if ( !( AXIS_OUT(x) || ANY_CROSS_AXES(AXIS_OUT) ) ) {
+            return 0;
+        }
+    }
+#undef AXIS_OUT
+    return 1;
+}
+
+/**
+* @fn ̏Ԃf[^t@CƓ`ŏo.
+* @param state ݂̃XebvƎ. Xebv̓t@CɎg
+* @param writer NULLłȂ΃oCi`ł̏o˗邾Ŗ߂
+* @return Ƃ1 sƂ0
+*/
+static int write_state(struct BatchOptions const *options, struct StarsState const *state, const int size, struct Stars const *stars,
+    struct SnapshotWriter *writer) {
+    FILE *out = stdout;
+    int i;
+    if ( writer != NULL ) {
+        return record_snapshot(writer, state, size, stars);
+    }
+    if ( options->output != NULL ) {
+        char name[1024];
+        snprintf(name, sizeof(name), "%s%08ld.txt", options->output, state->step);
+        out = fopen(name, "w");
+        if ( out == NULL ) {
+            fprintf(stderr, "error: cannot open %s.\n", name);
+            return 0;
+        }
+    }
+    //17 digits so that the state is read back exactly
+    fprintf(out, "%d\n", size);
+    for ( i = 0; i < size; i++ ) {
+#if GRAVITY_DIM == 3
+        fprintf(out, "%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+            stars->m[i], stars->x[i], stars->y[i], stars->z[i], stars->vx[i], stars->vy[i], stars->vz[i]);
+#else
+        fprintf(out, "%.17g,%.17g,%.17g,%.17g,%.17g\n", stars->m[i], stars->x[i], stars->y[i], stars->vx[i], stars->vy[i]);
+#endif
+    }
+    if ( out != stdout ) {
+        fclose(out);
+    } else {
+        fflush(out);
+    }
+    return 1;
+}
+
+/**
+* @fn `FbN|Cgo.
+* @param state ݂̃Xebv, Ǝ̍ݕ
+* @param stepper g񂷒lž̋Ԃɏo
+* @param escape o̐Ǝʂ𓯂o
+* @param bin ÕXebv̑g𓯂o
+* @return Ƃ1 sƂ0
+*/
+static int write_checkpoint(struct BatchOptions const *options, struct StarsState const *state, const int size, struct Stars const *stars,
+    struct Stepper const *stepper, struct Workspace const *work, struct Escapers const *escape, struct Binaries const *bin) {
+    struct StarsExtra extra = { NULL, 0, 0 };
+    int ok = save_stepper(size, stepper, work, &extra) && save_escapers(escape, &extra) && save_binaries(bin, &extra);
+    ok = ok && save_checkpoint(options->checkpoint, size, stars, state, &extra);
+    free_extra(&extra);
+    if ( !ok ) {
+        fprintf(stderr, "error: cannot write checkpoint %s.\n", options->checkpoint);
+        return 0;
+    }
+    return 1;
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *( const double* )a;
+    const double y = *( const double* )b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+* @fn x̉xdoublẻxƔ, 덷Ƒ\.
+* @param repeats Ԃ𑪂邽߂ɉxvZ
+* @detail ŏ̏ԂɂĒڑaŗ̐x̉xvZ.
+*         Ɨ̈rx[0], ry[0], rz[0]doublẻx, vx[0]ɐƂ̌덷u
+*/
+static void report_accuracy(const int size, struct Stars const *stars, struct Workspace *work, const long repeats) {
+#define AXIS_EXACT(X) double *b##X = work->r##X[0];
+    FOR_AXES(AXIS_EXACT)
+#undef AXIS_EXACT
+    double *error = work->vx[0];
+    double start, exact_time = 0, mixed_time = 0;
+    double rms = 0;
+    //net force | m a| relative to  m |a|, zero in exact arithmetic by the action-reaction law
+    double net[2], scale[2];
+    int i, k, worst = 0;
+    long r;
+#define AXIS_MOMENT(X) f##X += stars->m[i] * work->a##X[i];
+#define AXIS_SQUARE(X) work->a##X[i] * work->a##X[i]
+#define AXIS_NET(X) f##X * f##X
+#define AXIS_EXACT_SQUARE(X) b##X[i] * b##X[i]
+#define AXIS_GAP(X) ( work->a##X[i] - b##X[i] ) * ( work->a##X[i] - b##X[i] )
+    for ( k = 0; k < 2; k++ ) {
+#define AXIS_FORCE(X) double f##X = 0;
+        FOR_AXES(AXIS_FORCE)
+#undef AXIS_FORCE
+        set_force_precision(k == 0 ? FORCE_PRECISION_DOUBLE : FORCE_PRECISION_MIXED);
+        start = wall_time();
+        for ( r = 0; r < repeats; r++ ) {
+            accelerations(size, stars, work);
+        }
+        if ( k == 0 ) {
+            exact_time = ( wall_time() - start ) / repeats;
+#define AXIS_KEEP(X) memcpy(b##X, work->a##X, size * sizeof(double));
+            FOR_AXES(AXIS_KEEP)
+#undef AXIS_KEEP
+        } else {
+            mixed_time = ( wall_time() - start ) / repeats;
+        }
+        scale[k] = 0;
+        for ( i = 0; i < size; i++ ) {
+            FOR_AXES(AXIS_MOMENT)
+            scale[k] += stars->m[i] * sqrt(SUM_AXES(AXIS_SQUARE));
+        }
+        net[k] = sqrt(SUM_AXES(AXIS_NET));
+    }
+    for ( i = 0; i < size; i++ ) {
+        const double a = sqrt(SUM_AXES(AXIS_EXACT_SQUARE));
+        error[i] = a > 0 ? sqrt(SUM_AXES(AXIS_GAP)) / a : 0;
+        rms += error[i] * error[i];
+        if ( error[i] > error[worst] ) {
+            worst = i;
+        }
+    }
+#undef AXIS_MOMENT
+#undef AXIS_SQUARE
+#undef AXIS_NET
+#undef AXIS_EXACT_SQUARE
+#undef AXIS_GAP
+    fprintf(stderr, "mixed precision against double : %d stars, %s kernel, %d threads\n",
+        size, force_kernel_name(get_force_kernel()), pool_threads(work->pool));
+    fprintf(stderr, "relative error of acceleration : max %.3e (star %d), ", error[worst], worst);
+    qsort(error, size, sizeof(double), compare_double);
+    fprintf(stderr, "99%% %.3e, median %.3e, rms %.3e\n", error[( size - 1 ) * 99 / 100], error[( size - 1 ) / 2], sqrt(rms / size));
+    fprintf(stderr, "net force |sum m a| / sum m |a| : double %.3e, mixed %.3e\n",
+        scale[0] > 0 ? net[0] / scale[0] : 0.0, scale[1] > 0 ? net[1] / scale[1] : 0.0);
+    fprintf(stderr, "time per evaluation : double %.3f ms, mixed %.3f ms (%.2fx)\n",
+        exact_time * 1e3, mixed_time * 1e3, mixed_time > 0 ? exact_time / mixed_time : 0.0);
+}
+
+/**
+* @fn ߂|eVffɉďo.
+* @param initial ŏ̐ff ܂Ȃ(step)̐ffŏƂ
+*/
+static void finish_diagnostics(FILE *log, const int size, struct Stars const *stars, double const *phi, struct Diagnostics *diag,
+    struct Diagnostics *initial) {
+    add_potential(size, stars, phi, diag);
+    if ( initial->step < 0 ) {
+        *initial = *diag;
+    }
+    write_diagnostics(log, diag, initial);
+}
+
+int main(int argc, char **argv) {
+    struct BatchOptions options;
+    struct Stars stars;
+    struct StarsState state;
+    struct StarsExtra extra;
+    struct Workspace work;
+    struct Tree tree;
+    struct Stepper stepper;
+#if GRAVITY_DIM == 3
+    struct Fmm fmm;
+#endif
+    struct ThreadPool *pool = NULL;
+    struct SnapshotWriter *writer = NULL;
+    struct FrameRenderer *renderer = NULL;
+    struct Diagnostics diag, initial;
+    struct MergeLog merges = { NULL, 0, 0 };
+    struct Escapers escape;
+    struct Binaries bin;
+    FILE *log = stderr;
+    int size, bound, merged;
+    long step = 0, first;
+    double t = 0;
+    double limit, h;
+    double start, elapsed;
+    const char *reason;
+
+    if ( argc < 2 ) {
+        fprintf(stderr, "usage: %s data [--dt dt] [--steps n] [--end t] [--bound r] [--every k] [--output prefix] [--format txt|bin] [--convert file]"
+            " [--method rk4|dopri|hermite|euler|leapfrog|yoshida4|yoshida6] [--rtol r] [--atol a] [--eta e] [--checkpoint file] [--interval k]"
+            " [--precision double|mixed] [--accuracy n] [--diagnostics k] [--log file] [--profile file]"
+            " [--render prefix] [--pipe command] [--frames k] [--image png|ppm] [--width w] [--height h] [--unit u] [--render-threads n]"
+            " [--escape r] [--escape-every k]"
+            " [--softening e] [--softening-kernel plummer|spline] [--regularize r] [--theta theta] [--order n]%s [--threads n]\n", argv[0], GRAVITY_DIM == 3 ? " [--fmm p]" : "");
+        return 2;
+    }
+    if ( !parse_options(argc, argv, &options) ) {
+        return 2;
+    }
+    //the pool also parses a text data file in parallel
+    if ( options.threads > 1 ) {
+        pool = create_pool(options.threads);
+    }
+    size = load_checkpoint(argv[1], &stars, pool, &state, &extra);
+    if ( size <= 0 ) {
+        fprintf(stderr, "error: cannot read stars from %s.\n", argv[1]);
+        free_extra(&extra);
+        destroy_pool(pool);
+        return 1;
+    }
+    //Windows cannot replace a mapped file, and the checkpoint or the converted file may be the one just read
+    if ( ( options.convert != NULL || options.checkpoint != NULL ) && !detach_stars(size, &stars) ) {
+        fprintf(stderr, "error: cannot copy the stars out of %s.\n", argv[1]);
+        free_extra(&extra);
+        free_stars(&stars);
+        destroy_pool(pool);
+        return 1;
+    }
+    if ( options.convert != NULL ) {
+        const int ok = save_stars(options.convert, size, &stars, &state);
+        if ( ok ) {
+            fprintf(stderr, "wrote %d stars to %s\n", size, options.convert);
+        } else {
+            fprintf(stderr, "error: cannot write %s.\n", options.convert);
+        }
+        free_extra(&extra);
+        free_stars(&stars);
+        destroy_pool(pool);
+        return ok ? 0 : 1;
+    }
+    if ( !allocate_workspace(size, &work) ) {
+        fprintf(stderr, "error: cannot allocate workspace.\n");
+        free_extra(&extra);
+        free_stars(&stars);
+        destroy_pool(pool);
+        return 1;
+    }
+    work.pool = pool;
+    if ( options.accuracy > 0 ) {
+        report_accuracy(size, &stars, &work, options.accuracy);
+        free_extra(&extra);
+        free_workspace(&work);
+        free_stars(&stars);
+        destroy_pool(pool);
+        return 0;
+    }
+    set_force_precision(options.precision);
+    set_force_softening(options.softening_kind, options.softening);
+    if ( options.precision == FORCE_PRECISION_MIXED && ( options.method == METHOD_HERMITE || options.theta >= 0 || options.fmm_order > 0 ) ) {
+        //the tree, FMM and the jerk of Hermite have their own double kernels
+        fprintf(stderr, "warning: --precision mixed only affects direct summation.\n");
+    }
+    //resume from the step and time step recorded in a checkpoint
+    //the step size of Dormand-Prince is a state of the controller rather than an option
+    if ( options.dt <= 0 || ( options.method == METHOD_DOPRI && state.dt > 0 ) ) {
+        options.dt = state.dt > 0 ? state.dt : 1.0;
+    }
+    step = state.step;
+    first = step;
+    t = options.method == METHOD_DOPRI ? state.time : step * options.dt;
+    if ( step > 0 ) {
+        fprintf(stderr, "resume from step %ld, t = %g\n", step, t);
+    }
+    if ( !allocate_stepper(size, options.method, options.dt, options.rtol, options.atol, options.eta, &stepper) ) {
+        fprintf(stderr, "error: cannot allocate %s workspace. use rk4.\n", method_name(options.method));
+        options.method = METHOD_RK4;
+        allocate_stepper(size, options.method, options.dt, options.rtol, options.atol, options.eta, &stepper);
+        t = step * options.dt;
+    }
+    if ( options.binary ) {
+        writer = create_writer(options.output, size);
+        if ( writer == NULL ) {
+            fprintf(stderr, "error: cannot start the snapshot writer. write text files.\n");
+        }
+    }
+    if ( options.render.prefix != NULL || options.render.pipe != NULL ) {
+        renderer = create_renderer(&options.render, size);
+        if ( renderer == NULL ) {
+            fprintf(stderr, "error: cannot start the renderer. no frames are drawn.\n");
+        }
+    }
+    if ( options.method == METHOD_HERMITE && ( options.theta >= 0 || options.fmm_order > 0 ) ) {
+        //the jerk needs the exact pairwise velocities
+        fprintf(stderr, "warning: hermite always uses direct summation.\n");
+#if GRAVITY_DIM == 3
+    } else if ( options.fmm_order > 0 ) {
+        if ( allocate_fmm(size, options.theta >= 0 ? options.theta : 0.5, options.fmm_order, &fmm) ) {
+            work.fmm = &fmm;
+        } else {
+            fprintf(stderr, "error: cannot allocate FMM. use direct summation.\n");
+        }
+#endif
+    } else if ( options.theta >= 0 ) {
+        if ( allocate_tree(size, options.theta, options.order, &tree) ) {
+            work.tree = &tree;
+        } else {
+            fprintf(stderr, "error: cannot allocate tree. use direct summation.\n");
+        }
+    }
+
+    init_escapers(options.escape, &escape);
+    //the values the integrator would have reused, the escaped stars at the end of the arrays and the pairs of the last step
+    restore_stepper(size, &extra, &stepper, &work);
+    if ( restore_escapers(size, &extra, &escape) ) {
+        fprintf(stderr, "resume with %d escaped stars\n", escape.count);
+    }
+    if ( !allocate_binaries(size, options.regularize, &bin) ) {
+        fprintf(stderr, "error: cannot allocate the binaries. no pair is regularized.\n");
+    }
+    restore_binaries(size, &extra, &bin);
+    free_extra(&extra);
+    //regularized pairs pass through each other at the pericenter without merging
+    stepper.partner = bin.partner;
+    diag.step = -1;
+    diag.pending = 0;
+    initial.step = -1;
+    if ( options.diagnostics > 0 ) {
+        if ( options.log != NULL ) {
+            log = fopen(options.log, "w");
+            if ( log == NULL ) {
+                fprintf(stderr, "error: cannot open %s. write diagnostics to stderr.\n", options.log);
+                log = stderr;
+            }
+        }
+        stepper.merges = &merges;
+    }
+
+    if ( options.profile != NULL ) {
+        profile_start(1);
+    }
+    start = wall_time();
+    state.step = step;
+    state.time = t;
+    state.dt = options.dt;
+    if ( options.every > 0 ) {
+        write_state(&options, &state, size, &stars, writer);
+    }
+    if ( renderer != NULL && step % options.frames == 0 ) {
+        render_frame(renderer, step, size, &stars);
+    }
+    for ( ;; ) {
+        if ( options.steps >= 0 && step >= options.steps ) {
+            reason = "step count";
+            break;
+        }
+        //stop at the step nearest to the end time, Dormand-Prince shortens the last step to end there
+        if ( options.end >= 0 && ( options.method == METHOD_DOPRI ? t >= options.end : t + options.dt * 0.5 > options.end ) ) {
+            reason = "end time";
+            break;
+        }
+        PROFILE_BEGIN(PROFILE_UPDATE);
+        if ( options.bound >= 0 ) {
+            int out;
+            PROFILE_BEGIN(PROFILE_ON_SCREEN);
+            out = is_all_out(size, &stars, options.bound);
+            PROFILE_END(PROFILE_ON_SCREEN);
+            if ( out ) {
+                PROFILE_END(PROFILE_UPDATE);
+                reason = "all stars out of bound";
+                break;
+            }
+        }
+        limit = options.end >= 0 ? options.end - t : 0;
+        PROFILE_BEGIN(PROFILE_COLLISION);
+        //only the bound stars collide, the escaped ones after them are shifted to close the gap
+        bound = size - escape.count;
+        merged = stepper_collision(bound, &stars, &stepper);
+        size = shift_escapers(size, bound, merged, &stars);
+        PROFILE_END(PROFILE_COLLISION);
+        if ( merged != bound ) {
+            forget_binaries(&bin);
+        }
+        if ( merges.count > 0 ) {
+            write_merges(log, step, t, &merges);
+        }
+        if ( options.escape > 0 && step % options.escape_every == 0 ) {
+            const int escaped = classify_escapers(size, &stars, &escape);
+            if ( escaped > 0 ) {
+                stepper_discard(&stepper);
+                forget_binaries(&bin);
+                if ( options.diagnostics > 0 ) {
+                    write_escapers(log, step, t, escaped, size, &escape);
+                }
+            }
+        }
+        bound = size - escape.count;
+        //the accelerations kept by the stepper are for the previous set of pairs
+        if ( select_binaries(bound, &stars, &bin) ) {
+            stepper_discard(&stepper);
+            if ( options.diagnostics > 0 ) {
+                write_binaries(log, step, t, &bin);
+            }
+        }
+        prepare_escapers(size, &stars, &escape, &work);
+        if ( options.diagnostics > 0 && ( step == first || step % options.diagnostics == 0 ) ) {
+            measure_state(step, t, bound, &stars, &diag);
+            //rk4 and euler find the potential in the first force evaluation of the step below
+            if ( stepper_potential(bound, &stars, &work, &stepper) ) {
+                finish_diagnostics(log, bound, &stars, work.phi, &diag, &initial);
+            } else if ( bin.count > 0 ) {
+                //the step below sees each pair as one star, the potential needs both members
+                accelerations(bound, &stars, &work);
+                finish_diagnostics(log, bound, &stars, work.phi, &diag, &initial);
+            }
+            if ( bin.count > 0 ) {
+                stepper_discard(&stepper);
+            }
+        }
+        PROFILE_BEGIN(PROFILE_ADVANCE);
+        prepare_binaries(&stars, &work, &bin);
+        h = advance(bound, limit, &stars, &work, &stepper);
+        propagate_binaries(h, &stars, &bin);
+        propagate_escapers(size, h, &stars, &escape);
+        PROFILE_END(PROFILE_ADVANCE);
+        if ( diag.pending ) {
+            finish_diagnostics(log, bound, &stars, work.phi, &diag, &initial);
+        }
+        step++;
+        if ( options.method == METHOD_DOPRI ) {
+            t = limit > 0 && h >= limit ? options.end : t + h;
+        } else {
+            //count the fixed steps so that rounding errors do not add up
+            t = step * options.dt;
+        }
+        state.dt = next_dt(&stepper);
+        state.step = step;
+        state.time = t;
+        PROFILE_BEGIN(PROFILE_OUTPUT);
+        if ( options.every > 0 && step % options.every == 0 ) {
+            write_state(&options, &state, size, &stars, writer);
+        }
+        if ( options.checkpoint != NULL && step % options.interval == 0 ) {
+            write_checkpoint(&options, &state, size, &stars, &stepper, &work, &escape, &bin);
+        }
+        //only copies the positions, the render thread draws them while the next steps run
+        if ( renderer != NULL && step % options.frames == 0 ) {
+            render_frame(renderer, step, size, &stars);
+        }
+        PROFILE_END(PROFILE_OUTPUT);
+        PROFILE_END(PROFILE_UPDATE);
+    }
+    if ( options.diagnostics > 0 && diag.step != step ) {
+        bound = size - escape.count;
+        prepare_escapers(size, &stars, &escape, &work);
+        measure_state(step, t, bound, &stars, &diag);
+        if ( !stepper_potential(bound, &stars, &work, &stepper) ) {
+            accelerations(bound, &stars, &work);
+        }
+        finish_diagnostics(log, bound, &stars, work.phi, &diag, &initial);
+    }
+    if ( options.checkpoint != NULL && step % options.interval != 0 ) {
+        write_checkpoint(&options, &state, size, &stars, &stepper, &work, &escape, &bin);
+    }
+    if ( options.every <= 0 || step % options.every != 0 ) {
+        write_state(&options, &state, size, &stars, writer);
+    }
+    elapsed = wall_time() - start;
+    fprintf(stderr, "stopped by %s : %ld steps, t = %g, %d stars, %.3f s (%.1f steps/s, %d threads)\n",
+        reason, step, t, size, elapsed, elapsed > 0 ? ( step - first ) / elapsed : 0.0, pool_threads(pool));
+    report_stepper(stderr, size, step - first, &stepper);
+    if ( options.escape > 0 ) {
+        fprintf(stderr, "escaped : %d stars, mass %g, %d bound\n", escape.count, escape.mass, size - escape.count);
+    }
+    if ( options.regularize > 0 ) {
+        fprintf(stderr, "binaries : %d pairs, %ld formed, %ld dissolved, %ld Kepler drifts\n", bin.count, bin.formed, bin.dissolved, bin.substeps);
+    }
+    if ( options.profile != NULL ) {
+        profile_report(stderr);
+        if ( !profile_write_trace(options.profile) ) {
+            fprintf(stderr, "error: cannot write %s.\n", options.profile);
+        }
+    }
+    free_stepper(&stepper);
+    free_binaries(&bin);
+    free_merge_log(&merges);
+    if ( log != stderr ) {
+        fclose(log);
+    }
+
+    if ( destroy_writer(writer) > 0 ) {
+        fprintf(stderr, "error: some snapshots could not be written.\n");
+    }
+    if ( destroy_renderer(renderer) > 0 ) {
+        fprintf(stderr, "error: some frames could not be written.\n");
+    }
+    destroy_pool(pool);
+    if ( work.tree != NULL ) {
+        free_tree(&tree);
+    }
+#if GRAVITY_DIM == 3
+    if ( work.fmm != NULL ) {
+        free_fmm(&fmm);
+    }
+#endif
+    free_workspace(&work);
+    free_stars(&stars);
+    return 0;
+}
@@ -0,0 +1,722 @@
+/**
+* @brief vZ̃J[l̑𑪂x`}[N 2ł3ł̋ʕ
+* @detail
+* bench1.c  bench3.c ꂼ gravity*.h ȂǂBENCH_NAME`ɃCN[h.
+* l (l, v}[, ~) ɂ, ̐ƃXbh̐ςȂ
+* x̌vZ, QENb^@, IC[@, Փ˂̔, f[^t@C̓ǂݍ݂1񂠂̎Ԃ𑪂,
+* ʂJSONŏo. OɏoJSONɓnƓ̌ʂƔ, xȂ̂񍐂.
+* g : bench3d [IvV]
+*   --kernels list  鏈J}؂ force,rk4,euler,collision,init (ȗ͑S)
+*   --models list   lJ}؂ uniform,plummer,disk (ȗ͑S)
+*   --sizes list    ̐J}؂ (ȗ100,1000,10000,100000,1000000)
+*   --threads list  Xbh̐J}؂ (ȗ1ƌvZ@̃Xbh)
+*                   collision, init͕񉻂ĂȂ̂1Xbhő
+*   --time s        1̏JԂđ鎞Ԃ̉ (ȗ0.5)
+*   --limit s       1̎Ԃ𒴂ƌ܂͑Ȃ (ȗ10)
+*                   ̈̐̌ʂ, ڑa͐̐2, ̑͂ق1Ōς
+*   --dt dt         rk4, euler, collisionɓnݕ (ȗ0.001)
+*   --seed n        l̗̎ (ȗ1)
+*   --output f      JSONf֏o (ȗ͕Wo)
+*   --baseline f    OɏoJSONƔׂ. xȂΏIR[h1ɂ
+*   --tolerance r   xƂ݂ȂԂ̔̒ߕ (ȗ0.1)
+*   --theta , --order n, --fmm p, --precision p  x̌vZ@ (gravity3dƓ)
+* ̎ʂ͑S1/N, d͒萔1. 2ł̃v}[3ōʒuƑxxyʂ֎ˉe.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define BENCH_LIST 16       // maximum entries of a comma separated option
+
+// processes to measure, in the order of --kernels
+#define BENCH_FORCE 0
+#define BENCH_RK4 1
+#define BENCH_EULER 2
+#define BENCH_COLLISION 3
+#define BENCH_INIT 4
+#define BENCH_KERNELS 5
+
+// synthetic initial conditions
+#define MODEL_UNIFORM 0
+#define MODEL_PLUMMER 1
+#define MODEL_DISK 2
+#define MODEL_COUNT 3
+
+static const char *KERNEL_NAMES[BENCH_KERNELS] = { "force", "rk4", "euler", "collision", "init" };
+static const char *MODEL_NAMES[MODEL_COUNT] = { "uniform", "plummer", "disk" };
+
+/**
+* x`}[N̐ݒ
+*/
+struct BenchOptions {
+    int kernels[BENCH_KERNELS];
+    int kernel_count;
+    int models[MODEL_COUNT];
+    int model_count;
+    long sizes[BENCH_LIST];
+    int size_count;
+    int threads[BENCH_LIST];
+    int thread_count;
+    double min_time;    // measure each case at least this long in seconds
+    double limit;       // skip a case expected to take longer than this per call
+    double dt;
+    unsigned long long seed;
+    const char *output; // NULL for stdout
+    const char *baseline; // JSON written before, NULL for no comparison
+    double tolerance;
+    double theta;       // opening angle of Barnes-Hut, < 0 for direct summation
+    int order;
+    int fmm_order;      // expansion order of FMM, 0 for Barnes-Hut or direct summation
+    int precision;      // FORCE_PRECISION_*
+};
+
+/**
+* 1̏̌
+*/
+struct BenchResult {
+    int kernel;
+    int model;
+    long n;
+    int threads;
+    long calls;
+    double seconds;
+    double ns;          // nanoseconds per call
+    double interactions; // pairwise interactions per call, 0 unless direct summation
+    size_t memory;      // bytes of the star and workspace arrays
+};
+
+/**
+* JSONǂ1̏
+*/
+struct BaselineEntry {
+    char kernel[16];
+    char model[16];
+    long n;
+    int threads;
+    double ns;
+};
+
+/**
+* @fn oߎԂbŕԂ.
+*/
+static double wall_time(void) {
+#ifdef _WIN32
+    return GetTickCount64() / 1000.0;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+* @fn l闐 (xorshift64*). ɂ炸Ԃ
+* @return [0, 1) ̈l
+*/
+static double next_random(unsigned long long *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return ( ( *state * 2685821657736338717ULL ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+/**
+* @fn Pʋ (2ł͒Pʉ~) ̓̈lȓ_I.
+*/
+static void random_in_ball(unsigned long long *state, struct GRAVITY_VECTOR *p) {
+#define RANDOM_AXIS(X) p->X = 2 * next_random(state) - 1;
+    do {
+        FOR_AXES(RANDOM_AXIS)
+    } while ( dot_vector(p, p) > 1 );
+#undef RANDOM_AXIS
+}
+
+/**
+* @fn 3̒Pʋʏ̈lȓ_I. 2ł͂̎ˉeg
+*/
+static void random_direction(unsigned long long *state, double *dx, double *dy, double *dz) {
+    const double c = 2 * next_random(state) - 1;
+    const double s = sqrt(1 - c * c);
+    const double phi = 2 * 3.14159265358979323846 * next_random(state);
+    *dx = s * cos(phi);
+    *dy = s * sin(phi);
+    *dz = c;
+}
+
+/**
+* @fn lŐ̏W.
+* @param model MODEL_*
+*         uniform : a1̈lȋ, x͔a0.5̋̒ňl
+*         plummer : XP[1̃v}[ (Aarseth, Henon, Wielen 1974 ̕@), a20O͑Iђ
+*         disk    : a1ŖʖxaɔႷ~ (Mestel~), ]ȐȂ̂őSĂ̐1ŉ~^
+*                   3ł͌0.05
+* @return ̐ mۂɎsƂ0
+*/
+static int make_model(const int model, const int size, const unsigned long long seed, struct Stars *stars) {
+    unsigned long long state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    if ( !allocate_stars(size, stars) ) {
+        return 0;
+    }
+    for ( int i = 0; i < size; i++ ) {
+        struct GRAVITY_VECTOR p = { 0 }, v = { 0 };
+        if ( model == MODEL_PLUMMER ) {
+            double r, q, y, speed, dx, dy, dz;
+            do {
+                r = 1 / sqrt(pow(next_random(&state) * 0.999999 + 1e-9, -2.0 / 3.0) - 1);
+            } while ( r > 20 );
+            //the speed from the distribution function by rejection
+            do {
+                q = next_random(&state);
+                y = next_random(&state);
+            } while ( 0.1 * y > q * q * pow(1 - q * q, 3.5) );
+            speed = q * sqrt(2.0) * pow(1 + r * r, -0.25);
+            random_direction(&state, &dx, &dy, &dz);
+            p.x = r * dx;
+            p.y = r * dy;
+#if GRAVITY_DIM == 3
+            p.z = r * dz;
+#endif
+            random_direction(&state, &dx, &dy, &dz);
+            v.x = speed * dx;
+            v.y = speed * dy;
+#if GRAVITY_DIM == 3
+            v.z = speed * dz;
+#endif
+        } else if ( model == MODEL_DISK ) {
+            const double r = next_random(&state);
+            const double phi = 2 * 3.14159265358979323846 * next_random(&state);
+            p.x = r * cos(phi);
+            p.y = r * sin(phi);
+            v.x = -sin(phi);
+            v.y = cos(phi);
+#if GRAVITY_DIM == 3
+            p.z = 0.05 * ( next_random(&state) - 0.5 );
+#endif
+        } else {
+            random_in_ball(&state, &p);
+            random_in_ball(&state, &v);
+            mul_vector(&v, 0.5);
+        }
+        stars->m[i] = 1.0 / size;
+#define MODEL_STATE(X) stars->X[i] = p.X; stars->pre_##X[i] = p.X; stars->v##X[i] = v.X;
+        FOR_AXES(MODEL_STATE)
+#undef MODEL_STATE
+    }
+    return size;
+}
+
+/**
+* @fn ̏Wf[^t@Č`ŏo. init̓͂Ɏg
+*/
+static void write_text(FILE *out, const int size, struct Stars const *stars) {
+    fprintf(out, "%d\n", size);
+    for ( int i = 0; i < size; i++ ) {
+#if GRAVITY_DIM == 3
+        fprintf(out, "%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+            stars->m[i], stars->x[i], stars->y[i], stars->z[i], stars->vx[i], stars->vy[i], stars->vz[i]);
+#else
+        fprintf(out, "%.17g,%.17g,%.17g,%.17g,%.17g\n", stars->m[i], stars->x[i], stars->y[i], stars->vx[i], stars->vy[i]);
+#endif
+    }
+}
+
+/**
+* @fn ÕJ}؂̕тԍ̕тɂ.
+* @return ǂ񂾐 mȂOƂ-1
+*/
+static int parse_names(const char *text, const char **names, const int count, int *values) {
+    int n = 0;
+    while ( *text != '\0' ) {
+        const char *end = strchr(text, ',');
+        const size_t length = end != NULL ? ( size_t )( end - text ) : strlen(text);
+        int k;
+        for ( k = 0; k < count; k++ ) {
+            if ( strlen(names[k]) == length && strncmp(names[k], text, length) == 0 ) {
+                break;
+            }
+        }
+        if ( k == count || n == count ) {
+            return -1;
+        }
+        values[n++] = k;
+        text += length;
+        if ( *text == ',' ) {
+            text++;
+        }
+    }
+    return n;
+}
+
+/**
+* @fn ̐̃J}؂̕тǂ.
+* @return ǂ񂾐 肪Ƃ-1
+*/
+static int parse_numbers(const char *text, long *values) {
+    int n = 0;
+    while ( *text != '\0' ) {
+        char *end;
+        const long value = strtol(text, &end, 10);
+        if ( end == text || value <= 0 || n == BENCH_LIST || ( *end != ',' && *end != '\0' ) ) {
+            return -1;
+        }
+        values[n++] = value;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+/**
+* @fn R}hCǂݍ.
+* @return ǂ߂Ƃ1 肪Ƃ0
+*/
+static int parse_options(int argc, char **argv, struct BenchOptions *options) {
+    static const long SIZES[] = { 100, 1000, 10000, 100000, 1000000 };
+    long list[BENCH_LIST];
+    int i, k;
+    options->kernel_count = BENCH_KERNELS;
+    for ( k = 0; k < BENCH_KERNELS; k++ ) {
+        options->kernels[k] = k;
+    }
+    options->model_count = MODEL_COUNT;
+    for ( k = 0; k < MODEL_COUNT; k++ ) {
+        options->models[k] = k;
+    }
+    options->size_count = sizeof(SIZES) / sizeof(SIZES[0]);
+    for ( k = 0; k < options->size_count; k++ ) {
+        options->sizes[k] = SIZES[k];
+    }
+    options->threads[0] = 1;
+    options->thread_count = 1;
+    if ( hardware_threads() > 1 ) {
+        options->threads[options->thread_count++] = hardware_threads();
+    }
+    options->min_time = 0.5;
+    options->limit = 10;
+    options->dt = 0.001;
+    options->seed = 1;
+    options->output = NULL;
+    options->baseline = NULL;
+    options->tolerance = 0.1;
+    options->theta = -1;
+    options->order = TREE_QUADRUPOLE;
+    options->fmm_order = 0;
+    options->precision = FORCE_PRECISION_DOUBLE;
+    for ( i = 1; i < argc; i++ ) {
+        if ( i + 1 >= argc ) {
+            fprintf(stderr, "error: option %s needs a value.\n", argv[i]);
+            return 0;
+        } else if ( strcmp(argv[i], "--kernels") == 0 ) {
+            options->kernel_count = parse_names(argv[++i], KERNEL_NAMES, BENCH_KERNELS, options->kernels);
+            if ( options->kernel_count <= 0 ) {
+                fprintf(stderr, "error: unknown kernel in %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--models") == 0 ) {
+            options->model_count = parse_names(argv[++i], MODEL_NAMES, MODEL_COUNT, options->models);
+            if ( options->model_count <= 0 ) {
+                fprintf(stderr, "error: unknown model in %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--sizes") == 0 ) {
+            options->size_count = parse_numbers(argv[++i], options->sizes);
+            if ( options->size_count <= 0 ) {
+                fprintf(stderr, "error: bad sizes %s.\n", argv[i]);
+                return 0;
+            }
+        } else if ( strcmp(argv[i], "--threads") == 0 ) {
+            options->thread_count = parse_numbers(argv[++i], list);
+            if ( options->thread_count <= 0 ) {
+                fprintf(stderr, "error: bad thread counts %s.\n", argv[i]);
+                return 0;
+            }
+            for ( k = 0; k < options->thread_count; k++ ) {
+                options->threads[k] = ( int )list[k];
+            }
+        } else if ( strcmp(argv[i], "--time") == 0 ) {
+            options->min_time = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--limit") == 0 ) {
+            options->limit = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--dt") == 0 ) {
+            options->dt = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--seed") == 0 ) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if ( strcmp(argv[i], "--output") == 0 ) {
+            options->output = argv[++i];
+        } else if ( strcmp(argv[i], "--baseline") == 0 ) {
+            options->baseline = argv[++i];
+        } else if ( strcmp(argv[i], "--tolerance") == 0 ) {
+            options->tolerance = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--theta") == 0 ) {
+            options->theta = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--order") == 0 ) {
+            options->order = atoi(argv[++i]) >= TREE_QUADRUPOLE ? TREE_QUADRUPOLE : TREE_MONOPOLE;
+#if GRAVITY_DIM == 3
+        } else if ( strcmp(argv[i], "--fmm") == 0 ) {
+            options->fmm_order = atoi(argv[++i]);
+#endif
+        } else if ( strcmp(argv[i], "--precision") == 0 ) {
+            ++i;
+            if ( strcmp(argv[i], "double") == 0 ) {
+                options->precision = FORCE_PRECISION_DOUBLE;
+            } else if ( strcmp(argv[i], "mixed") == 0 ) {
+                options->precision = FORCE_PRECISION_MIXED;
+            } else {
+                fprintf(stderr, "error: unknown precision %s.\n", argv[i]);
+                return 0;
+            }
+        } else {
+            fprintf(stderr, "error: unknown option %s.\n", argv[i]);
+            return 0;
+        }
+    }
+    if ( options->min_time < 0 || options->limit <= 0 || !( options->dt > 0 ) || options->tolerance < 0 ) {
+        fprintf(stderr, "error: --time, --limit, --dt and --tolerance must be positive.\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+* @fn x̌vZ@̖OԂ.
+*/
+static const char* engine_name(struct BenchOptions const *options) {
+    if ( options->fmm_order > 0 ) {
+        return "fmm";
+    }
+    return options->theta >= 0 ? "tree" : "direct";
+}
+
+/**
+* @fn 鏈1Ă.
+* @param sweep collisionŎg񂷑|̍Ɨ̈
+* @param text initœǂރf[^t@C
+* @return ̌̐̐ sƂ0
+*/
+static int call_kernel(struct BenchOptions const *options, const int kernel, const int size, struct Stars *stars, struct Workspace *work,
+    struct Sweep *sweep, FILE *text) {
+    struct Stars loaded;
+    int read;
+    switch ( kernel ) {
+    case BENCH_FORCE:
+        accelerations(size, stars, work);
+        return size;
+    case BENCH_RK4:
+        runge_kutta(size, options->dt, stars, work);
+        return size;
+    case BENCH_EULER:
+        euler(size, options->dt, stars, work);
+        return size;
+    case BENCH_COLLISION:
+        return collision_excluding(size, options->dt, stars, NULL, NULL, sweep);
+    default:
+        rewind(text);
+        read = initialize_stars(text, &loaded);
+        free_stars(&loaded);
+        return read == size ? size : 0;
+    }
+}
+
+/**
+* @fn 1̏𑪂.
+* @detail ŏ1̓LbVƃXbh߂邽߂ɌĂ, Ȃ.
+*         ͍̌킹options->min_timeb𒴂܂ŌJԂ
+* @return Ƃ1 mۂȂǂɎsƂ0
+*/
+static int run_case(struct BenchOptions const *options, const int kernel, const int model, const int n, const int threads,
+    struct BenchResult *result) {
+    struct Stars stars;
+    struct Workspace work;
+    struct Sweep sweep = { 0 };
+    struct Tree tree;
+#if GRAVITY_DIM == 3
+    struct Fmm fmm;
+#endif
+    FILE *text = NULL;
+    const size_t line = STARS_ALIGNMENT / sizeof(double);
+    const size_t stride = ( ( size_t )n + line - 1 ) / line * line;
+    int size = make_model(model, n, options->seed, &stars);
+    double start, elapsed = 0;
+    long calls = 0;
+    if ( size <= 0 ) {
+        return 0;
+    }
+    if ( !allocate_workspace(size, &work) ) {
+        free_stars(&stars);
+        return 0;
+    }
+    work.pool = threads > 1 ? create_pool(threads) : NULL;
+    if ( options->fmm_order > 0 ) {
+#if GRAVITY_DIM == 3
+        if ( allocate_fmm(size, options->theta >= 0 ? options->theta : 0.5, options->fmm_order, &fmm) ) {
+            work.fmm = &fmm;
+        }
+#endif
+    } else if ( options->theta >= 0 && allocate_tree(size, options->theta, options->order, &tree) ) {
+        work.tree = &tree;
+    }
+    if ( kernel == BENCH_COLLISION ) {
+        //as a stepper reuses it every step
+        allocate_sweep(size, &sweep);
+    }
+    if ( kernel == BENCH_INIT ) {
+        text = tmpfile();
+        if ( text == NULL ) {
+            fprintf(stderr, "error: cannot create a temporary file.\n");
+            size = 0;
+        } else {
+            write_text(text, size, &stars);
+        }
+    }
+    if ( size > 0 ) {
+        size = call_kernel(options, kernel, size, &stars, &work, &sweep, text);
+    }
+    start = wall_time();
+    while ( size > 0 && ( calls == 0 || elapsed < options->min_time ) ) {
+        size = call_kernel(options, kernel, size, &stars, &work, &sweep, text);
+        calls++;
+        elapsed = wall_time() - start;
+    }
+    if ( text != NULL ) {
+        fclose(text);
+    }
+    if ( size > 0 ) {
+        //direct summation evaluates every ordered pair once per force evaluation
+        const double pairs = ( double )size * ( size - 1 );
+        result->kernel = kernel;
+        result->model = model;
+        result->n = n;
+        result->threads = threads;
+        result->calls = calls;
+        result->seconds = elapsed;
+        result->ns = elapsed / calls * 1e9;
+        result->interactions = 0;
+        if ( options->theta < 0 && options->fmm_order <= 0 ) {
+            result->interactions = kernel == BENCH_FORCE || kernel == BENCH_EULER ? pairs : kernel == BENCH_RK4 ? 4 * pairs : 0;
+        }
+        //stars and the integration workspace
+        result->memory = ( 1 + GRAVITY_DIM * 3 + GRAVITY_DIM * 9 + 1 ) * stride * sizeof(double);
+    }
+    destroy_pool(work.pool);
+    if ( work.tree != NULL ) {
+        free_tree(&tree);
+    }
+#if GRAVITY_DIM == 3
+    if ( work.fmm != NULL ) {
+        free_fmm(&fmm);
+    }
+#endif
+    free_sweep(&sweep);
+    free_workspace(&work);
+    free_stars(&stars);
+    return size > 0;
+}
+
+/**
+* @fn JSON1slo. ̃vOo1s1̏̌`ǂ
+* @return Ƃ1
+*/
+static int json_field(const char *line, const char *key, char *value, const size_t length) {
+    char pattern[64];
+    const char *p;
+    size_t n = 0;
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    p = strstr(line, pattern);
+    if ( p == NULL ) {
+        return 0;
+    }
+    p += strlen(pattern);
+    while ( *p == ' ' || *p == '"' ) {
+        p++;
+    }
+    while ( *p != '\0' && *p != '"' && *p != ',' && *p != '}' && n + 1 < length ) {
+        value[n++] = *p++;
+    }
+    value[n] = '\0';
+    return n > 0;
+}
+
+/**
+* @fn JSONǂ.
+* @param count ǂ񂾏̐
+* @return ǂ񂾏̔z Ăяoŉ. ǂ߂ȂƂNULL
+*/
+static struct BaselineEntry* read_baseline(const char *path, int *count) {
+    FILE *in = fopen(path, "r");
+    struct BaselineEntry *entries = NULL;
+    int capacity = 0;
+    char line[1024], value[64];
+    *count = 0;
+    if ( in == NULL ) {
+        return NULL;
+    }
+    while ( fgets(line, sizeof(line), in) != NULL ) {
+        struct BaselineEntry entry;
+        if ( !json_field(line, "kernel", entry.kernel, sizeof(entry.kernel))
+            || !json_field(line, "model", entry.model, sizeof(entry.model)) ) {
+            continue;
+        }
+        if ( !json_field(line, "n", value, sizeof(value)) ) {
+            continue;
+        }
+        entry.n = atol(value);
+        if ( !json_field(line, "threads", value, sizeof(value)) ) {
+            continue;
+        }
+        entry.threads = atoi(value);
+        if ( !json_field(line, "ns_per_step", value, sizeof(value)) ) {
+            continue;
+        }
+        entry.ns = atof(value);
+        if ( *count == capacity ) {
+            struct BaselineEntry *grown;
+            capacity = capacity > 0 ? capacity * 2 : 64;
+            grown = ( struct BaselineEntry * )realloc(entries, sizeof(struct BaselineEntry) * capacity);
+            if ( grown == NULL ) {
+                break;
+            }
+            entries = grown;
+        }
+        entries[( *count )++] = entry;
+    }
+    fclose(in);
+    return entries;
+}
+
+/**
+* @fn 瓯T.
+* @return ȂƂNULL
+*/
+static struct BaselineEntry const* find_baseline(struct BaselineEntry const *entries, const int count, struct BenchResult const *result) {
+    for ( int i = 0; i < count; i++ ) {
+        if ( strcmp(entries[i].kernel, KERNEL_NAMES[result->kernel]) == 0 && strcmp(entries[i].model, MODEL_NAMES[result->model]) == 0
+            && entries[i].n == result->n && entries[i].threads == result->threads ) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+* @fn vZX̍ő̏풓oCgŕԂ. ȂƂ0
+*/
+static long long peak_memory(void) {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if ( getrusage(RUSAGE_SELF, &usage) != 0 ) {
+        return 0;
+    }
+    //kilobytes on Linux
+    return ( long long )usage.ru_maxrss * 1024;
+#endif
+}
+
+int main(int argc, char **argv) {
+    struct BenchOptions options;
+    struct BaselineEntry *baseline = NULL;
+    int baseline_count = 0;
+    int regressions = 0, first = 1;
+    FILE *out = stdout;
+
+    if ( !parse_options(argc, argv, &options) ) {
+        fprintf(stderr, "usage: %s [--kernels force,rk4,euler,collision,init] [--models uniform,plummer,disk] [--sizes n,...] [--threads n,...]"
+            " [--time s] [--limit s] [--dt dt] [--seed n] [--output file] [--baseline file] [--tolerance r]"
+            " [--theta theta] [--order n]%s [--precision double|mixed]\n", argv[0], GRAVITY_DIM == 3 ? " [--fmm p]" : "");
+        return 2;
+    }
+    if ( options.baseline != NULL ) {
+        baseline = read_baseline(options.baseline, &baseline_count);
+        if ( baseline_count == 0 ) {
+            fprintf(stderr, "error: no results in %s.\n", options.baseline);
+            free(baseline);
+            return 2;
+        }
+    }
+    if ( options.output != NULL ) {
+        out = fopen(options.output, "w");
+        if ( out == NULL ) {
+            fprintf(stderr, "error: cannot open %s.\n", options.output);
+            free(baseline);
+            return 2;
+        }
+    }
+    set_force_precision(options.precision);
+    fprintf(out, "{\n\"benchmark\": \"%s\",\n\"dimension\": %d,\n\"simd\": \"%s\",\n\"precision\": \"%s\",\n",
+        BENCH_NAME, GRAVITY_DIM, force_kernel_name(get_force_kernel()), force_precision_name(options.precision));
+    fprintf(out, "\"engine\": \"%s\",\n\"theta\": %g,\n\"order\": %d,\n\"fmm\": %d,\n\"hardware_threads\": %d,\n\"seed\": %llu,\n\"dt\": %g,\n\"timestamp\": %lld,\n",
+        engine_name(&options), options.theta, options.order, options.fmm_order, hardware_threads(), options.seed, options.dt, ( long long )time(NULL));
+    fprintf(out, "\"results\": [\n");
+    for ( int k = 0; k < options.kernel_count; k++ ) {
+        const int kernel = options.kernels[k];
+        //collision and reading a data file run on one thread
+        const int serial = kernel == BENCH_COLLISION || kernel == BENCH_INIT;
+        const int thread_count = serial ? 1 : options.thread_count;
+        for ( int m = 0; m < options.model_count; m++ ) {
+            for ( int t = 0; t < thread_count; t++ ) {
+                const int threads = serial ? 1 : options.threads[t];
+                double previous_ns = 0;
+                long previous_n = 0;
+                for ( int s = 0; s < options.size_count; s++ ) {
+                    const long n = options.sizes[s];
+                    struct BenchResult result = { 0 };
+                    struct BaselineEntry const *base;
+                    if ( previous_n > 0 ) {
+                        //the cost grows as n^2 for direct summation and roughly as n otherwise
+                        const int quadratic = ( kernel == BENCH_FORCE || kernel == BENCH_RK4 || kernel == BENCH_EULER )
+                            && options.theta < 0 && options.fmm_order <= 0;
+                        const double ratio = ( double )n / previous_n;
+                        const double estimate = previous_ns * 1e-9 * ( quadratic ? ratio * ratio : ratio * log(( double )n) / log(( double )previous_n) );
+                        if ( estimate > options.limit ) {
+                            fprintf(stderr, "skip %s %s n=%ld threads=%d : estimated %.3g s per call\n",
+                                KERNEL_NAMES[kernel], MODEL_NAMES[options.models[m]], n, threads, estimate);
+                            break;
+                        }
+                    }
+                    if ( n > 0x7fffffffL || !run_case(&options, kernel, options.models[m], ( int )n, threads, &result) ) {
+                        fprintf(stderr, "error: cannot run %s %s n=%ld.\n", KERNEL_NAMES[kernel], MODEL_NAMES[options.models[m]], n);
+                        break;
+                    }
+                    previous_ns = result.ns;
+                    previous_n = n;
+                    fprintf(out, "%s{\"kernel\": \"%s\", \"model\": \"%s\", \"n\": %ld, \"threads\": %d, \"calls\": %ld, \"seconds\": %.6g, \"ns_per_step\": %.6g,"
+                        " \"interactions_per_s\": %.6g, \"memory_bytes\": %zu",
+                        first ? "" : ",\n", KERNEL_NAMES[kernel], MODEL_NAMES[result.model], result.n, result.threads, result.calls, result.seconds, result.ns,
+                        result.interactions / result.ns * 1e9, result.memory);
+                    first = 0;
+                    base = baseline != NULL ? find_baseline(baseline, baseline_count, &result) : NULL;
+                    if ( base != NULL && base->ns > 0 ) {
+                        const double ratio = result.ns / base->ns;
+                        const int slower = ratio > 1 + options.tolerance;
+                        fprintf(out, ", \"baseline_ns_per_step\": %.6g, \"ratio\": %.4g, \"regression\": %s", base->ns, ratio, slower ? "true" : "false");
+                        fprintf(stderr, "%-9s %-7s n=%-7ld threads=%-2d %12.6g ns -> %12.6g ns (%.3fx)%s\n", KERNEL_NAMES[kernel], MODEL_NAMES[result.model],
+                            result.n, result.threads, base->ns, result.ns, ratio, slower ? " REGRESSION" : "");
+                        regressions += slower;
+                    } else {
+                        fprintf(stderr, "%-9s %-7s n=%-7ld threads=%-2d %12.6g ns per call\n", KERNEL_NAMES[kernel], MODEL_NAMES[result.model],
+                            result.n, result.threads, result.ns);
+                    }
+                    fprintf(out, "}");
+                    fflush(out);
+                }
+            }
+        }
+    }
+    fprintf(out, "\n],\n\"peak_memory_bytes\": %lld,\n\"regressions\": %d\n}\n", peak_memory(), regressions);
+    if ( out != stdout ) {
+        fclose(out);
+    }
+    free(baseline);
+    if ( baseline != NULL ) {
+        fprintf(stderr, "%d regressions over %.0f%%\n", regressions, options.tolerance * 100);
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/**
+* @brief ۑʂ̐ff
+* 2ł3ł̋ʕ diagnostics1.c  diagnostics3.c ꂼ diagnostics*.h ̌ɃCN[h
+* @detail
+* ^GlM[, ^, p^, dS͐Ƃ̘aȂ̂O(N)ŋ߂.
+* ʒuGlM[O(N^2)̑g̘aȂ̂ŕʂɌvZ, xƓǧvZŃ|eV߂Ă炤
+* (Ɨ̈potential1ɂĂaccelerationsĂ. stepper_potentialϕ@ɍ킹čs).
+* |eV͉xƓ@ŋ߂̂, ؂⍂dɖ@ł͉xƓx̋ߎɂȂ.
+* SďՓ˂ō̂̐̏Wɂċ߂. ̂ł͉^GlM[̂, ̂̌̓GlM[ۑȂ.
+*/
+#include <math.h>
+#include <stdio.h>
+
+/**
+* @fn ^GlM[, ^, p^ʂƏdS߂.
+* @param step,time ̃XebvƎ
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param diag ߂l. ʒuGlM[add_potentialŉ܂0
+*/
+void measure_state(const long step, const double time, const int size, struct Stars const *stars, struct Diagnostics *diag) {
+    int i;
+    diag->step = step;
+    diag->time = time;
+    diag->size = size;
+    diag->mass = 0;
+    diag->kinetic = 0;
+    diag->potential = 0;
+    diag->energy = 0;
+#define CLEAR(X) diag->momentum.X = 0; diag->center.X = 0;
+    FOR_AXES(CLEAR)
+#undef CLEAR
+#if GRAVITY_DIM == 3
+    diag->angular.x = 0;
+    diag->angular.y = 0;
+    diag->angular.z = 0;
+#else
+    diag->angular = 0;
+#endif
+#define SPEED2(X) stars->v##X[i] * stars->v##X[i]
+#define MOMENTUM(X) diag->momentum.X += m * stars->v##X[i]; diag->center.X += m * stars->X[i];
+    for ( i = 0; i < size; i++ ) {
+        const double m = stars->m[i];
+        diag->mass += m;
+        diag->kinetic += 0.5 * m * SUM_AXES(SPEED2);
+        FOR_AXES(MOMENTUM)
+        //L =  m r ~ v
+#if GRAVITY_DIM == 3
+        diag->angular.x += m * ( stars->y[i] * stars->vz[i] - stars->z[i] * stars->vy[i] );
+        diag->angular.y += m * ( stars->z[i] * stars->vx[i] - stars->x[i] * stars->vz[i] );
+        diag->angular.z += m * ( stars->x[i] * stars->vy[i] - stars->y[i] * stars->vx[i] );
+#else
+        diag->angular += m * ( stars->x[i] * stars->vy[i] - stars->y[i] * stars->vx[i] );
+#endif
+    }
+#undef SPEED2
+#undef MOMENTUM
+#define CENTER(X) diag->center.X /= diag->mass;
+    if ( diag->mass > 0 ) {
+        FOR_AXES(CENTER)
+    }
+#undef CENTER
+    diag->energy = diag->kinetic;
+    diag->pending = 1;
+}
+
+/**
+* @fn xƓɋ߂|eVʒuGlM[.
+* @param phi Ƃ̃|eV G  m_j / r_ij. measure_stateƓԂŋ߂
+*/
+void add_potential(const int size, struct Stars const *stars, double const *phi, struct Diagnostics *diag) {
+    double sum = 0;
+    int i;
+    for ( i = 0; i < size; i++ ) {
+        sum += stars->m[i] * phi[i];
+    }
+    //each pair appears twice in the sum
+    diag->potential = -0.5 * sum;
+    diag->energy = diag->kinetic + diag->potential;
+    diag->pending = 0;
+}
+
+/**
+* @fn ff̒lsŏo.
+* @param initial ׂŏ̒l GlM[͑Ό덷, ^ʂƊp^ʂ͍̑傫
+* @detail  diag step=... t=... ̂悤ɖO=l󔒂ŋ؂
+*/
+void write_diagnostics(FILE *out, struct Diagnostics const *diag, struct Diagnostics const *initial) {
+    struct GRAVITY_VECTOR dp = diag->momentum;
+#if GRAVITY_DIM == 3
+    struct Vector3 dl = diag->angular;
+    const double l = sqrt(dot_vector(&diag->angular, &diag->angular));
+    sub_vector(&dl, &initial->angular);
+    const double dL = sqrt(dot_vector(&dl, &dl));
+#else
+    const double l = diag->angular;
+    const double dL = fabs(diag->angular - initial->angular);
+#endif
+    sub_vector(&dp, &initial->momentum);
+    fprintf(out, "diag step=%ld t=%.10g n=%d M=%.10g K=%.10g W=%.10g E=%.10g dE=%.3e P=%.3e dP=%.3e L=%.10g dL=%.3e\n",
+        diag->step, diag->time, diag->size, diag->mass, diag->kinetic, diag->potential, diag->energy,
+        initial->energy != 0 ? ( diag->energy - initial->energy ) / fabs(initial->energy) : 0.0,
+        sqrt(dot_vector(&diag->momentum, &diag->momentum)), sqrt(dot_vector(&dp, &dp)), l, dL);
+}
+
+/**
+* @fn L^̂sŏo, L^ɂ.
+* @param step,time ̂𔻒肵XebvƎ
+*/
+void write_merges(FILE *out, const long step, const double time, struct MergeLog *log) {
+    int k;
+    for ( k = 0; k < log->count; k++ ) {
+        struct MergeEvent const *e = &log->events[k];
+#if GRAVITY_DIM == 3
+        fprintf(out, "merge step=%ld t=%.10g i=%d j=%d mi=%.10g mj=%.10g x=%.10g y=%.10g z=%.10g v=%.10g\n",
+            step, time, e->i, e->j, e->mi, e->mj, e->position.x, e->position.y, e->position.z, e->speed);
+#else
+        fprintf(out, "merge step=%ld t=%.10g i=%d j=%d mi=%.10g mj=%.10g x=%.10g y=%.10g v=%.10g\n",
+            step, time, e->i, e->j, e->mi, e->mj, e->position.x, e->position.y, e->speed);
+#endif
+    }
+    log->count = 0;
+}
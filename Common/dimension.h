@@ -0,0 +1,80 @@
+/**
+* @brief 2ł3łŋL鎟̒`
+* @detail
+* CN[hOGRAVITY_DIM2܂3ɒ`.
+* ̏W͐ƂɖO̕tʁX̔z (x, y, z, vx, ...) ̂, Ƃ̏
+* FOR_AXESȂǂ̃}Nɐ̖OnĎׂ̐. [vł͂Ȃ̂ŕKRpCɓWJ,
+* 2łł z ̏Ռ`Ȃ.
+* GRAVITY_REAL̓xNg̐̌^, `Ȃdouble. ̏W̔z̓t@Č`ɍ킹ďdouble
+*/
+#pragma once
+#include <math.h>
+
+#if !defined(GRAVITY_DIM) || ( GRAVITY_DIM != 2 && GRAVITY_DIM != 3 )
+#error GRAVITY_DIM must be 2 or 3
+#endif
+
+#ifndef GRAVITY_REAL
+#define GRAVITY_REAL double
+#endif
+
+#ifdef _MSC_VER
+#define GRAVITY_INLINE static __inline
+#else
+#define GRAVITY_INLINE static inline
+#endif
+
+// FOR_AXES(X)       X(x) X(y) X(z)       repeats a statement for each axis
+// SUM_AXES(X)       ( X(x) + X(y) + X(z) ), added in this order
+// ANY_CROSS_AXES(X) ( X(y) || X(z) ), the axes other than x along which collision sweeps
+#if GRAVITY_DIM == 3
+#define FOR_AXES(X) X(x) X(y) X(z)
+#define SUM_AXES(X) ( X(x) + X(y) + X(z) )
+#define ANY_CROSS_AXES(X) ( X(y) || X(z) )
+#define GRAVITY_VECTOR Vector3
+#else
+#define FOR_AXES(X) X(x) X(y)
+#define SUM_AXES(X) ( X(x) + X(y) )
+#define ANY_CROSS_AXES(X) ( X(y) )
+#define GRAVITY_VECTOR Vector2
+#endif
+
+#define VECTOR_MEMBER(X) GRAVITY_REAL X;
+struct GRAVITY_VECTOR {
+    FOR_AXES(VECTOR_MEMBER)
+};
+#undef VECTOR_MEMBER
+
+#define VECTOR_DOT(X) v1->X * v2->X
+GRAVITY_INLINE GRAVITY_REAL dot_vector(struct GRAVITY_VECTOR const* v1, struct GRAVITY_VECTOR const* v2) {
+    return SUM_AXES(VECTOR_DOT);
+}
+#undef VECTOR_DOT
+
+#define VECTOR_GAP(X) ( v1->X - v2->X ) * ( v1->X - v2->X )
+GRAVITY_INLINE GRAVITY_REAL distance_vector(struct GRAVITY_VECTOR const* v1, struct GRAVITY_VECTOR const* v2) {
+    return ( GRAVITY_REAL )sqrt(SUM_AXES(VECTOR_GAP));
+}
+#undef VECTOR_GAP
+
+#define VECTOR_MUL(X) vec->X *= val;
+GRAVITY_INLINE void mul_vector(struct GRAVITY_VECTOR* vec, GRAVITY_REAL const val) {
+    FOR_AXES(VECTOR_MUL)
+}
+#undef VECTOR_MUL
+
+#define VECTOR_SUB(X) v1->X -= v2->X;
+GRAVITY_INLINE void sub_vector(struct GRAVITY_VECTOR* v1, struct GRAVITY_VECTOR const* v2) {
+    FOR_AXES(VECTOR_SUB)
+}
+#undef VECTOR_SUB
+
+#define VECTOR_ADD(X) v1->X += v2->X;
+GRAVITY_INLINE void add_vector(struct GRAVITY_VECTOR* v1, struct GRAVITY_VECTOR const* v2) {
+    FOR_AXES(VECTOR_ADD)
+}
+#undef VECTOR_ADD
+
+GRAVITY_INLINE void copy_vector(struct GRAVITY_VECTOR* des, struct GRAVITY_VECTOR const* src) {
+    *des = *src;
+}
@@ -0,0 +1,1137 @@
+/**
+* @brief ̏W𕡐̃vZXɕČvZ̈敪 2ł3ł̋ʕ
+* @detail
+* domain1.c  domain3.c ꂼ domain*.h, force*.h, pool.h  mpi.h ̌ɃCN[h.
+* MPI̎v̂, make mpi ō bin/mpi2d, bin/mpi3d Ɋ܂߂.
+*
+* ̈ : ċA񕪊 (ORB). N͈̔͂𔼕ɕ邽т, ͈̔͂̐͂ޔ̍łɉ
+*        ̐̐N̐̔ɂȂʒu񕪖@ŒTĐ؂. ͑SĂ̐ؒf܂ĂxɈڂ.
+*    : x̌vẐтɊeN̐͂ޔ.
+*        ڑał͑SẴN̐̎ʂƈʒuW, ̐擪ɒu force*.c ̃J[lŋ߂.
+*        ؂ł͎̖̐؂𑊎̔ɑ΂Ăǂ, ̂ǂ猩ĂJȂĂ悢Z͏dSɒuʂƂ,
+*        JKv̂t̐͂̂܂ܑ (locally essential tree). 󂯎_̐̌ɉĖ؂,
+*        ̐̉x߂. Z͒PɎqȂ̂, ̃N̉̏d͂ɂ͎ldɎq̍Ȃ.
+* Փ : SĂ̐̑x̒S̑̍őlvƂ, Փ˂g 2 v dt ߂.
+*        ̃N̔炻̋ɂ鐯𑗂荇, N܂ŏՓ˂gT. ̂悤ȑg
+*        Փ˂głȂԍ̍ł̃NֈڂĂ, eNcollisionĂ.
+* N̒̐͏l̔ԍ̏ɕׂ̂, ̂Ŏc鐯̂̏Ԃ̃vZXŌvZꍇƓɂȂ.
+* J֐͑SẴNɌĂԂ (ŏWcʐMs).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DOMAIN_MARGIN 1.000001  // widens the reach of collisions against rounding errors
+#define DOMAIN_CHUNK 64         // stars per task of the parallel force evaluation, a multiple of 8
+#define DOMAIN_BISECTIONS 64    // iterations to place a cut of the recursive bisection
+#define DOMAIN_CHILDREN ( 1 << GRAVITY_DIM )    // children of a tree cell
+#define DOMAIN_STACK ( 64 * DOMAIN_CHILDREN )   // deeper than the deepest tree
+#define DOMAIN_BOX ( 2 * GRAVITY_DIM )          // values of a bounding box
+#define MIGRANT_WIDTH ( 2 + 2 * GRAVITY_DIM )   // id, mass, position and velocity of a star sent to another rank
+#define SOURCE_WIDTH ( 1 + GRAVITY_DIM )        // mass and position of a star or cell acting on another rank
+#define PAIR_WIDTH 4                            // id and rank of both stars of a colliding pair
+
+/**
+* ԍŕבւ鐯
+*/
+struct IdEntry {
+    long id;
+    int index;
+};
+
+/**
+* Փ˂̔ő|鐯. xWŕׂ
+*/
+struct DomainEntry {
+    double x;
+    int index;
+};
+
+/**
+* ɌvZx͈̔͂ɓnl
+*/
+struct DomainTask {
+    struct Domain *domain;
+    struct Workspace *work;
+    int size;           // local stars, whose acceleration is wanted
+    int total;          // local and imported stars
+    double *phi;        // potential to write as well, NULL if not wanted
+};
+
+/**
+* @fn ȂƂ͑SẴN~߂. ̃N͏WcʐMő҂܂܂ɂȂ邽
+*/
+static void domain_fail(struct Domain const *domain, const char *what) {
+    fprintf(stderr, "error: rank %d cannot allocate %s.\n", domain->rank, what);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+/**
+* @fn M̔zȂƂlength̒l悤ɐL΂.
+*/
+static double *reserve_buffer(struct Domain const *domain, double **buffer, size_t *capacity, const size_t length) {
+    if ( length > *capacity ) {
+        const size_t grown = *capacity * 2 > length ? *capacity * 2 : length;
+        double *larger = ( double * )realloc(*buffer, sizeof(double) * grown);
+        if ( larger == NULL ) {
+            domain_fail(domain, "buffers");
+        }
+        *buffer = larger;
+        *capacity = grown;
+    }
+    return *buffer;
+}
+
+/**
+* @fn ̏WȂƂsize̐悤ɐL΂. 擪count̐̒lp
+*/
+static void reserve_stars(const int count, const int size, struct Stars *stars, struct Domain const *domain) {
+    struct Stars larger;
+    const size_t length = sizeof(double) * count;
+    if ( size <= stars->capacity ) {
+        return;
+    }
+    if ( !allocate_stars(size + size / 2 + 16, &larger) ) {
+        domain_fail(domain, "stars");
+    }
+    memcpy(larger.m, stars->m, length);
+#define KEEP(X) \
+    memcpy(larger.X, stars->X, length); \
+    memcpy(larger.pre_##X, stars->pre_##X, length); \
+    memcpy(larger.v##X, stars->v##X, length);
+    FOR_AXES(KEEP)
+#undef KEEP
+    free_stars(stars);
+    *stars = larger;
+}
+
+/**
+* @fn ̐̏W, ԍƍƗ̈ȂƂsize̐悤ɐL΂.
+* @param work NULL̂ƂƗ̈͐L΂Ȃ
+*/
+static void reserve_local(const int count, const int size, struct Stars *stars, struct Workspace *work, struct Domain *domain) {
+    reserve_stars(count, size, stars, domain);
+    if ( stars->capacity > domain->capacity ) {
+        long *id = ( long * )realloc(domain->id, sizeof(long) * stars->capacity);
+        int *mark;
+        if ( id == NULL ) {
+            domain_fail(domain, "indices");
+        }
+        domain->id = id;
+        mark = ( int * )realloc(domain->mark, sizeof(int) * stars->capacity);
+        if ( mark == NULL ) {
+            domain_fail(domain, "indices");
+        }
+        domain->mark = mark;
+        domain->capacity = stars->capacity;
+    }
+    if ( work != NULL && stars->capacity > work->capacity ) {
+        struct Workspace larger;
+        //the arrays are only scratch between the steps, the settings are kept
+        if ( !allocate_workspace(stars->capacity, &larger) ) {
+            domain_fail(domain, "workspace");
+        }
+        larger.tree = work->tree;
+        larger.pool = work->pool;
+        larger.external = work->external;
+        larger.hook = work->hook;
+        larger.hook_context = work->hook_context;
+        larger.potential = work->potential;
+#if GRAVITY_DIM == 3
+        larger.fmm = work->fmm;
+#endif
+        free_workspace(work);
+        *work = larger;
+    }
+}
+
+/**
+* @fn ؂ȂƂsize̐ō悤Ɋmۂ.
+*/
+static void reserve_tree(const int size, struct Tree *tree, struct Domain const *domain) {
+    if ( size <= tree->capacity ) {
+        return;
+    }
+    free_tree(tree);
+    if ( !allocate_tree(size + size / 2 + 16, domain->theta, domain->order, tree) ) {
+        domain_fail(domain, "tree");
+    }
+}
+
+/**
+* @fn Փ˂̔̍Ɨ̈ȂƂsize̐|ł悤Ɋmۂ.
+* @detail mۂłȂƂcollision_excludinǧĂяo̊Ԃmۂ
+*/
+static void reserve_sweep(const int size, struct Sweep *sweep) {
+    if ( size <= sweep->capacity ) {
+        return;
+    }
+    free_sweep(sweep);
+    allocate_sweep(size + size / 2 + 16, sweep);
+}
+
+/**
+* @fn ̈敪̏Ԃ. MPI_IniťɌĂ
+* @param theta ؂̊Jp ̂Ƃڑa
+* @param order ؂̑dɓWJ̎
+* @param pool x̌vZɎgƃXbh NULL̂ƂĂяoXbhŌvZ
+* @return Ƃ1 sƂ0
+*/
+int init_domain(const double theta, const int order, struct ThreadPool *pool, struct Domain *domain) {
+    memset(domain, 0, sizeof(struct Domain));
+    MPI_Comm_rank(MPI_COMM_WORLD, &domain->rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &domain->ranks);
+    domain->theta = theta;
+    domain->order = order;
+    domain->pool = pool;
+    domain->box = ( double * )malloc(sizeof(double) * DOMAIN_BOX * domain->ranks);
+    domain->counts = ( int * )malloc(sizeof(int) * 4 * domain->ranks);
+    if ( domain->box == NULL || domain->counts == NULL ) {
+        free_domain(domain);
+        return 0;
+    }
+    return 1;
+}
+
+void free_domain(struct Domain *domain) {
+    free(domain->id);
+    free(domain->mark);
+    free(domain->box);
+    free(domain->counts);
+    free(domain->send);
+    free(domain->receive);
+    free_tree(&domain->local);
+    free_tree(&domain->tree);
+    free_stars(&domain->sources);
+    free_merge_log(&domain->merges);
+    free_sweep(&domain->sweep);
+    domain->id = NULL;
+    domain->mark = NULL;
+    domain->box = NULL;
+    domain->counts = NULL;
+    domain->send = NULL;
+    domain->receive = NULL;
+    domain->capacity = 0;
+}
+
+/**
+* @fn L^ɋl߂. ԍ, , ʒu, x̏
+* @return ̋L^
+*/
+static double *pack_migrant(double *record, const long id, const int i, struct Stars const *stars) {
+    //the indices stay exact in a double up to 2^53
+    *record++ = ( double )id;
+    *record++ = stars->m[i];
+#define PACK_POSITION(X) *record++ = stars->X[i];
+#define PACK_VELOCITY(X) *record++ = stars->v##X[i];
+    FOR_AXES(PACK_POSITION)
+    FOR_AXES(PACK_VELOCITY)
+#undef PACK_POSITION
+#undef PACK_VELOCITY
+    return record;
+}
+
+/**
+* @fn L^琯o.
+* @return ̔ԍ
+*/
+static long unpack_migrant(double const *record, const int i, struct Stars *stars) {
+    const long id = ( long )*record++;
+    stars->m[i] = *record++;
+#define UNPACK_POSITION(X) stars->X[i] = *record++;
+#define UNPACK_VELOCITY(X) stars->v##X[i] = *record++;
+    FOR_AXES(UNPACK_POSITION)
+    FOR_AXES(UNPACK_VELOCITY)
+#undef UNPACK_POSITION
+#undef UNPACK_VELOCITY
+    return id;
+}
+
+/**
+* @fn 悲Ƃɂ܂Ƃ߂L^𑗂, eN̋L^󂯎.
+* @param width ̋L^̒l̐
+* @return 󂯎L^̐
+* @detail 悲Ƃ̋L^̐counts[0..ranks)ɓ, L^̏send֋l߂Ă.
+*         󂯎L^receiveɑ茳̏ɕ, 茳Ƃ̒l̐ƈʒucounts[2 ranks..4 ranks)Ɏc
+*/
+static int exchange(struct Domain *domain, const int width) {
+    const int ranks = domain->ranks;
+    int *send_count = domain->counts;
+    int *send_offset = send_count + ranks;
+    int *receive_count = send_offset + ranks;
+    int *receive_offset = receive_count + ranks;
+    int r, sent = 0, total = 0;
+    MPI_Alltoall(send_count, 1, MPI_INT, receive_count, 1, MPI_INT, MPI_COMM_WORLD);
+    for ( r = 0; r < ranks; r++ ) {
+        send_offset[r] = sent * width;
+        receive_offset[r] = total * width;
+        sent += send_count[r];
+        total += receive_count[r];
+        send_count[r] *= width;
+        receive_count[r] *= width;
+    }
+    reserve_buffer(domain, &domain->send, &domain->send_capacity, ( size_t )sent * width + 1);
+    reserve_buffer(domain, &domain->receive, &domain->receive_capacity, ( size_t )total * width + 1);
+    MPI_Alltoallv(domain->send, send_count, send_offset, MPI_DOUBLE, domain->receive, receive_count, receive_offset, MPI_DOUBLE,
+        MPI_COMM_WORLD);
+    return total;
+}
+
+/**
+* @fn eN̐͂ޔSẴNŋL. ̂ȂN͉̔[[傫
+*/
+static void share_boxes(const int size, struct Stars const *stars, struct Domain *domain) {
+    double own[DOMAIN_BOX];
+    int i, k;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        own[k] = HUGE_VAL;
+        own[k + GRAVITY_DIM] = -HUGE_VAL;
+    }
+#define BOX_EXTEND(X) \
+        if ( stars->X[i] < own[k] ) own[k] = stars->X[i]; \
+        if ( stars->X[i] > own[k + GRAVITY_DIM] ) own[k + GRAVITY_DIM] = stars->X[i]; \
+        k++;
+    for ( i = 0; i < size; i++ ) {
+        k = 0;
+        FOR_AXES(BOX_EXTEND)
+    }
+#undef BOX_EXTEND
+    MPI_Allgather(own, DOMAIN_BOX, MPI_DOUBLE, domain->box, DOMAIN_BOX, MPI_DOUBLE, MPI_COMM_WORLD);
+}
+
+/**
+* @fn _甠܂ł̋2. ̒ł0
+*/
+static double box_distance2(double const *box, double const *point) {
+    double d2 = 0;
+    int k;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        const double below = box[k] - point[k];
+        const double above = point[k] - box[k + GRAVITY_DIM];
+        const double gap = below > above ? below : above;
+        if ( gap > 0 ) {
+            d2 += gap * gap;
+        }
+    }
+    return d2;
+}
+
+static int compare_ids(const void *a, const void *b) {
+    const struct IdEntry *p = ( const struct IdEntry * )a;
+    const struct IdEntry *q = ( const struct IdEntry * )b;
+    return p->id < q->id ? -1 : p->id > q->id ? 1 : 0;
+}
+
+/**
+* @fn ̐ԍ̏ɕבւ.
+*/
+static void sort_local(const int size, struct Stars *stars, struct Domain *domain) {
+    struct IdEntry *entries;
+    double *temp;
+    int i;
+    for ( i = 1; i < size && domain->id[i - 1] < domain->id[i]; i++ ) {
+    }
+    if ( i >= size ) {
+        return;
+    }
+    entries = ( struct IdEntry * )malloc(sizeof(struct IdEntry) * size);
+    if ( entries == NULL ) {
+        domain_fail(domain, "indices");
+    }
+    for ( i = 0; i < size; i++ ) {
+        entries[i].id = domain->id[i];
+        entries[i].index = i;
+    }
+    qsort(entries, size, sizeof(struct IdEntry), compare_ids);
+    //the send buffer is free between the exchanges
+    temp = reserve_buffer(domain, &domain->send, &domain->send_capacity, size);
+#define PERMUTE(A) \
+    for ( i = 0; i < size; i++ ) { \
+        temp[i] = ( A )[entries[i].index]; \
+    } \
+    memcpy(( A ), temp, sizeof(double) * size);
+#define PERMUTE_AXIS(X) PERMUTE(stars->X) PERMUTE(stars->pre_##X) PERMUTE(stars->v##X)
+    PERMUTE(stars->m)
+    FOR_AXES(PERMUTE_AXIS)
+#undef PERMUTE
+#undef PERMUTE_AXIS
+    for ( i = 0; i < size; i++ ) {
+        domain->id[i] = entries[i].id;
+    }
+    free(entries);
+}
+
+/**
+* @fn mark[i]̃Nw̃Nֈڂ, 󂯎Ĕԍ̏ɕׂ.
+* @return ڂ̎̐̐
+*/
+static int migrate(const int size, struct Stars *stars, struct Workspace *work, struct Domain *domain) {
+    const int ranks = domain->ranks;
+    int *count = domain->counts;
+    int *offset = count + ranks;
+    int i, r, n = 0, moved = 0, received;
+    double *send;
+    for ( r = 0; r < ranks; r++ ) {
+        count[r] = 0;
+    }
+    for ( i = 0; i < size; i++ ) {
+        if ( domain->mark[i] != domain->rank ) {
+            count[domain->mark[i]]++;
+            moved++;
+        }
+    }
+    send = reserve_buffer(domain, &domain->send, &domain->send_capacity, ( size_t )moved * MIGRANT_WIDTH + 1);
+    for ( r = 0, offset[0] = 0; r + 1 < ranks; r++ ) {
+        offset[r + 1] = offset[r] + count[r];
+    }
+    //pack the leaving stars and close the gaps they leave, keeping the order
+#define KEEP(X) stars->X[n] = stars->X[i]; stars->pre_##X[n] = stars->pre_##X[i]; stars->v##X[n] = stars->v##X[i];
+    for ( i = 0; i < size; i++ ) {
+        const int to = domain->mark[i];
+        if ( to != domain->rank ) {
+            pack_migrant(send + ( size_t )offset[to]++ * MIGRANT_WIDTH, domain->id[i], i, stars);
+            continue;
+        }
+        if ( n != i ) {
+            stars->m[n] = stars->m[i];
+            FOR_AXES(KEEP)
+            domain->id[n] = domain->id[i];
+        }
+        n++;
+    }
+#undef KEEP
+    received = exchange(domain, MIGRANT_WIDTH);
+    reserve_local(n, n + received, stars, work, domain);
+    for ( i = 0; i < received; i++ ) {
+        domain->id[n + i] = unpack_migrant(domain->receive + ( size_t )i * MIGRANT_WIDTH, n + i, stars);
+    }
+    domain->migrated += moved;
+    sort_local(n + received, stars, domain);
+    return n + received;
+}
+
+/**
+* @fn SẴNǂݍ񂾐̏W, ԍ̘A̕o.
+* @param total SĂ̐̐
+* @param all SĂ̐̏W Ă񂾌ŉĂ悢
+* @param stars ̐W Ŋmۂ
+* @return ̐̐
+* @detail ŏ͔̕ԍ̏Ȃ̂, ̌balance_domainĂŋԂŕ
+*/
+int split_stars(const int total, struct Stars *all, struct Stars *stars, struct Domain *domain) {
+    const int first = ( int )( ( long long )total * domain->rank / domain->ranks );
+    const int last = ( int )( ( long long )total * ( domain->rank + 1 ) / domain->ranks );
+    const int size = last - first;
+    const size_t length = sizeof(double) * size;
+    int i;
+    stars->block = NULL;
+    stars->mapping = NULL;
+    stars->mapping_size = 0;
+    stars->capacity = 0;
+    reserve_local(0, size > 0 ? size : 1, stars, NULL, domain);
+    memcpy(stars->m, all->m + first, length);
+#define TAKE(X) memcpy(stars->X, all->X + first, length); memcpy(stars->v##X, all->v##X + first, length);
+    FOR_AXES(TAKE)
+#undef TAKE
+    for ( i = 0; i < size; i++ ) {
+        domain->id[i] = first + i;
+    }
+    return size;
+}
+
+/**
+* @fn ̏W𒼌ċA񕪊ŕ, eN̗̈̐̃Nֈڂ.
+* @param size ̐̐
+* @param work Ɨ̈ Ƃ͐L΂
+* @return ̎̐̐
+* @detail N͈̔[lower, upper)𔼕ɕ邽т, ͈͂̐͂ޔ̍łɉ
+*         ̐̐Ŝ (mid - lower) / (upper - lower) ɂȂʒu񕪖@ŒT.
+*         ǂ͈̔͂SẴNɎU΂ɂēɐ؂̂, ؂邽тɐڂȂ
+*/
+int balance_domain(const int size, struct Stars *stars, struct Workspace *work, struct Domain *domain) {
+    const int ranks = domain->ranks;
+#define AXIS_POSITION(X) stars->X,
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+#undef AXIS_POSITION
+    int *lower = ( int * )malloc(sizeof(int) * ranks * 5);
+    int *upper = lower + ranks;
+    int *axis = upper + ranks;
+    int *left = axis + ranks;
+    int *settled = left + ranks;
+    double *bounds = ( double * )malloc(sizeof(double) * ranks * ( DOMAIN_BOX + 3 ));
+    double *low = bounds + ranks * DOMAIN_BOX;
+    double *high = low + ranks;
+    double *cut = high + ranks;
+    long long *counts = ( long long * )malloc(sizeof(long long) * ranks * 3);
+    long long *total = counts + ranks;
+    long long *target = total + ranks;
+    int segments = 1, s, i, k, it;
+    if ( lower == NULL || bounds == NULL || counts == NULL ) {
+        domain_fail(domain, "bisection");
+    }
+    lower[0] = 0;
+    upper[0] = ranks;
+    for ( i = 0; i < size; i++ ) {
+        domain->mark[i] = 0;
+    }
+    for ( ;; ) {
+        int divided = 0, next = 0, open;
+        for ( s = 0; s < segments; s++ ) {
+            divided |= upper[s] - lower[s] > 1;
+        }
+        if ( !divided ) {
+            break;
+        }
+        //the box and the number of the stars of each segment, the lower corner negated to take the maximum
+        for ( k = 0; k < segments * DOMAIN_BOX; k++ ) {
+            bounds[k] = -HUGE_VAL;
+        }
+        for ( s = 0; s < segments; s++ ) {
+            counts[s] = 0;
+        }
+        for ( i = 0; i < size; i++ ) {
+            double *b = bounds + domain->mark[i] * DOMAIN_BOX;
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                if ( -position[k][i] > b[k] ) b[k] = -position[k][i];
+                if ( position[k][i] > b[k + GRAVITY_DIM] ) b[k + GRAVITY_DIM] = position[k][i];
+            }
+            counts[domain->mark[i]]++;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, bounds, segments * DOMAIN_BOX, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        MPI_Allreduce(counts, total, segments, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        for ( s = 0; s < segments; s++ ) {
+            double const *b = bounds + s * DOMAIN_BOX;
+            const int mid = ( lower[s] + upper[s] ) / 2;
+            axis[s] = 0;
+            for ( k = 1; k < GRAVITY_DIM; k++ ) {
+                if ( b[k + GRAVITY_DIM] + b[k] > b[axis[s] + GRAVITY_DIM] + b[axis[s]] ) {
+                    axis[s] = k;
+                }
+            }
+            low[s] = -b[axis[s]];
+            high[s] = b[axis[s] + GRAVITY_DIM];
+            target[s] = total[s] * ( mid - lower[s] ) / ( upper[s] - lower[s] );
+            //a segment of one rank or without stars is not cut
+            settled[s] = upper[s] - lower[s] <= 1 || total[s] == 0;
+            cut[s] = settled[s] ? 0 : low[s];
+        }
+        for ( it = 0; it < DOMAIN_BISECTIONS; it++ ) {
+            open = 0;
+            for ( s = 0; s < segments; s++ ) {
+                counts[s] = 0;
+                if ( !settled[s] ) {
+                    cut[s] = ( low[s] + high[s] ) * 0.5;
+                    open = 1;
+                }
+            }
+            if ( !open ) {
+                break;
+            }
+            for ( i = 0; i < size; i++ ) {
+                s = domain->mark[i];
+                counts[s] += position[axis[s]][i] < cut[s];
+            }
+            MPI_Allreduce(MPI_IN_PLACE, counts, segments, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+            for ( s = 0; s < segments; s++ ) {
+                if ( settled[s] ) {
+                    continue;
+                }
+                if ( counts[s] == target[s] ) {
+                    settled[s] = 1;
+                } else if ( counts[s] < target[s] ) {
+                    low[s] = cut[s];
+                } else {
+                    high[s] = cut[s];
+                }
+            }
+        }
+        //the left half keeps the index of the segment in the next level, the right half follows it
+        for ( s = 0; s < segments; s++ ) {
+            left[s] = next;
+            next += upper[s] - lower[s] > 1 ? 2 : 1;
+        }
+        for ( i = 0; i < size; i++ ) {
+            s = domain->mark[i];
+            if ( upper[s] - lower[s] > 1 && !( position[axis[s]][i] < cut[s] ) ) {
+                domain->mark[i] = left[s] + 1;
+            } else {
+                domain->mark[i] = left[s];
+            }
+        }
+        for ( s = segments - 1; s >= 0; s-- ) {
+            const int mid = ( lower[s] + upper[s] ) / 2;
+            const int l = lower[s];
+            const int u = upper[s];
+            if ( u - l > 1 ) {
+                lower[left[s]] = l;
+                upper[left[s]] = mid;
+                lower[left[s] + 1] = mid;
+                upper[left[s] + 1] = u;
+            } else {
+                lower[left[s]] = l;
+                upper[left[s]] = u;
+            }
+        }
+        segments = next;
+    }
+    for ( i = 0; i < size; i++ ) {
+        domain->mark[i] = lower[domain->mark[i]];
+    }
+    free(lower);
+    free(bounds);
+    free(counts);
+    domain->changed = 1;
+    return migrate(size, stars, work, domain);
+}
+
+/**
+* @fn SẴN̐̎ʂƈʒuW߂. ڑaɎg
+* @param own ̐̋L^̈ʒu
+* @return W߂L^̐ ̐܂
+*/
+static int gather_sources(const int size, struct Stars const *stars, struct Domain *domain, int *own) {
+    const int ranks = domain->ranks;
+    int *count = domain->counts + ranks * 2;
+    int *offset = count + ranks;
+    double *record = reserve_buffer(domain, &domain->send, &domain->send_capacity, ( size_t )size * SOURCE_WIDTH + 1);
+    int i, r, total = 0;
+#define PACK_SOURCE(X) *record++ = stars->X[i];
+    for ( i = 0; i < size; i++ ) {
+        *record++ = stars->m[i];
+        FOR_AXES(PACK_SOURCE)
+    }
+#undef PACK_SOURCE
+    MPI_Allgather(&size, 1, MPI_INT, count, 1, MPI_INT, MPI_COMM_WORLD);
+    for ( r = 0; r < ranks; r++ ) {
+        if ( r == domain->rank ) {
+            *own = total;
+        }
+        offset[r] = total * SOURCE_WIDTH;
+        total += count[r];
+        count[r] *= SOURCE_WIDTH;
+    }
+    reserve_buffer(domain, &domain->receive, &domain->receive_capacity, ( size_t )total * SOURCE_WIDTH + 1);
+    MPI_Allgatherv(domain->send, size * SOURCE_WIDTH, MPI_DOUBLE, domain->receive, count, offset, MPI_DOUBLE, MPI_COMM_WORLD);
+    return total;
+}
+
+/**
+* @fn ̖̐؂𑊎̔ɑ΂Ăǂ, ̐̉xɗvZƐ𑗂L^ɉ.
+* @param box ̐͂ޔ
+* @param length L^̒l̐ ₷
+* @return L^̐
+* @detail ̂ǂ̓_猩ĂZ̏dSZJ艓, ZdSɒuʂƂđ.
+*         łȂΎq̃Z֍~, tł͒̐𑗂. ̖؂ZJɍςޔ͈͂ōłe
+*/
+static int export_tree(struct Domain *domain, double const *box, size_t *length) {
+    struct Tree const *tree = &domain->local;
+    int stack[DOMAIN_STACK];
+    int top = 0, count = 0;
+    stack[top++] = 0;
+    while ( top > 0 ) {
+        struct TreeNode const *n = &tree->nodes[stack[--top]];
+        double point[GRAVITY_DIM];
+        double *record;
+        int k = 0;
+        if ( n->m <= 0 ) {
+            continue;
+        }
+#define NODE_POINT(X) point[k++] = n->X;
+        FOR_AXES(NODE_POINT)
+#undef NODE_POINT
+        if ( box_distance2(box, point) > n->limit2 ) {
+            record = reserve_buffer(domain, &domain->send, &domain->send_capacity, *length + SOURCE_WIDTH) + *length;
+            *record++ = n->m;
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                *record++ = point[k];
+            }
+            *length += SOURCE_WIDTH;
+            count++;
+        } else if ( n->child < 0 ) {
+            record = reserve_buffer(domain, &domain->send, &domain->send_capacity, *length + ( size_t )n->count * SOURCE_WIDTH) + *length;
+#define LEAF_POINT(X) *record++ = tree->p##X[k];
+            for ( k = n->first; k < n->first + n->count; k++ ) {
+                *record++ = tree->pm[k];
+                FOR_AXES(LEAF_POINT)
+            }
+#undef LEAF_POINT
+            *length += ( size_t )n->count * SOURCE_WIDTH;
+            count += n->count;
+        } else {
+            for ( k = n->child; k < n->child + DOMAIN_CHILDREN; k++ ) {
+                stack[top++] = k;
+            }
+        }
+    }
+    return count;
+}
+
+static void domain_direct_task(void *arg, const int begin, const int end) {
+    struct DomainTask *task = ( struct DomainTask * )arg;
+#define TASK_ACCELERATION(X) , task->work->a##X
+    if ( task->phi != NULL ) {
+        calc_accelerations_potential_range(task->total, &task->domain->sources, begin, end FOR_AXES(TASK_ACCELERATION), task->phi);
+    } else {
+        calc_accelerations_range(task->total, &task->domain->sources, begin, end FOR_AXES(TASK_ACCELERATION));
+    }
+}
+
+static void domain_tree_task(void *arg, const int begin, const int end) {
+    struct DomainTask *task = ( struct DomainTask * )arg;
+    tree_accelerations_local(&task->domain->tree, task->size, begin, end FOR_AXES(TASK_ACCELERATION), task->phi);
+#undef TASK_ACCELERATION
+}
+
+/**
+* @fn ̃N̐̏d͂܂߂Ď̐̉x߂. accelerationsƗ̈hookƂČĂ΂
+* @param phi NULLłȂ΃|eV
+*/
+static void domain_forces(void *context, const int size, struct Stars const *stars, struct Workspace *work, double *phi) {
+    struct Domain *domain = ( struct Domain * )context;
+    struct DomainTask task;
+    size_t length = 0;
+    int i, r, received, own = 0, total, built = 0;
+    int *count = domain->counts;
+    share_boxes(size, stars, domain);
+    if ( domain->theta < 0 ) {
+        received = gather_sources(size, stars, domain, &own) - size;
+    } else {
+        if ( size > 0 ) {
+            reserve_tree(size, &domain->local, domain);
+        }
+        for ( r = 0; r < domain->ranks; r++ ) {
+            double const *box = domain->box + r * DOMAIN_BOX;
+            count[r] = 0;
+            //no stars on either side
+            if ( r == domain->rank || size == 0 || box[0] > box[GRAVITY_DIM] ) {
+                continue;
+            }
+            if ( !built && !build_tree(&domain->local, size, stars) ) {
+                domain_fail(domain, "tree");
+            }
+            built = 1;
+            count[r] = export_tree(domain, box, &length);
+        }
+        received = exchange(domain, SOURCE_WIDTH);
+    }
+    //the local stars first so that their indices are the same as in stars
+    total = size + received;
+    reserve_stars(0, total > 0 ? total : 1, &domain->sources, domain);
+    memcpy(domain->sources.m, stars->m, sizeof(double) * size);
+#define COPY_POSITION(X) memcpy(domain->sources.X, stars->X, sizeof(double) * size);
+    FOR_AXES(COPY_POSITION)
+#undef COPY_POSITION
+#define UNPACK_SOURCE(X) domain->sources.X[j] = *record++;
+    for ( i = 0; i < received; i++ ) {
+        //the records of the direct summation include the local stars at own
+        const int k = domain->theta < 0 && i >= own ? i + size : i;
+        double const *record = domain->receive + ( size_t )k * SOURCE_WIDTH;
+        const int j = size + i;
+        domain->sources.m[j] = *record++;
+        FOR_AXES(UNPACK_SOURCE)
+    }
+#undef UNPACK_SOURCE
+    domain->imported += received;
+    domain->evaluations++;
+    task.domain = domain;
+    task.work = work;
+    task.size = size;
+    task.total = total;
+    task.phi = phi;
+    if ( domain->theta >= 0 && total > 0 ) {
+        reserve_tree(total, &domain->tree, domain);
+        if ( build_tree(&domain->tree, total, &domain->sources) ) {
+            parallel_for(domain->pool, total, DOMAIN_CHUNK, domain_tree_task, &task);
+            return;
+        }
+    }
+    //direct summation, also when the tree could not be built
+    parallel_for(domain->pool, size, DOMAIN_CHUNK, domain_direct_task, &task);
+}
+
+/**
+* @fn Ɨ̈̉x̌vZ𑼂̃N̐܂߂vZɒu.
+*/
+void attach_domain(struct Domain *domain, struct Workspace *work) {
+    work->hook = domain_forces;
+    work->hook_context = domain;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const struct DomainEntry *p = ( const struct DomainEntry * )a;
+    const struct DomainEntry *q = ( const struct DomainEntry * )b;
+    if ( p->x < q->x ) {
+        return -1;
+    }
+    if ( p->x > q->x ) {
+        return 1;
+    }
+    return p->index - q->index;
+}
+
+/**
+* @fn ̏W̒ŏՓ˂gT.
+* @param size ̐
+* @param split 0ȏ̂Ƃ, ԍsplit̐splitȏ̐̑gT
+* @param reach Փ˂g̋̏
+* @param pairs g̔ԍ2ǋLz KvȂL΂
+* @param count g̐ ₷
+*/
+static void find_pairs(const int size, const int split, const double dt, const double reach, struct Stars const *stars,
+    int **pairs, int *count, int *capacity, struct Domain const *domain) {
+    struct DomainEntry *entries;
+    int a, b;
+    if ( size < 2 ) {
+        return;
+    }
+    entries = ( struct DomainEntry * )malloc(sizeof(struct DomainEntry) * size);
+    if ( entries == NULL ) {
+        domain_fail(domain, "collision");
+    }
+    for ( a = 0; a < size; a++ ) {
+        entries[a].x = stars->x[a];
+        entries[a].index = a;
+    }
+    qsort(entries, size, sizeof(struct DomainEntry), compare_entries);
+#define APART(X) fabs(stars->X[j] - stars->X[i]) > reach
+    for ( a = 0; a < size; a++ ) {
+        const int i = entries[a].index;
+        for ( b = a + 1; b < size && entries[b].x - entries[a].x <= reach; b++ ) {
+            const int j = entries[b].index;
+            if ( split >= 0 && ( i < split ) == ( j < split ) ) {
+                continue;
+            }
+            if ( ANY_CROSS_AXES(APART) || !is_collision(stars, i, j, dt) ) {
+                continue;
+            }
+            if ( *count == *capacity ) {
+                const int grown = *capacity > 0 ? *capacity * 2 : 16;
+                int *larger = ( int * )realloc(*pairs, sizeof(int) * 2 * grown);
+                if ( larger == NULL ) {
+                    domain_fail(domain, "collision");
+                }
+                *pairs = larger;
+                *capacity = grown;
+            }
+            ( *pairs )[*count * 2] = i < j ? i : j;
+            ( *pairs )[*count * 2 + 1] = i < j ? j : i;
+            ( *count )++;
+        }
+    }
+#undef APART
+    free(entries);
+}
+
+/**
+* @fn ԍ̕񂾔z񂩂ԍT.
+* @return ʒu ȂƂ-1
+*/
+static int find_id(long const *ids, const int count, const long id) {
+    int lo = 0, hi = count;
+    while ( lo < hi ) {
+        const int mid = ( lo + hi ) / 2;
+        if ( ids[mid] < id ) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count && ids[lo] == id ? lo : -1;
+}
+
+static int compare_longs(const void *a, const void *b) {
+    const long x = *( const long * )a;
+    const long y = *( const long * )b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static int find_root(int *parent, int k) {
+    while ( parent[k] != k ) {
+        parent[k] = parent[parent[k]];
+        k = parent[k];
+    }
+    return k;
+}
+
+/**
+* @fn N܂ŏՓ˂głȂ, ̒Ŕԍ̍ł̃Nֈڂ.
+* @param pairs SẴNŌg (ԍ, N, ԍ, N)
+* @return ڂ̎̐̐
+* @detail SẴNg̈ꗗ瓯ʂ߂̂, ڂɂĒʐMȂ
+*/
+static int gather_pairs(const int size, long const *pairs, const int count, struct Stars *stars, struct Workspace *work, struct Domain *domain) {
+    long *ids = ( long * )malloc(sizeof(long) * count * 2);
+    int *parent = ( int * )malloc(sizeof(int) * count * 4);
+    int *owner = parent + count * 2;
+    int k, n = 0, i;
+    if ( ids == NULL || parent == NULL ) {
+        domain_fail(domain, "collision");
+    }
+    for ( k = 0; k < count * 2; k++ ) {
+        ids[k] = pairs[k * 2];
+    }
+    qsort(ids, count * 2, sizeof(long), compare_longs);
+    for ( k = 0; k < count * 2; k++ ) {
+        if ( n == 0 || ids[n - 1] != ids[k] ) {
+            ids[n++] = ids[k];
+        }
+    }
+    for ( k = 0; k < n; k++ ) {
+        parent[k] = k;
+    }
+    for ( k = 0; k < count; k++ ) {
+        const int a = find_id(ids, n, pairs[k * 4]);
+        const int b = find_id(ids, n, pairs[k * 4 + 2]);
+        const int ra = find_root(parent, a);
+        const int rb = find_root(parent, b);
+        owner[a] = ( int )pairs[k * 4 + 1];
+        owner[b] = ( int )pairs[k * 4 + 3];
+        //the smaller index, that is the smaller id, becomes the root
+        if ( ra < rb ) {
+            parent[rb] = ra;
+        } else if ( rb < ra ) {
+            parent[ra] = rb;
+        }
+    }
+    for ( i = 0; i < size; i++ ) {
+        const int a = find_id(ids, n, domain->id[i]);
+        domain->mark[i] = a < 0 ? domain->rank : owner[find_root(parent, a)];
+    }
+    free(ids);
+    free(parent);
+    return migrate(size, stars, work, domain);
+}
+
+/**
+* @fn N܂̂܂߂ďՓ˂Sč̂.
+* @param size ̐̐
+* @param dt ̕ω
+* @param work Ɨ̈ Ƃ͐L΂
+* @return ̂̎̐̐
+* @detail ǂ̃NŐڂ邩̂Ƃchanged1ɂ̂, g񂷉xSẴNŎ̂Ă
+*/
+int domain_collision(const int size, const double dt, struct Stars *stars, struct Workspace *work, struct Domain *domain) {
+    const int ranks = domain->ranks;
+    double center[GRAVITY_DIM + 1];
+    struct GRAVITY_VECTOR mean;
+    double speed = 0, reach, reach2;
+    int *pairs = NULL, *count = domain->counts;
+    long *found = NULL, *all = NULL;
+    int found_count = 0, capacity = 0, candidates = 0, received, total = 0;
+    int i, k, r, n = size, merged, changed;
+    size_t length = 0;
+    domain->changed = 0;
+    if ( !( dt > 0 ) ) {
+        return size;
+    }
+    //the relative speed of a pair is at most the sum of their speeds measured from the common center
+    for ( k = 0; k <= GRAVITY_DIM; k++ ) {
+        center[k] = 0;
+    }
+#define CENTER_SUM(X) center[k++] += stars->v##X[i];
+    for ( i = 0; i < size; i++ ) {
+        k = 0;
+        FOR_AXES(CENTER_SUM)
+    }
+#undef CENTER_SUM
+    center[GRAVITY_DIM] = size;
+    MPI_Allreduce(MPI_IN_PLACE, center, GRAVITY_DIM + 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    k = 0;
+#define CENTER_MEAN(X) mean.X = center[k++] / ( center[GRAVITY_DIM] > 0 ? center[GRAVITY_DIM] : 1 );
+    FOR_AXES(CENTER_MEAN)
+#undef CENTER_MEAN
+#define SPEED(X) ( stars->v##X[i] - mean.X ) * ( stars->v##X[i] - mean.X )
+    for ( i = 0; i < size; i++ ) {
+        const double s = SUM_AXES(SPEED);
+        if ( s > speed ) {
+            speed = s;
+        }
+    }
+#undef SPEED
+    MPI_Allreduce(MPI_IN_PLACE, &speed, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    reach = 2 * sqrt(speed) * dt * DOMAIN_MARGIN;
+    reach2 = reach * reach;
+
+    //show the stars near the other boxes to those ranks
+    share_boxes(size, stars, domain);
+    for ( i = 0; i < size; i++ ) {
+        domain->mark[i] = 0;
+    }
+    for ( r = 0; r < ranks; r++ ) {
+        double const *box = domain->box + r * DOMAIN_BOX;
+        count[r] = 0;
+        if ( r == domain->rank || box[0] > box[GRAVITY_DIM] ) {
+            continue;
+        }
+        for ( i = 0; i < size; i++ ) {
+            double point[GRAVITY_DIM];
+            k = 0;
+#define STAR_POINT(X) point[k++] = stars->X[i];
+            FOR_AXES(STAR_POINT)
+#undef STAR_POINT
+            if ( box_distance2(box, point) <= reach2 ) {
+                reserve_buffer(domain, &domain->send, &domain->send_capacity, length + MIGRANT_WIDTH);
+                pack_migrant(domain->send + length, domain->id[i], i, stars);
+                length += MIGRANT_WIDTH;
+                count[r]++;
+                candidates += !domain->mark[i];
+                domain->mark[i] = 1;
+            }
+        }
+    }
+    received = exchange(domain, MIGRANT_WIDTH);
+
+    //the pairs of a local star near the border and a star of another rank
+    reserve_stars(0, candidates + received + 1, &domain->sources, domain);
+    for ( i = 0, k = 0; i < size; i++ ) {
+        if ( domain->mark[i] ) {
+            domain->sources.m[k] = stars->m[i];
+#define COPY_STAR(X) domain->sources.X[k] = stars->X[i]; domain->sources.v##X[k] = stars->v##X[i];
+            FOR_AXES(COPY_STAR)
+#undef COPY_STAR
+            domain->mark[k++] = i;
+        }
+    }
+    for ( i = 0; i < received; i++ ) {
+        unpack_migrant(domain->receive + ( size_t )i * MIGRANT_WIDTH, candidates + i, &domain->sources);
+    }
+    find_pairs(candidates + received, candidates, dt, reach, &domain->sources, &pairs, &found_count, &capacity, domain);
+    MPI_Allreduce(&found_count, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    if ( total > 0 ) {
+        //the owner of each received star, from the offsets of the senders
+        int *receive_count = count + ranks * 2;
+        int *owner = ( int * )malloc(sizeof(int) * ( received + 1 ));
+        int *gathered = ( int * )malloc(sizeof(int) * ranks * 2);
+        int local = found_count;
+        if ( owner == NULL || gathered == NULL ) {
+            domain_fail(domain, "collision");
+        }
+        for ( r = 0, k = 0; r < ranks; r++ ) {
+            for ( i = 0; i < receive_count[r] / MIGRANT_WIDTH; i++ ) {
+                owner[k++] = r;
+            }
+        }
+        //a star that moves takes its local partners along, so every local pair joins the list
+        find_pairs(size, -1, dt, reach, stars, &pairs, &found_count, &capacity, domain);
+        found = ( long * )malloc(sizeof(long) * PAIR_WIDTH * ( found_count + 1 ));
+        if ( found == NULL ) {
+            domain_fail(domain, "collision");
+        }
+        for ( k = 0; k < found_count; k++ ) {
+            const int a = pairs[k * 2];
+            const int b = pairs[k * 2 + 1];
+            long *p = found + k * PAIR_WIDTH;
+            if ( k < local ) {
+                const long idb = ( long )domain->receive[( size_t )( b - candidates ) * MIGRANT_WIDTH];
+                p[0] = domain->id[domain->mark[a]];
+                p[1] = domain->rank;
+                p[2] = idb;
+                p[3] = owner[b - candidates];
+                //each crossing pair is found on both ranks
+                domain->crossings += domain->rank < owner[b - candidates];
+            } else {
+                p[0] = domain->id[a];
+                p[1] = domain->rank;
+                p[2] = domain->id[b];
+                p[3] = domain->rank;
+            }
+        }
+        k = found_count * PAIR_WIDTH;
+        MPI_Allgather(&k, 1, MPI_INT, gathered, 1, MPI_INT, MPI_COMM_WORLD);
+        for ( r = 0, total = 0; r < ranks; r++ ) {
+            gathered[ranks + r] = total;
+            total += gathered[r];
+        }
+        all = ( long * )malloc(sizeof(long) * ( total + 1 ));
+        if ( all == NULL ) {
+            domain_fail(domain, "collision");
+        }
+        MPI_Allgatherv(found, k, MPI_LONG, all, gathered, gathered + ranks, MPI_LONG, MPI_COMM_WORLD);
+        n = gather_pairs(size, all, total / PAIR_WIDTH, stars, work, domain);
+        free(owner);
+        free(gathered);
+        free(found);
+        free(all);
+    }
+    free(pairs);
+
+    //every pair that collides is now on one rank
+    domain->merges.count = 0;
+    reserve_sweep(n, &domain->sweep);
+    merged = collision_excluding(n, dt, stars, &domain->merges, NULL, &domain->sweep);
+    if ( merged != n ) {
+        if ( domain->merges.count != n - merged ) {
+            //the log could not grow, the indices are lost
+            domain_fail(domain, "merge log");
+        }
+        for ( i = 0; i < n; i++ ) {
+            domain->mark[i] = 0;
+        }
+        for ( k = 0; k < domain->merges.count; k++ ) {
+            domain->mark[domain->merges.events[k].j] = 1;
+        }
+        for ( i = 0, k = 0; i < n; i++ ) {
+            if ( !domain->mark[i] ) {
+                domain->id[k++] = domain->id[i];
+            }
+        }
+    }
+    changed = total > 0 || merged != size;
+    MPI_Allreduce(&changed, &domain->changed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    return merged;
+}
+
+/**
+* @fn SẴN̘̐̐a.
+*/
+long total_stars(const int size) {
+    long local = size, total = 0;
+    MPI_Allreduce(&local, &total, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    return total;
+}
+
+/**
+* @fn SẴN̐N0ɔԍ̏ɏW߂. oɎg
+* @param all N0ł͏W߂WŊmۂ. Ă񂾑free_starsŉ
+* @return N0ł͏W߂̐ ̃Nł0
+*/
+int gather_stars(const int size, struct Stars const *stars, struct Domain *domain, struct Stars *all) {
+    const int ranks = domain->ranks;
+    int *count = domain->counts;
+    int *offset = count + ranks;
+    double *record = reserve_buffer(domain, &domain->send, &domain->send_capacity, ( size_t )size * MIGRANT_WIDTH + 1);
+    struct IdEntry *entries;
+    int i, r, total = 0;
+    for ( i = 0; i < size; i++ ) {
+        record = pack_migrant(record, domain->id[i], i, stars);
+    }
+    MPI_Gather(&size, 1, MPI_INT, count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if ( domain->rank == 0 ) {
+        for ( r = 0; r < ranks; r++ ) {
+            offset[r] = total * MIGRANT_WIDTH;
+            total += count[r];
+            count[r] *= MIGRANT_WIDTH;
+        }
+        reserve_buffer(domain, &domain->receive, &domain->receive_capacity, ( size_t )total * MIGRANT_WIDTH + 1);
+    }
+    MPI_Gatherv(domain->send, size * MIGRANT_WIDTH, MPI_DOUBLE, domain->receive, count, offset, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if ( domain->rank != 0 ) {
+        return 0;
+    }
+    entries = ( struct IdEntry * )malloc(sizeof(struct IdEntry) * ( total + 1 ));
+    if ( entries == NULL || !allocate_stars(total > 0 ? total : 1, all) ) {
+        domain_fail(domain, "output");
+    }
+    for ( i = 0; i < total; i++ ) {
+        entries[i].id = ( long )domain->receive[( size_t )i * MIGRANT_WIDTH];
+        entries[i].index = i;
+    }
+    qsort(entries, total, sizeof(struct IdEntry), compare_ids);
+    for ( i = 0; i < total; i++ ) {
+        unpack_migrant(domain->receive + ( size_t )entries[i].index * MIGRANT_WIDTH, i, all);
+    }
+    free(entries);
+    return total;
+}
@@ -0,0 +1,225 @@
+/**
+* @brief h}EvX@ 5(4) ɂ鍏ݕ̎
+* 2ł3ł̋ʕ dopri1.c  dopri3.c ꂼ dopri*.h ̌ɃCN[h
+* @detail
+* 7i̖ߍ݌^QENb^@5̉i, 4̉Ƃ̍Ǐ덷ς.
+* 덷el𒴂݂͎̂Ăďk߂݂ł蒼, 󗝂݂̌덷玟݂̍߂.
+* Ō̒i͎󗝂Ԃł̉x̂̂Ȃ̂ (FSAL), ݂̍̍ŏ̒iɎg,
+* 1Xebv̉x̌vZ6ōς.
+* 덷͑SĂ̐̑SĂ̐̍őlő̂, g̋ߐڑł݂k.
+*/
+#include <math.h>
+#include <stdlib.h>
+
+#define DOPRI_SAFETY 0.9        // margin on the optimal step size
+#define DOPRI_MIN_FACTOR 0.2    // the step never shrinks more than this at once
+#define DOPRI_MAX_FACTOR 5.0    // nor grows more than this
+
+//coefficients a[s][j] of the stages, the last row is also the weight of the 5th order solution
+static const double A[DOPRI_STAGES][DOPRI_STAGES - 1] = {
+    { 0.0 },
+    { 1.0 / 5.0 },
+    { 3.0 / 40.0, 9.0 / 40.0 },
+    { 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 },
+    { 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 },
+    { 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 },
+    { 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 },
+};
+
+//difference between the weights of the 5th and the 4th order solutions
+static const double E[DOPRI_STAGES] = {
+    71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0, -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0,
+};
+
+/**
+* @fn h}EvX@̍Ɨ̈mۂ.
+* @param capacity ̐̏
+* @param rtol, atol 1Xebv̌덷̋el |덷| <= atol + rtol * |l| eɉۂ
+* @param dt ŏɎݕ
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_dopri(const int capacity, const double rtol, const double atol, const double dt, struct Dopri *dopri) {
+    size_t stride;
+    int n = 0;
+    int s;
+    //ux, uy, uz, ax, ay, az for each stage, without z in 2D
+    double *base = allocate_arrays(capacity, DOPRI_STAGES * GRAVITY_DIM * 2, &dopri->block, &stride);
+    if ( base == NULL ) {
+        dopri->capacity = 0;
+        return 0;
+    }
+#define STAGE_VELOCITY(X) dopri->u##X[s] = base + stride * n++;
+#define STAGE_ACCELERATION(X) dopri->a##X[s] = base + stride * n++;
+    for ( s = 0; s < DOPRI_STAGES; s++ ) {
+        FOR_AXES(STAGE_VELOCITY)
+        FOR_AXES(STAGE_ACCELERATION)
+    }
+#undef STAGE_VELOCITY
+#undef STAGE_ACCELERATION
+    dopri->rtol = rtol;
+    dopri->atol = atol;
+    dopri->dt = dt;
+    dopri->accepted = 0;
+    dopri->rejected = 0;
+    dopri->evaluations = 0;
+    dopri->fsal = 0;
+    dopri->capacity = capacity;
+    return 1;
+}
+
+void free_dopri(struct Dopri *dopri) {
+    free(dopri->block);
+    dopri->block = NULL;
+    dopri->capacity = 0;
+}
+
+/**
+* @fn elŊ덷̑傫Ԃ.
+* @param error 덷̌ς
+* @param before, after ݂̑O̒l
+*/
+static double scaled_error(struct Dopri const *dopri, const double error, const double before, const double after) {
+    const double scale = fabs(before) > fabs(after) ? fabs(before) : fabs(after);
+    return fabs(error) / ( dopri->atol + dopri->rtol * scale );
+}
+
+/**
+* @fn ŏ̒ỉxvZ.
+*/
+static void first_stage(const int size, struct Stars *stars, struct Workspace *work, struct Dopri *dopri) {
+    int i;
+#define FIRST_ACCELERATION(X) work->a##X = dopri->a##X[0];
+#define FIRST_VELOCITY(X) dopri->u##X[0][i] = stars->v##X[i];
+    FOR_AXES(FIRST_ACCELERATION)
+    accelerations(size, stars, work);
+    dopri->evaluations++;
+    for ( i = 0; i < size; i++ ) {
+        FOR_AXES(FIRST_VELOCITY)
+    }
+#undef FIRST_ACCELERATION
+#undef FIRST_VELOCITY
+    dopri->fsal = 1;
+}
+
+/**
+* @fn Ō̒i̔zƍŏ̒i̔zւ.
+*/
+static void swap_arrays(double **stages) {
+    double *swap = stages[0];
+    stages[0] = stages[DOPRI_STAGES - 1];
+    stages[DOPRI_STAGES - 1] = swap;
+}
+
+/**
+* @fn h}EvX@Ō덷elɎ܂鍏݂i߂.
+* @param size SĂ̐̐
+* @param limit ݕ̏ Iɂ傤ǎ~߂ƂȂǂɎg. 0ȉ̂ƂȂ
+* @param stars ̏W
+* @param work Ɨ̈ x̌vZ@ƍƃXbhg
+* @param dopri ݕƓvXV
+* @return i߂̕
+*/
+double dormand_prince(const int size, const double limit, struct Stars *stars, struct Workspace *work, struct Dopri *dopri) {
+    double h, error, factor;
+    int rejects = 0;
+    int i, j, s;
+    //the force routines write to work->ax, which points at each stage in turn until the end
+#define SAVE_ACCELERATION(X) double *const a##X = work->a##X;
+#define RESTORE_ACCELERATION(X) work->a##X = a##X;
+#define STAGE_ACCELERATION(X) work->a##X = dopri->a##X[s];
+#define STORE_POSITION(X) stars->pre_##X[i] = stars->X[i];
+#define STAGE_LOAD(X) r.X = stars->pre_##X[i]; v.X = stars->v##X[i];
+#define STAGE_ADD(X) r.X += c[j] * dopri->u##X[j][i]; v.X += c[j] * dopri->a##X[j][i];
+#define STAGE_STORE(X) stars->X[i] = r.X; dopri->u##X[s][i] = v.X;
+#define ERROR_ADD(X) er.X += E[j] * dopri->u##X[j][i]; ev.X += E[j] * dopri->a##X[j][i];
+#define POSITION_ERROR(X) \
+            e = scaled_error(dopri, er.X * h, stars->pre_##X[i], stars->X[i]); \
+            error = e > error ? e : error;
+#define VELOCITY_ERROR(X) \
+            e = scaled_error(dopri, ev.X * h, stars->v##X[i], dopri->u##X[DOPRI_STAGES - 1][i]); \
+            error = e > error ? e : error;
+#define ACCEPT_VELOCITY(X) stars->v##X[i] = dopri->u##X[DOPRI_STAGES - 1][i];
+#define SWAP_STAGES(X) swap_arrays(dopri->u##X); swap_arrays(dopri->a##X);
+    FOR_AXES(SAVE_ACCELERATION)
+    for ( i = 0; i < size; i++ ) {
+        //store the position at the beginning of the step, the velocity stays in stars until accepted
+        FOR_AXES(STORE_POSITION)
+    }
+    if ( !dopri->fsal ) {
+        first_stage(size, stars, work, dopri);
+    }
+    for ( ;; ) {
+        h = limit > 0 && dopri->dt > limit ? limit : dopri->dt;
+        for ( s = 1; s < DOPRI_STAGES; s++ ) {
+            double c[DOPRI_STAGES - 1];
+            for ( j = 0; j < s; j++ ) {
+                c[j] = A[s][j] * h;
+            }
+            for ( i = 0; i < size; i++ ) {
+                struct GRAVITY_VECTOR r, v;
+                FOR_AXES(STAGE_LOAD)
+                for ( j = 0; j < s; j++ ) {
+                    FOR_AXES(STAGE_ADD)
+                }
+                FOR_AXES(STAGE_STORE)
+            }
+            FOR_AXES(STAGE_ACCELERATION)
+            accelerations(size, stars, work);
+            dopri->evaluations++;
+        }
+        //the last stage is the 5th order solution, compare it with the embedded 4th order one
+        error = 0;
+        for ( i = 0; i < size; i++ ) {
+            struct GRAVITY_VECTOR er = { 0 }, ev = { 0 };
+            double e;
+            for ( j = 0; j < DOPRI_STAGES; j++ ) {
+                FOR_AXES(ERROR_ADD)
+            }
+            FOR_AXES(POSITION_ERROR)
+            FOR_AXES(VELOCITY_ERROR)
+        }
+        //error^(-1/5) is the optimal ratio since the local error is of 5th order in h
+        factor = error > 0 ? DOPRI_SAFETY * pow(error, -0.2) : DOPRI_MAX_FACTOR;
+        if ( !( factor >= DOPRI_MIN_FACTOR ) ) {
+            //also when the error is not a number
+            factor = DOPRI_MIN_FACTOR;
+        } else if ( factor > DOPRI_MAX_FACTOR ) {
+            factor = DOPRI_MAX_FACTOR;
+        }
+        if ( error <= 1.0 || rejects >= DOPRI_MAX_REJECTS ) {
+            break;
+        }
+        dopri->rejected++;
+        rejects++;
+        dopri->dt = h * factor;
+    }
+    dopri->accepted++;
+    for ( i = 0; i < size; i++ ) {
+        FOR_AXES(ACCEPT_VELOCITY)
+    }
+    //first same as last : the last stage becomes the first stage of the next step
+    FOR_AXES(SWAP_STAGES)
+    //do not grow right after a rejection, and keep the step shortened by the limit for later
+    if ( rejects > 0 && factor > 1.0 ) {
+        factor = 1.0;
+    }
+    if ( h < dopri->dt ) {
+        dopri->dt = h * factor < dopri->dt ? h * factor : dopri->dt;
+    } else {
+        dopri->dt = h * factor;
+    }
+    FOR_AXES(RESTORE_ACCELERATION)
+#undef SAVE_ACCELERATION
+#undef RESTORE_ACCELERATION
+#undef STAGE_ACCELERATION
+#undef STORE_POSITION
+#undef STAGE_LOAD
+#undef STAGE_ADD
+#undef STAGE_STORE
+#undef ERROR_ADD
+#undef POSITION_ERROR
+#undef VELOCITY_ERROR
+#undef ACCEPT_VELOCITY
+#undef SWAP_STAGES
+    return h;
+}
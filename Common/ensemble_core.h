@@ -0,0 +1,748 @@
+/**
+* @brief ̏ȌnSIMD[ɕׂēɐi߂ 2ł3ł̋ʕ
+* @detail
+* ensemble1.c  ensemble3.c ꂼ ensemble*.h, force*.h, pool.h ̌ɃCN[h.
+* 琔\̐̌nł, SIMD[ɕׂx̃J[l̓[܂炸,
+* nƂ̐ϕ̌Ăяoƕ񉻂̎Ԃ̕傫. Ő̐̋߂nENSEMBLE_LANESgɂ,
+* ԍ̐n̏ɕׂ(array of systems), n[ƂĈxɌvZ.
+* gǂ͓ƗȂ̂, ƃXbh͑gčŌ̃Xebv܂Ői, XebvƂɑ҂킹Ȃ.
+* ϕ@̓QENb^@, x͑I𒆂̃J[l(force*.c)ƗvfƂɓZŋ߂̂,
+* eňʂgravity*dňvZʂƃrbgPʂňv (--precision doublêƂ).
+* Փ˂̔͂ǂ̑g肦ȂƂXebv̍ŏ̉xƓǧvZŃ[ƂɊm, 肤n̐̏WɎʂ
+* collisionŔƍ̂s. ̂̏Ԃƌʂ̌vZƕςȂ.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define ENSEMBLE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#if !defined(_MSC_VER) || _MSC_VER >= 1911
+#define ENSEMBLE_AVX512
+#endif
+#endif
+
+#define ENSEMBLE_MARGIN 1.000001  // widens the quick collision test against rounding errors
+
+extern const double G;
+
+/**
+* ̐ŕבւn
+*/
+struct EnsembleEntry {
+    int size;
+    int index;
+};
+
+static int compare_entries(const void *a, const void *b) {
+    const struct EnsembleEntry *p = ( const struct EnsembleEntry * )a;
+    const struct EnsembleEntry *q = ( const struct EnsembleEntry * )b;
+    //larger systems first, ties in the given order
+    return p->size != q->size ? q->size - p->size : p->index - q->index;
+}
+
+/**
+* @fn g̔zmۂ.
+* @param capacity 1[̐̐
+* @return mۂɐƂ1 sƂ0
+*/
+static int allocate_group(const int capacity, struct EnsembleGroup *g) {
+    size_t stride;
+    int n = 1;
+    int k;
+    //m, then x, pre_x, vx, rx[4], wx[4] and ax for each axis
+    double *base = allocate_arrays(capacity * ENSEMBLE_LANES, 1 + GRAVITY_DIM * 12, &g->block, &stride);
+    if ( base == NULL ) {
+        return 0;
+    }
+    g->m = base;
+#define GROUP_STATE(X) \
+    g->X = base + stride * n++; \
+    g->pre_##X = base + stride * n++; \
+    g->v##X = base + stride * n++;
+#define GROUP_STAGE(X) \
+    g->r##X[k] = base + stride * n++; \
+    g->w##X[k] = base + stride * n++;
+#define GROUP_ACCELERATION(X) g->a##X = base + stride * n++;
+    FOR_AXES(GROUP_STATE)
+    for ( k = 0; k < 4; k++ ) {
+        FOR_AXES(GROUP_STAGE)
+    }
+    FOR_AXES(GROUP_ACCELERATION)
+#undef GROUP_STATE
+#undef GROUP_STAGE
+#undef GROUP_ACCELERATION
+    g->capacity = capacity;
+    return 1;
+}
+
+/**
+* @fn n̏W܂mۂ.
+* @param count n̐
+* @param sizes en̐̐ 1ȏł邱
+* @param ens mۂgݒ肷. ̒lset_systemŏ
+* @return mۂɐƂ1 sƂ0
+* @detail ̐̑ɕׂENSEMBLE_LANESgɂ̂, g̒̋󂢂g͏Ȃ
+*/
+int allocate_ensemble(const int count, int const *sizes, struct Ensemble *ens) {
+    struct EnsembleEntry *entries;
+    int g, l;
+    ens->count = count;
+    ens->groups = ( count + ENSEMBLE_LANES - 1 ) / ENSEMBLE_LANES;
+    ens->group = ( struct EnsembleGroup * )calloc(ens->groups > 0 ? ens->groups : 1, sizeof(struct EnsembleGroup));
+    ens->slot = ( struct EnsembleSlot * )malloc(sizeof(struct EnsembleSlot) * ( count > 0 ? count : 1 ));
+    entries = ( struct EnsembleEntry * )malloc(sizeof(struct EnsembleEntry) * ( count > 0 ? count : 1 ));
+    if ( ens->group == NULL || ens->slot == NULL || entries == NULL ) {
+        free(entries);
+        free_ensemble(ens);
+        return 0;
+    }
+    for ( l = 0; l < count; l++ ) {
+        entries[l].size = sizes[l];
+        entries[l].index = l;
+    }
+    qsort(entries, count, sizeof(struct EnsembleEntry), compare_entries);
+    for ( g = 0; g < ens->groups; g++ ) {
+        struct EnsembleGroup *group = &ens->group[g];
+        struct EnsembleEntry const *first = &entries[g * ENSEMBLE_LANES];
+        group->systems = count - g * ENSEMBLE_LANES < ENSEMBLE_LANES ? count - g * ENSEMBLE_LANES : ENSEMBLE_LANES;
+        //the first system of a group is the largest
+        if ( !allocate_group(first->size, group) ) {
+            free(entries);
+            free_ensemble(ens);
+            return 0;
+        }
+        for ( l = 0; l < group->systems; l++ ) {
+            group->size[l] = first[l].size;
+            group->running[l] = 1;
+            ens->slot[first[l].index].group = g;
+            ens->slot[first[l].index].lane = l;
+        }
+    }
+    free(entries);
+    return 1;
+}
+
+void free_ensemble(struct Ensemble *ens) {
+    int g;
+    if ( ens->group != NULL ) {
+        for ( g = 0; g < ens->groups; g++ ) {
+            free(ens->group[g].block);
+        }
+    }
+    free(ens->group);
+    free(ens->slot);
+    ens->group = NULL;
+    ens->slot = NULL;
+    ens->count = 0;
+    ens->groups = 0;
+}
+
+/**
+* @fn n̐[֏.
+* @param index n̔ԍ allocate_ensembleɓn
+* @param stars ސ. ̐allocate_ensembleɓn
+*/
+void set_system(struct Ensemble *ens, const int index, struct Stars const *stars) {
+    struct EnsembleGroup *g = &ens->group[ens->slot[index].group];
+    const int lane = ens->slot[index].lane;
+    int i;
+#define SET_AXIS(X) \
+        g->X[e] = stars->X[i]; \
+        g->v##X[e] = stars->v##X[i];
+    for ( i = 0; i < g->size[lane]; i++ ) {
+        const int e = i * ENSEMBLE_LANES + lane;
+        g->m[e] = stars->m[i];
+        FOR_AXES(SET_AXIS)
+    }
+#undef SET_AXIS
+}
+
+/**
+* @fn n̐[ǂݏo.
+* @param stars ǂݏoސ̏W eʂ͌n̍ŏ̐̐ȏł邱
+* @return nɎcĂ鐯̐
+*/
+int get_system(struct Ensemble const *ens, const int index, struct Stars *stars) {
+    struct EnsembleGroup const *g = &ens->group[ens->slot[index].group];
+    const int lane = ens->slot[index].lane;
+    int i;
+#define GET_AXIS(X) \
+        stars->X[i] = g->X[e]; \
+        stars->pre_##X[i] = g->X[e]; \
+        stars->v##X[i] = g->v##X[e];
+    for ( i = 0; i < g->size[lane]; i++ ) {
+        const int e = i * ENSEMBLE_LANES + lane;
+        stars->m[i] = g->m[e];
+        FOR_AXES(GET_AXIS)
+    }
+#undef GET_AXIS
+    return g->size[lane];
+}
+
+
+// the kernels below repeat the operations of the kernels of force*.c element by element
+// limit[l] is the number of stars of lane l whose acceleration is wanted, 0 for a stopped lane
+// hit, unless NULL, receives 1 for the lanes where some pair is closer than |relative velocity| * dt,
+// a necessary condition of is_collision, 0 < 0 never holds between the empty slots resting at the origin
+#define KERNEL_LOAD(X) const double *X = g->X; const double *v##X = g->v##X;
+#define KERNEL_ACCELERATION(X) double *a##X = g->a##X;
+
+/**
+* @fn XJ[Zőg̑SẴ[̉xvZ.
+* @param n vZ鐯̐ Ă郌[̐̐̍ől
+*/
+static void forces_scalar(struct EnsembleGroup *g, const int n, double const *limit, int *hit) {
+    const double *m = g->m;
+    FOR_AXES(KERNEL_LOAD)
+    FOR_AXES(KERNEL_ACCELERATION)
+    int i, j, l;
+#define SCALAR_ORIGIN(X) const double X##i = X[a]; const double v##X##i = v##X[a];
+#define SCALAR_SUM(X) double s##X = 0;
+#define SCALAR_DIFF(X) const double d##X = X[b] - X##i;
+#define SCALAR_SQUARE(X) d##X * d##X
+#define SCALAR_RELATIVE(X) ( v##X[b] - v##X##i ) * ( v##X[b] - v##X##i )
+#define SCALAR_ADD(X) s##X += d##X * k;
+#define SCALAR_STORE(X) a##X[a] = 0; a##X[a] += s##X; a##X[a] *= G;
+#define SCALAR_CLEAR(X) a##X[a] = 0;
+    for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+        const double reach = g->dt[l] * g->dt[l] * ENSEMBLE_MARGIN;
+        int close = 0;
+        for ( i = 0; i < n; i++ ) {
+            const int a = i * ENSEMBLE_LANES + l;
+            FOR_AXES(SCALAR_ORIGIN)
+            FOR_AXES(SCALAR_SUM)
+            if ( !( i < limit[l] ) ) {
+                FOR_AXES(SCALAR_CLEAR)
+                continue;
+            }
+            for ( j = 0; j < n; j++ ) {
+                const int b = j * ENSEMBLE_LANES + l;
+                FOR_AXES(SCALAR_DIFF)
+                const double r2 = SUM_AXES(SCALAR_SQUARE);
+                //skip the star itself
+                if ( r2 > 0 ) {
+                    const double k = m[b] / ( r2 * sqrt(r2) );
+                    FOR_AXES(SCALAR_ADD)
+                }
+                if ( hit != NULL ) {
+                    close |= r2 < SUM_AXES(SCALAR_RELATIVE) * reach;
+                }
+            }
+            FOR_AXES(SCALAR_STORE)
+        }
+        if ( hit != NULL ) {
+            hit[l] = close;
+        }
+    }
+#undef SCALAR_ORIGIN
+#undef SCALAR_SUM
+#undef SCALAR_DIFF
+#undef SCALAR_SQUARE
+#undef SCALAR_RELATIVE
+#undef SCALAR_ADD
+#undef SCALAR_STORE
+#undef SCALAR_CLEAR
+}
+
+#ifdef ENSEMBLE_X86
+#define SIMD_ORIGIN(X) const VEC X##i = LOAD(&X[a]); const VEC v##X##i = LOAD(&v##X[a]);
+#define SIMD_SUM(X) VEC s##X = zero;
+#define SIMD_DIFF(X) const VEC d##X = SUB(LOAD(&X[b]), X##i);
+#define SIMD_RELATIVE(X) const VEC u##X = SUB(LOAD(&v##X[b]), v##X##i);
+
+/**
+* @fn SSE2őg2[xvZ.
+*/
+TARGET_SSE2 static void forces_sse2(struct EnsembleGroup *g, const int n, double const *limit, int *hit) {
+#define VEC __m128d
+#define LOAD _mm_loadu_pd
+#define SUB _mm_sub_pd
+#define SIMD_ADD(X) s##X = _mm_add_pd(s##X, _mm_mul_pd(d##X, k));
+#define SIMD_STORE(X) _mm_storeu_pd(&a##X[a], _mm_and_pd(_mm_mul_pd(s##X, gravity), live));
+    const double *m = g->m;
+    FOR_AXES(KERNEL_LOAD)
+    FOR_AXES(KERNEL_ACCELERATION)
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d three_half = _mm_set1_pd(1.5);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d gravity = _mm_set1_pd(G);
+    int i, j, l;
+    for ( l = 0; l < ENSEMBLE_LANES; l += 2 ) {
+        const __m128d bound = _mm_loadu_pd(&limit[l]);
+        const __m128d step = _mm_loadu_pd(&g->dt[l]);
+        const __m128d reach = _mm_mul_pd(_mm_mul_pd(step, step), _mm_set1_pd(ENSEMBLE_MARGIN));
+        __m128d close = zero;
+        for ( i = 0; i < n; i++ ) {
+            const int a = i * ENSEMBLE_LANES + l;
+            const __m128d live = _mm_cmplt_pd(_mm_set1_pd(i), bound);
+            FOR_AXES(SIMD_ORIGIN)
+            FOR_AXES(SIMD_SUM)
+            for ( j = 0; j < n; j++ ) {
+                const int b = j * ENSEMBLE_LANES + l;
+                FOR_AXES(SIMD_DIFF)
+#if GRAVITY_DIM == 3
+                const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+#else
+                const __m128d r2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+#endif
+                __m128d inv = _mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(r2)));
+                __m128d hr2 = _mm_mul_pd(half, r2);
+                __m128d k;
+                inv = _mm_mul_pd(inv, _mm_sub_pd(three_half, _mm_mul_pd(hr2, _mm_mul_pd(inv, inv))));
+                inv = _mm_mul_pd(inv, _mm_sub_pd(three_half, _mm_mul_pd(hr2, _mm_mul_pd(inv, inv))));
+                k = _mm_mul_pd(_mm_loadu_pd(&m[b]), _mm_mul_pd(inv, _mm_mul_pd(inv, inv)));
+                k = _mm_and_pd(k, _mm_cmpgt_pd(r2, zero));
+                FOR_AXES(SIMD_ADD)
+                if ( hit != NULL ) {
+                    FOR_AXES(SIMD_RELATIVE)
+#if GRAVITY_DIM == 3
+                    const __m128d u2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(ux, ux), _mm_mul_pd(uy, uy)), _mm_mul_pd(uz, uz));
+#else
+                    const __m128d u2 = _mm_add_pd(_mm_mul_pd(ux, ux), _mm_mul_pd(uy, uy));
+#endif
+                    close = _mm_or_pd(close, _mm_cmplt_pd(r2, _mm_mul_pd(u2, reach)));
+                }
+            }
+            FOR_AXES(SIMD_STORE)
+        }
+        if ( hit != NULL ) {
+            const int bits = _mm_movemask_pd(close);
+            hit[l] = bits & 1;
+            hit[l + 1] = ( bits >> 1 ) & 1;
+        }
+    }
+#undef VEC
+#undef LOAD
+#undef SUB
+#undef SIMD_ADD
+#undef SIMD_STORE
+}
+
+/**
+* @fn AVX2őg4[xvZ.
+*/
+TARGET_AVX2 static void forces_avx2(struct EnsembleGroup *g, const int n, double const *limit, int *hit) {
+#define VEC __m256d
+#define LOAD _mm256_loadu_pd
+#define SUB _mm256_sub_pd
+#define SIMD_ADD(X) s##X = _mm256_fmadd_pd(d##X, k, s##X);
+#define SIMD_STORE(X) _mm256_storeu_pd(&a##X[a], _mm256_and_pd(_mm256_mul_pd(s##X, gravity), live));
+    const double *m = g->m;
+    FOR_AXES(KERNEL_LOAD)
+    FOR_AXES(KERNEL_ACCELERATION)
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_half = _mm256_set1_pd(1.5);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d gravity = _mm256_set1_pd(G);
+    int i, j, l, h;
+    for ( l = 0; l < ENSEMBLE_LANES; l += 4 ) {
+        const __m256d bound = _mm256_loadu_pd(&limit[l]);
+        const __m256d step = _mm256_loadu_pd(&g->dt[l]);
+        const __m256d reach = _mm256_mul_pd(_mm256_mul_pd(step, step), _mm256_set1_pd(ENSEMBLE_MARGIN));
+        __m256d close = zero;
+        for ( i = 0; i < n; i++ ) {
+            const int a = i * ENSEMBLE_LANES + l;
+            const __m256d live = _mm256_cmp_pd(_mm256_set1_pd(i), bound, _CMP_LT_OQ);
+            FOR_AXES(SIMD_ORIGIN)
+            FOR_AXES(SIMD_SUM)
+            for ( j = 0; j < n; j++ ) {
+                const int b = j * ENSEMBLE_LANES + l;
+                FOR_AXES(SIMD_DIFF)
+#if GRAVITY_DIM == 3
+                const __m256d r2 = _mm256_fmadd_pd(dz, dz, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx)));
+#else
+                const __m256d r2 = _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx));
+#endif
+                __m256d inv = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2)));
+                __m256d hr2 = _mm256_mul_pd(half, r2);
+                __m256d k;
+                inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_half));
+                inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_half));
+                k = _mm256_mul_pd(_mm256_loadu_pd(&m[b]), _mm256_mul_pd(inv, _mm256_mul_pd(inv, inv)));
+                k = _mm256_and_pd(k, _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+                FOR_AXES(SIMD_ADD)
+                if ( hit != NULL ) {
+                    FOR_AXES(SIMD_RELATIVE)
+#if GRAVITY_DIM == 3
+                    const __m256d u2 = _mm256_fmadd_pd(uz, uz, _mm256_fmadd_pd(uy, uy, _mm256_mul_pd(ux, ux)));
+#else
+                    const __m256d u2 = _mm256_fmadd_pd(uy, uy, _mm256_mul_pd(ux, ux));
+#endif
+                    close = _mm256_or_pd(close, _mm256_cmp_pd(r2, _mm256_mul_pd(u2, reach), _CMP_LT_OQ));
+                }
+            }
+            FOR_AXES(SIMD_STORE)
+        }
+        if ( hit != NULL ) {
+            const int bits = _mm256_movemask_pd(close);
+            for ( h = 0; h < 4; h++ ) {
+                hit[l + h] = ( bits >> h ) & 1;
+            }
+        }
+    }
+#undef VEC
+#undef LOAD
+#undef SUB
+#undef SIMD_ADD
+#undef SIMD_STORE
+}
+
+#ifdef ENSEMBLE_AVX512
+/**
+* @fn AVX-512őg8[܂Ƃ߂ĉxvZ.
+*/
+TARGET_AVX512 static void forces_avx512(struct EnsembleGroup *g, const int n, double const *limit, int *hit) {
+#define VEC __m512d
+#define LOAD _mm512_loadu_pd
+#define SUB _mm512_sub_pd
+#define SIMD_ADD(X) s##X = _mm512_fmadd_pd(d##X, k, s##X);
+#define SIMD_STORE(X) _mm512_storeu_pd(&a##X[a], _mm512_maskz_mul_pd(live, s##X, gravity));
+    const double *m = g->m;
+    FOR_AXES(KERNEL_LOAD)
+    FOR_AXES(KERNEL_ACCELERATION)
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_half = _mm512_set1_pd(1.5);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d gravity = _mm512_set1_pd(G);
+    const __m512d bound = _mm512_loadu_pd(limit);
+    const __m512d step = _mm512_loadu_pd(g->dt);
+    const __m512d reach = _mm512_mul_pd(_mm512_mul_pd(step, step), _mm512_set1_pd(ENSEMBLE_MARGIN));
+    __mmask8 close = 0;
+    int i, j, l;
+    for ( i = 0; i < n; i++ ) {
+        const int a = i * ENSEMBLE_LANES;
+        const __mmask8 live = _mm512_cmp_pd_mask(_mm512_set1_pd(i), bound, _CMP_LT_OQ);
+        FOR_AXES(SIMD_ORIGIN)
+        FOR_AXES(SIMD_SUM)
+        for ( j = 0; j < n; j++ ) {
+            const int b = j * ENSEMBLE_LANES;
+            FOR_AXES(SIMD_DIFF)
+#if GRAVITY_DIM == 3
+            const __m512d r2 = _mm512_fmadd_pd(dz, dz, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx)));
+#else
+            const __m512d r2 = _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx));
+#endif
+            const __mmask8 other = _mm512_cmp_pd_mask(r2, zero, _CMP_GT_OQ);
+            __m512d inv = _mm512_rsqrt14_pd(r2);
+            __m512d hr2 = _mm512_mul_pd(half, r2);
+            __m512d k;
+            inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_half));
+            inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_half));
+            k = _mm512_maskz_mul_pd(other, _mm512_loadu_pd(&m[b]), _mm512_mul_pd(inv, _mm512_mul_pd(inv, inv)));
+            FOR_AXES(SIMD_ADD)
+            if ( hit != NULL ) {
+                FOR_AXES(SIMD_RELATIVE)
+#if GRAVITY_DIM == 3
+                const __m512d u2 = _mm512_fmadd_pd(uz, uz, _mm512_fmadd_pd(uy, uy, _mm512_mul_pd(ux, ux)));
+#else
+                const __m512d u2 = _mm512_fmadd_pd(uy, uy, _mm512_mul_pd(ux, ux));
+#endif
+                close |= _mm512_cmp_pd_mask(r2, _mm512_mul_pd(u2, reach), _CMP_LT_OQ);
+            }
+        }
+        FOR_AXES(SIMD_STORE)
+    }
+    if ( hit != NULL ) {
+        for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+            hit[l] = ( close >> l ) & 1;
+        }
+    }
+#undef VEC
+#undef LOAD
+#undef SUB
+#undef SIMD_ADD
+#undef SIMD_STORE
+}
+#endif
+#undef SIMD_ORIGIN
+#undef SIMD_SUM
+#undef SIMD_DIFF
+#undef SIMD_RELATIVE
+#endif
+#undef KERNEL_LOAD
+#undef KERNEL_ACCELERATION
+
+/**
+* @fn I𒆂̃J[lőg̉xvZ.
+*/
+static void group_forces(struct EnsembleGroup *g, const int n, double const *limit, int *hit) {
+    switch ( get_force_kernel() ) {
+#ifdef ENSEMBLE_X86
+#ifdef ENSEMBLE_AVX512
+    case FORCE_KERNEL_AVX512:
+        forces_avx512(g, n, limit, hit);
+        break;
+#endif
+    case FORCE_KERNEL_AVX2:
+        forces_avx2(g, n, limit, hit);
+        break;
+    case FORCE_KERNEL_SSE2:
+        forces_sse2(g, n, limit, hit);
+        break;
+#endif
+    default:
+        forces_scalar(g, n, limit, hit);
+        break;
+    }
+}
+
+// the updates of runge_kutta over n stars of every lane, the arrays do not overlap each other
+#define LANES_RESTRICT __restrict
+
+/**
+* @fn ŏ̒i w = a dt, r = v dt
+*/
+static void lanes_first(const int n, double const *dt, double const *LANES_RESTRICT a, double const *LANES_RESTRICT v,
+    double *LANES_RESTRICT w, double *LANES_RESTRICT r) {
+    int i, l;
+    for ( i = 0; i < n * ENSEMBLE_LANES; i += ENSEMBLE_LANES ) {
+        for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+            w[i + l] = a[i + l] * dt[l];
+            r[i + l] = v[i + l] * dt[l];
+        }
+    }
+}
+
+/**
+* @fn 2iڈȍ~ w = a dt, r = (w' half + v) dt
+*/
+static void lanes_stage(const int n, double const *dt, const double half, double const *LANES_RESTRICT a, double const *LANES_RESTRICT v,
+    double const *LANES_RESTRICT previous, double *LANES_RESTRICT w, double *LANES_RESTRICT r) {
+    int i, l;
+    for ( i = 0; i < n * ENSEMBLE_LANES; i += ENSEMBLE_LANES ) {
+        for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+            w[i + l] = a[i + l] * dt[l];
+            r[i + l] = ( previous[i + l] * half + v[i + l] ) * dt[l];
+        }
+    }
+}
+
+/**
+* @fn ïʒu x = r half + pre
+*/
+static void lanes_move(const int n, const double half, double const *LANES_RESTRICT r, double const *LANES_RESTRICT pre, double *LANES_RESTRICT x) {
+    int i;
+    for ( i = 0; i < n * ENSEMBLE_LANES; i++ ) {
+        x[i] = r[i] * half + pre[i];
+    }
+}
+
+/**
+* @fn ̒l x = x + k1 / 6 + k2 * 2 / 6 + k3 * 2 / 6 + k4 / 6 瑫
+*/
+static void lanes_next(const int n, double *LANES_RESTRICT x, double const *LANES_RESTRICT k1, double const *LANES_RESTRICT k2,
+    double const *LANES_RESTRICT k3, double const *LANES_RESTRICT k4) {
+    int i;
+    for ( i = 0; i < n * ENSEMBLE_LANES; i++ ) {
+        x[i] = x[i] + k1[i] * ( 1.0 / 6.0 ) + k2[i] * ( 2.0 / 6.0 ) + k3[i] * ( 2.0 / 6.0 ) + k4[i] * ( 1.0 / 6.0 );
+    }
+}
+
+/**
+* @fn QENb^@őg̑SẴ[1Xebvi߂. ƉZ̏runge_kuttaƓ
+* @param n i߂鐯̐ Ă郌[̐̐̍ől
+* @param limit e[ŉx߂鐯̐
+* @detail ŏ̒ỉx͌ĂԑOgroup_forcesŋ߂Ă.
+*         ~܂[Ƌ󂢂g͉x0, ݕ0̃[͈ʒuxςȂ
+*/
+static void group_runge_kutta(struct EnsembleGroup *g, const int n, double const *limit) {
+    const size_t length = sizeof(double) * n * ENSEMBLE_LANES;
+    int k;
+#define RK_STORE(X) memcpy(g->pre_##X, g->X, length);
+#define RK_FIRST(X) lanes_first(n, g->dt, g->a##X, g->v##X, g->w##X[0], g->r##X[0]);
+#define RK_STAGE(X) lanes_stage(n, g->dt, half, g->a##X, g->v##X, g->w##X[k - 1], g->w##X[k], g->r##X[k]);
+#define RK_MOVE(X) lanes_move(n, half, g->r##X[k - 1], g->pre_##X, g->X);
+#define RK_NEXT(X) \
+    memcpy(g->X, g->pre_##X, length); \
+    lanes_next(n, g->X, g->r##X[0], g->r##X[1], g->r##X[2], g->r##X[3]); \
+    lanes_next(n, g->v##X, g->w##X[0], g->w##X[1], g->w##X[2], g->w##X[3]);
+    FOR_AXES(RK_STORE)
+    FOR_AXES(RK_FIRST)
+    for ( k = 1; k < 4; k++ ) {
+        const double half = k < 3 ? 0.5 : 1.0;
+        FOR_AXES(RK_MOVE)
+        group_forces(g, n, limit, NULL);
+        FOR_AXES(RK_STAGE)
+    }
+    FOR_AXES(RK_NEXT)
+#undef RK_STORE
+#undef RK_FIRST
+#undef RK_STAGE
+#undef RK_MOVE
+#undef RK_NEXT
+}
+
+/**
+* @fn Փ˂̂肤郌[̌nocollisionō̂.
+* @param hit Փ˂̂肤郌[ group_forcesŒׂĂ
+* @return ̂[̐
+* @detail on̓QENb^@̒i̔z (Xebv̊Ԃ͎gȂ) ɒu
+*/
+static int group_collision(struct EnsembleGroup *g, int const *hit) {
+    int i, l, lanes = 0;
+    for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+        struct Stars lane;
+        int size, merged;
+        if ( !hit[l] || !g->running[l] ) {
+            continue;
+        }
+        //the stages are overwritten in the next step
+        lane.m = g->rx[0];
+        lane.capacity = g->capacity;
+        lane.block = NULL;
+        lane.mapping = NULL;
+        lane.mapping_size = 0;
+#define LANE_ARRAYS(X) \
+        lane.X = g->w##X[0]; \
+        lane.pre_##X = g->w##X[1]; \
+        lane.v##X = g->w##X[2];
+        FOR_AXES(LANE_ARRAYS)
+#undef LANE_ARRAYS
+        size = g->size[l];
+#define LANE_GET(X) lane.X[i] = g->X[e]; lane.pre_##X[i] = g->pre_##X[e]; lane.v##X[i] = g->v##X[e];
+#define LANE_PUT(X) g->X[e] = lane.X[i]; g->pre_##X[e] = lane.pre_##X[i]; g->v##X[e] = lane.v##X[i];
+#define LANE_CLEAR(X) g->X[e] = 0; g->pre_##X[e] = 0; g->v##X[e] = 0;
+        for ( i = 0; i < size; i++ ) {
+            const int e = i * ENSEMBLE_LANES + l;
+            lane.m[i] = g->m[e];
+            FOR_AXES(LANE_GET)
+        }
+        merged = collision(size, g->dt[l], &lane, NULL);
+        if ( merged == size ) {
+            continue;
+        }
+        for ( i = 0; i < size; i++ ) {
+            const int e = i * ENSEMBLE_LANES + l;
+            if ( i < merged ) {
+                g->m[e] = lane.m[i];
+                FOR_AXES(LANE_PUT)
+            } else {
+                //the slots the merged stars leave empty
+                g->m[e] = 0;
+                FOR_AXES(LANE_CLEAR)
+            }
+        }
+#undef LANE_GET
+#undef LANE_PUT
+#undef LANE_CLEAR
+        g->merges[l] += size - merged;
+        g->size[l] = merged;
+        lanes++;
+    }
+    return lanes;
+}
+
+/**
+* @fn [̑SĂ͈̐͂̊Oɂ邩ׂ. batch*.cis_all_outƓ
+*/
+static int lane_all_out(struct EnsembleGroup const *g, const int lane, const double bound) {
+    int i;
+#define INSIDE(X) fabs(g->X[e]) < bound &&
+    for ( i = 0; i < g->size[lane]; i++ ) {
+        const int e = i * ENSEMBLE_LANES + lane;
+        if ( FOR_AXES(INSIDE) 1 ) {
+            return 0;
+        }
+    }
+#undef INSIDE
+    return 1;
+}
+
+/**
+* @fn Ă郌[̐̐̍ől, e[ŉx߂鐯̐߂.
+*/
+static int group_limit(struct EnsembleGroup const *g, double *limit) {
+    int l, n = 0;
+    for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+        limit[l] = g->running[l] ? g->size[l] : 0;
+        if ( g->running[l] && g->size[l] > n ) {
+            n = g->size[l];
+        }
+    }
+    return n;
+}
+
+/**
+* @fn g̑SĂ̌n~܂܂Ői߂.
+* @detail [Ƃgravity*d̃Xebv̏߂Ɠ, Xebv, ͈, Փ˂𒲂ׂĂi߂.
+*         Փ˂݂̌̓Xebv̍ŏ̉xƓǧvZŒ, ̂gxߒ
+*/
+static void run_group(struct EnsembleGroup *g, const long steps, const double dt, const double bound) {
+    double limit[ENSEMBLE_LANES];
+    int hit[ENSEMBLE_LANES];
+    int l, n;
+    for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+        g->dt[l] = g->running[l] ? dt : 0;
+    }
+    for ( ;; ) {
+        for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+            if ( g->running[l] && ( g->steps[l] >= steps || ( bound >= 0 && lane_all_out(g, l, bound) ) ) ) {
+                g->running[l] = 0;
+                g->dt[l] = 0;
+            }
+        }
+        n = group_limit(g, limit);
+        if ( n == 0 ) {
+            break;
+        }
+        group_forces(g, n, limit, hit);
+        if ( group_collision(g, hit) > 0 ) {
+            n = group_limit(g, limit);
+            group_forces(g, n, limit, NULL);
+        }
+        group_runge_kutta(g, n, limit);
+        for ( l = 0; l < ENSEMBLE_LANES; l++ ) {
+            g->steps[l] += g->running[l];
+        }
+    }
+}
+
+/**
+* ɐi߂g͈̔͂ɓnl
+*/
+struct EnsembleTask {
+    struct Ensemble *ens;
+    long steps;
+    double dt;
+    double bound;
+};
+
+static void ensemble_task(void *arg, const int begin, const int end) {
+    struct EnsembleTask const *task = ( struct EnsembleTask const * )arg;
+    int g;
+    for ( g = begin; g < end; g++ ) {
+        run_group(&task->ens->group[g], task->steps, task->dt, task->bound);
+    }
+}
+
+/**
+* @fn SĂ̌nQENb^@Ői߂.
+* @param steps eni߂Xebv̏
+* @param dt ̕ω
+* @param bound n̑SĂ̐_𒆐SƂ2bound͈̔͂o炻̌n~߂ ̂Ƃ~߂Ȃ
+* @param pool ƃXbh NULL̂ƂĂяoXbhŐi߂
+* @detail ~܂n͂ȏi߂, gsteps, mergesɐi߂Xebvƍ̂Ō̐c.
+*         ČĂԂƎ~܂ĂȂni
+*/
+void run_ensemble(struct Ensemble *ens, const long steps, const double dt, const double bound, struct ThreadPool *pool) {
+    struct EnsembleTask task;
+    task.ens = ens;
+    task.steps = steps;
+    task.dt = dt;
+    task.bound = bound;
+    //detect the kernel before the workers read it
+    get_force_kernel();
+    //each group runs to the end without waiting for the others
+    parallel_for(pool, ens->groups, 1, ensemble_task, &task);
+}
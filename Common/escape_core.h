@@ -0,0 +1,339 @@
+/**
+* @brief n甲o̊Ǘ
+* 2ł3ł̋ʕ escape1.c  escape3.c ꂼ escape*.h ̌ɃCN[h
+* @detail
+* c甲o͉֔ы葱̂, ڑałO(N^2)̑ǧvZƏՓ˂̔Ɏc葱.
+* classify_escapers͑ꂽ̏dS radius 艓, O֌ē,
+* dŜ܂̃GlM[ 1/2 w^2 - G M / r ̐𔲂oƂ, žֈڂ.
+* oǂ̏d͖͂, ̋ߎň.
+*   ỏ^   ꂽdŜ܂̒PɎqƎldɎqŋߎd͂̒, [vtbO@Ői߂ (O(1)/)
+*   ꂽւ̏d ȍd͂𑩔ꂽ̏dŜ܂ɓWJ, lȍƒ̍Ƃ
+*                        xɉ (work->external. WJ̓XebvƂɈxO(o̐))
+* o͖߂ĂȂ. ꂽ̏Wς̂, ڂ͐ϕ@̎g񂷉x̂Ă邱.
+* `FbN|Cgɂ͔o̐ƎʂԂƂċL^, ĊJƂɓ瑱.
+*/
+#include <math.h>
+#include <string.h>
+
+extern const double G;
+
+#define AXIS_POSITION(X) stars->X,
+#define AXIS_PREVIOUS(X) stars->pre_##X,
+#define AXIS_VELOCITY(X) stars->v##X,
+#define AXIS_CENTER(X) esc->center.X,
+#define AXIS_DRIFT(X) esc->velocity.X,
+
+void init_escapers(const double radius, struct Escapers *esc) {
+    memset(esc, 0, sizeof(struct Escapers));
+    esc->radius = radius;
+}
+
+/**
+* @fn ̐̑SĂ̒lւ.
+*/
+static void swap_stars(struct Stars *stars, const int i, const int j) {
+    double swap;
+#define SWAP(A) swap = A[i]; A[i] = A[j]; A[j] = swap;
+#define SWAP_AXIS(X) SWAP(stars->X) SWAP(stars->pre_##X) SWAP(stars->v##X)
+    SWAP(stars->m)
+    FOR_AXES(SWAP_AXIS)
+#undef SWAP_AXIS
+#undef SWAP
+}
+
+/**
+* @fn Փ˂őꂽƂ, ̔ol߂.
+* @param size SĂ̐̐
+* @param bound Փ˂̑Ȏꂽ̐
+* @param merged Փ˂̌̑ꂽ̐
+* @return l߂̑SĂ̐̐
+*/
+int shift_escapers(const int size, const int bound, const int merged, struct Stars *stars) {
+    const size_t length = sizeof(double) * ( size - bound );
+    if ( merged == bound || size == bound ) {
+        return size - ( bound - merged );
+    }
+    memmove(&stars->m[merged], &stars->m[bound], length);
+#define SHIFT_AXIS(X) \
+    memmove(&stars->X[merged], &stars->X[bound], length); \
+    memmove(&stars->pre_##X[merged], &stars->pre_##X[bound], length); \
+    memmove(&stars->v##X[merged], &stars->v##X[bound], length);
+    FOR_AXES(SHIFT_AXIS)
+#undef SHIFT_AXIS
+    return size - ( bound - merged );
+}
+
+/**
+* @fn ꂽ̎, dS, dS̑xƏdŜ܂̎ldɃ[g߂.
+* @param bound ꂽ̐
+*/
+static void measure_bound(const int bound, struct Stars const *stars, struct Escapers *esc) {
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double const *velocity[GRAVITY_DIM] = { FOR_AXES(AXIS_VELOCITY) };
+    double c[GRAVITY_DIM], w[GRAVITY_DIM];
+    double mass = 0;
+    int i, k, l;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        c[k] = 0;
+        w[k] = 0;
+        for ( l = 0; l < GRAVITY_DIM; l++ ) {
+            esc->q[k][l] = 0;
+        }
+    }
+    for ( i = 0; i < bound; i++ ) {
+        mass += stars->m[i];
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            c[k] += stars->m[i] * position[k][i];
+            w[k] += stars->m[i] * velocity[k][i];
+        }
+    }
+    if ( mass > 0 ) {
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            c[k] /= mass;
+            w[k] /= mass;
+        }
+    }
+    //Q =  m (3 d d^T - |d|^2 I), the same moment as the cells of the tree
+    for ( i = 0; i < bound; i++ ) {
+        double d[GRAVITY_DIM], d2 = 0;
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            d[k] = position[k][i] - c[k];
+            d2 += d[k] * d[k];
+        }
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                esc->q[k][l] += stars->m[i] * ( 3 * d[k] * d[l] - ( k == l ? d2 : 0 ) );
+            }
+        }
+    }
+    esc->bound_mass = mass;
+    k = 0;
+#define STORE_CENTER(X) esc->center.X = c[k]; esc->velocity.X = w[k]; k++;
+    FOR_AXES(STORE_CENTER)
+#undef STORE_CENTER
+}
+
+/**
+* @fn ꂽPɎqƎldɎqŋߎd͂߂.
+* @param d ꂽ̏dS猩ʒu
+* @param a x
+*/
+static void bound_field(struct Escapers const *esc, double const *d, double *a) {
+    double qd[GRAVITY_DIM], dqd = 0, r2 = 0;
+    double inv2, inv3, inv5;
+    int k, l;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        r2 += d[k] * d[k];
+        qd[k] = 0;
+        for ( l = 0; l < GRAVITY_DIM; l++ ) {
+            qd[k] += esc->q[k][l] * d[l];
+        }
+        dqd += d[k] * qd[k];
+    }
+    if ( r2 <= 0 ) {
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            a[k] = 0;
+        }
+        return;
+    }
+    inv2 = 1.0 / r2;
+    inv3 = inv2 * sqrt(inv2);
+    inv5 = inv3 * inv2;
+    //phi = M / r + 1/2 (d^T Q d) / r^5, a = grad phi
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        a[k] = G * ( -esc->bound_mass * d[k] * inv3 + qd[k] * inv5 - 2.5 * dqd * d[k] * inv5 * inv2 );
+    }
+}
+
+/**
+* @fn ꂽ̂ožֈڂ.
+* @param size SĂ̐̐ esc->count͊ɔo
+* @return Vɔo̐ 1ȏ̂Ƃ͐ϕ@̎g񂷉x̂Ă邱
+*/
+int classify_escapers(const int size, struct Stars *stars, struct Escapers *esc) {
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double const *velocity[GRAVITY_DIM] = { FOR_AXES(AXIS_VELOCITY) };
+    int bound = size - esc->count;
+    int escaped = 0;
+    int i, k;
+    if ( esc->radius <= 0 ) {
+        return 0;
+    }
+    measure_bound(bound, stars, esc);
+    {
+        const double center[GRAVITY_DIM] = { FOR_AXES(AXIS_CENTER) };
+        const double drift[GRAVITY_DIM] = { FOR_AXES(AXIS_DRIFT) };
+        for ( i = 0; i < bound; ) {
+            double r2 = 0, w2 = 0, dw = 0;
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                const double d = position[k][i] - center[k];
+                const double w = velocity[k][i] - drift[k];
+                r2 += d * d;
+                w2 += w * w;
+                dw += d * w;
+            }
+            //far, receding and unbound from the rest
+            if ( r2 > esc->radius * esc->radius && dw > 0 && 0.5 * w2 > G * ( esc->bound_mass - stars->m[i] ) / sqrt(r2) ) {
+                esc->mass += stars->m[i];
+                bound--;
+                //the star moved to i is examined next
+                swap_stars(stars, i, bound);
+                escaped++;
+            } else {
+                i++;
+            }
+        }
+    }
+    esc->count += escaped;
+    return escaped;
+}
+
+/**
+* @fn ȍd͂𑩔ꂽ̏dŜ܂ɓWJ, accelerations悤ɂ.
+* @detail Xebv̏߂ɈxĂ. ỏ^Ɏgꂽ̏dSƎldɃ[gŋ߂.
+*         oȂwork->externalNULLɂ
+*/
+void prepare_escapers(const int size, struct Stars const *stars, struct Escapers *esc, struct Workspace *work) {
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    const int bound = size - esc->count;
+    int i, k, l;
+    if ( esc->count <= 0 ) {
+        work->external = NULL;
+        return;
+    }
+    measure_bound(bound, stars, esc);
+    {
+        const double center[GRAVITY_DIM] = { FOR_AXES(AXIS_CENTER) };
+        struct ExternalField *f = &esc->field;
+        f->center = esc->center;
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            f->a[k] = 0;
+            for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                f->t[k][l] = 0;
+            }
+        }
+        //a(c + d) =  m (s - d) / |s - d|^3   m s / s^3 +  m (3 s s^T - s^2 I) / s^5 d
+        for ( i = bound; i < size; i++ ) {
+            double s[GRAVITY_DIM], s2 = 0, inv2, inv3, inv5;
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                s[k] = position[k][i] - center[k];
+                s2 += s[k] * s[k];
+            }
+            if ( s2 <= 0 ) {
+                continue;
+            }
+            inv2 = 1.0 / s2;
+            inv3 = inv2 * sqrt(inv2);
+            inv5 = inv3 * inv2;
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                f->a[k] += stars->m[i] * s[k] * inv3;
+                for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                    f->t[k][l] += stars->m[i] * ( 3 * s[k] * s[l] - ( k == l ? s2 : 0 ) ) * inv5;
+                }
+            }
+        }
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            f->a[k] *= G;
+            for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                f->t[k][l] *= G;
+            }
+        }
+    }
+    work->external = &esc->field;
+}
+
+/**
+* @fn o[vtbO@1Xebvi߂.
+* @param h ꂽi߂̕ω
+* @detail ꂽ̏dS̓Xebv̊Ԃ̑xœɓƂ. prepare_escaperšɌĂ.
+*         ÕXebv̈ʒü͍ʒuƓɂĂ. IC[@͈ʒu̔zւ邪, o͂ǂǂł悢
+*/
+void propagate_escapers(const int size, const double h, struct Stars *stars, struct Escapers const *esc) {
+    double *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double *previous[GRAVITY_DIM] = { FOR_AXES(AXIS_PREVIOUS) };
+    double *velocity[GRAVITY_DIM] = { FOR_AXES(AXIS_VELOCITY) };
+    const double center[GRAVITY_DIM] = { FOR_AXES(AXIS_CENTER) };
+    const double drift[GRAVITY_DIM] = { FOR_AXES(AXIS_DRIFT) };
+    int i, k;
+    for ( i = size - esc->count; i < size; i++ ) {
+        double d[GRAVITY_DIM], a[GRAVITY_DIM];
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            d[k] = position[k][i] - center[k];
+        }
+        bound_field(esc, d, a);
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            velocity[k][i] += a[k] * h * 0.5;
+            position[k][i] += velocity[k][i] * h;
+            d[k] = position[k][i] - center[k] - drift[k] * h;
+        }
+        bound_field(esc, d, a);
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            velocity[k][i] += a[k] * h * 0.5;
+            previous[k][i] = position[k][i];
+        }
+    }
+}
+
+/**
+* @fn o̐Ǝʂ`FbN|Cg̋Ԃɉ.
+* @detail o͔žɂ̂, ΍ĊJƂɓɖ߂.
+*         dSldɃ[g̓XebvƂɋߒ̂ŋL^Ȃ
+* @return Ƃ1 mۂłȂƂ0 oȂΉ1
+*/
+int save_escapers(struct Escapers const *esc, struct StarsExtra *extra) {
+    struct {
+        int64_t count;
+        double mass;
+    } record;
+    void *contents;
+    if ( esc->count <= 0 ) {
+        return 1;
+    }
+    contents = add_section(extra, ESCAPE_SECTION, ESCAPE_SECTION_VERSION, sizeof(record));
+    if ( contents == NULL ) {
+        return 0;
+    }
+    record.count = esc->count;
+    record.mass = esc->mass;
+    memcpy(contents, &record, sizeof(record));
+    return 1;
+}
+
+/**
+* @fn `FbN|Cg̋Ԃ甲o̐Ǝʂ߂. init_escaperšɌĂ
+* @param size SĂ̐̐
+* @return ߂Ƃ1 ԂȂoȂƂ0 ̂Ƃ͑SĂ̐𑩔ꂽƂ
+*/
+int restore_escapers(const int size, struct StarsExtra const *extra, struct Escapers *esc) {
+    struct {
+        int64_t count;
+        double mass;
+    } record;
+    size_t length = 0;
+    const void *contents = find_section(extra, ESCAPE_SECTION, ESCAPE_SECTION_VERSION, &length);
+    if ( esc->radius <= 0 || contents == NULL || length != sizeof(record) ) {
+        return 0;
+    }
+    memcpy(&record, contents, sizeof(record));
+    if ( record.count <= 0 || record.count > size ) {
+        return 0;
+    }
+    esc->count = ( int )record.count;
+    esc->mass = record.mass;
+    return 1;
+}
+
+/**
+* @fn Vɔo̐ƑŜ̗lqsŏo.
+* @detail  escape step=... t=... new=... escaped=... bound=... mass=... , mass͔o̎ʂ̍v
+*/
+void write_escapers(FILE *out, const long step, const double time, const int escaped, const int size, struct Escapers const *esc) {
+    fprintf(out, "escape step=%ld t=%.10g new=%d escaped=%d bound=%d mass=%.10g\n",
+        step, time, escaped, esc->count, size - esc->count, esc->mass);
+}
+
+#undef AXIS_POSITION
+#undef AXIS_PREVIOUS
+#undef AXIS_VELOCITY
+#undef AXIS_CENTER
+#undef AXIS_DRIFT
@@ -0,0 +1,649 @@
+/**
+* @brief ̏W̊m, ϕ@, Փ˂̔ 2ł3ł̋ʕ
+* @detail
+* gravity1.c  gravity3.c ꂼ gravity*.h  mapfile.h ̌ɃCN[h, Ƃ̊֐𐶐.
+* Ƃ̎ dimension.h ̃}NœWĴ, ƂɎŏƓɌvZʂςȂ.
+* x̌vZ (accelerations) ƃeLXg̓ǂݍ݂͎ƂɈقȂ̂, CN[h鑤Œ`
+*/
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+* @fn ̔z̃ubN؂oĊmۂ.
+* @param capacity ez̒
+* @param count z̐
+* @param block mۂubN
+* @param stride ׂ荇z̐擪̊Ԋu
+* @return 擪̔z mۂɎsƂNULL
+* @detail ez̐擪STARS_ALIGNMENToCgEɑ, Svf0ŏ
+*/
+double *allocate_arrays(const int capacity, const int count, void **block, size_t *stride) {
+    //round up each array length to a multiple of the alignment
+    const size_t line = STARS_ALIGNMENT / sizeof(double);
+    *stride = ( ( size_t )capacity + line - 1 ) / line * line;
+    *block = calloc(*stride * count + line, sizeof(double));
+    PROFILE_COUNT(PROFILE_ALLOCATIONS, 1);
+    if ( *block == NULL ) {
+        return NULL;
+    }
+    return ( double * )( ( ( uintptr_t )*block + STARS_ALIGNMENT - 1 ) & ~( uintptr_t )( STARS_ALIGNMENT - 1 ) );
+}
+
+/**
+* @fn ̏Wi[zmۂ.
+* @param capacity i[ł鐯̐
+* @param stars mۂzݒ肷鐯̏W
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_stars(const int capacity, struct Stars *stars) {
+    size_t stride;
+    int n = 1;
+    //m, then x, y, z, pre_x, pre_y, pre_z, vx, vy, vz without z in 2D
+    double *base = allocate_arrays(capacity, 1 + GRAVITY_DIM * 3, &stars->block, &stride);
+    stars->mapping = NULL;
+    if ( base == NULL ) {
+        stars->capacity = 0;
+        return 0;
+    }
+    stars->m = base;
+#define STARS_POSITION(X) stars->X = base + stride * n++;
+#define STARS_PREVIOUS(X) stars->pre_##X = base + stride * n++;
+#define STARS_VELOCITY(X) stars->v##X = base + stride * n++;
+    FOR_AXES(STARS_POSITION)
+    FOR_AXES(STARS_PREVIOUS)
+    FOR_AXES(STARS_VELOCITY)
+#undef STARS_POSITION
+#undef STARS_PREVIOUS
+#undef STARS_VELOCITY
+    stars->capacity = capacity;
+    stars->mapping_size = 0;
+    return 1;
+}
+
+/**
+* @fn ϕ̍Ɨ̈mۂ.
+* @param capacity Ɨ̈g̐̏
+* @param work mۂzݒ肷Ɨ̈
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_workspace(const int capacity, struct Workspace *work) {
+    size_t stride;
+    int n = 0;
+    int k;
+    //rx, ry, rz, vx, vy, vz for each of 4 stages, ax, ay, az and phi, without z in 2D
+    double *base = allocate_arrays(capacity, GRAVITY_DIM * 9 + 1, &work->block, &stride);
+    if ( base == NULL ) {
+        work->capacity = 0;
+        return 0;
+    }
+#define STAGE_DISPLACEMENT(X) work->r##X[k] = base + stride * n++;
+#define STAGE_VELOCITY(X) work->v##X[k] = base + stride * n++;
+#define ACCELERATION(X) work->a##X = base + stride * n++;
+    for ( k = 0; k < 4; k++ ) {
+        FOR_AXES(STAGE_DISPLACEMENT)
+        FOR_AXES(STAGE_VELOCITY)
+    }
+    FOR_AXES(ACCELERATION)
+#undef STAGE_DISPLACEMENT
+#undef STAGE_VELOCITY
+#undef ACCELERATION
+    work->phi = base + stride * n++;
+    work->potential = 0;
+    work->tree = NULL;
+    work->pool = NULL;
+    work->external = NULL;
+    work->hook = NULL;
+    work->hook_context = NULL;
+#if GRAVITY_DIM == 3
+    work->fmm = NULL;
+#endif
+    work->capacity = capacity;
+    return 1;
+}
+
+/**
+* @fn ͂̌vZȌd͂x։. accelerationswork->external̂ƂɌĂ
+* @param size x߂̐
+*/
+void add_external(const int size, struct Stars const *stars, struct Workspace *work) {
+    struct ExternalField const *f = work->external;
+#define AXIS_POSITION(X) stars->X,
+#define AXIS_ACCELERATION(X) work->a##X,
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double *acceleration[GRAVITY_DIM] = { FOR_AXES(AXIS_ACCELERATION) };
+#undef AXIS_POSITION
+#undef AXIS_ACCELERATION
+#define AXIS_CENTER(X) f->center.X,
+    const double center[GRAVITY_DIM] = { FOR_AXES(AXIS_CENTER) };
+#undef AXIS_CENTER
+    int i, k, l;
+    for ( i = 0; i < size; i++ ) {
+        double d[GRAVITY_DIM];
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            d[k] = position[k][i] - center[k];
+        }
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            double a = f->a[k];
+            for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                a += f->t[k][l] * d[l];
+            }
+            acceleration[k][i] += a;
+        }
+    }
+}
+
+void free_workspace(struct Workspace *work) {
+    free(work->block);
+    work->block = NULL;
+    work->capacity = 0;
+}
+
+void free_stars(struct Stars *stars) {
+    free(stars->block);
+    stars->block = NULL;
+    //arrays loaded from a binary file point into its mapping
+    unmap_file(stars->mapping, stars->mapping_size);
+    stars->mapping = NULL;
+    stars->capacity = 0;
+}
+
+/**
+* @fn IC[@pĎ̎̈ʒuExvZ.
+* @param dt ̕ω
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param work Ɨ̈ eʂsizeȏł邱
+*/
+void euler(const int size, const double dt, struct Stars *stars, struct Workspace *work) {
+    double *swap;
+    //!!Caution!! Not write new position value while calculating the acceleration of other stars
+    accelerations(size, stars, work);
+    for ( int i = 0; i < size; i++ ) {
+        // dv = a * dt, then write new position value to pre_x, pre_y, pre_z
+        // dr = v * dt
+#define EULER_STEP(X) \
+        stars->v##X[i] += work->a##X[i] * dt; \
+        stars->pre_##X[i] = stars->X[i] + stars->v##X[i] * dt;
+        FOR_AXES(EULER_STEP)
+#undef EULER_STEP
+    }
+    //swap old and new value
+#define EULER_SWAP(X) \
+    swap = stars->X; \
+    stars->X = stars->pre_##X; \
+    stars->pre_##X = swap;
+    FOR_AXES(EULER_SWAP)
+#undef EULER_SWAP
+}
+
+
+/**
+* @fn QENb^@pĎ̎̈ʒuExvZ.
+* @param dt ̕ω
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param work Ɨ̈ eʂsizeȏł邱
+*/
+void runge_kutta(const int size, const double dt, struct Stars *stars, struct Workspace *work) {
+    /*
+    t:time
+    r:position of star (vector)
+    v:velosity of star (vector)
+    target equation : 1/dt(dr/dt) = f(t,r,v)
+    f(t,r,v) = sum (G * m' * (r'-r) * |r'-r|^-3 )  not depending on v or t
+    r', m' is mass and position of other stars
+    => dv/dt = f(r) AND dr/dt = v
+    calc following values;
+    v1 = dt * f(r)           r1 = dt * v
+    v2 = dt * f(r+r1/2)      r2 = dt * (v+v1/2)
+    v3 = dt * f(r+r2/2)      r3 = dt * (v+v2/2)
+    v4 = dt * f(r+r3  )      r4 = dt * (v+v3  )
+    r(next) = r + (r1+2*r2+2*r3+r4)/6
+    v(next) = v + (v1+2*v2+2*v3+v4)/6
+    */
+
+    int i;
+    //work->rx[k], work->vx[k] and so on hold r(k+1), v(k+1) of all the stars
+#define RK_STORE(X) stars->pre_##X[i] = stars->X[i];
+#define RK_FIRST(X) \
+        work->v##X[0][i] = work->a##X[i] * dt; \
+        work->r##X[0][i] = stars->v##X[i] * dt;
+#define RK_STAGE(X) \
+        work->v##X[k][i] = work->a##X[i] * dt; \
+        work->r##X[k][i] = ( work->v##X[k - 1][i] * half + stars->v##X[i] ) * dt;
+#define RK_MOVE(X) stars->X[i] = work->r##X[k - 1][i] * half + stars->pre_##X[i];
+#define RK_NEXT(X) \
+        stars->X[i] = stars->pre_##X[i] + work->r##X[0][i] * ( 1.0 / 6.0 ) + work->r##X[1][i] * ( 2.0 / 6.0 ) \
+            + work->r##X[2][i] * ( 2.0 / 6.0 ) + work->r##X[3][i] * ( 1.0 / 6.0 ); \
+        stars->v##X[i] = stars->v##X[i] + work->v##X[0][i] * ( 1.0 / 6.0 ) + work->v##X[1][i] * ( 2.0 / 6.0 ) \
+            + work->v##X[2][i] * ( 2.0 / 6.0 ) + work->v##X[3][i] * ( 1.0 / 6.0 );
+    for ( i = 0; i < size; i++ ) {
+        //store previous position
+        FOR_AXES(RK_STORE)
+    }
+
+    //v1 = dt * f(r), r1 = dt * v
+    PROFILE_BEGIN(PROFILE_RK4_STAGE1);
+    accelerations(size, stars, work);
+    for ( i = 0; i < size; i++ ) {
+        FOR_AXES(RK_FIRST)
+    }
+    PROFILE_END(PROFILE_RK4_STAGE1);
+    for ( int k = 1; k < 4; k++ ) {
+        //set r+r1/2, r+r2/2 and r+r3 in turn. the last stage takes a whole step
+        const double half = k < 3 ? 0.5 : 1.0;
+        PROFILE_BEGIN(PROFILE_RK4_STAGE1 + k);
+        for ( i = 0; i < size; i++ ) {
+            FOR_AXES(RK_MOVE)
+        }
+        //v(k+1) = dt * f(r+rk/2), r(k+1) = dt * (v+vk/2)
+        accelerations(size, stars, work);
+        for ( i = 0; i < size; i++ ) {
+            FOR_AXES(RK_STAGE)
+        }
+        PROFILE_END(PROFILE_RK4_STAGE1 + k);
+    }
+    for ( i = 0; i < size; i++ ) {
+        //r(next) = r + (r1+2*r2+2*r3+r4)/6
+        //v(next) = v + (v1+2*v2+2*v3+v4)/6
+        FOR_AXES(RK_NEXT)
+    }
+#undef RK_STORE
+#undef RK_FIRST
+#undef RK_STAGE
+#undef RK_MOVE
+#undef RK_NEXT
+}
+
+/**
+* @fn [vtbO@ (kick-drift-kick) pĎ̎̈ʒuExvZ.
+* @param dt ̕ω
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param work Ɨ̈ ax, ayȂǂɌ݂̈ʒuł̉xĂ邱. IƎ̎̉x
+* @detail ÕXebv̍ŌɌvZxg񂷂̂, x̌vZ1Xebv1ōς.
+*         VvNeBbN@Ȃ̂, ԐϕĂGlM[̌덷Ȃ
+*/
+void leapfrog(const int size, const double dt, struct Stars *stars, struct Workspace *work) {
+    const double half = dt * 0.5;
+#define LEAPFROG_KICK(X) stars->v##X[i] += work->a##X[i] * half;
+#define LEAPFROG_DRIFT(X) stars->X[i] += stars->v##X[i] * dt;
+    for ( int i = 0; i < size; i++ ) {
+        //kick by a half step, then drift by a whole step
+        FOR_AXES(LEAPFROG_KICK)
+        FOR_AXES(LEAPFROG_DRIFT)
+    }
+    accelerations(size, stars, work);
+    for ( int i = 0; i < size; i++ ) {
+        FOR_AXES(LEAPFROG_KICK)
+    }
+#undef LEAPFROG_KICK
+#undef LEAPFROG_DRIFT
+}
+
+/**
+* @fn gc̕@, d݂t[vtbO@gݍ킹Ď̎̈ʒuExvZ.
+* @param dt ̕ω
+* @param order  4܂6. 1Xebv̉x̌vZ͂ꂼ37
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param work Ɨ̈ leapfrogƓ݂̉xĂ邱
+*/
+void yoshida(const int size, const double dt, const int order, struct Stars *stars, struct Workspace *work) {
+    //w1 = 1 / (2 - 2^(1/3)), w0 = 1 - 2 w1
+    static const double w4[3] = { 1.3512071919596578, -1.7024143839193153, 1.3512071919596578 };
+    //solution A of Yoshida (1990), w0 = 1 - 2 (w1 + w2 + w3)
+    static const double w6[7] = {
+        0.784513610477560, 0.235573213359357, -1.17767998417887, 1.31518632068391,
+        -1.17767998417887, 0.235573213359357, 0.784513610477560,
+    };
+    const double *w = order >= 6 ? w6 : w4;
+    const int stages = order >= 6 ? 7 : 3;
+    for ( int k = 0; k < stages; k++ ) {
+        leapfrog(size, w[k] * dt, stars, work);
+    }
+}
+
+#define SWEEP_MARGIN 1.000001  // widens the swept boxes against rounding errors
+
+/**
+* Փ˂̔ő|鐯. x̋Ԃ̉[ŕׂ
+*/
+struct SweepEntry {
+    double lower;       // lower end of the box along x
+    int index;
+};
+
+/**
+* Փ˂̑g i < j
+*/
+struct CollisionPair {
+    int i;
+    int j;
+};
+
+int is_collision(struct Stars const *stars, const int a, const int b, double dt) {
+    //(Ԃ̑Αx̑Ζʕ) * dt < (Ԃ̋)
+    struct GRAVITY_VECTOR r, v;
+#define RELATIVE(X) \
+    r.X = stars->X[b] - stars->X[a]; \
+    v.X = stars->v##X[b] - stars->v##X[a];
+    FOR_AXES(RELATIVE)
+#undef RELATIVE
+    double d = sqrt(dot_vector(&r, &r));
+    double s = dot_vector(&r, &v) / d; //Ζʕ̐
+    return d < s * dt;
+}
+
+/**
+* @fn W菜㑱̐l߂.
+* @param size SĂ̐̐
+* @param index 菜
+* @param stars ̏W
+*/
+void remove_star(const int size, const int index, struct Stars *stars) {
+    const size_t length = sizeof(double) * ( size - index - 1 );
+    memmove(&stars->m[index], &stars->m[index + 1], length);
+#define REMOVE_POSITION(X) memmove(&stars->X[index], &stars->X[index + 1], length);
+#define REMOVE_PREVIOUS(X) memmove(&stars->pre_##X[index], &stars->pre_##X[index + 1], length);
+#define REMOVE_VELOCITY(X) memmove(&stars->v##X[index], &stars->v##X[index + 1], length);
+    FOR_AXES(REMOVE_POSITION)
+    FOR_AXES(REMOVE_PREVIOUS)
+    FOR_AXES(REMOVE_VELOCITY)
+#undef REMOVE_POSITION
+#undef REMOVE_PREVIOUS
+#undef REMOVE_VELOCITY
+}
+
+/**
+* @fn jiɍ̂. j͌Ŏ菜
+*/
+static void merge_stars(const int i, const int j, struct Stars *stars) {
+    //Փ˂݂͌̈ʒȗxxNǧŔ
+    //Փˌ̐stars[i]//_VWɐݒ
+    const double m = stars->m[i] + stars->m[j];
+    //^ʕۑ
+#define MERGE(X) \
+    stars->X[i] = ( stars->X[i] + stars->X[j] ) * 0.5; \
+    stars->v##X[i] = ( stars->v##X[i] * stars->m[i] + stars->v##X[j] * stars->m[j] ) * ( 1.0 / m );
+    FOR_AXES(MERGE)
+#undef MERGE
+    stars->m[i] = m;
+}
+
+/**
+* @fn jiɍ̂O, ̍̂L^ɒǋL. L^L΂ȂƂ͋L^Ȃ
+* @param log ̂̋L^ NULL̂ƂȂ
+*/
+static void record_merge(const int i, const int j, struct Stars const *stars, struct MergeLog *log) {
+    struct MergeEvent *event;
+    struct GRAVITY_VECTOR v;
+    if ( log == NULL ) {
+        return;
+    }
+    if ( log->count == log->capacity ) {
+        const int grown = log->capacity > 0 ? log->capacity * 2 : 16;
+        struct MergeEvent *larger = ( struct MergeEvent * )realloc(log->events, sizeof(struct MergeEvent) * grown);
+        if ( larger == NULL ) {
+            return;
+        }
+        log->events = larger;
+        log->capacity = grown;
+        PROFILE_COUNT(PROFILE_ALLOCATIONS, 1);
+    }
+    event = &log->events[log->count++];
+    event->i = i;
+    event->j = j;
+    event->mi = stars->m[i];
+    event->mj = stars->m[j];
+#define EVENT(X) \
+    event->position.X = ( stars->X[i] + stars->X[j] ) * 0.5; \
+    v.X = stars->v##X[j] - stars->v##X[i];
+    FOR_AXES(EVENT)
+#undef EVENT
+    event->speed = sqrt(dot_vector(&v, &v));
+}
+
+void free_merge_log(struct MergeLog *log) {
+    free(log->events);
+    log->events = NULL;
+    log->count = 0;
+    log->capacity = 0;
+}
+
+/**
+* @fn ŏɌĝ. |̍Ɨ̈mۂłȂƂɎg
+* @return ̂̐̐
+*/
+static int collision_first(const int size, const double dt, struct Stars *stars, struct MergeLog *log, int const *partner) {
+    for ( int i = 0; i < size - 1; i++ ) {
+        for ( int j = i + 1; j < size; j++ ) {
+            if ( partner != NULL && partner[i] == j ) {
+                continue;
+            }
+            if ( is_collision(stars, i, j, dt) ) {
+                record_merge(i, j, stars, log);
+                merge_stars(i, j, stars);
+                remove_star(size, j, stars);
+                return size - 1;
+            }
+        }
+    }
+    return size;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const struct SweepEntry *p = ( const struct SweepEntry * )a;
+    const struct SweepEntry *q = ( const struct SweepEntry * )b;
+    //not-a-number last, ties by index so that the order does not depend on qsort
+    if ( ( p->lower != p->lower ) != ( q->lower != q->lower ) ) {
+        return p->lower != p->lower ? 1 : -1;
+    }
+    if ( p->lower < q->lower ) {
+        return -1;
+    }
+    if ( p->lower > q->lower ) {
+        return 1;
+    }
+    return p->index - q->index;
+}
+
+static int compare_pairs(const void *a, const void *b) {
+    const struct CollisionPair *p = ( const struct CollisionPair * )a;
+    const struct CollisionPair *q = ( const struct CollisionPair * )b;
+    return p->i != q->i ? p->i - q->i : p->j - q->j;
+}
+
+/**
+* @fn 菜̕t, cԂۂċl߂.
+* @return c̐
+*/
+static int compact_stars(const int size, unsigned char const *removed, struct Stars *stars) {
+    int n = 0;
+#define COMPACT(X) \
+            stars->X[n] = stars->X[i]; \
+            stars->pre_##X[n] = stars->pre_##X[i]; \
+            stars->v##X[n] = stars->v##X[i];
+    for ( int i = 0; i < size; i++ ) {
+        if ( removed[i] ) {
+            continue;
+        }
+        if ( n != i ) {
+            stars->m[n] = stars->m[i];
+            FOR_AXES(COMPACT)
+        }
+        n++;
+    }
+#undef COMPACT
+    return n;
+}
+
+/**
+* @fn Փ˂̔ő|Ɨ̈mۂ.
+* @param capacity xɔ肷鐯̐̏
+* @return mۂɐƂ1 sƂ0. sĂcollision_excludingɓn, ̂Ƃ͌ĂԂтɊmۂ
+*/
+int allocate_sweep(const int capacity, struct Sweep *sweep) {
+    const int n = capacity > 0 ? capacity : 1;
+    const size_t entries = sizeof(struct SweepEntry) * n;
+    const size_t radius = sizeof(double) * n;
+    sweep->block = malloc(entries + radius + n);
+    sweep->pairs = ( struct CollisionPair * )malloc(sizeof(struct CollisionPair) * n);
+    if ( sweep->block == NULL || sweep->pairs == NULL ) {
+        free_sweep(sweep);
+        return 0;
+    }
+    sweep->entries = ( struct SweepEntry * )sweep->block;
+    sweep->radius = ( double * )( ( char * )sweep->block + entries );
+    sweep->removed = ( unsigned char * )sweep->block + entries + radius;
+    sweep->capacity = n;
+    sweep->pair_capacity = n;
+    return 1;
+}
+
+void free_sweep(struct Sweep *sweep) {
+    free(sweep->block);
+    free(sweep->pairs);
+    sweep->block = NULL;
+    sweep->pairs = NULL;
+    sweep->entries = NULL;
+    sweep->radius = NULL;
+    sweep->removed = NULL;
+    sweep->capacity = 0;
+    sweep->pair_capacity = 0;
+}
+
+/**
+* @fn mۍς݂̍Ɨ̈ő|, Փ˂Sč̂.
+* @return ̂̐̐
+*/
+static int sweep_collision(int const size, const double dt, struct Stars *stars, struct MergeLog *log, int const *partner,
+    struct Sweep *sweep) {
+    struct SweepEntry *entries = sweep->entries;
+    double *radius = sweep->radius;
+    unsigned char *removed = sweep->removed;
+    struct GRAVITY_VECTOR center = { 0 };
+    int count = 0, merged = 0;
+    memset(removed, 0, size);
+    //the relative speed of a pair is at most the sum of their speeds measured from any common velocity
+#define CENTER_SUM(X) center.X += stars->v##X[i];
+#define CENTER_MEAN(X) center.X /= size;
+#define SPEED(X) u.X = stars->v##X[i] - center.X;
+    for ( int i = 0; i < size; i++ ) {
+        FOR_AXES(CENTER_SUM)
+    }
+    FOR_AXES(CENTER_MEAN)
+    for ( int i = 0; i < size; i++ ) {
+        struct GRAVITY_VECTOR u;
+        FOR_AXES(SPEED)
+        radius[i] = sqrt(dot_vector(&u, &u)) * dt * SWEEP_MARGIN;
+        entries[i].lower = stars->x[i] - radius[i];
+        entries[i].index = i;
+    }
+#undef CENTER_SUM
+#undef CENTER_MEAN
+#undef SPEED
+    qsort(entries, size, sizeof(struct SweepEntry), compare_entries);
+#define APART(X) fabs(stars->X[j] - stars->X[i]) > reach
+    for ( int a = 0; a < size; a++ ) {
+        const int i = entries[a].index;
+        const double upper = stars->x[i] + radius[i];
+        for ( int b = a + 1; b < size && entries[b].lower <= upper; b++ ) {
+            const int j = entries[b].index;
+            const double reach = radius[i] + radius[j];
+            const int first = i < j ? i : j;
+            const int second = i < j ? j : i;
+            if ( ANY_CROSS_AXES(APART) ) {
+                continue;
+            }
+            if ( partner != NULL && partner[first] == second ) {
+                continue;
+            }
+            if ( !is_collision(stars, first, second, dt) ) {
+                continue;
+            }
+            if ( count == sweep->pair_capacity ) {
+                const int grown = sweep->pair_capacity > 0 ? sweep->pair_capacity * 2 : 16;
+                struct CollisionPair *larger = ( struct CollisionPair * )realloc(sweep->pairs, sizeof(struct CollisionPair) * grown);
+                if ( larger == NULL ) {
+                    //merge the pairs found so far, the rest are found again in the next step
+                    break;
+                }
+                //kept for the following passes
+                sweep->pairs = larger;
+                sweep->pair_capacity = grown;
+                PROFILE_COUNT(PROFILE_ALLOCATIONS, 1);
+            }
+            sweep->pairs[count].i = first;
+            sweep->pairs[count].j = second;
+            count++;
+        }
+    }
+#undef APART
+    //the same order as checking every pair with i < j
+    if ( count > 1 ) {
+        qsort(sweep->pairs, count, sizeof(struct CollisionPair), compare_pairs);
+    }
+    for ( int k = 0; k < count; k++ ) {
+        const int i = sweep->pairs[k].i;
+        const int j = sweep->pairs[k].j;
+        if ( removed[i] || removed[j] ) {
+            continue;
+        }
+        //star i may have absorbed another one earlier in this pass
+        if ( k > 0 && !is_collision(stars, i, j, dt) ) {
+            continue;
+        }
+        record_merge(i, j, stars, log);
+        merge_stars(i, j, stars);
+        removed[j] = 1;
+        merged++;
+    }
+    PROFILE_COUNT(PROFILE_MERGES, merged);
+    return merged > 0 ? compact_stars(size, removed, stars) : size;
+}
+
+/**
+* @fn Փ˂Sč̂.
+* @param size SĂ̐̐
+* @param dt ̕ω
+* @param stars ̏W
+* @param log ̂ƂɒǋLL^ NULL̂ƂL^Ȃ
+* @return ̂̐̐
+* @detail is_collision͑Αx̑傫~dt߂gł藧Ȃ̂, e𑬓x̒S̑~dt̔a̔ŕ,
+*         xɕבւđ|(sweep and prune), dȂg𒲂ׂ.
+*         g͓Y̏ɍ̂, ɍ̂Ď菜܂ޑg͔΂. ̂Ő̏Wςg͔肵.
+*         xőSĂ̏Փ˂̂, 菜͍Ōɂ܂Ƃ߂ċl߂.
+*         |̍Ɨ̈͌ĂԂтɊmۂ. XebvƂɌĂԂƂcollision_excludingɊmۍς݂̍Ɨ̈n
+*/
+int collision(int const size, const double dt, struct Stars *stars, struct MergeLog *log) {
+    return collision_excluding(size, dt, stars, log, NULL, NULL);
+}
+
+/**
+* @fn collisionƓՓ˂Sč̂. ipartner[i]̑ĝ͍Ȃ
+* @param partner Ƃɍ̂Ȃ (i < partner[i] ̑g). 肪ȂΕ̒l. NULL̂ƂcollisionƓ
+* @param sweep allocate_sweepŊmۂ|̍Ɨ̈. q[vg킸Ɏg
+*              NULL̂ƂeʂsizeɑȂƂ, ̌Ăяo̊Ԃmۂ
+* @detail ĕʂɐϕߐژA, ݕ葬߂ÂĂ̂Ȃ
+*/
+int collision_excluding(int const size, const double dt, struct Stars *stars, struct MergeLog *log, int const *partner,
+    struct Sweep *sweep) {
+    struct Sweep local;
+    int count;
+    if ( size < 2 || !( dt > 0 ) ) {
+        return size;
+    }
+    if ( sweep != NULL && sweep->capacity >= size ) {
+        return sweep_collision(size, dt, stars, log, partner, sweep);
+    }
+    PROFILE_COUNT(PROFILE_ALLOCATIONS, 2);
+    if ( !allocate_sweep(size, &local) ) {
+        return collision_first(size, dt, stars, log, partner);
+    }
+    count = sweep_collision(size, dt, stars, log, partner, &local);
+    free_sweep(&local);
+    return count;
+}
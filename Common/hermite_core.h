@@ -0,0 +1,299 @@
+/**
+* @brief 4̃G~[g@ƊKwIȌʎԍ
+* 2ł3ł̋ʕ hermite1.c  hermite3.c ꂼ hermite*.h, force*.h  pool.h ̌ɃCN[h
+* @detail
+* xƈꏏɂ̎Ԕ (jerk) vZ, SĂ̐̈ʒuƑx𓯂֗\Ă
+* VxjerkŏC. ݂͐ƂɑI, 1Xebv̕2ׂ̂Ŋlɑ̂,
+* ɍ݂I鐯̏W (ubN) xvZ΂悢.
+* ߐژA݂̍ZȂĂ, ̐͂̉{݂̍Ői.
+* 1Xebv̏Iɂ͑SĂ̐ɑ̂, Փ˂̔o͂̓Xebv̊Ԃɍs.
+* x͏ɒڑaŌvZ. ؂⑽dɓWJ̋ߎłjerk̐xȂ.
+*  (set_force_softening) w肷Ɖxjerkjœ.
+*/
+#include <math.h>
+#include <stdlib.h>
+
+#define HERMITE_CHUNK 16    // active stars per task of the parallel force evaluation
+
+extern const double G;
+
+struct HermiteTask {
+    int size;
+    struct Stars const* stars;
+    struct Hermite* hermite;
+};
+
+/**
+* @fn G~[g@̍Ɨ̈mۂ.
+* @param capacity ̐̏
+* @param eta ݕ߂鐸x̌W 0ȉ̂ƂHERMITE_ETA
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_hermite(const int capacity, const double eta, struct Hermite *hermite) {
+    size_t stride;
+    int n = 0;
+    //ax, ay, az, jx, jy, jz, ax1, ay1, az1, jx1, jy1, jz1, px, py, pz, pvx, pvy, pvz without z in 2D
+    double *base = allocate_arrays(capacity, GRAVITY_DIM * 6, &hermite->block, &stride);
+    int *indices;
+    if ( base == NULL ) {
+        hermite->capacity = 0;
+        return 0;
+    }
+    //3 arrays : level, tick, active
+    indices = ( int * )calloc(( size_t )capacity * 3 + 1, sizeof(int));
+    if ( indices == NULL ) {
+        free(hermite->block);
+        hermite->block = NULL;
+        hermite->capacity = 0;
+        return 0;
+    }
+#define HERMITE_ACCELERATION(X) hermite->a##X = base + stride * n++;
+#define HERMITE_JERK(X) hermite->j##X = base + stride * n++;
+#define HERMITE_ACCELERATION1(X) hermite->a##X##1 = base + stride * n++;
+#define HERMITE_JERK1(X) hermite->j##X##1 = base + stride * n++;
+#define HERMITE_POSITION(X) hermite->p##X = base + stride * n++;
+#define HERMITE_VELOCITY(X) hermite->pv##X = base + stride * n++;
+    FOR_AXES(HERMITE_ACCELERATION)
+    FOR_AXES(HERMITE_JERK)
+    FOR_AXES(HERMITE_ACCELERATION1)
+    FOR_AXES(HERMITE_JERK1)
+    FOR_AXES(HERMITE_POSITION)
+    FOR_AXES(HERMITE_VELOCITY)
+#undef HERMITE_ACCELERATION
+#undef HERMITE_JERK
+#undef HERMITE_ACCELERATION1
+#undef HERMITE_JERK1
+#undef HERMITE_POSITION
+#undef HERMITE_VELOCITY
+    hermite->level = indices;
+    hermite->tick = indices + capacity;
+    hermite->active = indices + capacity * 2;
+    hermite->indices = indices;
+    hermite->eta = eta > 0 ? eta : HERMITE_ETA;
+    hermite->blocks = 0;
+    hermite->evaluations = 0;
+    hermite->ready = 0;
+    hermite->capacity = capacity;
+    return 1;
+}
+
+void free_hermite(struct Hermite *hermite) {
+    free(hermite->block);
+    free(hermite->indices);
+    hermite->block = NULL;
+    hermite->indices = NULL;
+    hermite->capacity = 0;
+}
+
+/**
+* @fn \ʒuƑxꕔ̊̐̉xjerkvZ.
+* @detail ʂax1, jx1Ȃǂ֏, Cςނ܂Ō̒lc
+*/
+static void jerk_task(void *arg, const int begin, const int end) {
+    struct HermiteTask *task = ( struct HermiteTask * )arg;
+    struct Hermite *h = task->hermite;
+    const double *m = task->stars->m;
+    const int size = task->size;
+    struct Softening const *soft = get_force_softening();
+    int k, j;
+#define JERK_LOAD(X) p.X = h->p##X[i]; v.X = h->pv##X[i]; a.X = 0; jerk.X = 0;
+#define JERK_RELATIVE(X) d.X = h->p##X[j] - p.X; dv.X = h->pv##X[j] - v.X;
+#define JERK_ADD(X) a.X += k3 * d.X; jerk.X += k3 * ( dv.X - rv * d.X );
+#define JERK_STORE(X) h->a##X##1[i] = a.X * G; h->j##X##1[i] = jerk.X * G;
+    for ( k = begin; k < end; k++ ) {
+        const int i = h->active[k];
+        struct GRAVITY_VECTOR p, v, a, jerk;
+        FOR_AXES(JERK_LOAD)
+        for ( j = 0; j < size; j++ ) {
+            struct GRAVITY_VECTOR d, dv;
+            double r2;
+            FOR_AXES(JERK_RELATIVE)
+            r2 = dot_vector(&d, &d);
+            //skip the star itself
+            if ( r2 > 0 ) {
+                double k3, rv;
+                if ( r2 < soft->h2 ) {
+                    //inside the spline kernel : d/dt (m g r) = m (g v + q (r.v) r)
+                    double q = 0;
+                    const double g = soften(soft, r2, NULL, &q);
+                    k3 = m[j] * g;
+                    rv = -q * dot_vector(&d, &dv) / g;
+                } else {
+                    //d/dt (m r / |r|^3) = m (v - 3 (r.v) r / |r|^2) / |r|^3, Plummer softening replaces |r|^2 by |r|^2 + eps^2
+                    const double inv2 = 1.0 / ( r2 + soft->eps2 );
+                    k3 = m[j] * inv2 * sqrt(inv2);
+                    rv = 3.0 * dot_vector(&d, &dv) * inv2;
+                }
+                FOR_AXES(JERK_ADD)
+            }
+        }
+        FOR_AXES(JERK_STORE)
+    }
+#undef JERK_LOAD
+#undef JERK_RELATIVE
+#undef JERK_ADD
+#undef JERK_STORE
+}
+
+/**
+* @fn ̐̉xjerkvZ.
+* @param count ̐̐
+*/
+static void evaluate(const int count, const int size, struct Stars const *stars, struct Workspace *work, struct Hermite *hermite) {
+    struct HermiteTask task;
+    task.size = size;
+    task.stars = stars;
+    task.hermite = hermite;
+    parallel_for(work->pool, count, HERMITE_CHUNK, jerk_task, &task);
+    hermite->evaluations += count;
+}
+
+/**
+* @fn ]܂ݕɑΉ镪̒iI.
+* @param step ]܂ݕ
+* @param dt 1Xebv̕
+* @param level ̒i
+* @param tick ̎
+* @return dt / 2^i stepȉɂȂŏ̒i. ݂L΂͈̂x2{܂ł,
+*         L΂݂̋Eɍ̎ĂƂ
+*/
+static int choose_level(const double step, const double dt, const int level, const int tick) {
+    double s = dt;
+    int next = 0;
+    //also shortest when step is not a number
+    while ( !( s <= step ) && next < HERMITE_MAX_LEVEL ) {
+        s *= 0.5;
+        next++;
+    }
+    if ( next < level ) {
+        const int longer = 1 << ( HERMITE_MAX_LEVEL - level + 1 );
+        next = tick % longer == 0 ? level - 1 : level;
+    }
+    return next;
+}
+
+/**
+* @fn SĂ̐̈ʒuƑxnow֗\.
+* @param unit ̒P
+*/
+static void predict(const int size, const int now, const double unit, struct Stars const *stars, struct Hermite *h) {
+    int i;
+#define PREDICT(X) \
+        h->p##X[i] = stars->X[i] + s * ( stars->v##X[i] + s * ( h->a##X[i] * 0.5 + s * h->j##X[i] * ( 1.0 / 6.0 ) ) ); \
+        h->pv##X[i] = stars->v##X[i] + s * ( h->a##X[i] + s * h->j##X[i] * 0.5 );
+    for ( i = 0; i < size; i++ ) {
+        const double s = ( now - h->tick[i] ) * unit;
+        FOR_AXES(PREDICT)
+    }
+#undef PREDICT
+}
+
+/**
+* @fn SĂ̐̉xjerkvZ, ŏ݂̍I.
+*/
+static void start(const int size, const double dt, struct Stars *stars, struct Workspace *work, struct Hermite *h) {
+    int i;
+#define START_LOAD(X) h->p##X[i] = stars->X[i]; h->pv##X[i] = stars->v##X[i];
+#define SQUARE_ACCELERATION1(X) h->a##X##1[i] * h->a##X##1[i]
+#define SQUARE_JERK1(X) h->j##X##1[i] * h->j##X##1[i]
+#define START_STORE(X) h->a##X[i] = h->a##X##1[i]; h->j##X[i] = h->j##X##1[i];
+    for ( i = 0; i < size; i++ ) {
+        FOR_AXES(START_LOAD)
+        h->active[i] = i;
+    }
+    evaluate(size, size, stars, work, h);
+    for ( i = 0; i < size; i++ ) {
+        const double a2 = SUM_AXES(SQUARE_ACCELERATION1);
+        const double j2 = SUM_AXES(SQUARE_JERK1);
+        FOR_AXES(START_STORE)
+        //no higher derivatives yet, estimate the step from |a| / |j|
+        h->level[i] = choose_level(j2 > 0 ? HERMITE_ETA_START * sqrt(a2 / j2) : dt, dt, 0, 0);
+    }
+#undef START_LOAD
+#undef SQUARE_ACCELERATION1
+#undef SQUARE_JERK1
+#undef START_STORE
+    h->ready = 1;
+}
+
+/**
+* @fn ̗̐\lVxjerkŏC, ݂̍I.
+* @param count ̐̐
+* @param now C鎞
+*/
+static void correct(const int count, const int now, const double unit, const double dt, struct Stars *stars, struct Hermite *h) {
+    int k;
+    //2nd and 3rd derivatives of the acceleration from the Hermite interpolation on the step
+#define CORRECT(X) \
+        sn.X = ( -6.0 * ( h->a##X[i] - h->a##X##1[i] ) - s * ( 4.0 * h->j##X[i] + 2.0 * h->j##X##1[i] ) ) / s2; \
+        cr.X = ( 12.0 * ( h->a##X[i] - h->a##X##1[i] ) + 6.0 * s * ( h->j##X[i] + h->j##X##1[i] ) ) / s3; \
+        stars->X[i] = h->p##X[i] + s2 * s2 * ( sn.X * ( 1.0 / 24.0 ) + s * cr.X * ( 1.0 / 120.0 ) ); \
+        stars->v##X[i] = h->pv##X[i] + s3 * ( sn.X * ( 1.0 / 6.0 ) + s * cr.X * ( 1.0 / 24.0 ) ); \
+        h->a##X[i] = h->a##X##1[i]; \
+        h->j##X[i] = h->j##X##1[i]; \
+        a.X = h->a##X[i]; \
+        jerk.X = h->j##X[i]; \
+        snap_end.X = sn.X + s * cr.X;
+    for ( k = 0; k < count; k++ ) {
+        const int i = h->active[k];
+        const double s = ( now - h->tick[i] ) * unit;
+        const double s2 = s * s;
+        const double s3 = s2 * s;
+        struct GRAVITY_VECTOR sn, cr, a, jerk, snap_end;
+        double aa, j, snap, crackle;
+        FOR_AXES(CORRECT)
+        h->tick[i] = now;
+        //Aarseth's criterion with the derivatives at the end of the step
+        aa = sqrt(dot_vector(&a, &a));
+        j = sqrt(dot_vector(&jerk, &jerk));
+        snap = sqrt(dot_vector(&snap_end, &snap_end));
+        crackle = sqrt(dot_vector(&cr, &cr));
+        h->level[i] = choose_level(j * crackle + snap * snap > 0 ? sqrt(h->eta * ( aa * snap + j * j ) / ( j * crackle + snap * snap )) : dt,
+            dt, h->level[i], now);
+    }
+#undef CORRECT
+}
+
+/**
+* @fn G~[g@őSĂ̐̕dti߂.
+* @param size SĂ̐̐
+* @param dt 1Xebv̕ Ƃ݂̍͂2ׂ̂Ŋ
+* @param stars ̏W
+* @param work Ɨ̈ ƃXbhg
+* @param hermite Ƃ݂̍ƓvXV
+* @detail IƂɂ͑SĂ̐ɂ
+*/
+void block_hermite(const int size, const double dt, struct Stars *stars, struct Workspace *work, struct Hermite *hermite) {
+    const int end = 1 << HERMITE_MAX_LEVEL;
+    const double unit = dt / end;
+    int now = 0;
+    int i;
+    if ( size <= 0 ) {
+        return;
+    }
+    if ( !hermite->ready ) {
+        start(size, dt, stars, work, hermite);
+    }
+    for ( i = 0; i < size; i++ ) {
+        hermite->tick[i] = 0;
+    }
+    while ( now < end ) {
+        //the stars whose step ends earliest move together
+        int next = end;
+        int count = 0;
+        for ( i = 0; i < size; i++ ) {
+            const int t = hermite->tick[i] + ( 1 << ( HERMITE_MAX_LEVEL - hermite->level[i] ) );
+            next = t < next ? t : next;
+        }
+        for ( i = 0; i < size; i++ ) {
+            if ( hermite->tick[i] + ( 1 << ( HERMITE_MAX_LEVEL - hermite->level[i] ) ) == next ) {
+                hermite->active[count++] = i;
+            }
+        }
+        predict(size, next, unit, stars, hermite);
+        evaluate(count, size, stars, work, hermite);
+        correct(count, next, unit, dt, stars, hermite);
+        hermite->blocks++;
+        now = next;
+    }
+}
@@ -0,0 +1,702 @@
+/**
+* @brief lt@C̍ȓǂݍ
+* 2ł3ł̋ʕ loader1.c  loader3.c ꂼ loader*.h ̌ɃCN[h
+* @detail
+* oCi`̃t@C̓Ɋ蓖, ̏W̔zt@C̒֒ڌ̂œǂݍ݂̏Ȃ.
+* eLXg`̃t@C蓖Ăōs̋ڂŋ؂, ԂƂɍƃXbhŕɉ͂.
+* l͌̏ȂꍇZŋ, cstrtodɔĈŌʂfscanfƈv.
+* s̒lƃoCi`̔z͂ǂ, ʒu̐, x̐̏ɕ.
+* `FbN|Cg͔žɐϕ̏Ԃ𖼑Ot̋ԂƂĎ. load_checkpointǂ, add_sectionō.
+*/
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mapfile.h"
+#include "pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define LOADER_FIELDS ( 1 + 2 * GRAVITY_DIM ) // m, then x, y, z, then vx, vy, vz without z in 2D
+#define LOADER_PIECE 65536      // minimum bytes of text per parallel piece
+#define LOADER_TOKEN 64         // maximum length of a number handed to strtod
+
+/**
+* ɉ͂eLXg̋
+*/
+struct TextPiece {
+    const char* begin;
+    const char* end;
+    int records;        // non-blank lines in the piece
+    int first;          // index of the first record of the piece
+    int parsed;         // records stored before a malformed one or the end of the arrays
+};
+
+struct TextTask {
+    struct TextPiece* pieces;
+    double* fields[LOADER_FIELDS]; // arrays of the stars in the order of the fields of a line
+    int size;           // length of the arrays
+};
+
+/**
+* @fn ̏W̔zt@Cɕԏɕׂ.
+*/
+static void list_fields(struct Stars *stars, double **fields[LOADER_FIELDS]) {
+    int k = 0;
+    fields[k++] = &stars->m;
+#define FIELD_POSITION(X) fields[k++] = &stars->X;
+#define FIELD_VELOCITY(X) fields[k++] = &stars->v##X;
+    FOR_AXES(FIELD_POSITION)
+    FOR_AXES(FIELD_VELOCITY)
+#undef FIELD_POSITION
+#undef FIELD_VELOCITY
+}
+
+//powers of ten exactly representable as double
+static const double POWERS[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static int is_blank(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* skip_blank(const char *p, const char *end) {
+    while ( p < end && is_blank(*p) ) {
+        p++;
+    }
+    return p;
+}
+
+/**
+* @fn ǂ.
+* @param p ǂݎn߂ʒu
+* @param end s̏I
+* @param value ǂ񂾒l
+* @return ǂ񂾐l̒̈ʒu lƂēǂ߂ȂƂNULL
+* @detail
+* L15ȉ10̎w22ȉȂ, 10̙pdoubleŐmɕ\̂
+* ̏揜ZŐۂ߂lɂȂ. ȊOstrtodœǂނ̂, ǂ̏ꍇfscanfƓlɂȂ
+*/
+static const char* parse_value(const char *p, const char *end, double *value) {
+    const char *start;
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0, exact = 1, any = 0;
+    char token[LOADER_TOKEN];
+    char *stop;
+    p = skip_blank(p, end);
+    start = p;
+    if ( p < end && ( *p == '-' || *p == '+' ) ) {
+        p++;
+    }
+    for ( ; p < end && *p >= '0' && *p <= '9'; p++ ) {
+        any = 1;
+        if ( mantissa == 0 && *p == '0' ) {
+            continue;
+        }
+        if ( digits < 19 ) {
+            mantissa = mantissa * 10 + ( *p - '0' );
+            digits++;
+        } else {
+            exponent++;
+            exact = 0;
+        }
+    }
+    if ( p < end && *p == '.' ) {
+        for ( p++; p < end && *p >= '0' && *p <= '9'; p++ ) {
+            any = 1;
+            if ( mantissa == 0 && *p == '0' ) {
+                exponent--;
+            } else if ( digits < 19 ) {
+                mantissa = mantissa * 10 + ( *p - '0' );
+                digits++;
+                exponent--;
+            } else {
+                exact = 0;
+            }
+        }
+    }
+    if ( any && p < end && ( *p == 'e' || *p == 'E' ) ) {
+        const char *q = p + 1;
+        int sign = 1, power = 0;
+        if ( q < end && ( *q == '-' || *q == '+' ) ) {
+            sign = *q == '-' ? -1 : 1;
+            q++;
+        }
+        if ( q < end && *q >= '0' && *q <= '9' ) {
+            for ( ; q < end && *q >= '0' && *q <= '9'; q++ ) {
+                if ( power < 10000 ) {
+                    power = power * 10 + ( *q - '0' );
+                }
+            }
+            exponent += sign * power;
+            p = q;
+        }
+    }
+    if ( any && exact && digits <= 15 && exponent >= -22 && exponent <= 22 ) {
+        double v = ( double )mantissa;
+        v = exponent >= 0 ? v * POWERS[exponent] : v / POWERS[-exponent];
+        *value = *start == '-' ? -v : v;
+        return p;
+    }
+    if ( !any ) {
+        //inf, nan and hexadecimal floats are left to strtod
+        for ( p = start; p < end && *p != ',' && !is_blank(*p); p++ );
+    }
+    if ( p == start || p - start >= LOADER_TOKEN ) {
+        return NULL;
+    }
+    memcpy(token, start, p - start);
+    token[p - start] = '\0';
+    *value = strtod(token, &stop);
+    return stop == token + ( p - start ) ? p : NULL;
+}
+
+/**
+* @fn s̎, ʒuƑxǂ.
+* @return ǂ߂Ƃ1 `ĂƂ0
+*/
+static int parse_record(const char *p, const char *end, double *values) {
+    int k;
+    for ( k = 0; k < LOADER_FIELDS; k++ ) {
+        if ( k > 0 ) {
+            p = skip_blank(p, end);
+            if ( p >= end || *p != ',' ) {
+                return 0;
+            }
+            p++;
+        }
+        p = parse_value(p, end, &values[k]);
+        if ( p == NULL ) {
+            return 0;
+        }
+    }
+    return skip_blank(p, end) == end;
+}
+
+/**
+* @fn Ԃ̎̍s̏IԂ. sȂ΋Ԃ̏I
+*/
+static const char* line_end(const char *p, const char *end) {
+    const char *next = ( const char * )memchr(p, '\n', end - p);
+    return next != NULL ? next : end;
+}
+
+/**
+* @fn eԂ̋łȂs𐔂. parallel_forԂƂɌĂ΂
+*/
+static void count_task(void *arg, const int begin, const int end) {
+    struct TextTask *task = ( struct TextTask * )arg;
+    int k;
+    for ( k = begin; k < end; k++ ) {
+        struct TextPiece *piece = &task->pieces[k];
+        const char *p = piece->begin;
+        int records = 0;
+        while ( p < piece->end ) {
+            const char *last = line_end(p, piece->end);
+            if ( skip_blank(p, last) < last ) {
+                records++;
+            }
+            p = last + 1;
+        }
+        piece->records = records;
+    }
+}
+
+/**
+* @fn eԂ̍s͂Ĕž܂ʒu֏. parallel_forԂƂɌĂ΂
+*/
+static void parse_task(void *arg, const int begin, const int end) {
+    struct TextTask *task = ( struct TextTask * )arg;
+    int k, l;
+    for ( k = begin; k < end; k++ ) {
+        struct TextPiece *piece = &task->pieces[k];
+        const char *p = piece->begin;
+        int i = piece->first;
+        while ( p < piece->end && i < task->size ) {
+            const char *last = line_end(p, piece->end);
+            if ( skip_blank(p, last) < last ) {
+                double values[LOADER_FIELDS];
+                if ( !parse_record(p, last, values) ) {
+                    break;
+                }
+                for ( l = 0; l < LOADER_FIELDS; l++ ) {
+                    task->fields[l][i] = values[l];
+                }
+                i++;
+            }
+            p = last + 1;
+        }
+        piece->parsed = i - piece->first;
+    }
+}
+
+/**
+* @fn eLXg`̃f[^ǂݍ. `initialize_starsƓ
+* @param text t@C̓e
+* @param length t@C̒
+* @param pool ͂ɎgƃXbh NULL̂ƂĂяoXbhŉ͂
+* @return ǂݍ񂾐̐ ŏ̌s̎O܂łǂ
+*/
+static int read_text(const char *text, const size_t length, struct Stars *stars, struct ThreadPool *pool) {
+    const char *end = text + length;
+    const char *p = text, *last, *body;
+    struct TextTask task;
+    struct TextPiece *pieces;
+    double **fields[LOADER_FIELDS];
+    long long size = 0;
+    int count, k, total;
+    size_t span;
+    //the first non-blank line holds the number of stars
+    while ( p < end && ( is_blank(*p) || *p == '\n' ) ) {
+        p++;
+    }
+    last = line_end(p, end);
+    if ( p < last && *p == '+' ) {
+        p++;
+    }
+    if ( p >= last || *p < '0' || *p > '9' ) {
+        return 0;
+    }
+    for ( ; p < last && *p >= '0' && *p <= '9'; p++ ) {
+        size = size * 10 + ( *p - '0' );
+        if ( size > INT_MAX ) {
+            return 0;
+        }
+    }
+    if ( size <= 0 || skip_blank(p, last) < last || !allocate_stars(( int )size, stars) ) {
+        return 0;
+    }
+    body = last < end ? last + 1 : end;
+
+    //split at line breaks into pieces large enough to be worth a task
+    span = ( size_t )( end - body );
+    count = pool_threads(pool) * 4;
+    if ( ( size_t )count > span / LOADER_PIECE + 1 ) {
+        count = ( int )( span / LOADER_PIECE + 1 );
+    }
+    pieces = ( struct TextPiece * )calloc(count, sizeof(struct TextPiece));
+    if ( pieces == NULL ) {
+        free_stars(stars);
+        return 0;
+    }
+    pieces[0].begin = body;
+    for ( k = 1; k < count; k++ ) {
+        p = body + span / count * k;
+        if ( p < pieces[k - 1].begin ) {
+            p = pieces[k - 1].begin;
+        }
+        last = line_end(p, end);
+        pieces[k].begin = last < end ? last + 1 : end;
+        pieces[k - 1].end = pieces[k].begin;
+    }
+    pieces[count - 1].end = end;
+
+    task.pieces = pieces;
+    list_fields(stars, fields);
+    for ( k = 0; k < LOADER_FIELDS; k++ ) {
+        task.fields[k] = *fields[k];
+    }
+    task.size = ( int )size;
+    parallel_for(pool, count, 1, count_task, &task);
+    total = 0;
+    for ( k = 0; k < count; k++ ) {
+        pieces[k].first = total;
+        total += pieces[k].records;
+        if ( total > task.size ) {
+            total = task.size;
+        }
+    }
+    parallel_for(pool, count, 1, parse_task, &task);
+    //stop at the first malformed line like the sequential reader
+    for ( k = 0; k < count; k++ ) {
+        if ( pieces[k].parsed < pieces[k].records ) {
+            total = pieces[k].first + pieces[k].parsed;
+            break;
+        }
+    }
+    free(pieces);
+    if ( total <= 0 ) {
+        free_stars(stars);
+    }
+    return total;
+}
+
+/**
+* @fn Ԃt.
+* @param name Ԃ̖O 8܂
+* @param version ǧ`̔
+* @param bytes g̒
+* @return gސ 0Ŗ߂Ă mۂłȂƂNULL
+*/
+void* add_section(struct StarsExtra *extra, const char *name, const uint32_t version, const size_t bytes) {
+    const size_t padded = ( bytes + STARS_SECTION_ALIGNMENT - 1 ) / STARS_SECTION_ALIGNMENT * STARS_SECTION_ALIGNMENT;
+    const size_t need = extra->size + sizeof(struct StarsSection) + padded;
+    struct StarsSection section;
+    char *contents;
+    if ( need > extra->capacity ) {
+        const size_t capacity = need > extra->capacity * 2 ? need : extra->capacity * 2;
+        char *data = ( char * )realloc(extra->data, capacity);
+        if ( data == NULL ) {
+            return NULL;
+        }
+        extra->data = data;
+        extra->capacity = capacity;
+    }
+    memset(&section, 0, sizeof(section));
+    memcpy(section.name, name, strlen(name) < sizeof(section.name) ? strlen(name) : sizeof(section.name));
+    section.version = version;
+    section.bytes = ( int64_t )bytes;
+    memcpy(extra->data + extra->size, &section, sizeof(section));
+    contents = extra->data + extra->size + sizeof(section);
+    memset(contents, 0, padded);
+    extra->size = need;
+    return contents;
+}
+
+/**
+* @fn OƔł̈vԂT.
+* @param bytes g̒
+* @return g̐擪 STARS_SECTION_ALIGNMENToCgEɑĂ ȂƂNULL
+*/
+const void* find_section(struct StarsExtra const *extra, const char *name, const uint32_t version, size_t *bytes) {
+    size_t offset = 0;
+    while ( offset + sizeof(struct StarsSection) <= extra->size ) {
+        struct StarsSection section;
+        memcpy(&section, extra->data + offset, sizeof(section));
+        offset += sizeof(section);
+        if ( strncmp(section.name, name, sizeof(section.name)) == 0 && section.version == version ) {
+            *bytes = ( size_t )section.bytes;
+            return extra->data + offset;
+        }
+        offset += ( ( size_t )section.bytes + STARS_SECTION_ALIGNMENT - 1 ) / STARS_SECTION_ALIGNMENT * STARS_SECTION_ALIGNMENT;
+    }
+    return NULL;
+}
+
+void free_extra(struct StarsExtra *extra) {
+    free(extra->data);
+    extra->data = NULL;
+    extra->size = 0;
+    extra->capacity = 0;
+}
+
+/**
+* @fn žɑԂ𕡎ʂ.
+* @param data ŏ̋Ԃ̌o
+* @param length t@C̖܂ł̃oCg
+* @detail oƒ܂ŐƂʂ. Ԃ̂Ȃt@CȂ牽Ȃ
+*/
+static void read_sections(const char *data, const size_t length, struct StarsExtra *extra) {
+    size_t offset = 0;
+    while ( offset + sizeof(struct StarsSection) <= length ) {
+        struct StarsSection section;
+        memcpy(&section, data + offset, sizeof(section));
+        offset += sizeof(section);
+        if ( section.bytes < 0 || ( uint64_t )section.bytes > length - offset ) {
+            fprintf(stderr, "warning: the sections after the arrays are broken. the integration state is rebuilt.\n");
+            return;
+        }
+        offset += ( ( size_t )section.bytes + STARS_SECTION_ALIGNMENT - 1 ) / STARS_SECTION_ALIGNMENT * STARS_SECTION_ALIGNMENT;
+    }
+    if ( offset == 0 ) {
+        return;
+    }
+    offset = offset < length ? offset : length;
+    extra->data = ( char * )malloc(offset);
+    if ( extra->data == NULL ) {
+        return;
+    }
+    memcpy(extra->data, data, offset);
+    extra->size = offset;
+    extra->capacity = offset;
+}
+
+/**
+* @fn oCi`̃f[^ǂݍ.
+* @param address t@C蓖Ă擪. ǂݍ݂ɐĔz񂪂wƂ͐̏WL
+* @param extra ž̋Ԃ𕡎ʂ NULL̂Ƃǂ܂Ȃ
+* @return ǂݍ񂾐̐ `ĂƂ0
+*/
+static int read_binary(void *address, const size_t length, struct Stars *stars, struct StarsExtra *extra) {
+    struct StarsFileHeader header;
+    const char *data = ( const char * )address + sizeof(struct StarsFileHeader);
+    double **arrays[LOADER_FIELDS];
+    size_t bytes;
+    int k, i, count;
+    memcpy(&header, address, sizeof(header));
+    if ( header.version != STARS_FILE_VERSION || header.order != STARS_FILE_ORDER ) {
+        fprintf(stderr, "error: unsupported version or byte order of the binary file.\n");
+        return 0;
+    }
+    if ( header.dimension != GRAVITY_DIM ) {
+        fprintf(stderr, "error: the binary file has %u dimensions, not %d.\n", header.dimension, GRAVITY_DIM);
+        return 0;
+    }
+    if ( ( header.precision != 8 && header.precision != 4 ) || header.count <= 0 || header.count > INT_MAX
+        || header.stride < header.count || header.stride > ( long long )( length / header.precision ) ) {
+        return 0;
+    }
+    bytes = ( size_t )header.stride * header.precision;
+    if ( length < sizeof(header) || ( length - sizeof(header) ) / LOADER_FIELDS < bytes ) {
+        return 0;
+    }
+    count = ( int )header.count;
+    if ( !allocate_stars(count, stars) ) {
+        return 0;
+    }
+    if ( extra != NULL ) {
+        read_sections(data + bytes * LOADER_FIELDS, length - sizeof(header) - bytes * LOADER_FIELDS, extra);
+    }
+    list_fields(stars, arrays);
+    if ( header.precision == sizeof(double) && bytes % STARS_ALIGNMENT == 0 ) {
+        //the untouched parts of the block for these arrays cost no memory
+        for ( k = 0; k < LOADER_FIELDS; k++ ) {
+            *arrays[k] = ( double * )( data + bytes * k );
+        }
+        stars->mapping = address;
+        stars->mapping_size = length;
+        return count;
+    }
+    for ( k = 0; k < LOADER_FIELDS; k++ ) {
+        double *array = *arrays[k];
+        if ( header.precision == sizeof(double) ) {
+            memcpy(array, data + bytes * k, sizeof(double) * count);
+        } else {
+            const float *values = ( const float * )( data + bytes * k );
+            for ( i = 0; i < count; i++ ) {
+                array[i] = values[i];
+            }
+        }
+    }
+    unmap_file(address, length);
+    return count;
+}
+
+/**
+* @fn lt@Cǂݍ. `͐擪̃oCg񂩂画肷
+* @param path t@C̃pX eLXg`Ȃinitialize_starsƓ`
+* @param stars ǂݍ񂾒lŏ鐯̏W free_starsŉ
+* @param pool eLXg̉͂ɎgƃXbh NULLł悢
+* @param state oCi`̃t@CɋL^ꂽi݋ eLXg`ȂS0 NULLł悢
+* @return ǂݍ񂾐̐ sƂ0
+*/
+int load_stars(const char *path, struct Stars *stars, struct ThreadPool *pool, struct StarsState *state) {
+    return load_checkpoint(path, stars, pool, state, NULL);
+}
+
+/**
+* @fn `FbN|Cgǂݍ. load_starsƓlt@Cǂ߂
+* @param extra žɋL^ꂽϕ̏Ԃ ԂȂ΋ free_extraŉ NULLł悢
+* @return ǂݍ񂾐̐ sƂ0
+*/
+int load_checkpoint(const char *path, struct Stars *stars, struct ThreadPool *pool, struct StarsState *state, struct StarsExtra *extra) {
+    size_t length = 0;
+    void *address;
+    int size;
+    stars->block = NULL;
+    stars->mapping = NULL;
+    stars->capacity = 0;
+    if ( state != NULL ) {
+        state->step = 0;
+        state->time = 0;
+        state->dt = 0;
+    }
+    if ( extra != NULL ) {
+        extra->data = NULL;
+        extra->size = 0;
+        extra->capacity = 0;
+    }
+    //copy-on-write so that the integrator may update arrays pointing into the file
+    address = map_file(path, 1, &length);
+    if ( address == NULL ) {
+        return 0;
+    }
+    if ( length >= sizeof(struct StarsFileHeader) && memcmp(address, STARS_FILE_MAGIC, 8) == 0 ) {
+        struct StarsFileHeader header;
+        memcpy(&header, address, sizeof(header));
+        size = read_binary(address, length, stars, extra);
+        if ( size <= 0 ) {
+            unmap_file(address, length);
+        } else if ( state != NULL ) {
+            state->step = ( long )header.step;
+            state->time = header.time;
+            state->dt = header.dt;
+        }
+        return size;
+    }
+    size = read_text(( const char * )address, length, stars, pool);
+    unmap_file(address, length);
+    return size;
+}
+
+/**
+* @fn t@C̒wĂzmۂz֕ʂ, t@C̊蓖Ă.
+* @detail Windowsł͊蓖Ă܂܂̃t@CuȂ̂, `FbN|CgoOɌĂ
+* @param size ʂ鐯̐
+* @return Ƃ1 mۂłȂƂ0 ̂Ƃ̏W͌̂܂
+*/
+int detach_stars(const int size, struct Stars *stars) {
+    struct Stars copy;
+    double **from[LOADER_FIELDS], **to[LOADER_FIELDS];
+    int k;
+    if ( stars->mapping == NULL ) {
+        return 1;
+    }
+    if ( !allocate_stars(stars->capacity, &copy) ) {
+        return 0;
+    }
+    list_fields(stars, from);
+    list_fields(&copy, to);
+    for ( k = 0; k < LOADER_FIELDS; k++ ) {
+        memcpy(*to[k], *from[k], sizeof(double) * size);
+    }
+#define COPY_PREVIOUS(X) memcpy(copy.pre_##X, stars->pre_##X, sizeof(double) * size);
+    FOR_AXES(COPY_PREVIOUS)
+#undef COPY_PREVIOUS
+    free_stars(stars);
+    *stars = copy;
+    return 1;
+}
+
+/**
+* @fn It@C̓efBXN֏ނ܂ő҂.
+*/
+static int sync_file(FILE *out) {
+    if ( fflush(out) != 0 ) {
+        return 0;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(out)) == 0;
+#else
+    return fsync(fileno(out)) == 0;
+#endif
+}
+
+/**
+* @fn t@C̖Ou. u悪ɂΈxɓւ
+* @param durable 1̂ƂO̕ύXfBXN֏ނ܂ő҂
+*/
+static int replace_file(const char *from, const char *to, const int durable) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | ( durable ? MOVEFILE_WRITE_THROUGH : 0 )) != 0;
+#else
+    char directory[1100];
+    const char *slash = strrchr(to, '/');
+    int fd;
+    if ( rename(from, to) != 0 ) {
+        return 0;
+    }
+    if ( !durable ) {
+        return 1;
+    }
+    //the new name is on disk once the directory is
+    if ( slash == NULL ) {
+        strcpy(directory, ".");
+    } else {
+        snprintf(directory, sizeof(directory), "%.*s", ( int )( slash - to ) + ( slash == to ), to);
+    }
+    fd = open(directory, O_RDONLY);
+    if ( fd >= 0 ) {
+        fsync(fd);
+        close(fd);
+    }
+    return 1;
+#endif
+}
+
+/**
+* @fn ̏WoCi`ŏo.
+* @detail
+* ꎞt@C path.tmp ֏IĂ疼Oû, rŎ~܂ĂO̓ec.
+* z̓obt@֕ʂ̂܂܏o
+* @param extra žɑ NULL̂ƂȂ
+* @param durable 1̂ƂOuOɃfBXNւ݂̏҂
+*/
+static int write_binary(const char *path, const int size, struct Stars const *stars, struct StarsState const *state,
+    struct StarsExtra const *extra, const int durable) {
+    static const double zeros[STARS_ALIGNMENT / sizeof(double)] = { 0 };
+    const size_t line = STARS_ALIGNMENT / sizeof(double);
+    double **arrays[LOADER_FIELDS];
+    struct StarsFileHeader header;
+    char temporary[1100];
+    FILE *out;
+    int k, ok = 1;
+    if ( size <= 0 ) {
+        return 0;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STARS_FILE_MAGIC, 8);
+    header.version = STARS_FILE_VERSION;
+    header.order = STARS_FILE_ORDER;
+    header.dimension = GRAVITY_DIM;
+    header.precision = sizeof(double);
+    header.count = size;
+    header.stride = ( ( size_t )size + line - 1 ) / line * line;
+    if ( state != NULL ) {
+        header.step = state->step;
+        header.time = state->time;
+        header.dt = state->dt;
+    }
+    //only reads the arrays
+    list_fields(( struct Stars * )stars, arrays);
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    out = fopen(temporary, "wb");
+    if ( out == NULL ) {
+        return 0;
+    }
+    ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for ( k = 0; k < LOADER_FIELDS && ok; k++ ) {
+        const size_t padding = ( size_t )( header.stride - size );
+        ok = fwrite(*arrays[k], sizeof(double), size, out) == ( size_t )size
+            && fwrite(zeros, sizeof(double), padding, out) == padding;
+    }
+    if ( ok && extra != NULL && extra->size > 0 ) {
+        ok = fwrite(extra->data, 1, extra->size, out) == extra->size;
+    }
+    if ( ok && durable ) {
+        ok = sync_file(out);
+    }
+    ok = fclose(out) == 0 && ok;
+    if ( ok ) {
+        ok = replace_file(temporary, path, durable);
+    }
+    if ( !ok ) {
+        remove(temporary);
+    }
+    return ok;
+}
+
+/**
+* @fn ̏WoCi`ŏo.
+* @param path ot@C̃pX
+* @param size ̐
+* @param state wb_ɋL^i݋ NULL̂ƂS0
+* @return Ƃ1 sƂ0
+*/
+int save_stars(const char *path, const int size, struct Stars const *stars, struct StarsState const *state) {
+    return write_binary(path, size, stars, state, NULL, 0);
+}
+
+/**
+* @fn vZĊJ邽߂̃`FbN|Cgo.
+* @detail
+* `save_starsƓ. QENb^@̍Ɨ̈ړÖʒu͖Xebv蒼̂,
+* , ʒu, xƐi݋œvZrbgPʂœʂ̂܂ܑ.
+* Xebv܂Ŏz (G~[g@݂̍g񂷉xȂ) extra̋ԂƂĔžɏo.
+* fBXNւ݂̏҂ĂÕ`FbN|CgƓւ̂, dĂǂ炩SȌ`Ŏc
+* @param extra žɑ NULLł悢
+* @return Ƃ1 sƂ0
+*/
+int save_checkpoint(const char *path, const int size, struct Stars const *stars, struct StarsState const *state,
+    struct StarsExtra const *extra) {
+    return write_binary(path, size, stars, state, extra, 1);
+}
@@ -0,0 +1,80 @@
+/**
+* @brief t@CɊ蓖Ă
+* @detail
+* t@C̓eǂݍ܂ɃAhXԂ֊蓖, Gꂽy[WOSǂݍ.
+* ݉\Ȋ蓖Ă̓Rs[ICgȂ̂, Ăt@Cɂ͔fȂ.
+*/
+#include "mapfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+* @fn t@CŜɊ蓖Ă.
+* @param path t@C̃pX
+* @param writable 0̂Ƃǂݍݐp ȊÔƂvZXŏ
+* @param length t@C̒
+* @return 蓖Ă擪̃AhX sƂ̃t@ĈƂNULL
+*/
+void* map_file(const char *path, const int writable, size_t *length) {
+#ifdef _WIN32
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+    void *address = NULL;
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if ( file == INVALID_HANDLE_VALUE ) {
+        return NULL;
+    }
+    if ( GetFileSizeEx(file, &size) && size.QuadPart > 0 && ( unsigned long long )size.QuadPart <= ( size_t )-1 ) {
+        mapping = CreateFileMappingA(file, NULL, writable ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+        if ( mapping != NULL ) {
+            address = MapViewOfFile(mapping, writable ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+            //the view keeps the mapping alive
+            CloseHandle(mapping);
+        }
+        *length = ( size_t )size.QuadPart;
+    }
+    CloseHandle(file);
+    return address;
+#else
+    struct stat info;
+    void *address;
+    const int fd = open(path, O_RDONLY);
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    if ( fstat(fd, &info) != 0 || info.st_size <= 0 ) {
+        close(fd);
+        return NULL;
+    }
+    address = mmap(NULL, ( size_t )info.st_size, PROT_READ | ( writable ? PROT_WRITE : 0 ), MAP_PRIVATE, fd, 0);
+    //the mapping stays valid after the descriptor is closed
+    close(fd);
+    if ( address == MAP_FAILED ) {
+        return NULL;
+    }
+    *length = ( size_t )info.st_size;
+    return address;
+#endif
+}
+
+/**
+* @fn map_fileŊ蓖Ă.
+*/
+void unmap_file(void *address, const size_t length) {
+    if ( address == NULL ) {
+        return;
+    }
+#ifdef _WIN32
+    ( void )length;
+    UnmapViewOfFile(address);
+#else
+    munmap(address, length);
+#endif
+}
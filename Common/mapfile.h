@@ -0,0 +1,13 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    void* map_file(const char *path, const int writable, size_t *length);
+    void unmap_file(void *address, const size_t length);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,246 @@
+/**
+* @brief vZƕ\ʂ̃XbhŐi߂
+* 2ł3ł̋ʕ monitor1.c  monitor3.c ꂼ monitor*.h ̌ɃCN[h
+* @detail
+* vZ̃Xbhstart_physicsɓn1XebvJԂ, publish_frameŎʂƈʒuOobt@֕ʂ.
+* \̃Xbh (DxLib̕`惋[v) view_frameōŐV̓̏Ԃ, ̊ԂԂԂ`.
+* Oobt@͏Ɠǂݎ肪 (SPSC) , bNgȂ҂s.
+*   head  肪JԂ̐. kslots[k % MONITOR_SLOTS]ɂ. 肾₷
+*   tail  ǂݎ肪܂ǂނȂłÂ. ǂݎ肾₷
+*  k - tail < MONITOR_SLOTS ̂Ƃk, IĂhead𑝂₷ (release).
+* ǂݎheadǂ (acquire), ŐV̓ head - 2, head - 1 ǂޑOtail܂Ői߂.
+* ͓ǂݎ҂, O܂ĂƂ͂̏Ԃ̂Ă̂, \xĂvZ͒xȂȂ.
+* ǂݎ҂, ŐV̓ÂԂ͓ǂ܂ɔ΂.
+* \͌J̊Ԋux点, ̏ԂJ̍ɑ΂oߎԂ̊ňʒu`ɕԂ.
+* ̂Ő̐ςƂ͕ԂŐV̏Ԃ`.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#include "threads.h"
+
+#define MONITOR_SLOTS 8     // states in the ring, the display holds two of them at most
+
+struct Monitor {
+    int capacity;
+    struct MonitorFrame slots[MONITOR_SLOTS];
+    thread_counter head;    // states published, written by the physics thread only
+    thread_counter tail;    // oldest state the display may still read, written by the display only
+    thread_counter stop;    // 1 : the physics thread returns after the current step
+    thread_counter running; // 1 while the physics thread runs steps
+    monitor_step step;
+    void* context;
+    thread_handle thread;
+    int started;            // 1 while the thread is to be joined
+    struct MonitorFrame view; // state interpolated for the display, used by the display only
+    long latest;            // state the view was last made from, -1 before the first
+    long dropped;           // states not published because the ring was full
+    long shown;             // states drawn as the latest at least once
+    long skipped;           // states published but never drawn
+};
+
+/**
+* @fn ԂJ𑪂鎞v. bŕԂ
+*/
+static double monitor_clock(void) {
+#ifdef _WIN32
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return ( double )now.QuadPart / ( double )frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+* @fn Ď. vZ̃Xbh͂܂NȂ
+* @param capacity xɌJ鐯̐̏
+* @return Ď sƂNULL
+*/
+struct Monitor* create_monitor(const int capacity) {
+    struct Monitor *monitor = ( struct Monitor * )calloc(1, sizeof(struct Monitor));
+    int k;
+    if ( monitor == NULL ) {
+        return NULL;
+    }
+    for ( k = 0; k <= MONITOR_SLOTS; k++ ) {
+        struct Stars *stars = k < MONITOR_SLOTS ? &monitor->slots[k].stars : &monitor->view.stars;
+        if ( !allocate_stars(capacity, stars) ) {
+            while ( k-- > 0 ) {
+                free_stars(&monitor->slots[k].stars);
+            }
+            free(monitor);
+            return NULL;
+        }
+    }
+    monitor->capacity = capacity;
+    monitor->latest = -1;
+    return monitor;
+}
+
+/**
+* @fn ԂJ. vZ̃XbhĂ
+* @detail ʂƈʒu󂢂Ăꏊ֕ʂ邾Ŗ߂. \҂Ƃ͂Ȃ
+* @return JƂ1 O܂ĂĎ̂ĂƂ0
+*/
+int publish_frame(struct Monitor *monitor, const long step, const double time, const int size, struct Stars const *stars) {
+    const long head = monitor->head;
+    struct MonitorFrame *frame;
+    if ( head - ( long )load_acquire(&monitor->tail) >= MONITOR_SLOTS || size > monitor->capacity ) {
+        monitor->dropped++;
+        return 0;
+    }
+    frame = &monitor->slots[head % MONITOR_SLOTS];
+    memcpy(frame->stars.m, stars->m, sizeof(double) * size);
+#define COPY_AXIS(X) memcpy(frame->stars.X, stars->X, sizeof(double) * size);
+    FOR_AXES(COPY_AXIS)
+#undef COPY_AXIS
+    frame->size = size;
+    frame->step = step;
+    frame->time = time;
+    frame->wall = monitor_clock();
+    store_release(&monitor->head, head + 1);
+    return 1;
+}
+
+/**
+* @fn \Ԃ߂. \̃Xbh`тɌĂ
+* @return ŐV̓̏Ԃ̎ŕԂ ܂JĂȂƂNULL
+*         view_frameĂԂ܂Ŏg
+*/
+struct MonitorFrame const* view_frame(struct Monitor *monitor) {
+    const long head = ( long )load_acquire(&monitor->head);
+    struct MonitorFrame *view = &monitor->view;
+    struct MonitorFrame const *previous = NULL;
+    struct MonitorFrame const *frame;
+    double weight = 1;
+    long pin;
+    int i;
+    if ( head == 0 ) {
+        return NULL;
+    }
+    //hold the two latest states, older ones may be overwritten from here
+    pin = head >= 2 ? head - 2 : head - 1;
+    if ( pin < ( long )monitor->tail ) {
+        pin = ( long )monitor->tail;
+    }
+    store_release(&monitor->tail, pin);
+    frame = &monitor->slots[( head - 1 ) % MONITOR_SLOTS];
+    if ( pin < head - 1 ) {
+        previous = &monitor->slots[pin % MONITOR_SLOTS];
+    }
+    if ( monitor->latest != head - 1 ) {
+        monitor->skipped += head - 1 - monitor->latest - 1;
+        monitor->shown++;
+        monitor->latest = head - 1;
+    }
+    //a merge renumbers the stars
+    if ( previous != NULL && previous->size == frame->size && frame->wall > previous->wall ) {
+        weight = ( monitor_clock() - frame->wall ) / ( frame->wall - previous->wall );
+        weight = weight < 0 ? 0 : weight > 1 ? 1 : weight;
+    }
+    view->size = frame->size;
+    view->step = frame->step;
+    view->wall = frame->wall;
+    memcpy(view->stars.m, frame->stars.m, sizeof(double) * frame->size);
+    if ( weight >= 1 ) {
+        view->time = frame->time;
+#define COPY_AXIS(X) memcpy(view->stars.X, frame->stars.X, sizeof(double) * frame->size);
+        FOR_AXES(COPY_AXIS)
+#undef COPY_AXIS
+    } else {
+        view->time = previous->time + weight * ( frame->time - previous->time );
+        for ( i = 0; i < frame->size; i++ ) {
+#define BLEND_AXIS(X) view->stars.X[i] = previous->stars.X[i] + weight * ( frame->stars.X[i] - previous->stars.X[i] );
+            FOR_AXES(BLEND_AXIS)
+#undef BLEND_AXIS
+        }
+    }
+    return view;
+}
+
+/**
+* @fn vZ̃Xbh̖{. ~߂w邩1Xebv0Ԃ܂ŌJԂ
+*/
+static void run_physics(struct Monitor *monitor) {
+    while ( !load_acquire(&monitor->stop) && monitor->step(monitor->context) ) {
+    }
+    store_release(&monitor->running, 0);
+}
+
+static thread_result THREAD_CALL physics_main(void *arg) {
+    run_physics(( struct Monitor * )arg);
+    return 0;
+}
+
+/**
+* @fn vZ̃XbhN.
+* @param step vZ̃XbhJԂĂ1Xebv. contextn
+* @return NƂ1 sƂ0
+*/
+int start_physics(struct Monitor *monitor, monitor_step step, void *context) {
+    if ( monitor->started ) {
+        return 0;
+    }
+    monitor->step = step;
+    monitor->context = context;
+    store_release(&monitor->stop, 0);
+    store_release(&monitor->running, 1);
+    monitor->started = start_thread(&monitor->thread, physics_main, monitor);
+    if ( !monitor->started ) {
+        store_release(&monitor->running, 0);
+    }
+    return monitor->started;
+}
+
+/**
+* @fn vZ̃Xbh܂Xebvi߂Ă邩ׂ.
+* @return i߂ĂƂ1 IƂ0
+*/
+int physics_running(struct Monitor *monitor) {
+    return load_acquire(&monitor->running) != 0;
+}
+
+/**
+* @fn vZ̃Xbh~߂. i߂ĂXebvÎ҂Ė߂
+*/
+void stop_physics(struct Monitor *monitor) {
+    if ( !monitor->started ) {
+        return;
+    }
+    store_release(&monitor->stop, 1);
+    join_thread(monitor->thread);
+    monitor->started = 0;
+}
+
+/**
+* @fn J, ̂Ă, `ԂƔ΂Ԃ̐o. vZ̃Xbh~߂ĂĂ
+*/
+void report_monitor(FILE *out, struct Monitor const *monitor) {
+    fprintf(out, "monitor : %ld states published, %ld dropped while the ring was full, %ld drawn, %ld skipped\n",
+        ( long )monitor->head, monitor->dropped, monitor->shown, monitor->skipped);
+}
+
+/**
+* @fn vZ̃Xbh~߂ĊĎj.
+*/
+void destroy_monitor(struct Monitor *monitor) {
+    int k;
+    if ( monitor == NULL ) {
+        return;
+    }
+    stop_physics(monitor);
+    for ( k = 0; k < MONITOR_SLOTS; k++ ) {
+        free_stars(&monitor->slots[k].stars);
+    }
+    free_stars(&monitor->view.stars);
+    free(monitor);
+}
@@ -0,0 +1,445 @@
+/**
+* @brief ̏W𕡐̃vZXɕČvZMPIł̃ob`s 2ł3ł̋ʕ
+* @detail
+* mpi1.c  mpi3.c ꂼ gravity*.h ȂǂDOMAIN_NAME`ɃCN[h.
+* eN͋Ԃ𕪂̗̈̐Đϕ, x̌vZł͑̃N̐̏d͂ domain*.c Ŏ󂯎.
+* ϕ@ stepper*.c ̂܂܎g, Ɨ̈hookx̌vZu.
+* g : mpirun -np 4 mpi2d, mpi3d f[^t@C [IvV]
+*   --dt dt       1Xebv̎̕ω (ȗ̓oCi`̃f[^t@CɋL^ꂽl, Ȃ1.0)
+*   --steps n     nXebvi߂I
+*   --end t       tɒBI
+*   --bound r     SĂ̐_𒆐SƂ2r͈̔͂oI
+*   --every k     kXebvƂɏԂo͂ (ȗ͍Ō̏Ԃ)
+*   --output p    Ԃt@C p00000010.txt Ȃǂ֏o͂ (ȗ͕Wo)
+*   --method m    ϕ@ rk4, euler, leapfrog, yoshida4, yoshida6 (ȗrk4)
+*                 ݕSĂ̐őĕςȂ@g
+*   --theta      ؂̊Jp (ȗ͒ڑa). ̃N̉̃Z͒PɎqƂĎ󂯎
+*   --order n     ̗̖̈̒؂̑dɓWJ̎ (ȗ2)
+*   --balance k   kXebvƂɗ̈𕪂 (ȗ10)
+*   --softening e, --softening-kernel k  gravity2d, gravity3dƓƓ̌`. ̃N̉̃Z̒PɎq
+*   --diagnostics k  kXebvƂƍŏƍŌɃGlM[, ^, p^ʂSẴNōvďo
+*   --log f       --diagnostics̏o (ȗ͕WG[o)
+*   --threads n   eN̍ƃXbh̐ (ȗ1)
+* I͏ȂƂw肷邱. SẴNf[^t@Cǂ, ԍ̏ɕĂԂŕ.
+* o͂̓N0SĂ̐̔ԍ̏ɏW߂ď̂, f[^t@CƓ`ŏlƂēǂݒ.
+* ڑał̓N̂Ƃgravity2d, gravity3dƓ̌ʂɃrbgPʂňv,
+* N̂Ƃ͘ȁԂ̈Ⴂɂۂߌ덷͈̔͂ňv. Փ˂ɂ鍇̂̓N܂łgŋN.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+
+/**
+* MPIł̃ob`s̐ݒ
+*/
+struct MpiOptions {
+    double dt;          // time step
+    long steps;         // stop after this number of steps, < 0 for no limit
+    double end;         // stop when the time reaches this, < 0 for no limit
+    double bound;       // stop when every star is out of this range, < 0 for no limit
+    long every;         // output cadence in steps, 0 for the final state only
+    const char* output; // prefix of the output files, NULL for stdout
+    int method;         // METHOD_*, one with a fixed common step
+    double theta;       // opening angle of Barnes-Hut, < 0 for direct summation
+    int order;
+    double softening;   // softening length, 0 for Newtonian gravity
+    int softening_kind; // FORCE_SOFTENING_*
+    long balance;       // cadence of the recursive bisection in steps
+    long diagnostics;   // cadence of the conservation diagnostics in steps, 0 for none
+    const char* log;    // file to write the diagnostics to, NULL for stderr
+    int threads;        // worker threads of each rank
+};
+
+/**
+* @fn f[^t@CɑR}hCǂݍ.
+* @param verbose 0̂Ƃ\Ȃ. N0\
+* @return ǂ߂Ƃ1 肪Ƃ0
+*/
+static int parse_options(int argc, char **argv, struct MpiOptions *options, const int verbose) {
+    const char *error = NULL;
+    int i;
+    options->dt = 0;
+    options->steps = -1;
+    options->end = -1;
+    options->bound = -1;
+    options->every = 0;
+    options->output = NULL;
+    options->method = METHOD_RK4;
+    options->theta = -1;
+    options->order = TREE_QUADRUPOLE;
+    options->softening = 0;
+    options->softening_kind = FORCE_SOFTENING_PLUMMER;
+    options->balance = 10;
+    options->diagnostics = 0;
+    options->log = NULL;
+    options->threads = 1;
+    for ( i = 2; i < argc && error == NULL; i++ ) {
+        if ( i + 1 >= argc ) {
+            error = "an option needs a value";
+        } else if ( strcmp(argv[i], "--dt") == 0 ) {
+            options->dt = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--steps") == 0 ) {
+            options->steps = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--end") == 0 ) {
+            options->end = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--bound") == 0 ) {
+            options->bound = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--every") == 0 ) {
+            options->every = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--output") == 0 ) {
+            options->output = argv[++i];
+        } else if ( strcmp(argv[i], "--method") == 0 ) {
+            options->method = find_method(argv[++i]);
+            if ( options->method < 0 ) {
+                error = "unknown method";
+            } else if ( options->method == METHOD_DOPRI || options->method == METHOD_HERMITE ) {
+                //the step size control and the block steps would need every rank to agree on each step
+                error = "dopri and hermite are not supported across processes. use rk4, euler, leapfrog, yoshida4 or yoshida6";
+            }
+        } else if ( strcmp(argv[i], "--theta") == 0 ) {
+            options->theta = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--order") == 0 ) {
+            options->order = atoi(argv[++i]) >= TREE_QUADRUPOLE ? TREE_QUADRUPOLE : TREE_MONOPOLE;
+        } else if ( strcmp(argv[i], "--softening") == 0 ) {
+            options->softening = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--softening-kernel") == 0 ) {
+            ++i;
+            if ( strcmp(argv[i], "plummer") == 0 ) {
+                options->softening_kind = FORCE_SOFTENING_PLUMMER;
+            } else if ( strcmp(argv[i], "spline") == 0 ) {
+                options->softening_kind = FORCE_SOFTENING_SPLINE;
+            } else {
+                error = "unknown softening kernel";
+            }
+        } else if ( strcmp(argv[i], "--balance") == 0 ) {
+            options->balance = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--diagnostics") == 0 ) {
+            options->diagnostics = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--log") == 0 ) {
+            options->log = argv[++i];
+        } else if ( strcmp(argv[i], "--threads") == 0 ) {
+            options->threads = atoi(argv[++i]);
+        } else {
+            error = "unknown option";
+        }
+    }
+    if ( error != NULL ) {
+        if ( verbose ) {
+            fprintf(stderr, "error: %s : %s.\n", error, argv[i - 1]);
+        }
+        return 0;
+    }
+    if ( options->dt < 0 ) {
+        error = "dt must be positive";
+    } else if ( options->softening < 0 ) {
+        error = "softening must not be negative";
+    } else if ( options->balance <= 0 ) {
+        error = "balance must be a positive cadence";
+    } else if ( options->diagnostics < 0 ) {
+        error = "diagnostics must be a positive cadence";
+    } else if ( options->log != NULL && options->diagnostics == 0 ) {
+        error = "--log needs --diagnostics";
+    } else if ( options->steps < 0 && options->end < 0 && options->bound < 0 ) {
+        error = "specify at least one of --steps, --end and --bound";
+    }
+    if ( error != NULL ) {
+        if ( verbose ) {
+            fprintf(stderr, "error: %s.\n", error);
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/**
+* @fn ̑SĂ͈̐͂̊Oɂ邩ׂ.
+* @param bound _𒆐SƂ͈͂̈ӂ̔
+*/
+static int is_all_out(const int size, struct Stars const *stars, const double bound) {
+    int i;
+#define INSIDE(X) fabs(stars->X[i]) < bound &&
+    for ( i = 0; i < size; i++ ) {
+        if ( FOR_AXES(INSIDE) 1 ) {
+            return 0;
+        }
+    }
+#undef INSIDE
+    return 1;
+}
+
+/**
+* @fn SẴN̐N0ɏW, f[^t@CƓ`ŏo.
+* @param step ݂̃Xebv. t@CɎg
+* @return Ƃ1 sƂ0 N0ȊO͏1
+*/
+static int write_state(struct MpiOptions const *options, const long step, const int size, struct Stars const *stars, struct Domain *domain) {
+    struct Stars all;
+    FILE *out = stdout;
+    int i, total;
+    total = gather_stars(size, stars, domain, &all);
+    if ( domain->rank != 0 ) {
+        return 1;
+    }
+    if ( options->output != NULL ) {
+        char name[1024];
+        snprintf(name, sizeof(name), "%s%08ld.txt", options->output, step);
+        out = fopen(name, "w");
+        if ( out == NULL ) {
+            fprintf(stderr, "error: cannot open %s.\n", name);
+            free_stars(&all);
+            return 0;
+        }
+    }
+#define WRITE_AXIS(X) fprintf(out, ",%.17g", all.X[i]);
+#define WRITE_VELOCITY(X) fprintf(out, ",%.17g", all.v##X[i]);
+    //17 digits so that the state is read back exactly
+    fprintf(out, "%d\n", total);
+    for ( i = 0; i < total; i++ ) {
+        fprintf(out, "%.17g", all.m[i]);
+        FOR_AXES(WRITE_AXIS)
+        FOR_AXES(WRITE_VELOCITY)
+        fprintf(out, "\n");
+    }
+#undef WRITE_AXIS
+#undef WRITE_VELOCITY
+    if ( out != stdout ) {
+        fclose(out);
+    } else {
+        fflush(out);
+    }
+    free_stars(&all);
+    return 1;
+}
+
+/**
+* @fn eN̐ffSĂ̐̐ffɍv.
+* @detail dS͎ʂŏd݂tč킹
+*/
+static void reduce_diagnostics(struct Diagnostics *diag) {
+    double sum[4 + 3 * GRAVITY_DIM];
+    const double mass = diag->mass;
+    int k = 0;
+    sum[k++] = diag->size;
+    sum[k++] = diag->mass;
+    sum[k++] = diag->kinetic;
+    sum[k++] = diag->potential;
+#define PACK_DIAGNOSTICS(X) sum[k++] = diag->momentum.X; sum[k++] = diag->center.X * mass;
+    FOR_AXES(PACK_DIAGNOSTICS)
+#undef PACK_DIAGNOSTICS
+#if GRAVITY_DIM == 3
+    sum[k++] = diag->angular.x;
+    sum[k++] = diag->angular.y;
+    sum[k++] = diag->angular.z;
+#else
+    sum[k++] = diag->angular;
+#endif
+    MPI_Allreduce(MPI_IN_PLACE, sum, k, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    k = 0;
+    diag->size = ( int )sum[k++];
+    diag->mass = sum[k++];
+    diag->kinetic = sum[k++];
+    diag->potential = sum[k++];
+#define UNPACK_DIAGNOSTICS(X) diag->momentum.X = sum[k++]; diag->center.X = sum[k++] / ( diag->mass > 0 ? diag->mass : 1 );
+    FOR_AXES(UNPACK_DIAGNOSTICS)
+#undef UNPACK_DIAGNOSTICS
+#if GRAVITY_DIM == 3
+    diag->angular.x = sum[k++];
+    diag->angular.y = sum[k++];
+    diag->angular.z = sum[k++];
+#else
+    diag->angular = sum[k++];
+#endif
+    diag->energy = diag->kinetic + diag->potential;
+}
+
+/**
+* @fn ߂|eVffɉ, SẴNōvăN0o.
+* @param initial ŏ̐ff ܂Ȃ(step)̐ffŏƂ
+*/
+static void finish_diagnostics(FILE *log, const int size, struct Stars const *stars, double const *phi, struct Diagnostics *diag,
+    struct Diagnostics *initial, const int root) {
+    add_potential(size, stars, phi, diag);
+    reduce_diagnostics(diag);
+    if ( initial->step < 0 ) {
+        *initial = *diag;
+    }
+    if ( root ) {
+        write_diagnostics(log, diag, initial);
+    }
+}
+
+int main(int argc, char **argv) {
+    struct MpiOptions options;
+    struct Stars all, stars;
+    struct StarsState state;
+    struct Workspace work;
+    struct Stepper stepper;
+    struct Domain domain;
+    struct ThreadPool *pool = NULL;
+    struct Diagnostics diag, initial;
+    FILE *log = stderr;
+    int rank, size, loaded, root, out;
+    long step = 0, first, total;
+    long long imported;
+    long migrated, crossings;
+    int largest;
+    double t = 0;
+    double start, elapsed;
+    const char *reason;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    root = rank == 0;
+    if ( argc < 2 ) {
+        if ( root ) {
+            fprintf(stderr, "usage: mpirun -np ranks %s data [--dt dt] [--steps n] [--end t] [--bound r] [--every k] [--output prefix]"
+                " [--method rk4|euler|leapfrog|yoshida4|yoshida6] [--theta theta] [--order n]"
+                " [--softening e] [--softening-kernel plummer|spline] [--balance k]"
+                " [--diagnostics k] [--log file] [--threads n]\n", argv[0]);
+        }
+        MPI_Finalize();
+        return 2;
+    }
+    if ( !parse_options(argc, argv, &options, root) ) {
+        MPI_Finalize();
+        return 2;
+    }
+    if ( options.threads > 1 ) {
+        pool = create_pool(options.threads);
+    }
+    //every rank reads the file and keeps its share
+    loaded = load_stars(argv[1], &all, pool, &state);
+    MPI_Allreduce(MPI_IN_PLACE, &loaded, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if ( loaded <= 0 ) {
+        if ( root ) {
+            fprintf(stderr, "error: cannot read stars from %s.\n", argv[1]);
+        }
+        destroy_pool(pool);
+        MPI_Finalize();
+        return 1;
+    }
+    if ( !init_domain(options.theta, options.order, pool, &domain) ) {
+        fprintf(stderr, "error: rank %d cannot allocate the domain.\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    size = split_stars(loaded, &all, &stars, &domain);
+    free_stars(&all);
+    if ( !allocate_workspace(stars.capacity, &work) ) {
+        fprintf(stderr, "error: rank %d cannot allocate workspace.\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    work.pool = pool;
+    attach_domain(&domain, &work);
+    set_force_softening(options.softening_kind, options.softening);
+    if ( options.dt <= 0 ) {
+        options.dt = state.dt > 0 ? state.dt : 1.0;
+    }
+    step = state.step;
+    first = step;
+    t = step * options.dt;
+    if ( step > 0 && root ) {
+        fprintf(stderr, "resume from step %ld, t = %g\n", step, t);
+    }
+    //the fixed step methods keep no arrays of their own
+    allocate_stepper(stars.capacity, options.method, options.dt, 1e-8, 1e-8, HERMITE_ETA, &stepper);
+    size = balance_domain(size, &stars, &work, &domain);
+
+    diag.step = -1;
+    diag.pending = 0;
+    initial.step = -1;
+    if ( options.diagnostics > 0 && root && options.log != NULL ) {
+        log = fopen(options.log, "w");
+        if ( log == NULL ) {
+            fprintf(stderr, "error: cannot open %s. write diagnostics to stderr.\n", options.log);
+            log = stderr;
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    if ( options.every > 0 ) {
+        write_state(&options, step, size, &stars, &domain);
+    }
+    for ( ;; ) {
+        if ( options.steps >= 0 && step >= options.steps ) {
+            reason = "step count";
+            break;
+        }
+        if ( options.end >= 0 && t + options.dt * 0.5 > options.end ) {
+            reason = "end time";
+            break;
+        }
+        if ( options.bound >= 0 ) {
+            out = is_all_out(size, &stars, options.bound);
+            MPI_Allreduce(MPI_IN_PLACE, &out, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+            if ( out ) {
+                reason = "all stars out of bound";
+                break;
+            }
+        }
+        if ( step > first && ( step - first ) % options.balance == 0 ) {
+            size = balance_domain(size, &stars, &work, &domain);
+            stepper_discard(&stepper);
+        }
+        size = domain_collision(size, next_dt(&stepper), &stars, &work, &domain);
+        if ( domain.changed ) {
+            //some rank moved or merged stars, every rank computes the force again together
+            stepper_discard(&stepper);
+        }
+        if ( options.diagnostics > 0 && ( step == first || step % options.diagnostics == 0 ) ) {
+            measure_state(step, t, size, &stars, &diag);
+            //rk4 and euler find the potential in the first force evaluation of the step below
+            if ( stepper_potential(size, &stars, &work, &stepper) ) {
+                finish_diagnostics(log, size, &stars, work.phi, &diag, &initial, root);
+            }
+        }
+        advance(size, 0, &stars, &work, &stepper);
+        if ( diag.pending ) {
+            finish_diagnostics(log, size, &stars, work.phi, &diag, &initial, root);
+        }
+        step++;
+        //count the fixed steps so that rounding errors do not add up
+        t = step * options.dt;
+        if ( options.every > 0 && step % options.every == 0 ) {
+            write_state(&options, step, size, &stars, &domain);
+        }
+    }
+    if ( options.diagnostics > 0 && diag.step != step ) {
+        measure_state(step, t, size, &stars, &diag);
+        if ( !stepper_potential(size, &stars, &work, &stepper) ) {
+            accelerations(size, &stars, &work);
+        }
+        finish_diagnostics(log, size, &stars, work.phi, &diag, &initial, root);
+    }
+    if ( options.every <= 0 || step % options.every != 0 ) {
+        write_state(&options, step, size, &stars, &domain);
+    }
+    elapsed = MPI_Wtime() - start;
+    total = total_stars(size);
+    MPI_Allreduce(&size, &largest, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Reduce(&domain.imported, &imported, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&domain.migrated, &migrated, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&domain.crossings, &crossings, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if ( root ) {
+        fprintf(stderr, "stopped by %s : %ld steps, t = %g, %ld stars, %.3f s (%.1f steps/s, %d ranks, %d threads each)\n",
+            reason, step, t, total, elapsed, elapsed > 0 ? ( step - first ) / elapsed : 0.0, domain.ranks, pool_threads(pool));
+        report_stepper(stderr, ( int )total, step - first, &stepper);
+        fprintf(stderr, "%s domain : %s, %.1f stars and cells imported per rank and evaluation,"
+            " %ld stars migrated, %ld colliding pairs across ranks, largest rank %.2f of the mean\n",
+            DOMAIN_NAME, options.theta < 0 ? "direct summation" : "locally essential trees",
+            domain.evaluations > 0 ? ( double )imported / domain.evaluations / domain.ranks : 0.0, migrated, crossings,
+            total > 0 ? ( double )largest * domain.ranks / total : 0.0);
+    }
+    free_stepper(&stepper);
+    if ( log != stderr ) {
+        fclose(log);
+    }
+    free_domain(&domain);
+    free_workspace(&work);
+    free_stars(&stars);
+    destroy_pool(pool);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+* @brief 풓Xbhɂ񃋁[v
+* @detail
+* create_poolōƃXbhNĂ, parallel_for̂тɖĂXbhN
+* [0, size) chunkҏŎ荇ď. ĂяoXbhꏏɏ,
+* SĂ͈̔͂I܂Ŗ߂Ȃ. Xbh̐create_pool̈xōς.
+*/
+#include <stdlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "pool.h"
+#include "threads.h"
+
+struct ThreadPool {
+    int threads;            // number of threads including the caller of parallel_for
+    thread_handle* workers; // threads - 1 worker threads
+    int started;            // number of worker threads actually started
+    thread_mutex lock;
+    thread_cond wake;       // signaled when a new job is posted or the pool stops
+    thread_cond done;       // signaled when the last worker finishes the job
+    int generation;         // incremented for each job
+    int running;            // workers still working on the current job
+    int stop;
+    pool_task task;         // current job
+    void* arg;
+    int size;
+    int chunk;
+    thread_counter next;    // first index not yet claimed
+};
+
+/**
+* @fn ݂͈̏̔͂ȂȂ܂chunkĎs.
+*/
+static void run(struct ThreadPool *pool) {
+    for ( ;; ) {
+        const long begin = fetch_add(&pool->next, pool->chunk);
+        if ( begin >= pool->size ) {
+            return;
+        }
+        pool->task(pool->arg, ( int )begin, begin + pool->chunk < pool->size ? ( int )begin + pool->chunk : pool->size);
+    }
+}
+
+/**
+* @fn ƃXbh̖{. V܂Ŗ, s
+*/
+static void work(struct ThreadPool *pool) {
+    int generation = 0;
+    mutex_lock(&pool->lock);
+    for ( ;; ) {
+        while ( pool->generation == generation && !pool->stop ) {
+            cond_wait(&pool->wake, &pool->lock);
+        }
+        if ( pool->stop ) {
+            break;
+        }
+        generation = pool->generation;
+        mutex_unlock(&pool->lock);
+        run(pool);
+        mutex_lock(&pool->lock);
+        if ( --pool->running == 0 ) {
+            cond_signal(&pool->done);
+        }
+    }
+    mutex_unlock(&pool->lock);
+}
+
+static thread_result THREAD_CALL worker_main(void *arg) {
+    work(( struct ThreadPool * )arg);
+    return 0;
+}
+
+/**
+* @fn vZ@œɎsłXbh̐Ԃ.
+*/
+int hardware_threads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return ( int )info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? ( int )count : 1;
+#endif
+}
+
+/**
+* @fn ƃXbhN.
+* @param threads Ăяo܂߂Xbh̐
+* @return NXbh̏W sƂNULL
+*/
+struct ThreadPool* create_pool(const int threads) {
+    struct ThreadPool *pool = ( struct ThreadPool * )calloc(1, sizeof(struct ThreadPool));
+    int i;
+    if ( pool == NULL ) {
+        return NULL;
+    }
+    pool->threads = threads > 1 ? threads : 1;
+    pool->workers = ( thread_handle * )malloc(sizeof(thread_handle) * pool->threads);
+    if ( pool->workers == NULL ) {
+        free(pool);
+        return NULL;
+    }
+    mutex_init(&pool->lock);
+    cond_init(&pool->wake);
+    cond_init(&pool->done);
+    for ( i = 0; i < pool->threads - 1; i++ ) {
+        if ( !start_thread(&pool->workers[i], worker_main, pool) ) {
+            break;
+        }
+        pool->started++;
+    }
+    //run with the threads that could be started
+    pool->threads = pool->started + 1;
+    return pool;
+}
+
+/**
+* @fn ƃXbhIĉ.
+*/
+void destroy_pool(struct ThreadPool *pool) {
+    int i;
+    if ( pool == NULL ) {
+        return;
+    }
+    mutex_lock(&pool->lock);
+    pool->stop = 1;
+    cond_broadcast(&pool->wake);
+    mutex_unlock(&pool->lock);
+    for ( i = 0; i < pool->started; i++ ) {
+        join_thread(pool->workers[i]);
+    }
+    cond_destroy(&pool->wake);
+    cond_destroy(&pool->done);
+    mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+* @fn Ăяo܂߂Xbh̐Ԃ. poolNULL̂Ƃ1
+*/
+int pool_threads(struct ThreadPool const *pool) {
+    return pool != NULL ? pool->threads : 1;
+}
+
+/**
+* @fn [0, size) chunkɕĕɏ. SďI܂Ŗ߂Ȃ
+* @param pool ƃXbh̏W NULL̂Ƃ͌ĂяoXbhŏ
+* @param chunk xɎ͈͂̑傫
+* @param task ͈͂ƂɌĂԏ
+* @param arg taskɓnl
+*/
+void parallel_for(struct ThreadPool *pool, const int size, const int chunk, pool_task task, void *arg) {
+    if ( size <= 0 ) {
+        return;
+    }
+    if ( pool == NULL || pool->threads <= 1 || size <= chunk ) {
+        task(arg, 0, size);
+        return;
+    }
+    mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->size = size;
+    pool->chunk = chunk > 0 ? chunk : 1;
+    pool->next = 0;
+    pool->running = pool->threads - 1;
+    pool->generation++;
+    cond_broadcast(&pool->wake);
+    mutex_unlock(&pool->lock);
+    run(pool);
+    mutex_lock(&pool->lock);
+    while ( pool->running > 0 ) {
+        cond_wait(&pool->done, &pool->lock);
+    }
+    mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+* Ɏs鏈. [begin, end) ͈̔͂vZ
+*/
+typedef void (*pool_task)(void *arg, const int begin, const int end);
+
+/**
+* 풓ƃXbh̏W. gpool.c̒ň
+*/
+struct ThreadPool;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int hardware_threads(void);
+    struct ThreadPool* create_pool(const int threads);
+    void destroy_pool(struct ThreadPool *pool);
+    int pool_threads(struct ThreadPool const *pool);
+    void parallel_for(struct ThreadPool *pool, const int size, const int chunk, pool_task task, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
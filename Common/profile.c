@@ -0,0 +1,360 @@
+/**
+* @brief ԂƂ̎ԂƉ񐔂̌v
+* @detail
+* vl̓XbhƂ̗̈ɑނ̂, ƃXbh܂߂ăbNȂŋL^ł.
+* Xbḧ̗͍ŏ̋L^̂ƂɈxmۂăXgɂȂ, WvƏo̎ɑSĂǂ.
+* x86łRDTSC, ȊOł͒PȎvœǂ, v̎n߂̌oߎԂŕbɊZ.
+* profile_startŃg[XLɂƋԂL^, Chrome (chrome://tracing, Perfetto) œǂ߂
+* JSONƂďo. WvƏo͍ƃXbh~܂ĂԂɌĂԂ.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PROFILE_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+static SRWLOCK lock = SRWLOCK_INIT;
+#define lock_threads() AcquireSRWLockExclusive(&lock)
+#define unlock_threads() ReleaseSRWLockExclusive(&lock)
+#else
+#include <pthread.h>
+#include <time.h>
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#define lock_threads() pthread_mutex_lock(&lock)
+#define unlock_threads() pthread_mutex_unlock(&lock)
+#endif
+
+#ifdef _MSC_VER
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL __thread
+#endif
+
+#define PROFILE_FIRST_EVENTS 4096       // events a thread can trace before growing the buffer
+#define PROFILE_MAX_EVENTS ( 1 << 22 )  // events a thread traces at most, 24 bytes each
+
+static const char *const phase_names[PROFILE_PHASES] = {
+    "update", "on_screen", "collision", "advance", "rk4_stage1", "rk4_stage2", "rk4_stage3", "rk4_stage4",
+    "force", "force_range", "output", "draw", "render",
+};
+
+static const char *const counter_names[PROFILE_COUNTERS] = {
+    "pairs", "cells", "merges", "allocations",
+};
+
+/**
+* g[XɋL^Ԉ
+*/
+struct ProfileEvent {
+    unsigned long long start;   // ticks from the origin
+    unsigned long long length;
+    int phase;
+};
+
+/**
+* XbhƂ̌vl
+*/
+struct ProfileThread {
+    int id;             // in order of the first record, 0 is usually the main thread
+    unsigned long long start[PROFILE_PHASES]; // ticks when the phase began
+    unsigned long long calls[PROFILE_PHASES];
+    unsigned long long total[PROFILE_PHASES];
+    unsigned long long shortest[PROFILE_PHASES];
+    unsigned long long longest[PROFILE_PHASES];
+    long long counters[PROFILE_COUNTERS];
+    struct ProfileEvent* events;
+    int event_count;
+    int event_capacity;
+    long dropped;       // events not traced because the buffer could not grow
+    struct ProfileThread* next;
+};
+
+static PROFILE_THREAD_LOCAL struct ProfileThread *local = NULL;
+static struct ProfileThread *threads = NULL;
+static int thread_count = 0;
+static int tracing = 0;
+static unsigned long long origin_ticks = 0;
+static double origin_seconds = 0;
+
+static unsigned long long ticks(void) {
+#ifdef PROFILE_RDTSC
+    return __rdtsc();
+#elif defined(_WIN32)
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return ( unsigned long long )now.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ( unsigned long long )now.tv_sec * 1000000000ull + ( unsigned long long )now.tv_nsec;
+#endif
+}
+
+static double seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return ( double )now.QuadPart / ( double )frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static void reset_thread(struct ProfileThread *t) {
+    int k;
+    for ( k = 0; k < PROFILE_PHASES; k++ ) {
+        t->calls[k] = 0;
+        t->total[k] = 0;
+        t->shortest[k] = ~0ull;
+        t->longest[k] = 0;
+    }
+    for ( k = 0; k < PROFILE_COUNTERS; k++ ) {
+        t->counters[k] = 0;
+    }
+    t->event_count = 0;
+    t->dropped = 0;
+}
+
+/**
+* @fn ĂяoXbȟvl̗̈Ԃ. ŏ̌ĂяoŊmۂăXgɂȂ
+* @return mۂłȂNULL
+*/
+static struct ProfileThread* this_thread(void) {
+    struct ProfileThread *t = local;
+    if ( t != NULL ) {
+        return t;
+    }
+    t = ( struct ProfileThread * )calloc(1, sizeof(struct ProfileThread));
+    if ( t == NULL ) {
+        return NULL;
+    }
+    reset_thread(t);
+    lock_threads();
+    if ( threads == NULL && origin_ticks == 0 ) {
+        origin_ticks = ticks();
+        origin_seconds = seconds();
+    }
+    t->id = thread_count++;
+    t->next = threads;
+    threads = t;
+    unlock_threads();
+    local = t;
+    return t;
+}
+
+/**
+* @fn GRAVITY_PROFILE`ăRpC.
+*/
+int profile_enabled(void) {
+#ifdef GRAVITY_PROFILE
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**
+* @fn v蒼. oߎԂ̋N_ɂ, ܂ł̌vl̂Ă
+* @param trace 1̂ƂԂL^profile_write_traceŏo悤ɂ
+*/
+void profile_start(const int trace) {
+    struct ProfileThread *t;
+    lock_threads();
+    for ( t = threads; t != NULL; t = t->next ) {
+        reset_thread(t);
+    }
+    tracing = trace;
+    origin_ticks = ticks();
+    origin_seconds = seconds();
+    unlock_threads();
+}
+
+void profile_begin(const int phase) {
+    struct ProfileThread *t = this_thread();
+    if ( t != NULL ) {
+        t->start[phase] = ticks();
+    }
+}
+
+void profile_end(const int phase) {
+    const unsigned long long now = ticks();
+    struct ProfileThread *t = local;
+    unsigned long long length;
+    if ( t == NULL ) {
+        return;
+    }
+    length = now - t->start[phase];
+    t->calls[phase]++;
+    t->total[phase] += length;
+    if ( length < t->shortest[phase] ) {
+        t->shortest[phase] = length;
+    }
+    if ( length > t->longest[phase] ) {
+        t->longest[phase] = length;
+    }
+    if ( !tracing || t->start[phase] < origin_ticks ) {
+        return;
+    }
+    if ( t->event_count == t->event_capacity ) {
+        const int grown = t->event_capacity > 0 ? t->event_capacity * 2 : PROFILE_FIRST_EVENTS;
+        struct ProfileEvent *larger = grown <= PROFILE_MAX_EVENTS
+            ? ( struct ProfileEvent * )realloc(t->events, sizeof(struct ProfileEvent) * grown) : NULL;
+        if ( larger == NULL ) {
+            t->dropped++;
+            return;
+        }
+        t->events = larger;
+        t->event_capacity = grown;
+    }
+    t->events[t->event_count].start = t->start[phase] - origin_ticks;
+    t->events[t->event_count].length = length;
+    t->events[t->event_count].phase = phase;
+    t->event_count++;
+}
+
+void profile_count(const int counter, const long long n) {
+    struct ProfileThread *t = this_thread();
+    if ( t != NULL ) {
+        t->counters[counter] += n;
+    }
+}
+
+/**
+* @fn N_̌oߎԂRDTSCȂǂ1b݂̍߂.
+*/
+static double elapsed_time(double *tick_rate) {
+    const double elapsed = seconds() - origin_seconds;
+    const unsigned long long now = ticks();
+    *tick_rate = elapsed > 0 && now > origin_ticks ? ( now - origin_ticks ) / elapsed : 1e9;
+    return elapsed;
+}
+
+/**
+* @fn Xbh̔ԍ̏ɕׂvl̔z.
+* @return mallocŊmۂz Ăяo
+*/
+static struct ProfileThread** sorted_threads(int *count) {
+    struct ProfileThread **list;
+    struct ProfileThread *t;
+    *count = 0;
+    list = ( struct ProfileThread ** )malloc(sizeof(struct ProfileThread *) * ( thread_count > 0 ? thread_count : 1 ));
+    if ( list == NULL ) {
+        return NULL;
+    }
+    for ( t = threads; t != NULL; t = t->next ) {
+        list[t->id] = t;
+        ( *count )++;
+    }
+    return list;
+}
+
+/**
+* @fn Ԃ, XbhƂ̎ԂƉ񐔂̕\o.
+* @detail ͌v̋N_̌oߎԂɑ΂l. q̋Ԃ͊ŐԂɂ܂܂
+*/
+void profile_report(FILE *out) {
+    double rate, elapsed;
+    struct ProfileThread **list;
+    int count, i, k;
+    lock_threads();
+    elapsed = elapsed_time(&rate);
+    list = sorted_threads(&count);
+    if ( list == NULL ) {
+        unlock_threads();
+        return;
+    }
+    fprintf(out, "profile : %.3f s, %d threads, %s %.3f GHz\n", elapsed, count,
+#ifdef PROFILE_RDTSC
+        "rdtsc",
+#else
+        "clock",
+#endif
+        rate * 1e-9);
+    fprintf(out, "%-12s %6s %10s %12s %10s %10s %10s %7s\n", "phase", "thread", "calls", "total ms", "mean us", "min us", "max us", "share");
+    for ( k = 0; k < PROFILE_PHASES; k++ ) {
+        for ( i = 0; i < count; i++ ) {
+            struct ProfileThread const *t = list[i];
+            if ( t->calls[k] == 0 ) {
+                continue;
+            }
+            fprintf(out, "%-12s %6d %10llu %12.3f %10.3f %10.3f %10.3f %6.1f%%\n", phase_names[k], t->id, t->calls[k],
+                t->total[k] / rate * 1e3, t->total[k] / rate * 1e6 / t->calls[k], t->shortest[k] / rate * 1e6,
+                t->longest[k] / rate * 1e6, elapsed > 0 ? t->total[k] / rate / elapsed * 100 : 0.0);
+        }
+    }
+    fprintf(out, "%-12s %6s %16s\n", "counter", "thread", "total");
+    for ( k = 0; k < PROFILE_COUNTERS; k++ ) {
+        for ( i = 0; i < count; i++ ) {
+            if ( list[i]->counters[k] != 0 ) {
+                fprintf(out, "%-12s %6d %16lld\n", counter_names[k], list[i]->id, list[i]->counters[k]);
+            }
+        }
+    }
+    for ( i = 0; i < count; i++ ) {
+        if ( list[i]->dropped > 0 ) {
+            fprintf(out, "thread %d : %ld events not traced\n", list[i]->id, list[i]->dropped);
+        }
+    }
+    free(list);
+    unlock_threads();
+}
+
+/**
+* @fn g[XԂChromẽg[X`(JSON)ŏo.
+* @return Ƃ1 sƂ0
+* @detail Ԃ͊Cxg("ph":"X"), JE^͍Ō̎ł̍v("ph":"C")Ƃď. ̒Pʂ̓}CNb
+*/
+int profile_write_trace(const char *path) {
+    double rate;
+    struct ProfileThread **list;
+    int count, i, k, ok;
+    const char *separator = "";
+    FILE *out = fopen(path, "w");
+    if ( out == NULL ) {
+        return 0;
+    }
+    lock_threads();
+    const double elapsed = elapsed_time(&rate);
+    list = sorted_threads(&count);
+    if ( list == NULL ) {
+        unlock_threads();
+        fclose(out);
+        return 0;
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for ( i = 0; i < count; i++ ) {
+        struct ProfileThread const *t = list[i];
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            separator, t->id, t->id == 0 ? "main" : "worker", t->id);
+        separator = ",\n";
+        for ( k = 0; k < t->event_count; k++ ) {
+            struct ProfileEvent const *e = &t->events[k];
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"gravity\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                phase_names[e->phase], t->id, e->start / rate * 1e6, e->length / rate * 1e6);
+        }
+        for ( k = 0; k < PROFILE_COUNTERS; k++ ) {
+            if ( t->counters[k] != 0 ) {
+                fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"%s\":%lld}}",
+                    counter_names[k], t->id, elapsed * 1e6, counter_names[k], t->counters[k]);
+            }
+        }
+    }
+    fprintf(out, "\n]}\n");
+    free(list);
+    unlock_threads();
+    ok = !ferror(out);
+    return fclose(out) == 0 && ok;
+}
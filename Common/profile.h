@@ -0,0 +1,77 @@
+#pragma once
+#include <stdio.h>
+
+/**
+* ԂƂ̎ԂƉ񐔂̌v
+* GRAVITY_PROFILE`ăRpCƂPROFILE_*̃}Nv. `ȂΉcȂ
+*/
+
+// phases measured with PROFILE_BEGIN and PROFILE_END, in the order of the summary table
+#define PROFILE_UPDATE 0        // one Simulator::Step, or one step of the batch loop
+#define PROFILE_ON_SCREEN 1     // whether any star is still on the screen or in the bound
+#define PROFILE_COLLISION 2     // collision and merging
+#define PROFILE_ADVANCE 3       // one step of the integrator
+#define PROFILE_RK4_STAGE1 4    // force evaluation and update of each stage of runge_kutta
+#define PROFILE_RK4_STAGE2 5
+#define PROFILE_RK4_STAGE3 6
+#define PROFILE_RK4_STAGE4 7
+#define PROFILE_FORCE 8         // accelerations, whichever method
+#define PROFILE_FORCE_RANGE 9   // the part of a force evaluation one thread computed at once
+#define PROFILE_OUTPUT 10       // snapshots and checkpoints
+#define PROFILE_DRAW 11         // OnDraw
+#define PROFILE_RENDER 12       // drawing and writing one frame on the render thread
+#define PROFILE_PHASES 13
+
+// counters added with PROFILE_COUNT
+#define PROFILE_PAIRS 0         // star-star interactions
+#define PROFILE_CELLS 1         // star-cell interactions of the tree and cell-cell ones of FMM
+#define PROFILE_MERGES 2        // stars merged by collision
+#define PROFILE_ALLOCATIONS 3   // heap allocations on the way of the steps
+#define PROFILE_COUNTERS 4
+
+#ifdef GRAVITY_PROFILE
+#define PROFILE_BEGIN(phase) profile_begin(phase)
+#define PROFILE_END(phase) profile_end(phase)
+#define PROFILE_COUNT(counter, n) profile_count(counter, n)
+#else
+#define PROFILE_BEGIN(phase)
+#define PROFILE_END(phase)
+//counts kept in local variables are used here and then optimized away
+#define PROFILE_COUNT(counter, n) ( ( void )( n ) )
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int profile_enabled(void);
+    void profile_start(const int trace);
+    void profile_begin(const int phase);
+    void profile_end(const int phase);
+    void profile_count(const int counter, const long long n);
+    void profile_report(FILE *out);
+    int profile_write_trace(const char *path);
+
+#ifdef __cplusplus
+}
+
+/**
+* XR[v𔲂܂ł̋ԂƂČv
+*/
+class ProfileScope {
+    int phase;
+    public:
+    explicit ProfileScope(const int phase) : phase(phase) {
+        PROFILE_BEGIN(phase);
+    }
+    ~ProfileScope() {
+        PROFILE_END(phase);
+    }
+};
+
+#ifdef GRAVITY_PROFILE
+#define PROFILE_SCOPE(phase) ProfileScope profile_scope_##phase(phase)
+#else
+#define PROFILE_SCOPE(phase)
+#endif
+#endif
@@ -0,0 +1,650 @@
+/**
+* @brief ߐژA̐
+* 2ł3ł̋ʕ regular1.c  regular3.c ꂼ regular*.h ̌ɃCN[h
+* @detail
+* ݕZŉA͌Œ荏݂̐ϕ@ł͐Xebvŉ, ݕς@ł͑Ŝ݂̍k߂.
+* select_binaries͔a radius ߂, ݂ɑ, ̐̒̏d͂ɔׂĎア̐AƂ.
+*   dS̉^   prepare_binariesAdSɒu mi + mj ̈̐ɒu, Ŝ̐ϕ@ő̐ƈꏏɐi߂.
+*                ͓̐ʒuɎ0Œû, ͂̌vZɂϕɂeȂ
+*   Ή^     propagate_binaries2̖𐳑Wŉ. 3Kustaanheimo-Stiefelϊ,
+*                2Levi-Civitaϊ, z s (dt = r ds) ɂ u'' = (E/2) u ̒aUqɂȂ.
+*                ŉ̂1XebvɉĂ덷܂炸, ߓ_łقɂȂȂ.
+*                ̐̒͏dSł̒e\ŋߎ, 1REGULAR_KICKS_PER_ORBIT̏RƂĉ
+* g̓XebvƂɑIђ. ÕXebv̑g͔a2{, ̔2{܂ŕۂ.
+* ÕXebv̑g̓`FbN|CgɋԂƂċL^, ĊJƂgIђ.
+* Xebv̊Ԃ͖{̓̐̈ʒuƑxɖ߂̂, o, ۑ, o̔͑SĂ̐.
+* Փ˂̔肾͘A̓̐̂Ȃ悤 stepper->partner ɑgn.
+* gςƂ, Փ˂┲oŐ̕тςƂ͐ϕ@̎g񂷉x̂Ă邱.
+* ݂̏d͓͂Ȃj[g̏d͂, A̎ldɎq̐ɋyڂd͖͂.
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern const double G;
+
+#if GRAVITY_DIM == 3
+#define REGULAR_DIM 4               // Kustaanheimo-Stiefel coordinates
+#else
+#define REGULAR_DIM 2               // Levi-Civita coordinates
+#endif
+#define REGULAR_GAMMA 1e-2          // tidal over internal force below which a pair is regularized
+#define REGULAR_KICKS_PER_ORBIT 16  // tidal kicks per orbit of a perturbed pair
+#define REGULAR_MAX_SUBSTEPS 4096   // bound on the tidal kicks in one step
+#define REGULAR_TWO_PI 6.283185307179586
+
+#define AXIS_POSITION(X) stars->X,
+#define AXIS_PREVIOUS(X) stars->pre_##X,
+#define AXIS_VELOCITY(X) stars->v##X,
+
+/**
+* @fn A̍Ɨ̈mۂ.
+* @param capacity ̐̏
+* @param radius ̋߂gAɂ 0ȉ̂ƂA킸mۂȂ
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_binaries(const int capacity, const double radius, struct Binaries *bin) {
+    int i;
+    memset(bin, 0, sizeof(struct Binaries));
+    bin->radius = radius;
+    if ( radius <= 0 || capacity <= 0 ) {
+        return 1;
+    }
+    bin->pairs = ( struct Binary * )malloc(sizeof(struct Binary) * ( capacity / 2 + 1 ));
+    bin->partner = ( int * )malloc(sizeof(int) * capacity);
+    bin->keys = ( struct BinaryKey * )malloc(sizeof(struct BinaryKey) * capacity);
+    if ( bin->pairs == NULL || bin->partner == NULL || bin->keys == NULL ) {
+        free_binaries(bin);
+        return 0;
+    }
+    bin->capacity = capacity;
+    for ( i = 0; i < capacity; i++ ) {
+        bin->partner[i] = -1;
+    }
+    return 1;
+}
+
+void free_binaries(struct Binaries *bin) {
+    free(bin->pairs);
+    free(bin->partner);
+    free(bin->keys);
+    free(bin->candidates);
+    bin->pairs = NULL;
+    bin->partner = NULL;
+    bin->keys = NULL;
+    bin->candidates = NULL;
+    bin->capacity = 0;
+    bin->candidate_capacity = 0;
+    bin->count = 0;
+}
+
+/**
+* @fn SĂ̑g. Փ˂┲oŐ̕тςƂɌĂ
+*/
+void forget_binaries(struct Binaries *bin) {
+    int k;
+    for ( k = 0; k < bin->count; k++ ) {
+        bin->partner[bin->pairs[k].i] = -1;
+        bin->partner[bin->pairs[k].j] = -1;
+    }
+    bin->dissolved += bin->count;
+    bin->count = 0;
+}
+
+static int compare_keys(const void *a, const void *b) {
+    const struct BinaryKey *p = ( const struct BinaryKey * )a;
+    const struct BinaryKey *q = ( const struct BinaryKey * )b;
+    if ( p->x < q->x ) {
+        return -1;
+    }
+    if ( p->x > q->x ) {
+        return 1;
+    }
+    return p->index - q->index;
+}
+
+static int compare_candidates(const void *a, const void *b) {
+    const struct BinaryCandidate *p = ( const struct BinaryCandidate * )a;
+    const struct BinaryCandidate *q = ( const struct BinaryCandidate * )b;
+    if ( p->r2 < q->r2 ) {
+        return -1;
+    }
+    if ( p->r2 > q->r2 ) {
+        return 1;
+    }
+    return p->i != q->i ? p->i - q->i : p->j - q->j;
+}
+
+/**
+* @fn ̐̑Έʒu, ΑxƏdS߂.
+*/
+static void relative_motion(struct Stars const *stars, const int i, const int j, double *r, double *v, double *center) {
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double const *velocity[GRAVITY_DIM] = { FOR_AXES(AXIS_VELOCITY) };
+    const double mass = stars->m[i] + stars->m[j];
+    int k;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        r[k] = position[k][i] - position[k][j];
+        v[k] = velocity[k][i] - velocity[k][j];
+        if ( center != NULL ) {
+            center[k] = ( stars->m[i] * position[k][i] + stars->m[j] * position[k][j] ) / mass;
+        }
+    }
+}
+
+/**
+* @fn ̐ȊȎSĂ̐dSɋyڂe\߂.
+* @param t a(c + d)  a(c) + T d  T 
+*/
+static void tidal_tensor(const int size, struct Stars const *stars, const int i, const int j, double const *center, double t[GRAVITY_DIM][GRAVITY_DIM]) {
+    double const *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    int n, k, l;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        for ( l = 0; l < GRAVITY_DIM; l++ ) {
+            t[k][l] = 0;
+        }
+    }
+    for ( n = 0; n < size; n++ ) {
+        double s[GRAVITY_DIM], s2 = 0, inv2, inv5;
+        if ( n == i || n == j || stars->m[n] <= 0 ) {
+            continue;
+        }
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            s[k] = position[k][n] - center[k];
+            s2 += s[k] * s[k];
+        }
+        if ( s2 <= 0 ) {
+            continue;
+        }
+        inv2 = 1.0 / s2;
+        inv5 = inv2 * inv2 * sqrt(inv2);
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                t[k][l] += stars->m[n] * ( 3 * s[k] * s[l] - ( k == l ? s2 : 0 ) ) * inv5;
+            }
+        }
+    }
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        for ( l = 0; l < GRAVITY_DIM; l++ ) {
+            t[k][l] *= G;
+        }
+    }
+}
+
+/**
+* @fn ̑gǉ. L΂ȂƂ͒ǉȂ
+*/
+static void add_candidate(struct Binaries *bin, int *count, const int i, const int j, const double r2, const int kept) {
+    struct BinaryCandidate *c;
+    if ( *count == bin->candidate_capacity ) {
+        const int grown = bin->candidate_capacity > 0 ? bin->candidate_capacity * 2 : 16;
+        struct BinaryCandidate *larger = ( struct BinaryCandidate * )realloc(bin->candidates, sizeof(struct BinaryCandidate) * grown);
+        if ( larger == NULL ) {
+            return;
+        }
+        bin->candidates = larger;
+        bin->candidate_capacity = grown;
+    }
+    c = &bin->candidates[( *count )++];
+    c->i = i < j ? i : j;
+    c->j = i < j ? j : i;
+    c->r2 = r2;
+    c->kept = kept;
+}
+
+/**
+* @fn ̏ԂAɂgIђ.
+* @param size ͂vZ鐯̐
+* @return gÕXebvςƂ1. ϕ@̎g񂷉x̂Ă邱
+* @detail xɕׂĔa2{̕ő|, ߂ꂽg߂Ɏ. e\͂̑g߂
+*/
+int select_binaries(const int size, struct Stars const *stars, struct Binaries *bin) {
+    const double reach = bin->radius * 2;
+    const int previous = bin->count;
+    int candidates = 0, kept = 0, n = 0;
+    int a, b, k;
+    if ( bin->radius <= 0 || bin->capacity < size ) {
+        return 0;
+    }
+    for ( k = 0; k < size; k++ ) {
+        if ( stars->m[k] > 0 ) {
+            bin->keys[n].x = stars->x[k];
+            bin->keys[n].index = k;
+            n++;
+        }
+    }
+    qsort(bin->keys, n, sizeof(struct BinaryKey), compare_keys);
+    for ( a = 0; a < n; a++ ) {
+        const int i = bin->keys[a].index;
+        for ( b = a + 1; b < n && bin->keys[b].x - bin->keys[a].x < reach; b++ ) {
+            const int j = bin->keys[b].index;
+            //a pair regularized in the previous step is kept up to twice the radius
+            const int was = bin->partner[i] == j;
+            const double limit = was ? reach : bin->radius;
+            double r[GRAVITY_DIM], v[GRAVITY_DIM], r2 = 0, v2 = 0;
+            relative_motion(stars, i, j, r, v, NULL);
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                r2 += r[k] * r[k];
+                v2 += v[k] * v[k];
+            }
+            if ( r2 >= limit * limit || r2 <= 0 ) {
+                continue;
+            }
+            //bound : 1/2 v^2 - G M / r < 0
+            if ( 0.5 * v2 * sqrt(r2) < G * ( stars->m[i] + stars->m[j] ) ) {
+                add_candidate(bin, &candidates, i, j, r2, was);
+            }
+        }
+    }
+    if ( candidates > 1 ) {
+        qsort(bin->candidates, candidates, sizeof(struct BinaryCandidate), compare_candidates);
+    }
+    for ( k = 0; k < previous; k++ ) {
+        bin->partner[bin->pairs[k].i] = -1;
+        bin->partner[bin->pairs[k].j] = -1;
+    }
+    bin->count = 0;
+    for ( k = 0; k < candidates; k++ ) {
+        struct BinaryCandidate const *c = &bin->candidates[k];
+        struct Binary *p = &bin->pairs[bin->count];
+        double r[GRAVITY_DIM], v[GRAVITY_DIM], center[GRAVITY_DIM], t2 = 0, gamma;
+        int l, m;
+        if ( bin->partner[c->i] >= 0 || bin->partner[c->j] >= 0 ) {
+            continue;
+        }
+        relative_motion(stars, c->i, c->j, r, v, center);
+        tidal_tensor(size, stars, c->i, c->j, center, p->t);
+        for ( l = 0; l < GRAVITY_DIM; l++ ) {
+            for ( m = 0; m < GRAVITY_DIM; m++ ) {
+                t2 += p->t[l][m] * p->t[l][m];
+            }
+        }
+        //tidal acceleration |T| r against the internal one G M / r^2
+        gamma = sqrt(t2) * c->r2 * sqrt(c->r2) / ( G * ( stars->m[c->i] + stars->m[c->j] ) );
+        if ( gamma >= ( c->kept ? REGULAR_GAMMA * 2 : REGULAR_GAMMA ) ) {
+            continue;
+        }
+        p->i = c->i;
+        p->j = c->j;
+        bin->partner[c->i] = c->j;
+        bin->partner[c->j] = c->i;
+        bin->count++;
+        kept += c->kept;
+    }
+    bin->formed += bin->count - kept;
+    bin->dissolved += previous - kept;
+    return bin->count != kept || previous != kept;
+}
+
+/**
+* @fn AdSɒu̐ɒu. select_binarieš, advance̒OɌĂ
+* @param work o̒ (work->external) ΘA̒ɉ
+* @detail iɎʂ̘aƏdS̈ʒuƑx, jɎ0ƓʒuƑx, Ή^oĂ
+*/
+void prepare_binaries(struct Stars *stars, struct Workspace const *work, struct Binaries *bin) {
+    double *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double *velocity[GRAVITY_DIM] = { FOR_AXES(AXIS_VELOCITY) };
+    int n, k, l;
+    for ( n = 0; n < bin->count; n++ ) {
+        struct Binary *p = &bin->pairs[n];
+        const int i = p->i, j = p->j;
+        double center[GRAVITY_DIM];
+        p->mi = stars->m[i];
+        p->mj = stars->m[j];
+        relative_motion(stars, i, j, p->r, p->v, center);
+        if ( work->external != NULL ) {
+            for ( k = 0; k < GRAVITY_DIM; k++ ) {
+                for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                    p->t[k][l] += work->external->t[k][l];
+                }
+            }
+        }
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            const double drift = ( p->mi * velocity[k][i] + p->mj * velocity[k][j] ) / ( p->mi + p->mj );
+            position[k][i] = center[k];
+            position[k][j] = center[k];
+            velocity[k][i] = drift;
+            velocity[k][j] = drift;
+        }
+        stars->m[i] = p->mi + p->mj;
+        stars->m[j] = 0;
+    }
+}
+
+/**
+* @fn W̕ϊsLwɊ|. Έʒu r = L(u) u
+* @param transpose 1̂Ƃ L^T |
+* @detail 3Kustaanheimo-Stiefelϊ, 2Levi-Civitaϊ (f2). ǂ L L^T = L^T L = |u|^2 I
+*/
+static void apply_regular(double const *u, double const *w, double *out, const int transpose) {
+#if GRAVITY_DIM == 3
+    if ( transpose ) {
+        out[0] = u[0] * w[0] + u[1] * w[1] + u[2] * w[2] + u[3] * w[3];
+        out[1] = -u[1] * w[0] + u[0] * w[1] + u[3] * w[2] - u[2] * w[3];
+        out[2] = -u[2] * w[0] - u[3] * w[1] + u[0] * w[2] + u[1] * w[3];
+        out[3] = u[3] * w[0] - u[2] * w[1] + u[1] * w[2] - u[0] * w[3];
+    } else {
+        out[0] = u[0] * w[0] - u[1] * w[1] - u[2] * w[2] + u[3] * w[3];
+        out[1] = u[1] * w[0] + u[0] * w[1] - u[3] * w[2] - u[2] * w[3];
+        out[2] = u[2] * w[0] + u[3] * w[1] + u[0] * w[2] + u[1] * w[3];
+        out[3] = u[3] * w[0] - u[2] * w[1] + u[1] * w[2] - u[0] * w[3];
+    }
+#else
+    if ( transpose ) {
+        out[0] = u[0] * w[0] + u[1] * w[1];
+        out[1] = -u[1] * w[0] + u[0] * w[1];
+    } else {
+        out[0] = u[0] * w[0] - u[1] * w[1];
+        out[1] = u[1] * w[0] + u[0] * w[1];
+    }
+#endif
+}
+
+/**
+* @fn ΈʒuƑΑx𐳑W u ƉzԂł̔ u' = 1/2 L^T(u) v ֕ϊ.
+* @detail ʒu u IԎRx, Ȃ̐𕽕ŋ߂ČŒ肷
+*/
+static void to_regular(double const *r, double const *v, double *u, double *du) {
+    double w[REGULAR_DIM] = { 0 };
+    double length = 0;
+    int k;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        length += r[k] * r[k];
+        w[k] = v[k];
+    }
+    length = sqrt(length);
+    for ( k = 0; k < REGULAR_DIM; k++ ) {
+        u[k] = 0;
+    }
+    if ( r[0] >= 0 ) {
+        u[0] = sqrt(0.5 * ( length + r[0] ));
+        u[1] = r[1] / ( 2 * u[0] );
+#if GRAVITY_DIM == 3
+        u[2] = r[2] / ( 2 * u[0] );
+#endif
+    } else {
+        u[1] = sqrt(0.5 * ( length - r[0] ));
+        u[0] = r[1] / ( 2 * u[1] );
+#if GRAVITY_DIM == 3
+        u[3] = r[2] / ( 2 * u[1] );
+#endif
+    }
+    apply_regular(u, w, du, 1);
+    for ( k = 0; k < REGULAR_DIM; k++ ) {
+        du[k] *= 0.5;
+    }
+}
+
+/**
+* @fn Stumpff֐ c0(z) = cos z, c1(z) = sin z / z, c3(z) = (z - sin z) / z^3/2 ߂.
+* @detail ẑƂ͑oȐ֐ɂȂ. 0̋߂͋ŋ߂Č
+*/
+static void stumpff(const double z, double *c0, double *c1, double *c3) {
+    if ( z > 0.1 ) {
+        const double w = sqrt(z);
+        *c0 = cos(w);
+        *c1 = sin(w) / w;
+        *c3 = ( w - sin(w) ) / ( z * w );
+    } else if ( z < -0.1 ) {
+        const double w = sqrt(-z);
+        *c0 = cosh(w);
+        *c1 = sinh(w) / w;
+        *c3 = ( sinh(w) - w ) / ( -z * w );
+    } else {
+        //c_k(z) =  (-z)^n / (2n + k)!
+        double t0 = 1, t1 = 1, t3 = 1.0 / 6.0;
+        int n;
+        *c0 = t0;
+        *c1 = t1;
+        *c3 = t3;
+        for ( n = 1; n < 10; n++ ) {
+            t0 *= -z / ( ( 2 * n - 1 ) * ( 2 * n ) );
+            t1 *= -z / ( ( 2 * n ) * ( 2 * n + 1 ) );
+            t3 *= -z / ( ( 2 * n + 2 ) * ( 2 * n + 3 ) );
+            *c0 += t0;
+            *c1 += t1;
+            *c3 += t3;
+        }
+    }
+}
+
+/**
+* @fn zs̊ԂɌoԂ߂.
+* @param uu, ud, dd |u|^2, u.u', |u'|^2 ̏l
+* @param beta -E/2 (E ͊Zʂ̃GlM[)
+* @param c, s u(s) = u C + u' S  C  S 
+* @return t(s) =  |u|^2 ds = |u|^2 (s - beta I) + (u.u') S^2 + |u'|^2 I   (I =  S^2 ds = 2 s^3 c3(4 beta s^2))
+*/
+static double elapsed(const double uu, const double ud, const double dd, const double beta, const double s, double *c, double *sc) {
+    double c0, c1, c3, integral, unused0, unused1;
+    stumpff(beta * s * s, &c0, &c1, &c3);
+    stumpff(4 * beta * s * s, &unused0, &unused1, &integral);
+    integral *= 2 * s * s * s;
+    *c = c0;
+    *sc = s * c1;
+    return uu * ( s - beta * integral ) + ud * *sc * *sc + dd * integral;
+}
+
+/**
+* @fn 2̖̑Ή^taui߂.
+* @param r, v ΈʒuƑΑx. i߂lŒu
+* @param mu G (mi + mj)
+* @detail Wł u(s) = u C + u' S, u'(s) = -beta u S + u' C ƕŏ̂,
+*         t(s) = tau ƂȂsj[g@ (͂ݏoƂ͓񕪖@) ŋ߂Ίۂߌ덷͈̔͂Őmɐi
+*/
+static void kepler_drift(double *r, double *v, const double mu, const double tau) {
+    double u[REGULAR_DIM], du[REGULAR_DIM], w[REGULAR_DIM], dw[REGULAR_DIM], out[REGULAR_DIM];
+    double uu = 0, ud = 0, dd = 0, beta, s, lo = 0, hi, c, sc, t;
+    int k, iteration;
+    to_regular(r, v, u, du);
+    for ( k = 0; k < REGULAR_DIM; k++ ) {
+        uu += u[k] * u[k];
+        ud += u[k] * du[k];
+        dd += du[k] * du[k];
+    }
+    //E = ( 2 |u'|^2 - mu ) / |u|^2
+    beta = ( mu - 2 * dd ) / ( 2 * uu );
+    //the mean of |u|^2 over an orbit is ( |u|^2 + |u'|^2 / beta ) / 2
+    s = beta > 0 ? 2 * tau * beta / ( uu * beta + dd ) : tau / uu;
+    hi = s;
+    for ( iteration = 0; iteration < 200 && elapsed(uu, ud, dd, beta, hi, &c, &sc) < tau; iteration++ ) {
+        lo = hi;
+        hi *= 2;
+    }
+    for ( iteration = 0; iteration < 100; iteration++ ) {
+        double next, rate = 0;
+        t = elapsed(uu, ud, dd, beta, s, &c, &sc);
+        if ( t < tau ) {
+            lo = s;
+        } else {
+            hi = s;
+        }
+        for ( k = 0; k < REGULAR_DIM; k++ ) {
+            const double uk = u[k] * c + du[k] * sc;
+            rate += uk * uk;
+        }
+        //dt/ds = |u(s)|^2
+        next = s - ( t - tau ) / rate;
+        if ( !( next > lo && next < hi ) ) {
+            next = 0.5 * ( lo + hi );
+        }
+        if ( fabs(next - s) <= 1e-15 * s ) {
+            s = next;
+            break;
+        }
+        s = next;
+    }
+    elapsed(uu, ud, dd, beta, s, &c, &sc);
+    for ( k = 0; k < REGULAR_DIM; k++ ) {
+        w[k] = u[k] * c + du[k] * sc;
+        dw[k] = -beta * u[k] * sc + du[k] * c;
+    }
+    uu = 0;
+    for ( k = 0; k < REGULAR_DIM; k++ ) {
+        uu += w[k] * w[k];
+    }
+    //r = L(u) u, v = 2 L(u) u' / |u|^2
+    apply_regular(w, w, out, 0);
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        r[k] = out[k];
+    }
+    apply_regular(w, dw, out, 0);
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        v[k] = 2 * out[k] / uu;
+    }
+}
+
+/**
+* @fn ̏R. Ήx a_i - a_j  T (x_i - x_j)
+*/
+static void tidal_kick(struct Binary const *p, double const *r, double *v, const double tau) {
+    int k, l;
+    for ( k = 0; k < GRAVITY_DIM; k++ ) {
+        double a = 0;
+        for ( l = 0; l < GRAVITY_DIM; l++ ) {
+            a += p->t[k][l] * r[l];
+        }
+        v[k] += a * tau;
+    }
+}
+
+/**
+* @fn ȂΉ^hi, Ŝ̐ϕ@i߂dŜ܂ɓ̐߂. advance̒ɌĂ
+* @param h advancei߂̕
+* @detail ̏R2̖݂̉Ɏg[vtbO@ (Kepler drift  tidal kick) Ői߂.
+*         Ȃ12̖̉ōς
+*/
+void propagate_binaries(const double h, struct Stars *stars, struct Binaries *bin) {
+    double *position[GRAVITY_DIM] = { FOR_AXES(AXIS_POSITION) };
+    double *previous[GRAVITY_DIM] = { FOR_AXES(AXIS_PREVIOUS) };
+    double *velocity[GRAVITY_DIM] = { FOR_AXES(AXIS_VELOCITY) };
+    int n, k, l;
+    for ( n = 0; n < bin->count; n++ ) {
+        struct Binary *p = &bin->pairs[n];
+        const int i = p->i, j = p->j;
+        const double mass = p->mi + p->mj;
+        const double mu = G * mass;
+        double r2 = 0, v2 = 0, t2 = 0, energy, tau;
+        int substeps = 1, m;
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            r2 += p->r[k] * p->r[k];
+            v2 += p->v[k] * p->v[k];
+            for ( l = 0; l < GRAVITY_DIM; l++ ) {
+                t2 += p->t[k][l] * p->t[k][l];
+            }
+        }
+        energy = 0.5 * v2 - mu / sqrt(r2);
+        if ( t2 > 0 && energy < 0 ) {
+            const double period = REGULAR_TWO_PI * mu / pow(-2 * energy, 1.5);
+            const double wanted = ceil(h / period * REGULAR_KICKS_PER_ORBIT);
+            substeps = wanted < 1 ? 1 : ( wanted > REGULAR_MAX_SUBSTEPS ? REGULAR_MAX_SUBSTEPS : ( int )wanted );
+        }
+        tau = h / substeps;
+        for ( m = 0; m < substeps; m++ ) {
+            tidal_kick(p, p->r, p->v, tau * 0.5);
+            kepler_drift(p->r, p->v, mu, tau);
+            tidal_kick(p, p->r, p->v, tau * 0.5);
+        }
+        bin->substeps += substeps;
+        for ( k = 0; k < GRAVITY_DIM; k++ ) {
+            const double center = position[k][i];
+            const double drift = velocity[k][i];
+            position[k][i] = center + p->mj / mass * p->r[k];
+            position[k][j] = center - p->mi / mass * p->r[k];
+            velocity[k][i] = drift + p->mj / mass * p->v[k];
+            velocity[k][j] = drift - p->mi / mass * p->v[k];
+            previous[k][i] = position[k][i];
+            previous[k][j] = position[k][j];
+        }
+        stars->m[i] = p->mi;
+        stars->m[j] = p->mj;
+    }
+}
+
+/**
+* @fn ÕXebv̑gƒʎZ̐`FbN|Cg̋Ԃɉ.
+* @detail Ԃ͑g̐, `, , Pv[^̐̌ɑgƂ̓̐̔ԍ.
+*         ̃Xebv͑ȎgL߂̏ŕۂ̂, gȂ΍ĊJvZőIԑgς.
+*         Ή^ƒe\̓XebvƂɋߒ̂ŋL^Ȃ
+* @return Ƃ1 mۂłȂƂ0 AȂƂ͉1
+*/
+int save_binaries(struct Binaries const *bin, struct StarsExtra *extra) {
+    int64_t counts[4];
+    int32_t *members;
+    char *contents;
+    int k;
+    if ( bin->radius <= 0 || bin->capacity <= 0 ) {
+        return 1;
+    }
+    contents = ( char * )add_section(extra, BINARY_SECTION, BINARY_SECTION_VERSION, sizeof(counts) + sizeof(int32_t) * 2 * bin->count);
+    if ( contents == NULL ) {
+        return 0;
+    }
+    counts[0] = bin->count;
+    counts[1] = bin->formed;
+    counts[2] = bin->dissolved;
+    counts[3] = bin->substeps;
+    memcpy(contents, counts, sizeof(counts));
+    //the contents are aligned to 8 bytes
+    members = ( int32_t * )( contents + sizeof(counts) );
+    for ( k = 0; k < bin->count; k++ ) {
+        members[k * 2] = bin->pairs[k].i;
+        members[k * 2 + 1] = bin->pairs[k].j;
+    }
+    return 1;
+}
+
+/**
+* @fn `FbN|Cg̋ԂÕXebv̑gƒʎZ̐߂. allocate_binariešɌĂ
+* @param size SĂ̐̐
+* @return ߂Ƃ1 ԂȂAȂƂ0 ̂Ƃ͑ȎgȂ̂ƂđI
+*/
+int restore_binaries(const int size, struct StarsExtra const *extra, struct Binaries *bin) {
+    int64_t counts[4];
+    int32_t const *members;
+    size_t length = 0;
+    const char *contents = ( const char * )find_section(extra, BINARY_SECTION, BINARY_SECTION_VERSION, &length);
+    int k;
+    if ( bin->radius <= 0 || bin->capacity <= 0 || contents == NULL || length < sizeof(counts) ) {
+        return 0;
+    }
+    memcpy(counts, contents, sizeof(counts));
+    if ( counts[0] < 0 || counts[0] > bin->capacity / 2 || length != sizeof(counts) + sizeof(int32_t) * 2 * counts[0] ) {
+        return 0;
+    }
+    members = ( int32_t const * )( contents + sizeof(counts) );
+    for ( k = 0; k < counts[0]; k++ ) {
+        const int i = members[k * 2], j = members[k * 2 + 1];
+        if ( i < 0 || j < 0 || i >= size || j >= size || i == j || bin->partner[i] >= 0 || bin->partner[j] >= 0 ) {
+            //leave no pair of a broken section behind
+            while ( k-- > 0 ) {
+                bin->partner[bin->pairs[k].i] = -1;
+                bin->partner[bin->pairs[k].j] = -1;
+            }
+            return 0;
+        }
+        bin->pairs[k].i = i;
+        bin->pairs[k].j = j;
+        bin->partner[i] = j;
+        bin->partner[j] = i;
+    }
+    bin->count = ( int )counts[0];
+    bin->formed = ( long )counts[1];
+    bin->dissolved = ( long )counts[2];
+    bin->substeps = ( long )counts[3];
+    return 1;
+}
+
+/**
+* @fn A̐ƒʎŽ`, ̐sŏo.
+* @detail  binary step=... t=... pairs=... formed=... dissolved=...
+*/
+void write_binaries(FILE *out, const long step, const double time, struct Binaries const *bin) {
+    fprintf(out, "binary step=%ld t=%.10g pairs=%d formed=%ld dissolved=%ld\n",
+        step, time, bin->count, bin->formed, bin->dissolved);
+}
+
+#undef AXIS_POSITION
+#undef AXIS_PREVIOUS
+#undef AXIS_VELOCITY
+#undef REGULAR_TWO_PI
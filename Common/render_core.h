@@ -0,0 +1,647 @@
+/**
+* @brief ʂg킸ɐ摜֕`ďo
+* 2ł3ł̋ʕ render1.c  render3.c ꂼ render*.h, pool.h, profile.h ̌ɃCN[h
+* @detail
+* render_frame͋󂢂Ăobt@֎ʂƈʒu𕡎ʂ邾Ŗ߂, `p̃Xbh̊Ԃɉ摜`ďo.
+* obt@snapshot*.c̏ݖƓ݂Ɏg, `悪ǂ܂ĂƂ҂.
+* ꖇ̕`͎Oiɕ.
+*   e     Ƃɉ摜̒S, a, s߂. ƂɓƗȂ̂ŕɏ
+*   U蕪 摜RENDER_BANDs̑тɕ, dȂт̈ꗗ֐̔ԍ̏ɐU蕪
+*   `     тƂɕ, ꗗ̐т̒̍s֕`. тǂ͉fLȂ̂Ŕrv炸,
+*            Xbh̐ɂ炸摜ɂȂ
+* eSimulator::OnDrawƓɂ. a͎ʂ̗10{.
+* 2ł͈ʒuunit{ĉ摜̒Sւ炷 (y͉). a͉f, 𔼉fڂ~`.
+* 3ł͈ʒuunit{_, _ (-w/2, h/2, -h/2) _ (0, 1, 0) p1.2WÃJœe.
+* aunit{Ȃ. sׂĎŐ,  (-1, 0, -1) ̌ŉAetĕ`.
+* ͕`Ȃ.
+* o̓t@C (PPM܂͖kPNG) , ÕR}h̕W֑͂ėPPM̂ǂ炩.
+* ҂ffmpegȂǂ̓̃GR[_ւ̂܂ܓn.
+*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threads.h"
+
+#ifdef _WIN32
+#define open_pipe(command) _popen(command, "wb")
+#define close_pipe(f) _pclose(f)
+#else
+#define open_pipe(command) popen(command, "w")
+#define close_pipe(f) pclose(f)
+#endif
+
+#define RENDER_BUFFERS 2
+#define RENDER_BAND 16      // rows of a band drawn by one task
+#define RENDER_CHUNK 4096   // stars projected by one task at once
+#define RENDER_FOV 1.2      // vertical field of view of the 3D camera in radians, as SetupCamera_Perspective
+#define RENDER_NEAR 0.1     // clipping distances of the 3D camera, as SetCameraNearFar
+#define RENDER_FAR 5000.0
+#define RENDER_AMBIENT 0.2  // brightness of a face the light does not reach
+#define PNG_BLOCK 65535     // largest stored block of deflate
+#define ADLER_RUN 5552      // bytes summed by Adler-32 before taking the modulus
+
+/**
+* `҂񕪂̏
+*/
+struct RenderBuffer {
+    double* m;          // copy of the masses and positions, only the first size elements are used
+#define BUFFER_AXIS(X) double* X;
+    FOR_AXES(BUFFER_AXIS)
+#undef BUFFER_AXIS
+    int size;
+    long step;          // step of the copied state, names the frame file
+    int full;           // 1 while waiting for or being drawn by the render thread
+};
+
+struct FrameRenderer {
+    struct RenderOptions options;
+    char prefix[1024];
+    int capacity;
+    struct RenderBuffer buffers[RENDER_BUFFERS];
+    int fill;           // buffer the next render_frame copies into
+    int drain;          // buffer the render thread draws next
+    int stop;
+    int failed;         // frames that could not be written
+    thread_handle thread;
+    thread_mutex lock;
+    thread_cond ready;  // signaled when a buffer is filled or the renderer stops
+    thread_cond empty;  // signaled when a buffer has been drawn
+    struct ThreadPool* pool; // threads drawing a frame, separate from those of the force
+    FILE* pipe;         // standard input of the encoder, NULL to write files
+    struct RenderBuffer const* current; // buffer being drawn
+    float* sx;          // projected center, radius in pixels and distance along the view of each star
+    float* sy;          // the radius is 0 for stars out of the image
+    float* sr;
+    float* sz;
+    int bands;
+    int* band_start;    // stars overlapping band k are band_stars[band_start[k]...band_start[k + 1] - 1]
+    int* band_fill;
+    int* band_stars;
+    int band_capacity;
+    unsigned char* pixels; // brightness of each pixel
+    float* depth;       // distance of the nearest surface of each pixel, 3D only
+    unsigned char* image; // rows of RGB, each led by the filter byte of PNG
+    double eye[3];      // camera of the 3D view : position, unit vectors to the right, up and forward
+    double right[3];
+    double up[3];
+    double forward[3];
+    double light[3];    // unit vector toward the light in the camera coordinates
+    double focal;       // pixels per unit of the tangent of the angle from the view axis
+};
+
+static unsigned long crc_table[256];
+
+/**
+* @fn PNG̃`NɕtCRC-32̕\.
+*/
+static void make_crc_table(void) {
+    unsigned long c;
+    int n, k;
+    for ( n = 0; n < 256; n++ ) {
+        c = ( unsigned long )n;
+        for ( k = 0; k < 8; k++ ) {
+            c = c & 1 ? 0xedb88320UL ^ ( c >> 1 ) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+static unsigned long update_crc(unsigned long crc, unsigned char const *data, const size_t length) {
+    size_t i;
+    for ( i = 0; i < length; i++ ) {
+        crc = crc_table[( crc ^ data[i] ) & 0xff] ^ ( crc >> 8 );
+    }
+    return crc;
+}
+
+static void put_u32(unsigned char *p, const unsigned long v) {
+    p[0] = ( unsigned char )( v >> 24 );
+    p[1] = ( unsigned char )( v >> 16 );
+    p[2] = ( unsigned char )( v >> 8 );
+    p[3] = ( unsigned char )v;
+}
+
+/**
+* @fn `N̒go, CRC։.
+*/
+static void put_data(FILE *out, unsigned char const *data, const size_t length, unsigned long *crc) {
+    fwrite(data, 1, length, out);
+    *crc = update_crc(*crc, data, length);
+}
+
+/**
+* @fn g̒Ă`Nn߂. Iend_chunkŏ
+*/
+static unsigned long begin_chunk(FILE *out, const char *type, const unsigned long length) {
+    unsigned char head[4];
+    unsigned long crc = 0xffffffffUL;
+    put_u32(head, length);
+    fwrite(head, 1, 4, out);
+    put_data(out, ( unsigned char const * )type, 4, &crc);
+    return crc;
+}
+
+static void end_chunk(FILE *out, const unsigned long crc) {
+    unsigned char tail[4];
+    put_u32(tail, crc ^ 0xffffffffUL);
+    fwrite(tail, 1, 4, out);
+}
+
+/**
+* @fn 摜𖳈kPNGŏo.
+* @detail sƂ̃tB^0(Ȃ), zlib̒g͈kȂubNׂ邾ɂ. ÕCugȂ
+*/
+static int write_png(FILE *out, struct FrameRenderer const *r) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    const size_t raw = ( size_t )r->options.height * ( 1 + 3 * ( size_t )r->options.width );
+    const size_t blocks = ( raw + PNG_BLOCK - 1 ) / PNG_BLOCK;
+    unsigned char header[13], block[5];
+    unsigned long crc, a = 1, b = 0;
+    size_t done, i;
+    fwrite(signature, 1, 8, out);
+    //width, height, 8 bits per sample, RGB, deflate, adaptive filtering, no interlace
+    put_u32(header, ( unsigned long )r->options.width);
+    put_u32(header + 4, ( unsigned long )r->options.height);
+    header[8] = 8;
+    header[9] = 2;
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+    crc = begin_chunk(out, "IHDR", 13);
+    put_data(out, header, 13, &crc);
+    end_chunk(out, crc);
+    //zlib header, stored blocks and Adler-32 of the rows
+    crc = begin_chunk(out, "IDAT", ( unsigned long )( 2 + raw + blocks * 5 + 4 ));
+    block[0] = 0x78;
+    block[1] = 0x01;
+    put_data(out, block, 2, &crc);
+    for ( done = 0; done < raw; done += PNG_BLOCK ) {
+        const size_t length = raw - done < PNG_BLOCK ? raw - done : PNG_BLOCK;
+        block[0] = done + length == raw ? 1 : 0;
+        block[1] = ( unsigned char )length;
+        block[2] = ( unsigned char )( length >> 8 );
+        block[3] = ( unsigned char )~length;
+        block[4] = ( unsigned char )( ~length >> 8 );
+        put_data(out, block, 5, &crc);
+        put_data(out, r->image + done, length, &crc);
+        //5552 bytes at most between the reductions keep b within 32 bits
+        for ( i = done; i < done + length; i += ADLER_RUN ) {
+            const size_t stop = i + ADLER_RUN < done + length ? i + ADLER_RUN : done + length;
+            size_t j;
+            for ( j = i; j < stop; j++ ) {
+                a += r->image[j];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+    }
+    put_u32(block, ( b << 16 ) | a);
+    put_data(out, block, 4, &crc);
+    end_chunk(out, crc);
+    crc = begin_chunk(out, "IEND", 0);
+    end_chunk(out, crc);
+    return !ferror(out);
+}
+
+/**
+* @fn 摜oCiPPM(P6)ŏo. ďΓ̃GR[_ǂ߂PPM̗ɂȂ
+*/
+static int write_ppm(FILE *out, struct FrameRenderer const *r) {
+    const size_t stride = 1 + 3 * ( size_t )r->options.width;
+    int y;
+    fprintf(out, "P6\n%d %d\n255\n", r->options.width, r->options.height);
+    for ( y = 0; y < r->options.height; y++ ) {
+        fwrite(r->image + y * stride + 1, 1, stride - 1, out);
+    }
+    return !ferror(out);
+}
+
+/**
+* @fn Ƃɉ摜̈ʒu, aƉs߂. pool_taskƂĕɌĂ
+*/
+static void project_task(void *arg, const int begin, const int end) {
+    struct FrameRenderer *r = ( struct FrameRenderer * )arg;
+    struct RenderBuffer const *b = r->current;
+    const double w = r->options.width, h = r->options.height, unit = r->options.unit;
+    int i;
+    for ( i = begin; i < end; i++ ) {
+        const double radius = b->m[i] > 0 ? pow(b->m[i], 1.0 / 3.0) * 10 : 0;
+        double cx, cy, cr, cz;
+#if GRAVITY_DIM == 3
+        const double px = b->x[i] * unit - r->eye[0];
+        const double py = b->y[i] * unit - r->eye[1];
+        const double pz = b->z[i] * unit - r->eye[2];
+        cz = px * r->forward[0] + py * r->forward[1] + pz * r->forward[2];
+        if ( cz - radius <= RENDER_NEAR || cz > RENDER_FAR ) {
+            r->sr[i] = 0;
+            continue;
+        }
+        cx = w / 2 + ( px * r->right[0] + py * r->right[1] + pz * r->right[2] ) / cz * r->focal;
+        cy = h / 2 - ( px * r->up[0] + py * r->up[1] + pz * r->up[2] ) / cz * r->focal;
+        cr = radius / cz * r->focal;
+#else
+        cx = b->x[i] * unit + w / 2;
+        cy = b->y[i] * unit + h / 2;
+        cr = radius;
+        cz = 0;
+#endif
+        //the edge is blurred by half a pixel
+        if ( cr <= 0 || cx + cr + 1 < 0 || cx - cr - 1 > w || cy + cr + 1 < 0 || cy - cr - 1 > h ) {
+            r->sr[i] = 0;
+            continue;
+        }
+        r->sx[i] = ( float )cx;
+        r->sy[i] = ( float )cy;
+        r->sr[i] = ( float )cr;
+        r->sz[i] = ( float )cz;
+    }
+}
+
+/**
+* @fn ̏c͈̔͂dȂт̔ԍ͈̔͂߂.
+*/
+static void band_range(struct FrameRenderer const *r, const int i, int *first, int *last) {
+    const float top = r->sy[i] - r->sr[i] - 1;
+    const float bottom = r->sy[i] + r->sr[i] + 1;
+    *first = top <= 0 ? 0 : ( int )top / RENDER_BAND;
+    *last = bottom >= r->options.height ? r->bands - 1 : ( int )bottom / RENDER_BAND;
+}
+
+/**
+* @fn Ă鐯dȂт̈ꗗ֐U蕪. ꗗ̒͐̔ԍ̏ɕ
+* @return Ƃ1 ꗗmۂłȂƂ0
+*/
+static int assign_bands(struct FrameRenderer *r, const int size) {
+    int i, k, first, last, total = 0;
+    memset(r->band_start, 0, sizeof(int) * ( r->bands + 1 ));
+    for ( i = 0; i < size; i++ ) {
+        if ( r->sr[i] > 0 ) {
+            band_range(r, i, &first, &last);
+            for ( k = first; k <= last; k++ ) {
+                r->band_start[k + 1]++;
+            }
+            total += last - first + 1;
+        }
+    }
+    if ( total > r->band_capacity ) {
+        const int capacity = total + total / 2;
+        int *stars = ( int * )realloc(r->band_stars, sizeof(int) * capacity);
+        if ( stars == NULL ) {
+            return 0;
+        }
+        r->band_stars = stars;
+        r->band_capacity = capacity;
+        PROFILE_COUNT(PROFILE_ALLOCATIONS, 1);
+    }
+    for ( k = 0; k < r->bands; k++ ) {
+        r->band_start[k + 1] += r->band_start[k];
+        r->band_fill[k] = r->band_start[k];
+    }
+    for ( i = 0; i < size; i++ ) {
+        if ( r->sr[i] > 0 ) {
+            band_range(r, i, &first, &last);
+            for ( k = first; k <= last; k++ ) {
+                r->band_stars[r->band_fill[k]++] = i;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+* @fn тƂɈꗗ̐`, 摜̍sֈڂ. pool_taskƂĕɌĂ
+* @detail 2ł͉~̉𔼉fڂ, dȂƂ͖邢.
+* 3ł͉sÔƂ`, ͌̐Fƍ
+*/
+static void band_task(void *arg, const int begin, const int end) {
+    struct FrameRenderer *r = ( struct FrameRenderer * )arg;
+    const int w = r->options.width;
+    const size_t stride = 1 + 3 * ( size_t )w;
+    int k;
+    for ( k = begin; k < end; k++ ) {
+        const int y0 = k * RENDER_BAND;
+        const int y1 = y0 + RENDER_BAND < r->options.height ? y0 + RENDER_BAND : r->options.height;
+        int j, x, y;
+        memset(r->pixels + ( size_t )y0 * w, 0, ( size_t )( y1 - y0 ) * w);
+#if GRAVITY_DIM == 3
+        for ( x = y0 * w; x < y1 * w; x++ ) {
+            r->depth[x] = ( float )RENDER_FAR;
+        }
+#endif
+        for ( j = r->band_start[k]; j < r->band_start[k + 1]; j++ ) {
+            const int i = r->band_stars[j];
+            const float cx = r->sx[i], cy = r->sy[i], cr = r->sr[i];
+            const int top = cy - cr - 1 > y0 ? ( int )( cy - cr - 1 ) : y0;
+            const int bottom = cy + cr + 1 < y1 ? ( int )( cy + cr + 1 ) + 1 : y1;
+            const int left = cx - cr - 1 > 0 ? ( int )( cx - cr - 1 ) : 0;
+            const int right = cx + cr + 1 < w ? ( int )( cx + cr + 1 ) + 1 : w;
+            for ( y = top; y < bottom; y++ ) {
+                const float dy = y + 0.5f - cy;
+                unsigned char *row = r->pixels + ( size_t )y * w;
+                for ( x = left; x < right; x++ ) {
+                    const float dx = x + 0.5f - cx;
+                    const float d2 = dx * dx + dy * dy;
+                    float cover;
+                    if ( d2 >= ( cr + 0.5f ) * ( cr + 0.5f ) ) {
+                        continue;
+                    }
+                    cover = cr + 0.5f - sqrtf(d2);
+                    cover = cover < 1 ? cover : 1;
+#if GRAVITY_DIM == 3
+                    {
+                        //normal of the sphere seen from the camera, the y axis of the image points down
+                        const float u = dx / cr, v = -dy / cr;
+                        const float q = u * u + v * v;
+                        const float n = q < 1 ? sqrtf(1 - q) : 0;
+                        const float z = r->sz[i] * ( 1 - cr * n / ( float )r->focal );
+                        float lit = ( float )( u * r->light[0] + v * r->light[1] - n * r->light[2] );
+                        float *nearest = &r->depth[( size_t )y * w + x];
+                        if ( z >= *nearest ) {
+                            continue;
+                        }
+                        lit = ( float )RENDER_AMBIENT + ( float )( 1 - RENDER_AMBIENT ) * ( lit > 0 ? lit : 0 );
+                        row[x] = ( unsigned char )( 255 * lit * cover + row[x] * ( 1 - cover ) + 0.5f );
+                        *nearest = z;
+                    }
+#else
+                    if ( 255 * cover + 0.5f > row[x] ) {
+                        row[x] = ( unsigned char )( 255 * cover + 0.5f );
+                    }
+#endif
+                }
+            }
+        }
+        //white stars on black, as the GUI draws them
+        for ( y = y0; y < y1; y++ ) {
+            unsigned char const *row = r->pixels + ( size_t )y * w;
+            unsigned char *out = r->image + y * stride;
+            out[0] = 0;
+            for ( x = 0; x < w; x++ ) {
+                out[1 + 3 * x] = row[x];
+                out[2 + 3 * x] = row[x];
+                out[3 + 3 * x] = row[x];
+            }
+        }
+    }
+}
+
+/**
+* @fn 񕪂̏Ԃ`ďo.
+* @return Ƃ1 sƂ0
+*/
+static int draw_frame(struct FrameRenderer *r, struct RenderBuffer const *buffer) {
+    FILE *out = r->pipe;
+    int ok;
+    r->current = buffer;
+    parallel_for(r->pool, buffer->size, RENDER_CHUNK, project_task, r);
+    if ( !assign_bands(r, buffer->size) ) {
+        return 0;
+    }
+    parallel_for(r->pool, r->bands, 1, band_task, r);
+    if ( out == NULL ) {
+        char name[1100];
+        snprintf(name, sizeof(name), "%s%08ld.%s", r->prefix, buffer->step, r->options.format == RENDER_PNG ? "png" : "ppm");
+        out = fopen(name, "wb");
+        if ( out == NULL ) {
+            return 0;
+        }
+    }
+    //the encoder reads a stream of PPM
+    ok = r->pipe == NULL && r->options.format == RENDER_PNG ? write_png(out, r) : write_ppm(out, r);
+    if ( r->pipe == NULL ) {
+        ok = fclose(out) == 0 && ok;
+    } else {
+        ok = fflush(out) == 0 && ok;
+    }
+    return ok;
+}
+
+/**
+* @fn `p̃Xbh̖{. ܂obt@ɕ`ďo
+* @detail ~߂wĂ, ܂Ăobt@Sĕ`ĂI
+*/
+static void drain(struct FrameRenderer *r) {
+    mutex_lock(&r->lock);
+    for ( ;; ) {
+        struct RenderBuffer *buffer = &r->buffers[r->drain];
+        int ok;
+        while ( !buffer->full && !r->stop ) {
+            cond_wait(&r->ready, &r->lock);
+        }
+        if ( !buffer->full ) {
+            break;
+        }
+        mutex_unlock(&r->lock);
+        PROFILE_BEGIN(PROFILE_RENDER);
+        ok = draw_frame(r, buffer);
+        PROFILE_END(PROFILE_RENDER);
+        mutex_lock(&r->lock);
+        if ( !ok ) {
+            r->failed++;
+        }
+        buffer->full = 0;
+        r->drain = ( r->drain + 1 ) % RENDER_BUFFERS;
+        cond_signal(&r->empty);
+    }
+    mutex_unlock(&r->lock);
+}
+
+static thread_result THREAD_CALL render_main(void *arg) {
+    drain(( struct FrameRenderer * )arg);
+    return 0;
+}
+
+#if GRAVITY_DIM == 3
+/**
+* @fn 3̃JSimulatorInitializeƓʒuƌɒu.
+*/
+static void setup_camera(struct FrameRenderer *r) {
+    const double w = r->options.width, h = r->options.height;
+    //toward the light travelling along (-1, 0, -1)
+    const double toward[3] = { 1 / sqrt(2.0), 0, 1 / sqrt(2.0) };
+    double length;
+    r->eye[0] = -w / 2;
+    r->eye[1] = h / 2;
+    r->eye[2] = -h / 2;
+    r->forward[0] = 0 - r->eye[0];
+    r->forward[1] = 1 - r->eye[1];
+    r->forward[2] = 0 - r->eye[2];
+    length = sqrt(r->forward[0] * r->forward[0] + r->forward[1] * r->forward[1] + r->forward[2] * r->forward[2]);
+    r->forward[0] /= length;
+    r->forward[1] /= length;
+    r->forward[2] /= length;
+    //left-handed : right = (0, 1, 0) ~ forward, up = forward ~ right
+    r->right[0] = r->forward[2];
+    r->right[1] = 0;
+    r->right[2] = -r->forward[0];
+    length = sqrt(r->right[0] * r->right[0] + r->right[2] * r->right[2]);
+    r->right[0] /= length;
+    r->right[2] /= length;
+    r->up[0] = r->forward[1] * r->right[2] - r->forward[2] * r->right[1];
+    r->up[1] = r->forward[2] * r->right[0] - r->forward[0] * r->right[2];
+    r->up[2] = r->forward[0] * r->right[1] - r->forward[1] * r->right[0];
+    r->light[0] = toward[0] * r->right[0] + toward[1] * r->right[1] + toward[2] * r->right[2];
+    r->light[1] = toward[0] * r->up[0] + toward[1] * r->up[1] + toward[2] * r->up[2];
+    r->light[2] = toward[0] * r->forward[0] + toward[1] * r->forward[1] + toward[2] * r->forward[2];
+    r->focal = h / 2 / tan(RENDER_FOV / 2);
+}
+#endif
+
+/**
+* @fn `̔z. create_renderer̓rŎsƂɂg
+*/
+static void free_renderer(struct FrameRenderer *r) {
+    int k;
+    for ( k = 0; k < RENDER_BUFFERS; k++ ) {
+        free(r->buffers[k].m);
+    }
+    free(r->sx);
+    free(r->band_start);
+    free(r->band_fill);
+    free(r->band_stars);
+    free(r->pixels);
+    free(r->depth);
+    free(r->image);
+    destroy_pool(r->pool);
+    free(r);
+}
+
+/**
+* @fn `p̃XbhN.
+* @param options 摜̑傫Əo. prefixpipêǂ炩w肷
+* @param capacity xɕ`̐̏
+* @return ` sƂNULL
+*/
+struct FrameRenderer* create_renderer(struct RenderOptions const *options, const int capacity) {
+    struct FrameRenderer *r;
+    const size_t pixels = ( size_t )options->width * options->height;
+    int k, ok = 1;
+    if ( options->width <= 0 || options->height <= 0 || options->unit <= 0 || capacity <= 0
+        || ( options->prefix == NULL ) == ( options->pipe == NULL ) ) {
+        return NULL;
+    }
+    r = ( struct FrameRenderer * )calloc(1, sizeof(struct FrameRenderer));
+    if ( r == NULL ) {
+        return NULL;
+    }
+    r->options = *options;
+    snprintf(r->prefix, sizeof(r->prefix), "%s", options->prefix != NULL ? options->prefix : "");
+    r->capacity = capacity;
+    r->bands = ( options->height + RENDER_BAND - 1 ) / RENDER_BAND;
+    for ( k = 0; k < RENDER_BUFFERS; k++ ) {
+        //mass and positions in one block
+        double *block = ( double * )malloc(sizeof(double) * capacity * ( GRAVITY_DIM + 1 ));
+        struct RenderBuffer *b = &r->buffers[k];
+        ok = ok && block != NULL;
+        b->m = block;
+        if ( block != NULL ) {
+            b->x = block + capacity;
+            b->y = block + capacity * 2;
+#if GRAVITY_DIM == 3
+            b->z = block + capacity * 3;
+#endif
+        }
+    }
+    r->sx = ( float * )malloc(sizeof(float) * capacity * 4);
+    r->band_start = ( int * )malloc(sizeof(int) * ( r->bands + 1 ));
+    r->band_fill = ( int * )malloc(sizeof(int) * r->bands);
+    r->pixels = ( unsigned char * )malloc(pixels);
+    r->image = ( unsigned char * )malloc(( size_t )options->height * ( 1 + 3 * ( size_t )options->width ));
+#if GRAVITY_DIM == 3
+    r->depth = ( float * )malloc(sizeof(float) * pixels);
+    ok = ok && r->depth != NULL;
+    setup_camera(r);
+#endif
+    if ( !ok || r->sx == NULL || r->band_start == NULL || r->band_fill == NULL || r->pixels == NULL || r->image == NULL ) {
+        free_renderer(r);
+        return NULL;
+    }
+    r->sy = r->sx + capacity;
+    r->sr = r->sx + capacity * 2;
+    r->sz = r->sx + capacity * 3;
+    if ( options->threads > 1 ) {
+        r->pool = create_pool(options->threads);
+    }
+    make_crc_table();
+    if ( options->pipe != NULL ) {
+        r->pipe = open_pipe(options->pipe);
+        if ( r->pipe == NULL ) {
+            free_renderer(r);
+            return NULL;
+        }
+    }
+    mutex_init(&r->lock);
+    cond_init(&r->ready);
+    cond_init(&r->empty);
+    if ( !start_thread(&r->thread, render_main, r) ) {
+        cond_destroy(&r->ready);
+        cond_destroy(&r->empty);
+        mutex_destroy(&r->lock);
+        if ( r->pipe != NULL ) {
+            close_pipe(r->pipe);
+        }
+        free_renderer(r);
+        return NULL;
+    }
+    return r;
+}
+
+/**
+* @fn ݂̏Ԃ𕡎ʂĕ`˗. `̊͑҂Ȃ
+* @param step t@CɕtXebv
+* @param size ̐ create_rendererŎw肵ȉ
+* @return ˗Ƃ1 ̐𒴂Ƃ0
+*/
+int render_frame(struct FrameRenderer *renderer, const long step, const int size, struct Stars const *stars) {
+    struct RenderBuffer *buffer = &renderer->buffers[renderer->fill];
+    if ( size > renderer->capacity ) {
+        return 0;
+    }
+    //wait only when the render thread is behind by a whole buffer
+    mutex_lock(&renderer->lock);
+    while ( buffer->full ) {
+        cond_wait(&renderer->empty, &renderer->lock);
+    }
+    mutex_unlock(&renderer->lock);
+    //the render thread does not touch a buffer that is not full
+    memcpy(buffer->m, stars->m, sizeof(double) * size);
+#define COPY_AXIS(X) memcpy(buffer->X, stars->X, sizeof(double) * size);
+    FOR_AXES(COPY_AXIS)
+#undef COPY_AXIS
+    buffer->size = size;
+    buffer->step = step;
+    mutex_lock(&renderer->lock);
+    buffer->full = 1;
+    cond_signal(&renderer->ready);
+    mutex_unlock(&renderer->lock);
+    renderer->fill = ( renderer->fill + 1 ) % RENDER_BUFFERS;
+    return 1;
+}
+
+/**
+* @fn ˗ς݂̏ԂSĕ`ďoĂ`. pCv͕ăGR[_̏I҂
+* @return oȂ摜̐ pCṽR}hsƂ1. rendererNULL̂Ƃ0
+*/
+int destroy_renderer(struct FrameRenderer *renderer) {
+    int failed;
+    if ( renderer == NULL ) {
+        return 0;
+    }
+    mutex_lock(&renderer->lock);
+    renderer->stop = 1;
+    cond_signal(&renderer->ready);
+    mutex_unlock(&renderer->lock);
+    join_thread(renderer->thread);
+    cond_destroy(&renderer->ready);
+    cond_destroy(&renderer->empty);
+    mutex_destroy(&renderer->lock);
+    failed = renderer->failed;
+    if ( renderer->pipe != NULL && close_pipe(renderer->pipe) != 0 ) {
+        failed++;
+    }
+    free_renderer(renderer);
+    return failed;
+}
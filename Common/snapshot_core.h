@@ -0,0 +1,171 @@
+/**
+* @brief vZƕsďԂt@C֏o
+* 2ł3ł̋ʕ snapshot1.c  snapshot3.c ꂼ snapshot*.h ̌ɃCN[h
+* @detail
+* ̃obt@݂Ɏg. record_snapshot͋󂢂Ăobt@֎, ʒu, x𕡎ʂ邾Ŗ߂,
+* ݗp̃XbhoCi` prefix00001000.bin Ȃǂ֏oԂɌvZ͎̃Xebv֐i.
+* ot@Cload_starsŏlƂēǂݒ.
+* ݂ǂ̃obt@܂ĂƂ, Е󂭂܂ő҂.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threads.h"
+
+#define WRITER_BUFFERS 2
+
+/**
+* o҂񕪂̏
+*/
+struct SnapshotBuffer {
+    struct Stars stars; // copy of the state, only the first size elements are used
+    int size;
+    struct StarsState state; // step, time and time step of the copied state
+    int full;           // 1 while waiting for or being written by the writer thread
+};
+
+struct SnapshotWriter {
+    char prefix[1024];
+    struct SnapshotBuffer buffers[WRITER_BUFFERS];
+    int fill;           // buffer the next record_snapshot copies into
+    int drain;          // buffer the writer thread writes next
+    int stop;
+    int failed;         // snapshots that could not be written
+    thread_handle thread;
+    thread_mutex lock;
+    thread_cond ready;  // signaled when a buffer is filled or the writer stops
+    thread_cond empty;  // signaled when a buffer has been written
+};
+
+/**
+* @fn ݗp̃Xbh̖{. ܂obt@ɏo
+* @detail ~߂wĂ, ܂Ăobt@SďoĂI
+*/
+static void drain(struct SnapshotWriter *writer) {
+    mutex_lock(&writer->lock);
+    for ( ;; ) {
+        struct SnapshotBuffer *buffer = &writer->buffers[writer->drain];
+        char name[1100];
+        int ok;
+        while ( !buffer->full && !writer->stop ) {
+            cond_wait(&writer->ready, &writer->lock);
+        }
+        if ( !buffer->full ) {
+            break;
+        }
+        mutex_unlock(&writer->lock);
+        snprintf(name, sizeof(name), "%s%08ld.bin", writer->prefix, buffer->state.step);
+        ok = save_stars(name, buffer->size, &buffer->stars, &buffer->state);
+        mutex_lock(&writer->lock);
+        if ( !ok ) {
+            writer->failed++;
+        }
+        buffer->full = 0;
+        writer->drain = ( writer->drain + 1 ) % WRITER_BUFFERS;
+        cond_signal(&writer->empty);
+    }
+    mutex_unlock(&writer->lock);
+}
+
+static thread_result THREAD_CALL writer_main(void *arg) {
+    drain(( struct SnapshotWriter * )arg);
+    return 0;
+}
+
+/**
+* @fn ݗp̃XbhN.
+* @param prefix ot@C̐擪. XebvƊgq.bin𑱂
+* @param capacity xɏo̐̏
+* @return ݖ sƂNULL
+*/
+struct SnapshotWriter* create_writer(const char *prefix, const int capacity) {
+    struct SnapshotWriter *writer = ( struct SnapshotWriter * )calloc(1, sizeof(struct SnapshotWriter));
+    int k;
+    if ( writer == NULL ) {
+        return NULL;
+    }
+    snprintf(writer->prefix, sizeof(writer->prefix), "%s", prefix);
+    for ( k = 0; k < WRITER_BUFFERS; k++ ) {
+        if ( !allocate_stars(capacity, &writer->buffers[k].stars) ) {
+            while ( k-- > 0 ) {
+                free_stars(&writer->buffers[k].stars);
+            }
+            free(writer);
+            return NULL;
+        }
+    }
+    mutex_init(&writer->lock);
+    cond_init(&writer->ready);
+    cond_init(&writer->empty);
+    if ( !start_thread(&writer->thread, writer_main, writer) ) {
+        cond_destroy(&writer->ready);
+        cond_destroy(&writer->empty);
+        mutex_destroy(&writer->lock);
+        for ( k = 0; k < WRITER_BUFFERS; k++ ) {
+            free_stars(&writer->buffers[k].stars);
+        }
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+/**
+* @fn ݂̏Ԃ𕡎ʂďo˗. o̊͑҂Ȃ
+* @param state t@Cƃwb_ɋL^i݋
+* @param size ̐ create_writerŎw肵ȉ
+* @return ˗Ƃ1 ̐𒴂Ƃ0
+*/
+int record_snapshot(struct SnapshotWriter *writer, struct StarsState const *state, const int size, struct Stars const *stars) {
+    struct SnapshotBuffer *buffer = &writer->buffers[writer->fill];
+    if ( size > buffer->stars.capacity ) {
+        return 0;
+    }
+    //wait only when the writer thread is behind by a whole buffer
+    mutex_lock(&writer->lock);
+    while ( buffer->full ) {
+        cond_wait(&writer->empty, &writer->lock);
+    }
+    mutex_unlock(&writer->lock);
+    //the writer thread does not touch a buffer that is not full
+    memcpy(buffer->stars.m, stars->m, sizeof(double) * size);
+#define COPY_AXIS(X) \
+    memcpy(buffer->stars.X, stars->X, sizeof(double) * size); \
+    memcpy(buffer->stars.v##X, stars->v##X, sizeof(double) * size);
+    FOR_AXES(COPY_AXIS)
+#undef COPY_AXIS
+    buffer->size = size;
+    buffer->state = *state;
+    mutex_lock(&writer->lock);
+    buffer->full = 1;
+    cond_signal(&writer->ready);
+    mutex_unlock(&writer->lock);
+    writer->fill = ( writer->fill + 1 ) % WRITER_BUFFERS;
+    return 1;
+}
+
+/**
+* @fn ˗ς݂̏ԂSďoĂ珑ݖ.
+* @return oȂԂ̐ writerNULL̂Ƃ0
+*/
+int destroy_writer(struct SnapshotWriter *writer) {
+    int k, failed;
+    if ( writer == NULL ) {
+        return 0;
+    }
+    mutex_lock(&writer->lock);
+    writer->stop = 1;
+    cond_signal(&writer->ready);
+    mutex_unlock(&writer->lock);
+    join_thread(writer->thread);
+    cond_destroy(&writer->ready);
+    cond_destroy(&writer->empty);
+    mutex_destroy(&writer->lock);
+    for ( k = 0; k < WRITER_BUFFERS; k++ ) {
+        free_stars(&writer->buffers[k].stars);
+    }
+    failed = writer->failed;
+    free(writer);
+    return failed;
+}
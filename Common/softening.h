@@ -0,0 +1,80 @@
+/**
+* @brief d͂̓ (softening)
+* 2ł3łŋL. force*.c ݒ, , FMM̋ߖT, G~[g@̑ǧvZ̊֐g
+* @detail
+* _ʂǂ̏d͂͋߂ÂقǍیȂȂ, Œ̍ݕł͋ߐڑŋO.
+*  eps ߂g̏d͂߂ėLɂ.
+*   Plummer  g = ( r^2 + eps^2 )^-3/2                 SĂ̋ŏ߂
+*   spline   Monaghan 3XvCj (GADGETƓ)    h = 2.8 eps 艓΃j[g̏d͂ƈv
+* ǂ r -> 0 ł̃|eV 1 / eps.
+* x G  m_j g d_ij, |eV G  m_j p (d_ij ͑ւ̕ψ).
+*/
+#pragma once
+#include <math.h>
+
+#ifdef _MSC_VER
+#define SOFTENING_INLINE static __inline
+#else
+#define SOFTENING_INLINE static inline
+#endif
+
+// kernels of the softening
+#define FORCE_SOFTENING_PLUMMER 0
+#define FORCE_SOFTENING_SPLINE 1
+
+#define SOFTENING_SPLINE_SCALE 2.8  // radius of the spline kernel over the Plummer-equivalent length
+
+struct Softening {
+    int kind;           // FORCE_SOFTENING_*
+    double eps;         // softening length, 0 : Newtonian
+    double eps2;        // eps^2 added to r^2 by the Plummer kernel, 0 for the spline
+    double h;           // radius of the spline kernel, 0 for Plummer
+    double h2;
+};
+
+/**
+* @fn d͂̌W߂.
+* @param r2 g̋2 (0傫)
+* @param p NULLłȂ΃|eV̌W
+* @param q NULLłȂ (dg/dr) / r . x (jerk)  m ( g dv + q (d.dv) d )
+* @return x̌W g
+*/
+SOFTENING_INLINE double soften(struct Softening const *s, const double r2, double *p, double *q) {
+    if ( s->kind == FORCE_SOFTENING_SPLINE && r2 < s->h2 ) {
+        const double inv_h = 1.0 / s->h;
+        const double inv_h3 = inv_h * inv_h * inv_h;
+        const double u = sqrt(r2) * inv_h;
+        const double u2 = u * u;
+        double g, dgu;  // dgu = ( dg/du ) / u
+        if ( u < 0.5 ) {
+            g = 10.666666666667 + u2 * ( 32.0 * u - 38.4 );
+            dgu = 96.0 * u - 76.8;
+            if ( p != NULL ) {
+                *p = ( 2.8 - u2 * ( 5.333333333333 + u2 * ( 6.4 * u - 9.6 ) ) ) * inv_h;
+            }
+        } else {
+            g = 21.333333333333 - 48.0 * u + 38.4 * u2 - 10.666666666667 * u2 * u - 0.066666666667 / ( u2 * u );
+            dgu = ( -48.0 + 76.8 * u - 32.0 * u2 + 0.2 / ( u2 * u2 ) ) / u;
+            if ( p != NULL ) {
+                *p = ( 3.2 - 0.066666666667 / u - u2 * ( 10.666666666667 + u * ( -16.0 + u * ( 9.6 - 2.133333333333 * u ) ) ) ) * inv_h;
+            }
+        }
+        if ( q != NULL ) {
+            //dg/dr / r = dg/du / ( h^2 u )
+            *q = dgu * inv_h3 * inv_h * inv_h;
+        }
+        return g * inv_h3;
+    } else {
+        //Newtonian or Plummer
+        const double r2e = r2 + s->eps2;
+        const double inv = 1.0 / sqrt(r2e);
+        const double g = inv * inv * inv;
+        if ( p != NULL ) {
+            *p = inv;
+        }
+        if ( q != NULL ) {
+            *q = -3.0 * g / r2e;
+        }
+        return g;
+    }
+}
@@ -0,0 +1,304 @@
+/**
+* @brief ϕ@𖼑OőI, ĂяoŐi߂
+* 2ł3ł̋ʕ stepper1.c  stepper3.c ꂼ stepper*.h ̌ɃCN[h
+* @detail
+* Œ荏݂̕@ (IC[@, QENb^@, [vtbO@, gc̕@) 
+* ݂ς@ (h}EvX@, G~[g@) ̍\̂ň.
+* [vtbO@Ƌgc̕@͑ÕXebv̍Ō̉xg񂷂̂,
+* ̏Wϕ̊OŏƂ͂̉x̂ĂKv. stepper_collisionstepper_discards.
+* g񂷒lsave_stepperrestore_stepperŃ`FbN|Cg֏o, ĊJƂɖ߂.
+*/
+#include <string.h>
+
+static const char *const names[METHOD_COUNT] = {
+    "rk4", "dopri", "hermite", "euler", "leapfrog", "yoshida4", "yoshida6",
+};
+
+/**
+* @fn Oϕ@T.
+* @return METHOD_* ȂƂ-1
+*/
+int find_method(const char *name) {
+    int k;
+    for ( k = 0; k < METHOD_COUNT; k++ ) {
+        if ( strcmp(name, names[k]) == 0 ) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+const char* method_name(const int method) {
+    return method >= 0 && method < METHOD_COUNT ? names[method] : "unknown";
+}
+
+/**
+* @fn ϕ@̏ԂƍƗ̈mۂ.
+* @param capacity ̐̏
+* @param method METHOD_*
+* @param dt 1Xebv̎̕ω h}EvX@ł͍ŏɎݕ
+* @param rtol, atol h}EvX@̌덷̋el
+* @param eta G~[g@̐x̌W
+* @return mۂɐƂ1 sƂ0
+* @detail Փ˂̔̍Ɨ̈Ŋmۂ. mۂłȂĂsƂ͂, stepper_collisionĂԂтɊmۂ
+*/
+int allocate_stepper(const int capacity, const int method, const double dt, const double rtol, const double atol, const double eta,
+    struct Stepper *stepper) {
+    stepper->method = method;
+    stepper->dt = dt;
+    stepper->ready = 0;
+    stepper->evaluations = 0;
+    stepper->merges = NULL;
+    stepper->partner = NULL;
+    stepper->dopri.block = NULL;
+    stepper->hermite.block = NULL;
+    stepper->hermite.indices = NULL;
+    stepper->sweep.block = NULL;
+    stepper->sweep.pairs = NULL;
+    stepper->sweep.capacity = 0;
+    if ( method < 0 || method >= METHOD_COUNT ) {
+        return 0;
+    }
+    if ( method == METHOD_DOPRI && !allocate_dopri(capacity, rtol, atol, dt, &stepper->dopri) ) {
+        return 0;
+    }
+    if ( method == METHOD_HERMITE && !allocate_hermite(capacity, eta, &stepper->hermite) ) {
+        return 0;
+    }
+    allocate_sweep(capacity, &stepper->sweep);
+    return 1;
+}
+
+void free_stepper(struct Stepper *stepper) {
+    if ( stepper->method == METHOD_DOPRI ) {
+        free_dopri(&stepper->dopri);
+    } else if ( stepper->method == METHOD_HERMITE ) {
+        free_hermite(&stepper->hermite);
+    }
+    free_sweep(&stepper->sweep);
+}
+
+/**
+* @fn Փ˂̂, ̏WςƂ͎g񂷒l̂Ă.
+* @return ̂̐̐
+*/
+int stepper_collision(const int size, struct Stars *stars, struct Stepper *stepper) {
+    const int merged = collision_excluding(size, next_dt(stepper), stars, stepper->merges, stepper->partner, &stepper->sweep);
+    if ( merged != size ) {
+        //the stars after the merged one are shifted, so are their cached values
+        stepper_discard(stepper);
+    }
+    return merged;
+}
+
+/**
+* @fn ̏Wϕ̊OŏƂ, g񂷉x̂Ă.
+*/
+void stepper_discard(struct Stepper *stepper) {
+    stepper->ready = 0;
+    stepper->dopri.fsal = 0;
+    stepper->hermite.ready = 0;
+}
+
+/**
+* @fn Xebv܂Ŏg񂷒lׂ.
+* @param arrays Ƃ̒l̔z
+* @param level G~[g@݂̍̒i gȂ@łNULL
+* @return z̐ g񂷒lȂƂ0
+*/
+static int cached_arrays(struct Stepper *stepper, struct Workspace *work, double **arrays, int **level) {
+    int count = 0;
+    *level = NULL;
+    switch ( stepper->method ) {
+    case METHOD_HERMITE:
+        if ( stepper->hermite.ready ) {
+            //the derivatives of every star at the end of the step, when all stars share the same time
+#define HERMITE_ARRAYS(X) arrays[count++] = stepper->hermite.a##X; arrays[count++] = stepper->hermite.j##X;
+            FOR_AXES(HERMITE_ARRAYS)
+#undef HERMITE_ARRAYS
+            *level = stepper->hermite.level;
+        }
+        break;
+    case METHOD_DOPRI:
+        if ( stepper->dopri.fsal ) {
+#define DOPRI_ARRAYS(X) arrays[count++] = stepper->dopri.u##X[0]; arrays[count++] = stepper->dopri.a##X[0];
+            FOR_AXES(DOPRI_ARRAYS)
+#undef DOPRI_ARRAYS
+        }
+        break;
+    case METHOD_LEAPFROG:
+    case METHOD_YOSHIDA4:
+    case METHOD_YOSHIDA6:
+        if ( stepper->ready ) {
+#define WORK_ARRAYS(X) arrays[count++] = work->a##X;
+            FOR_AXES(WORK_ARRAYS)
+#undef WORK_ARRAYS
+        }
+        break;
+    }
+    return count;
+}
+
+/**
+* @fn g񂷒l`FbN|Cg̋Ԃɉ.
+* @detail Ԃ͕@Ɛ̐, Ƃ̒l̔z, G~[g@ł͍݂̒ȉɕ.
+*         ꂪ΍ĊJƂlߒȂ̂, ƂƃrbgPʂœʂɂȂ
+* @return Ƃ1 mۂłȂƂ0 g񂷒lȂΉ1
+*/
+int save_stepper(const int size, struct Stepper const *stepper, struct Workspace const *work, struct StarsExtra *extra) {
+    double *arrays[2 * GRAVITY_DIM];
+    int *level;
+    //only reads the arrays
+    const int count = cached_arrays(( struct Stepper * )stepper, ( struct Workspace * )work, arrays, &level);
+    const size_t bytes = sizeof(double) * size;
+    int32_t head[2];
+    char *contents;
+    int k;
+    if ( count == 0 || size <= 0 ) {
+        return 1;
+    }
+    contents = ( char * )add_section(extra, STEPPER_SECTION, STEPPER_SECTION_VERSION,
+        sizeof(head) + bytes * count + ( level != NULL ? sizeof(int32_t) * size : 0 ));
+    if ( contents == NULL ) {
+        return 0;
+    }
+    head[0] = stepper->method;
+    head[1] = size;
+    memcpy(contents, head, sizeof(head));
+    contents += sizeof(head);
+    for ( k = 0; k < count; k++ ) {
+        memcpy(contents + bytes * k, arrays[k], bytes);
+    }
+    if ( level != NULL ) {
+        memcpy(contents + bytes * count, level, sizeof(int32_t) * size);
+    }
+    return 1;
+}
+
+/**
+* @fn `FbN|Cg̋Ԃg񂷒l߂. mۂ΂̐ϕ@ɑ΂ČĂ
+* @return ߂Ƃ1 ԂȂ@␯̐ႤƂ0 ̂Ƃ͍ŏ̃Xebvŋߒ
+*/
+int restore_stepper(const int size, struct StarsExtra const *extra, struct Stepper *stepper, struct Workspace *work) {
+    double *arrays[2 * GRAVITY_DIM];
+    int *level;
+    const size_t bytes = sizeof(double) * size;
+    int32_t head[2];
+    size_t length = 0;
+    const char *contents = ( const char * )find_section(extra, STEPPER_SECTION, STEPPER_SECTION_VERSION, &length);
+    int count, k;
+    if ( contents == NULL || length < sizeof(head) ) {
+        return 0;
+    }
+    memcpy(head, contents, sizeof(head));
+    if ( head[0] != stepper->method || head[1] != size ) {
+        return 0;
+    }
+    //the arrays to fill are those saved once the flags are up
+    stepper->ready = 1;
+    stepper->dopri.fsal = 1;
+    stepper->hermite.ready = 1;
+    count = cached_arrays(stepper, work, arrays, &level);
+    if ( count == 0 || length != sizeof(head) + bytes * count + ( level != NULL ? sizeof(int32_t) * size : 0 ) ) {
+        stepper_discard(stepper);
+        return 0;
+    }
+    contents += sizeof(head);
+    for ( k = 0; k < count; k++ ) {
+        memcpy(arrays[k], contents + bytes * k, bytes);
+    }
+    if ( level != NULL ) {
+        memcpy(level, contents + bytes * count, sizeof(int32_t) * size);
+    }
+    return 1;
+}
+
+/**
+* @fn ̏Ԃ̃|eVwork->phi֋߂悤w.
+* @return ŋ߂Ƃ1, advanceŋ߂Ƃ0
+* @detail QENb^@ƃIC[@͎̃Xebv̍ŏ̉x̏Ԃŋ߂̂, ̌vZɑ肵
+*         ]ȌvZȂ. 0ԂƂadvancěwork->phiǂނ, i߂ȂȂaccelerationsĂ.
+*         ̕@͍ŏ̉xg񂷂̏Ԃŋ߂Ȃ̂, ňxvZ.
+*         Ԃ̉xߒȂ̂, ǂ̕@łO͕ςȂ
+*/
+int stepper_potential(const int size, struct Stars *stars, struct Workspace *work, struct Stepper *stepper) {
+    work->potential = 1;
+    if ( stepper->method == METHOD_RK4 || stepper->method == METHOD_EULER ) {
+        return 0;
+    }
+    accelerations(size, stars, work);
+    stepper->evaluations++;
+    //the very same acceleration the next leapfrog or Yoshida step would compute first
+    stepper->ready = 1;
+    return 1;
+}
+
+/**
+* @fn I񂾐ϕ@őSĂ̐1Xebvi߂.
+* @param size SĂ̐̐
+* @param limit ݕ̏ h}EvX@g. 0ȉ̂ƂȂ
+* @param stars ̏W
+* @param work Ɨ̈
+* @param stepper ϕ@̏
+* @return i߂̕
+*/
+double advance(const int size, const double limit, struct Stars *stars, struct Workspace *work, struct Stepper *stepper) {
+    switch ( stepper->method ) {
+    case METHOD_DOPRI:
+        return dormand_prince(size, limit, stars, work, &stepper->dopri);
+    case METHOD_HERMITE:
+        block_hermite(size, stepper->dt, stars, work, &stepper->hermite);
+        return stepper->dt;
+    case METHOD_EULER:
+        euler(size, stepper->dt, stars, work);
+        stepper->evaluations++;
+        return stepper->dt;
+    case METHOD_LEAPFROG:
+    case METHOD_YOSHIDA4:
+    case METHOD_YOSHIDA6:
+        if ( !stepper->ready ) {
+            accelerations(size, stars, work);
+            stepper->evaluations++;
+            stepper->ready = 1;
+        }
+        if ( stepper->method == METHOD_LEAPFROG ) {
+            leapfrog(size, stepper->dt, stars, work);
+            stepper->evaluations++;
+        } else {
+            const int order = stepper->method == METHOD_YOSHIDA6 ? 6 : 4;
+            yoshida(size, stepper->dt, order, stars, work);
+            stepper->evaluations += order == 6 ? 7 : 3;
+        }
+        return stepper->dt;
+    default:
+        runge_kutta(size, stepper->dt, stars, work);
+        stepper->evaluations += 4;
+        return stepper->dt;
+    }
+}
+
+/**
+* @fn ̃Xebv̍ݕ. `FbN|CgɋL^, Փ˂̔ɂg
+*/
+double next_dt(struct Stepper const *stepper) {
+    return stepper->method == METHOD_DOPRI ? stepper->dopri.dt : stepper->dt;
+}
+
+/**
+* @fn x̌vZ񐔂Ȃǂ̓vo.
+* @param size ̐̐
+* @param steps i߂Xebv
+*/
+void report_stepper(FILE *out, const int size, const long steps, struct Stepper const *stepper) {
+    if ( stepper->method == METHOD_DOPRI ) {
+        fprintf(out, "dopri : %ld accepted, %ld rejected, %ld force evaluations, next dt = %g\n",
+            stepper->dopri.accepted, stepper->dopri.rejected, stepper->dopri.evaluations, stepper->dopri.dt);
+    } else if ( stepper->method == METHOD_HERMITE ) {
+        fprintf(out, "hermite : %ld block steps, %ld force evaluations on a star (%.2f per star and step)\n",
+            stepper->hermite.blocks, stepper->hermite.evaluations,
+            steps > 0 && size > 0 ? stepper->hermite.evaluations / ( double )size / steps : 0.0);
+    } else {
+        fprintf(out, "%s : %ld force evaluations (%.2f per step)\n",
+            method_name(stepper->method), stepper->evaluations, steps > 0 ? stepper->evaluations / ( double )steps : 0.0);
+    }
+}
@@ -0,0 +1,378 @@
+/**
+* @brief ̏Ȍn܂Ƃ߂ČvZp[^XC[v 2ł3ł̋ʕ
+* @detail
+* sweep1.c  sweep3.c ꂼ gravity*.h ȂǂSWEEP_NAME`ɃCN[h.
+* Xgɕׂf[^t@CSēǂݍ, KvȂʒuƑxh炵,
+* ensemble*.c ŌnSIMD[ɕׂēɃQENb^@Ői߂.
+* g : sweep2d, sweep3d Xg [IvV]
+*   Xg         f[^t@C̃pX1sɈeLXgt@C. s#Ŏn܂s͓ǂݔ΂
+*   --copies n     ef[^t@Cn̐ (ȗ1)
+*   --perturb e    2Ԗڈȍ~̈̕ʒuƑx̊e 1 + e u (u[-1, 1)̈l) | (ȗ0)
+*   --seed n       h炬̗̎ (ȗ1)
+*   --dt dt        1Xebv̎̕ω (ȗ1.0)
+*   --steps n      nXebvi߂I
+*   --end t        tɒBI
+*   --bound r      n̑SĂ̐_𒆐SƂ2r͈̔͂o炻̌n~߂
+*   --output p     en̍Ō̏Ԃt@C p00000012.txt (n̔ԍ) Ȃǂ֏o͂ (ȗ͏o͂Ȃ)
+*   --threads n    ƃXbh̐ (ȗ͌vZ@̃Xbh)
+* I͏ȂƂw肷邱. Wo͂ɂ͌nƂɈs, n̔ԍ, f[^t@C, ̔ԍ,
+* c̐, i߂Xebv, ~܂, ̂Ō̐, ~܂RCSVŏo.
+* eňʂ͓f[^t@Cgravity2d, gravity3dœ--dtƏIŌvZʂƃrbgPʂňv.
+*/
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define SWEEP_LINE 4096     // longest line of the list
+
+/**
+* XC[v̐ݒ
+*/
+struct SweepOptions {
+    int copies;         // systems made from each data file
+    double perturb;     // relative size of the perturbation of the copies
+    unsigned long long seed;
+    double dt;
+    long steps;         // stop after this number of steps, < 0 for no limit
+    double end;         // stop when the time reaches this, < 0 for no limit
+    double bound;       // stop a system when all its stars are out of this range, < 0 for no limit
+    const char *output; // prefix of the output files, NULL for none
+    int threads;
+};
+
+/**
+* Xgǂݍ񂾃f[^t@C
+*/
+struct SweepSource {
+    char *path;
+    struct Stars stars;
+    int size;
+};
+
+/**
+* @fn oߎԂbŕԂ.
+*/
+static double wall_time(void) {
+#ifdef _WIN32
+    return GetTickCount64() / 1000.0;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+* @fn h炬̗ (xorshift64*). ɂ炸Ԃ
+* @return [0, 1) ̈l
+*/
+static double next_random(unsigned long long *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return ( ( *state * 2685821657736338717ULL ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+/**
+* @fn XgɑR}hCǂݍ.
+* @return ǂ߂Ƃ1 肪Ƃ0
+*/
+static int parse_options(int argc, char **argv, struct SweepOptions *options) {
+    int i;
+    options->copies = 1;
+    options->perturb = 0;
+    options->seed = 1;
+    options->dt = 1.0;
+    options->steps = -1;
+    options->end = -1;
+    options->bound = -1;
+    options->output = NULL;
+    options->threads = hardware_threads();
+    for ( i = 2; i < argc; i++ ) {
+        if ( i + 1 >= argc ) {
+            fprintf(stderr, "error: option %s needs a value.\n", argv[i]);
+            return 0;
+        } else if ( strcmp(argv[i], "--copies") == 0 ) {
+            options->copies = atoi(argv[++i]);
+        } else if ( strcmp(argv[i], "--perturb") == 0 ) {
+            options->perturb = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--seed") == 0 ) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if ( strcmp(argv[i], "--dt") == 0 ) {
+            options->dt = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--steps") == 0 ) {
+            options->steps = atol(argv[++i]);
+        } else if ( strcmp(argv[i], "--end") == 0 ) {
+            options->end = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--bound") == 0 ) {
+            options->bound = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--output") == 0 ) {
+            options->output = argv[++i];
+        } else if ( strcmp(argv[i], "--threads") == 0 ) {
+            options->threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "error: unknown option %s.\n", argv[i]);
+            return 0;
+        }
+    }
+    if ( options->copies <= 0 ) {
+        fprintf(stderr, "error: copies must be positive.\n");
+        return 0;
+    }
+    if ( options->perturb < 0 ) {
+        fprintf(stderr, "error: perturb must not be negative.\n");
+        return 0;
+    }
+    if ( !( options->dt > 0 ) ) {
+        fprintf(stderr, "error: dt must be positive.\n");
+        return 0;
+    }
+    if ( options->steps < 0 && options->end < 0 && options->bound < 0 ) {
+        fprintf(stderr, "error: specify at least one of --steps, --end and --bound.\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+* @fn Xg̃f[^t@CSēǂݍ.
+* @param count ǂݍ񂾃f[^t@C̐
+* @return ǂݍ񂾃f[^t@C̔z sƂNULL
+*/
+static struct SweepSource *load_sources(const char *list, int *count) {
+    struct SweepSource *sources = NULL;
+    int capacity = 0;
+    char line[SWEEP_LINE];
+    FILE *in = fopen(list, "r");
+    *count = 0;
+    if ( in == NULL ) {
+        fprintf(stderr, "error: cannot open %s.\n", list);
+        return NULL;
+    }
+    while ( fgets(line, sizeof(line), in) != NULL ) {
+        struct StarsState state;
+        size_t length = strlen(line);
+        while ( length > 0 && ( line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ' ) ) {
+            line[--length] = '\0';
+        }
+        if ( length == 0 || line[0] == '#' ) {
+            continue;
+        }
+        if ( *count == capacity ) {
+            const int grown = capacity > 0 ? capacity * 2 : 16;
+            struct SweepSource *larger = ( struct SweepSource * )realloc(sources, sizeof(struct SweepSource) * grown);
+            if ( larger == NULL ) {
+                fprintf(stderr, "error: too many data files in %s.\n", list);
+                break;
+            }
+            sources = larger;
+            capacity = grown;
+        }
+        struct SweepSource *source = &sources[*count];
+        source->size = load_stars(line, &source->stars, NULL, &state);
+        if ( source->size <= 0 ) {
+            fprintf(stderr, "error: cannot read stars from %s.\n", line);
+            break;
+        }
+        source->path = ( char * )malloc(length + 1);
+        if ( source->path == NULL ) {
+            free_stars(&source->stars);
+            break;
+        }
+        memcpy(source->path, line, length + 1);
+        ( *count )++;
+    }
+    if ( !feof(in) || *count == 0 ) {
+        int k;
+        if ( *count == 0 && feof(in) ) {
+            fprintf(stderr, "error: no data files in %s.\n", list);
+        }
+        for ( k = 0; k < *count; k++ ) {
+            free(sources[k].path);
+            free_stars(&sources[k].stars);
+        }
+        free(sources);
+        fclose(in);
+        *count = 0;
+        return NULL;
+    }
+    fclose(in);
+    return sources;
+}
+
+/**
+* @fn ̈ʒuƑxh炷.
+* @param index n̔ԍ ̗nƂɕς
+*/
+static void perturb_stars(const int size, struct Stars *stars, const double perturb, const unsigned long long seed, const int index) {
+    unsigned long long state = ( seed + ( unsigned long long )index ) * 0x9E3779B97F4A7C15ULL + 1;
+    int i;
+#define PERTURB(X) \
+        stars->X[i] *= 1 + perturb * ( 2 * next_random(&state) - 1 ); \
+        stars->v##X[i] *= 1 + perturb * ( 2 * next_random(&state) - 1 );
+    for ( i = 0; i < size; i++ ) {
+        FOR_AXES(PERTURB)
+    }
+#undef PERTURB
+}
+
+/**
+* @fn IɑΉXebv߂. gravity*dƓ t + dt / 2 > end ƂȂŏ̃XebvŎ~߂
+*/
+static long steps_to_end(const double end, const double dt) {
+    long n = ( long )floor(end / dt + 0.5);
+    if ( n < 0 ) {
+        n = 0;
+    }
+    while ( n > 0 && ( n - 1 ) * dt + dt * 0.5 > end ) {
+        n--;
+    }
+    while ( !( n * dt + dt * 0.5 > end ) ) {
+        n++;
+    }
+    return n;
+}
+
+/**
+* @fn n̍Ō̏Ԃf[^t@CƓ`ŏo.
+* @return Ƃ1 sƂ0
+*/
+static int write_system(const char *prefix, const int index, const int size, struct Stars const *stars) {
+    char name[1024];
+    FILE *out;
+    int i;
+    snprintf(name, sizeof(name), "%s%08d.txt", prefix, index);
+    out = fopen(name, "w");
+    if ( out == NULL ) {
+        fprintf(stderr, "error: cannot open %s.\n", name);
+        return 0;
+    }
+#define WRITE_AXIS(X) fprintf(out, ",%.17g", stars->X[i]);
+#define WRITE_VELOCITY(X) fprintf(out, ",%.17g", stars->v##X[i]);
+    //17 digits so that the state is read back exactly
+    fprintf(out, "%d\n", size);
+    for ( i = 0; i < size; i++ ) {
+        fprintf(out, "%.17g", stars->m[i]);
+        FOR_AXES(WRITE_AXIS)
+        FOR_AXES(WRITE_VELOCITY)
+        fprintf(out, "\n");
+    }
+#undef WRITE_AXIS
+#undef WRITE_VELOCITY
+    fclose(out);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    struct SweepOptions options;
+    struct SweepSource *sources;
+    struct Ensemble ens;
+    struct Stars copy;
+    struct ThreadPool *pool = NULL;
+    int *sizes;
+    int files, count, largest = 0;
+    int k, c, failed = 0;
+    long steps;
+    long long total = 0;
+    double start, elapsed;
+
+    if ( argc < 2 ) {
+        fprintf(stderr, "usage: %s list [--copies n] [--perturb e] [--seed n] [--dt dt] [--steps n] [--end t] [--bound r]"
+            " [--output prefix] [--threads n]\n", argv[0]);
+        return 2;
+    }
+    if ( !parse_options(argc, argv, &options) ) {
+        return 2;
+    }
+    sources = load_sources(argv[1], &files);
+    if ( sources == NULL ) {
+        return 1;
+    }
+    count = files * options.copies;
+    sizes = ( int * )malloc(sizeof(int) * count);
+    if ( sizes == NULL ) {
+        fprintf(stderr, "error: cannot allocate %d systems.\n", count);
+        return 1;
+    }
+    for ( k = 0; k < files; k++ ) {
+        for ( c = 0; c < options.copies; c++ ) {
+            sizes[k * options.copies + c] = sources[k].size;
+        }
+        if ( sources[k].size > largest ) {
+            largest = sources[k].size;
+        }
+    }
+    if ( !allocate_ensemble(count, sizes, &ens) || !allocate_stars(largest, &copy) ) {
+        fprintf(stderr, "error: cannot allocate %d systems.\n", count);
+        return 1;
+    }
+    for ( k = 0; k < files; k++ ) {
+        struct Stars *stars = &sources[k].stars;
+        const size_t length = sizeof(double) * sources[k].size;
+        for ( c = 0; c < options.copies; c++ ) {
+            const int index = k * options.copies + c;
+            if ( c == 0 || options.perturb == 0 ) {
+                set_system(&ens, index, stars);
+                continue;
+            }
+#define COPY_AXIS(X) memcpy(copy.X, stars->X, length); memcpy(copy.v##X, stars->v##X, length);
+            memcpy(copy.m, stars->m, length);
+            FOR_AXES(COPY_AXIS)
+#undef COPY_AXIS
+            perturb_stars(sources[k].size, &copy, options.perturb, options.seed, index);
+            set_system(&ens, index, &copy);
+        }
+        //the ensemble holds its own copy
+        free_stars(stars);
+    }
+
+    steps = options.steps;
+    if ( options.end >= 0 ) {
+        const long last = steps_to_end(options.end, options.dt);
+        if ( steps < 0 || last < steps ) {
+            steps = last;
+        }
+    }
+    if ( options.threads > 1 ) {
+        pool = create_pool(options.threads);
+    }
+    start = wall_time();
+    run_ensemble(&ens, steps >= 0 ? steps : LONG_MAX, options.dt, options.bound, pool);
+    elapsed = wall_time() - start;
+
+    printf("system,file,copy,stars,steps,time,merges,stop\n");
+    for ( k = 0; k < count; k++ ) {
+        struct EnsembleGroup const *g = &ens.group[ens.slot[k].group];
+        const int lane = ens.slot[k].lane;
+        const char *reason = steps >= 0 && g->steps[lane] >= steps ? ( options.steps >= 0 && steps == options.steps ? "steps" : "end" ) : "bound";
+        total += g->steps[lane];
+        printf("%d,%s,%d,%d,%ld,%.17g,%d,%s\n", k, sources[k / options.copies].path, k % options.copies, g->size[lane],
+            g->steps[lane], g->steps[lane] * options.dt, g->merges[lane], reason);
+        if ( options.output != NULL ) {
+            const int size = get_system(&ens, k, &copy);
+            failed += !write_system(options.output, k, size, &copy);
+        }
+    }
+    fprintf(stderr, "%s ensemble : %d systems in %d groups of %d lanes, %s kernel, %.3f s (%.3g steps/s, %d threads)\n",
+        SWEEP_NAME, count, ens.groups, ENSEMBLE_LANES, force_kernel_name(get_force_kernel()), elapsed,
+        elapsed > 0 ? total / elapsed : 0.0, pool_threads(pool));
+    if ( failed > 0 ) {
+        fprintf(stderr, "error: %d systems could not be written.\n", failed);
+    }
+    for ( k = 0; k < files; k++ ) {
+        free(sources[k].path);
+    }
+    free(sources);
+    free(sizes);
+    free_stars(&copy);
+    free_ensemble(&ens);
+    destroy_pool(pool);
+    return failed > 0 ? 1 : 0;
+}
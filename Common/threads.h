@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+* @brief Xbh, r, ϐƕsȑWindowsPOSIXœOŎg
+* @detail
+* ƃXbh, ݖ, `, vZ̃XbhʂɎg. C̃\[XCN[h.
+* Xbh̖{̂ static thread_result THREAD_CALL name(void *arg) Ə0Ԃ.
+* start_thread͋NłƂ1Ԃ, join_thread͏Î҂Ăn.
+* thread_counterfetch_add, load_acquire, store_releaseő̃XbhƋL鐮.
+*/
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE thread_handle;
+typedef CRITICAL_SECTION thread_mutex;
+typedef CONDITION_VARIABLE thread_cond;
+typedef volatile LONG thread_counter;
+typedef DWORD thread_result;
+#define THREAD_CALL WINAPI
+#define start_thread(t, main, arg) ( ( *( t ) = CreateThread(NULL, 0, main, arg, 0, NULL) ) != NULL )
+#define join_thread(t) ( WaitForSingleObject(t, INFINITE), CloseHandle(t) )
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_destroy(m) DeleteCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_destroy(c)
+#define cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define cond_broadcast(c) WakeAllConditionVariable(c)
+#define cond_signal(c) WakeConditionVariable(c)
+#define fetch_add(p, v) InterlockedExchangeAdd(p, v)
+#define load_acquire(p) InterlockedCompareExchange(p, 0, 0)
+#define store_release(p, v) InterlockedExchange(p, v)
+#else
+#include <pthread.h>
+typedef pthread_t thread_handle;
+typedef pthread_mutex_t thread_mutex;
+typedef pthread_cond_t thread_cond;
+typedef volatile long thread_counter;
+typedef void* thread_result;
+#define THREAD_CALL
+#define start_thread(t, main, arg) ( pthread_create(t, NULL, main, arg) == 0 )
+#define join_thread(t) pthread_join(t, NULL)
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_destroy(m) pthread_mutex_destroy(m)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init(c, NULL)
+#define cond_destroy(c) pthread_cond_destroy(c)
+#define cond_wait(c, m) pthread_cond_wait(c, m)
+#define cond_broadcast(c) pthread_cond_broadcast(c)
+#define cond_signal(c) pthread_cond_signal(c)
+#define fetch_add(p, v) __sync_fetch_and_add(p, v)
+#define load_acquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
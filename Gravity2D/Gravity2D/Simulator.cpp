@@ -1,7 +1,13 @@
 #include "Simulator.h"
 #include "gravity1.h"
+#include "force1.h"
+#include "loader1.h"
+#include "monitor1.h"
+#include "../../Common/profile.h"
 #include "DxLib.h"
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 Simulator::Simulator(int argc, char **argv, int w, int h){
@@ -9,32 +15,155 @@ Simulator::Simulator(int argc, char **argv, int w, int h){
     this->w = w;
     this->h = h;
     cnt = 0;
+    dt = 0;
+    time = 0;
+    method = METHOD_RK4;
+    relative_tolerance = 1e-8;
+    absolute_tolerance = 1e-8;
+    eta = HERMITE_ETA;
+    stepper.method = METHOD_RK4;
+    stepper.sweep.block = NULL;
+    stepper.sweep.pairs = NULL;
+    unit = 10.0;
+    size = 0;
+    original_size = 0;
+    stars.block = NULL;
+    stars.mapping = NULL;
+    work.block = NULL;
+    work.tree = NULL;
+    work.pool = NULL;
+    theta = -1;
+    order = TREE_QUADRUPOLE;
+    pool = NULL;
+    threads = hardware_threads();
+    record = NULL;
+    every = 100;
+    writer = NULL;
+    checkpoint = NULL;
+    interval = 1000;
+    profile = NULL;
+    monitor = NULL;
+    frames = 1;
 
     if ( argc > 1 ) {
-        FILE* data;
-        fopen_s(&data, argv[1], "r");
-        if ( data == NULL ) {
-            fprintf(stderr, "error: cannot open %s.\n", argv[1]);
+        ParseOptions(argc, argv);
+        if ( profile != NULL ) {
+            if ( profile_enabled() ) {
+                profile_start(1);
+            } else {
+                fprintf(stderr, "warning: --profile needs a build with GRAVITY_PROFILE defined.\n");
+                profile = NULL;
+            }
+        }
+        //the pool also parses a text data file in parallel
+        if ( threads > 1 ) {
+            pool = create_pool(threads);
+        }
+        struct StarsState state;
+        struct StarsExtra extra;
+        size = load_checkpoint(argv[1], &stars, pool, &state, &extra);
+        //resume from the step and time step recorded in a checkpoint
+        if ( dt <= 0 || ( method == METHOD_DOPRI && state.dt > 0 ) ) {
+            dt = state.dt > 0 ? state.dt : 1.0;
+        }
+        cnt = ( int )state.step;
+        time = method == METHOD_DOPRI ? state.time : cnt * dt;
+        if ( size <= 0 ) {
+            fprintf(stderr, "error: cannot read stars from %s.\n", argv[1]);
+            size = 0;
         } else {
-            size = initialize_stars(data, &stars);
-            fclose(data);
             original_size = size;
+            //Windows cannot replace a mapped file, and the checkpoint may be the file just read
+            if ( checkpoint != NULL && !detach_stars(size, &stars) ) {
+                fprintf(stderr, "error: cannot copy the stars out of %s. no checkpoint is written.\n", argv[1]);
+                checkpoint = NULL;
+            }
+            if ( !allocate_workspace(original_size, &work) ) {
+                fprintf(stderr, "error: cannot allocate workspace.\n");
+                size = 0;
+            }
+            work.pool = pool;
+            if ( size > 0 && !allocate_stepper(original_size, method, dt, relative_tolerance, absolute_tolerance, eta, &stepper) ) {
+                fprintf(stderr, "error: cannot allocate %s workspace. use rk4.\n", method_name(method));
+                method = METHOD_RK4;
+                allocate_stepper(original_size, method, dt, relative_tolerance, absolute_tolerance, eta, &stepper);
+                time = cnt * dt;
+            }
+            //the values the integrator would have reused had the run gone on
+            if ( size > 0 ) {
+                restore_stepper(size, &extra, &stepper, &work);
+            }
+            if ( method == METHOD_HERMITE && theta >= 0 ) {
+                //the jerk needs the exact pairwise velocities
+                fprintf(stderr, "warning: hermite always uses direct summation.\n");
+            } else if ( theta >= 0 && size > 0 ) {
+                if ( allocate_tree(original_size, theta, order, &tree) ) {
+                    work.tree = &tree;
+                } else {
+                    fprintf(stderr, "error: cannot allocate tree. use direct summation.\n");
+                }
+            }
+            if ( record != NULL && size > 0 ) {
+                writer = create_writer(record, original_size);
+                if ( writer != NULL ) {
+                    GetState(&state);
+                    record_snapshot(writer, &state, size, &stars);
+                } else {
+                    fprintf(stderr, "error: cannot start the snapshot writer.\n");
+                }
+            }
+            if ( size > 0 ) {
+                //the steps run on their own thread, the display only reads the states they publish
+                monitor = create_monitor(original_size);
+                if ( monitor == NULL ) {
+                    fprintf(stderr, "error: cannot allocate the monitor. step and draw in turn.\n");
+                } else {
+                    publish_frame(monitor, cnt, time, size, &stars);
+                    if ( !start_physics(monitor, StepThread, this) ) {
+                        fprintf(stderr, "error: cannot start the physics thread. step and draw in turn.\n");
+                        destroy_monitor(monitor);
+                        monitor = NULL;
+                    }
+                }
+            }
         }
+        free_extra(&extra);
     } else {
         fprintf(stderr, "data file not specified.\n");
     }
 }
 
-bool Simulator::Update() {
+/**
+* @fn 1Xebvi߂. vZ̃XbhŌĂ΂, \͑҂Ȃ
+* @return ʂɐcĂĐi߂Ƃtrue
+*/
+bool Simulator::Step() {
+    PROFILE_SCOPE(PROFILE_UPDATE);
 	if ( IsAnyStarOnScreen() ) {
         cnt++;
-        //detect collision
-        size = collision(size, dt, stars);
-        //update
-		//euler(size,dt,stars);
-        runge_kutta(size, dt, stars);
-        //draw
-        OnDraw();
+        //detect collision, then update
+        PROFILE_BEGIN(PROFILE_COLLISION);
+        size = stepper_collision(size, &stars, &stepper);
+        PROFILE_END(PROFILE_COLLISION);
+        PROFILE_BEGIN(PROFILE_ADVANCE);
+        const double step = advance(size, 0, &stars, &work, &stepper);
+        PROFILE_END(PROFILE_ADVANCE);
+        time = method == METHOD_DOPRI ? time + step : cnt * dt;
+        PROFILE_BEGIN(PROFILE_OUTPUT);
+        //only copies the state, the writer thread writes it while the next steps run
+        if ( writer != NULL && cnt % every == 0 ) {
+            struct StarsState state;
+            GetState(&state);
+            record_snapshot(writer, &state, size, &stars);
+        }
+        if ( checkpoint != NULL && cnt % interval == 0 ) {
+            SaveCheckpoint();
+        }
+        //only copies the masses and positions, the display interpolates the latest two
+        if ( monitor != NULL && cnt % frames == 0 ) {
+            publish_frame(monitor, cnt, time, size, &stars);
+        }
+        PROFILE_END(PROFILE_OUTPUT);
 		return true;
 	} else {
 		return false;
@@ -42,30 +171,191 @@ bool Simulator::Update() {
 	
 }
 
-void Simulator::OnDraw() {
+int Simulator::StepThread(void *context) {
+    return static_cast<Simulator *>( context )->Step() ? 1 : 0;
+}
+
+/**
+* @fn ŐV̏Ԃ`. DxLib̕`惋[vĂ΂
+* @return vZĂƂtrue
+*/
+bool Simulator::Update() {
+    if ( monitor == NULL ) {
+        if ( !Step() ) {
+            return false;
+        }
+        OnDraw(size, &stars, time);
+        return true;
+    }
+    struct MonitorFrame const *frame = view_frame(monitor);
+    if ( frame != NULL ) {
+        OnDraw(frame->size, &frame->stars, frame->time);
+    }
+    return physics_running(monitor) != 0;
+}
+
+void Simulator::OnDraw(const int count, struct Stars const *shown, const double shown_time) {
+    PROFILE_SCOPE(PROFILE_DRAW);
     const int color = GetColor(0xff, 0xff, 0xff);
-    DrawFormatString(3, 3, color, "time : %5.1f", cnt * dt);
-    for ( int i = 0; i < size; i++ ) {
-        struct Star *star = &stars[i];
-        const float r = (float)( pow(star->m, 1.0 / 3.0) * 10 );
-        struct Vector2 *position = star->r;
-        const float x = (float)( position->x * unit + w / 2 );
-        const float y = (float)( position->y * unit + h / 2 );
+    DrawFormatString(3, 3, color, "time : %5.1f", shown_time);
+    for ( int i = 0; i < count; i++ ) {
+        const float r = (float)( pow(shown->m[i], 1.0 / 3.0) * 10 );
+        const float x = (float)( shown->x[i] * unit + w / 2 );
+        const float y = (float)( shown->y[i] * unit + h / 2 );
         DrawCircleAA(x, y, r, 32, color, true);
-        DrawFormatString(0, 30 * ( i + 1 ), color, "%2d > m:%4.1f r:(%5.1f,%5.1f)", i, star->m, position->x, position->y);
+        DrawFormatString(0, 30 * ( i + 1 ), color, "%2d > m:%4.1f r:(%5.1f,%5.1f)", i, shown->m[i], shown->x[i], shown->y[i]);
     }
 }
 
 Simulator::~Simulator() {
-    free_stars(original_size, stars);
+    //the steps stop before the state they write is saved and freed
+    if ( monitor != NULL ) {
+        stop_physics(monitor);
+    }
+    //keep the progress on exit as well
+    if ( checkpoint != NULL && size > 0 && cnt % interval != 0 ) {
+        SaveCheckpoint();
+    }
+    destroy_writer(writer);
+    if ( profile != NULL ) {
+        profile_report(stderr);
+        if ( monitor != NULL ) {
+            report_monitor(stderr, monitor);
+        }
+        if ( !profile_write_trace(profile) ) {
+            fprintf(stderr, "error: cannot write %s.\n", profile);
+        }
+    }
+    destroy_monitor(monitor);
+    free_stars(&stars);
+    free_stepper(&stepper);
+    if ( work.tree != NULL ) {
+        free_tree(&tree);
+    }
+    free_workspace(&work);
+    destroy_pool(pool);
+}
+
+/**
+* @fn f[^t@CɑR}hCǂݍ.
+* @detail ̃IvVwł
+*   --theta   Barnes-Hut@ŉxvZ. Ƃ͊Jp (ȗ͒ڑa)
+*   --order n  Barnes-Hut@̑dɓWJ̎ 0:PɎq 2:ldɎq (ȗ2)
+*   --threads n x̌vZɎgXbh̐ (ȗ͌vZ@̃Xbh)
+*   --dt dt    1Xebv̎̕ω (ȗ̓`FbN|CgɋL^ꂽl, Ȃ1.0)
+*   --unit u   1\f (ȗ10)
+*   --method m ϕ@ rk4:QENb^@ dopri:ݕŒh}EvX@
+*              hermite:Ƃɍ݂IԃG~[g@ euler:IC[@ leapfrog:[vtbO@
+*              yoshida4, yoshida6:[vtbO@gݍ킹4, 6̋gc̕@ (ȗrk4)
+*              doprîƂ--dt͍ŏɎݕ, hermitêƂ--dt͐Ƃ݂̍̏
+*   --rtol r, --atol a dopri1Xebv̌덷̋el (ȗ͂ǂ1e-8)
+*   --eta e    hermite̍ݕ߂鐸x̌W (ȗ0.02)
+*   --record p ԂoCi` p00000100.bin Ȃǂ֋L^. o͕ʂ̃Xbhs
+*   --every k  L^Xebv̊Ԋu (ȗ100)
+*   --checkpoint f vZĊJ邽߂̃`FbN|Cgf֒Iɏo. Iɂo
+*   --interval k `FbN|CgoXebv̊Ԋu (ȗ1000)
+*   --precision p ڑa̐x double:Sdouble mixed:gƂ̌vZ64g̘afloat, Ŝ̘adouble (ȗdouble)
+*   --frames k \֏ԂnXebv̊Ԋu (ȗ1). vZ͕ʂ̃Xbhŕ\҂ɐi,
+*              \͎󂯎ŐV̓̏Ԃ̊ԂԂĕ`
+*   --softening e . ߂g̏d͂߂ċߐڑłLɂ (ȗ0œȂ)
+*   --softening-kernel k ̌` plummer:(r^2 + e^2)^-3/2 spline:2.8e艓΃j[g̏d͂ƈv3XvC (ȗplummer)
+*   --profile f IɋԂƂ̎ԂƉ񐔂̕\WG[o͂, Chrome tracing`JSONf֏o
+*              GRAVITY_PROFILE`ărhƂg
+*/
+void Simulator::ParseOptions(int argc, char **argv) {
+    for ( int i = 2; i < argc; i++ ) {
+        if ( strcmp(argv[i], "--theta") == 0 && i + 1 < argc ) {
+            theta = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--order") == 0 && i + 1 < argc ) {
+            order = atoi(argv[++i]) >= TREE_QUADRUPOLE ? TREE_QUADRUPOLE : TREE_MONOPOLE;
+        } else if ( strcmp(argv[i], "--threads") == 0 && i + 1 < argc ) {
+            threads = atoi(argv[++i]);
+        } else if ( strcmp(argv[i], "--dt") == 0 && i + 1 < argc ) {
+            dt = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--unit") == 0 && i + 1 < argc ) {
+            unit = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--record") == 0 && i + 1 < argc ) {
+            record = argv[++i];
+        } else if ( strcmp(argv[i], "--every") == 0 && i + 1 < argc ) {
+            every = atol(argv[++i]);
+            if ( every <= 0 ) {
+                every = 1;
+            }
+        } else if ( strcmp(argv[i], "--method") == 0 && i + 1 < argc ) {
+            method = find_method(argv[++i]);
+            if ( method < 0 ) {
+                fprintf(stderr, "unknown method %s.\n", argv[i]);
+                method = METHOD_RK4;
+            }
+        } else if ( strcmp(argv[i], "--rtol") == 0 && i + 1 < argc ) {
+            relative_tolerance = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--atol") == 0 && i + 1 < argc ) {
+            absolute_tolerance = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--eta") == 0 && i + 1 < argc ) {
+            eta = atof(argv[++i]);
+        } else if ( strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc ) {
+            checkpoint = argv[++i];
+        } else if ( strcmp(argv[i], "--interval") == 0 && i + 1 < argc ) {
+            interval = atol(argv[++i]);
+            if ( interval <= 0 ) {
+                interval = 1;
+            }
+        } else if ( strcmp(argv[i], "--precision") == 0 && i + 1 < argc ) {
+            //kept by the force kernels, not by the simulator
+            if ( strcmp(argv[++i], "mixed") == 0 ) {
+                set_force_precision(FORCE_PRECISION_MIXED);
+            } else if ( strcmp(argv[i], "double") != 0 ) {
+                fprintf(stderr, "unknown precision %s.\n", argv[i]);
+            }
+        } else if ( strcmp(argv[i], "--frames") == 0 && i + 1 < argc ) {
+            frames = atol(argv[++i]);
+            if ( frames <= 0 ) {
+                frames = 1;
+            }
+        } else if ( strcmp(argv[i], "--softening") == 0 && i + 1 < argc ) {
+            set_force_softening(get_force_softening()->kind, atof(argv[++i]));
+        } else if ( strcmp(argv[i], "--softening-kernel") == 0 && i + 1 < argc ) {
+            if ( strcmp(argv[++i], "spline") == 0 ) {
+                set_force_softening(FORCE_SOFTENING_SPLINE, get_force_softening()->eps);
+            } else if ( strcmp(argv[i], "plummer") == 0 ) {
+                set_force_softening(FORCE_SOFTENING_PLUMMER, get_force_softening()->eps);
+            } else {
+                fprintf(stderr, "unknown softening kernel %s.\n", argv[i]);
+            }
+        } else if ( strcmp(argv[i], "--profile") == 0 && i + 1 < argc ) {
+            profile = argv[++i];
+        } else {
+            fprintf(stderr, "unknown option %s.\n", argv[i]);
+        }
+    }
+}
+
+void Simulator::GetState(struct StarsState *state) {
+    state->step = cnt;
+    state->time = time;
+    state->dt = next_dt(&stepper);
+}
+
+/**
+* @fn `FbN|Cgo. f[^t@CɎw肷ΓvZ̃Xebv瑱
+*/
+void Simulator::SaveCheckpoint() {
+    struct StarsState state;
+    GetState(&state);
+    struct StarsExtra extra = { NULL, 0, 0 };
+    const bool ok = save_stepper(size, &stepper, &work, &extra) && save_checkpoint(checkpoint, size, &stars, &state, &extra);
+    free_extra(&extra);
+    if ( !ok ) {
+        fprintf(stderr, "error: cannot write checkpoint %s.\n", checkpoint);
+    }
 }
 
 bool Simulator::IsAnyStarOnScreen() {
+    PROFILE_SCOPE(PROFILE_ON_SCREEN);
     const double wmax = w / unit / 2 + 2;
     const double hmax = h / unit / 2 + 2;
     for ( int i = 0; i < size; i++ ) {
-        struct Vector2 *position = stars[i].r;
-        if ( fabs(position->x) <= wmax && fabs(position->y) <= hmax ) {
+        if ( fabs(stars.x[i]) <= wmax && fabs(stars.y[i]) <= hmax ) {
             return true;
         }
     }
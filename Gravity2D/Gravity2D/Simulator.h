@@ -1,19 +1,50 @@
 #pragma once
+#include "gravity1.h"
+#include "tree1.h"
+#include "../../Common/pool.h"
+#include "snapshot1.h"
+#include "stepper1.h"
+#include "monitor1.h"
 
 class Simulator {
 
 	private:
-	struct Star* stars;
+	struct Stars stars;
+    struct Workspace work;
+    struct Tree tree;
+    double theta;
+    int order;
+    struct ThreadPool* pool;
+    int threads;
     int original_size;
 	int size;
     int cnt;
-	const double dt = 1.0;
-    const double unit = 10.0;
+	double dt;
+    double time;            // time of the current state, not always cnt * dt with Dormand-Prince
+    int method;             // METHOD_*
+    double relative_tolerance; // tolerances of Dormand-Prince
+    double absolute_tolerance;
+    double eta;             // accuracy parameter of Hermite
+    struct Stepper stepper;
+    double unit;
+    const char* record;     // prefix of the snapshot files, NULL not to record
+    long every;             // snapshot cadence in steps
+    struct SnapshotWriter* writer;
+    const char* checkpoint; // file to write checkpoints to, NULL for none
+    long interval;          // checkpoint cadence in steps
+    const char* profile;    // file to write the trace of the profiler to, NULL for none
+    struct Monitor* monitor; // runs the steps on its own thread and hands the states to the display, NULL to step and draw in turn
+    long frames;            // steps per state handed to the display
     int w, h;
 
     private:
+    void ParseOptions(int argc, char **argv);
+    void GetState(struct StarsState *state);
+    void SaveCheckpoint();
     bool IsAnyStarOnScreen();
-    void OnDraw();
+    bool Step();
+    static int StepThread(void *context);
+    void OnDraw(const int count, struct Stars const *shown, const double shown_time);
 
 	public:
 	Simulator(int argc, char **argv, int w, int h);
@@ -0,0 +1,18 @@
+/**
+* @brief ʂg킸ɌvZsob`sp̃Gg|Cg
+* 2 {̂3łƋʂ Common/batch_core.h ɂ
+*/
+#include "gravity1.h"
+#include "force1.h"
+#include "tree1.h"
+#include "loader1.h"
+#include "snapshot1.h"
+#include "stepper1.h"
+#include "diagnostics1.h"
+#include "render1.h"
+#include "escape1.h"
+#include "regular1.h"
+
+#define BATCH_SCREEN 800    // side of the GUI window in pixels, the default size of the frames
+
+#include "../../Common/batch_core.h"
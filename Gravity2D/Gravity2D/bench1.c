@@ -0,0 +1,12 @@
+/**
+* @brief vZ̃J[l̑𑪂x`}[N
+* 2 {̂3łƋʂ Common/bench_core.h ɂ
+*/
+#include "gravity1.h"
+#include "force1.h"
+#include "tree1.h"
+#include "../../Common/pool.h"
+
+#define BENCH_NAME "gravity2d"
+
+#include "../../Common/bench_core.h"
@@ -0,0 +1,7 @@
+/**
+* @brief ۑʂ̐ff
+* 2 {̂3łƋʂ Common/diagnostics_core.h ɂ
+*/
+#include "diagnostics1.h"
+
+#include "../../Common/diagnostics_core.h"
@@ -0,0 +1,10 @@
+/**
+* @brief ̏W𕡐̃vZXɕČvZ̈敪
+* 2 {̂3łƋʂ Common/domain_core.h ɂ
+*/
+#include <mpi.h>
+#include "domain1.h"
+#include "force1.h"
+#include "../../Common/pool.h"
+
+#include "../../Common/domain_core.h"
@@ -0,0 +1,54 @@
+#pragma once
+#include "gravity1.h"
+#include "tree1.h"
+
+struct ThreadPool;
+
+/**
+* ̏W𕡐̃vZX (MPĨN) ɕĎ. gdomain1.c̒ŏ
+* eN͋Ԃ𒼌ċA񕪊 (ORB) ̗̈̐ϕ, x̌vẐт
+* ̃N玩̗̈ɏd͂yڂZ󂯎
+*/
+struct Domain {
+    int rank;           // this process
+    int ranks;          // number of processes
+    long* id;           // index of each local star in the initial data, ascending
+    int* mark;          // destination rank or part of each local star, work array
+    int capacity;       // length of id and mark
+    double* box;        // bounding box of the stars of each rank, lower then upper corner, 4 values each
+    double theta;       // opening angle of the tree, < 0 for direct summation
+    int order;          // TREE_MONOPOLE or TREE_QUADRUPOLE
+    struct Tree local;  // tree of the local stars, walked to find what the other ranks need
+    struct Tree tree;   // tree of the local stars and the imported ones
+    struct Stars sources; // local stars followed by the stars and cells imported for the force
+    struct MergeLog merges; // merges of the last collision, in local indices
+    struct Sweep sweep; // buffers of the collision sweep, grown with the stars
+    struct ThreadPool* pool;
+    double* send;       // packed records to send, grouped by destination
+    double* receive;    // records received, grouped by source
+    size_t send_capacity;
+    size_t receive_capacity;
+    int* counts;        // send counts, send offsets, receive counts and receive offsets of each rank
+    int changed;        // 1 when the last call moved or merged stars on some rank
+    long evaluations;   // force evaluations
+    long long imported; // stars and cells received for the force over the run
+    long migrated;      // stars sent to other ranks
+    long crossings;     // pairs of colliding stars on different ranks
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int init_domain(const double theta, const int order, struct ThreadPool *pool, struct Domain *domain);
+    void free_domain(struct Domain *domain);
+    int split_stars(const int total, struct Stars *all, struct Stars *stars, struct Domain *domain);
+    void attach_domain(struct Domain *domain, struct Workspace *work);
+    int balance_domain(const int size, struct Stars *stars, struct Workspace *work, struct Domain *domain);
+    int domain_collision(const int size, const double dt, struct Stars *stars, struct Workspace *work, struct Domain *domain);
+    long total_stars(const int size);
+    int gather_stars(const int size, struct Stars const *stars, struct Domain *domain, struct Stars *all);
+
+#ifdef __cplusplus
+}
+#endif
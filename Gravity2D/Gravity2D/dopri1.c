@@ -0,0 +1,7 @@
+/**
+* @brief h}EvX@ 5(4) ɂ鍏ݕ̎
+* 2 {̂3łƋʂ Common/dopri_core.h ɂ
+*/
+#include "dopri1.h"
+
+#include "../../Common/dopri_core.h"
@@ -0,0 +1,9 @@
+/**
+* @brief ̏ȌnSIMD[ɕׂēɐi߂
+* 2 {̂3łƋʂ Common/ensemble_core.h ɂ
+*/
+#include "ensemble1.h"
+#include "force1.h"
+#include "../../Common/pool.h"
+
+#include "../../Common/ensemble_core.h"
@@ -0,0 +1,67 @@
+#pragma once
+#include "gravity1.h"
+
+#define ENSEMBLE_LANES 8    // systems integrated side by side in a group, the number of doubles in an AVX-512 register
+
+/**
+* ɐi߂鏬Ȍn̑g. nƂ̒lSIMD[ɕׂ
+* ǐnl̒l͔z i * ENSEMBLE_LANES + l Ԗڂɂ (array of systems)
+* ̏Ȃn̎c̘gƋ󂢂[͎0̐Ŗ, x0ɂēȂ
+*/
+struct EnsembleGroup {
+    int systems;        // lanes holding a system, the rest are empty
+    int capacity;       // stars per lane
+    int size[ENSEMBLE_LANES];    // stars left in each system
+    int running[ENSEMBLE_LANES]; // 1 until the system stops
+    long steps[ENSEMBLE_LANES];  // steps the system has taken
+    int merges[ENSEMBLE_LANES];  // stars the system has lost by merging
+    double dt[ENSEMBLE_LANES];   // time step of each lane, 0 after the system stops
+    double *m;
+    double *x;          // position, previous position and velocity
+    double *y;
+    double *pre_x;
+    double *pre_y;
+    double *vx;
+    double *vy;
+    double *rx[4];      // displacement and velocity change at each stage of runge_kutta
+    double *ry[4];
+    double *wx[4];
+    double *wy[4];
+    double *ax;         // acceleration
+    double *ay;
+    void *block;        // memory block holding all the arrays
+};
+
+struct ThreadPool;
+
+/**
+* n̒uꏊ
+*/
+struct EnsembleSlot {
+    int group;
+    int lane;
+};
+
+/**
+* Ȍn̏W܂. ̐̋߂n𓯂gɂ܂Ƃ߂
+*/
+struct Ensemble {
+    int count;          // systems
+    int groups;
+    struct EnsembleGroup *group;
+    struct EnsembleSlot *slot; // where each system is, in the order given to allocate_ensemble
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int allocate_ensemble(const int count, int const *sizes, struct Ensemble *ens);
+    void free_ensemble(struct Ensemble *ens);
+    void set_system(struct Ensemble *ens, const int index, struct Stars const *stars);
+    int get_system(struct Ensemble const *ens, const int index, struct Stars *stars);
+    void run_ensemble(struct Ensemble *ens, const long steps, const double dt, const double bound, struct ThreadPool *pool);
+
+#ifdef __cplusplus
+}
+#endif
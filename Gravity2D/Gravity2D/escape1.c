@@ -0,0 +1,7 @@
+/**
+* @brief n甲o̊Ǘ
+* 2 {̂3łƋʂ Common/escape_core.h ɂ
+*/
+#include "escape1.h"
+
+#include "../../Common/escape_core.h"
@@ -0,0 +1,35 @@
+#pragma once
+#include "gravity1.h"
+#include "../../Common/softening.h"
+
+// kernels of calc_accelerations, ordered by SIMD width
+#define FORCE_KERNEL_SCALAR 0
+#define FORCE_KERNEL_SSE2 1
+#define FORCE_KERNEL_AVX2 2
+#define FORCE_KERNEL_AVX512 3
+
+// precision of the pairwise math in calc_accelerations
+#define FORCE_PRECISION_DOUBLE 0   // everything in double
+#define FORCE_PRECISION_MIXED 1    // separations, 1/r^3 and sums over 64 pairs in float, the total in double
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int detect_force_kernel(void);
+    int set_force_kernel(const int request);
+    int get_force_kernel(void);
+    const char* force_kernel_name(const int kind);
+    int set_force_precision(const int request);
+    int get_force_precision(void);
+    const char* force_precision_name(const int kind);
+    int set_force_softening(const int kind, const double length);
+    struct Softening const* get_force_softening(void);
+    const char* force_softening_name(const int kind);
+    void calc_accelerations_range(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay);
+    void calc_accelerations_potential_range(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *phi);
+    void calc_accelerations(const int size, struct Stars const *stars, double *ax, double *ay);
+
+#ifdef __cplusplus
+}
+#endif
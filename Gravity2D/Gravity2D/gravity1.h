@@ -1,34 +1,129 @@
 #pragma once
 #include <stdio.h>
 
-struct Star {
-    double m;           // mass
-    struct Vector2* r;  // position
-    struct Vector2* pre_r;// position at previous step
-    struct Vector2* v;  // velocity
+#define GRAVITY_DIM 2
+#include "../../Common/dimension.h"
+
+#define STARS_ALIGNMENT 64  // alignment of each component array in bytes
+
+/**
+* ̏W. evfƂɘAzŕێ
+* SĂ̔z͈̃ubNSTARS_ALIGNMENToCgEɑĐ؂o
+*/
+struct Stars {
+    double* m;          // mass
+    double* x;          // position
+    double* y;
+    double* pre_x;      // position at previous step
+    double* pre_y;
+    double* vx;         // velocity
+    double* vy;
+    int capacity;       // length of each array
+    void* block;        // memory block holding all the arrays
+    void* mapping;      // mapped initial-condition file m, x, y, vx, vy point into, NULL if none
+    size_t mapping_size;
+};
+
+/**
+* ͂̌vZO̐c̐ɋyڂd. Ŝ܂ɓWJlȍƒ̍ŋߎ
+* a(r) = a + T (r - center)
+*/
+struct ExternalField {
+    struct Vector2 center; // point the field is expanded about
+    double a[2];        // acceleration at the center
+    double t[2][2];     // tidal tensor, symmetric
+};
+
+struct Workspace;
+
+/**
+* x̌vZu鏈. ̃vZX̏d͂ƂȂǂɎg
+* size̐̉xwork->ax, ayȂǂ, phiNULLłȂ΃|eV
+*/
+typedef void (*force_hook)(void *context, const int size, struct Stars const *stars, struct Workspace *work, double *phi);
+
+/**
+* ϕ̍Ɨ̈. QENb^@̊ei̒ԒlƉx𐯂Ƃ̘Azŕێ
+* ̐̏ňxmۂ, Փ˂Ő擪sizevfgčėp
+*/
+struct Workspace {
+    double* rx[4];      // displacement r1..r4 at each stage
+    double* ry[4];
+    double* vx[4];      // velocity change v1..v4 at each stage
+    double* vy[4];
+    double* ax;         // acceleration of each star
+    double* ay;
+    double* phi;        // potential G  m_j / r_ij of each star, written when potential is set
+    int potential;      // 1 : the next call of accelerations also writes phi, then clears this
+    struct Tree* tree;  // Barnes-Hut tree, NULL for direct summation
+    struct ThreadPool* pool; // worker threads, NULL for a single thread
+    struct ExternalField* external; // pull of the stars left out of the force, added by accelerations unless NULL
+    force_hook hook;    // evaluates the force instead of the tree, FMM or direct summation unless NULL
+    void* hook_context; // passed to hook
+    int capacity;       // length of each array
+    void* block;        // memory block holding all the arrays
+};
+
+/**
+* Փ˂ɂ鍇̈̋L^
+*/
+struct MergeEvent {
+    int i;              // star that remains, index before the absorbed stars are removed
+    int j;              // star absorbed into i
+    double mi;          // masses before the merge
+    double mj;
+    struct Vector2 position; // position of the merged star
+    double speed;       // relative speed of the pair
 };
 
-struct Vector2 {
-    double x;
-    double y;
-    };
+/**
+* ̂̋L^. collisionɓnƍ̂ƂɈǋL. ǂ񂾑count0ɖ߂
+*/
+struct MergeLog {
+    struct MergeEvent* events;
+    int count;          // events recorded
+    int capacity;       // length of events
+};
 
-#ifdef __cplusplus @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ 
+/**
+* Փ˂̔ő|Ɨ̈. ̐̏ňxmۂ, XebvƂɎg
+* gcollision̒ň
+*/
+struct Sweep {
+    struct SweepEntry* entries; // boxes sorted along x
+    double* radius;     // half width of the box of each star
+    unsigned char* removed; // 1 for the stars absorbed in this pass
+    struct CollisionPair* pairs; // pairs that collide, grown only when a pass finds more than ever before
+    int capacity;       // length of entries, radius and removed
+    int pair_capacity;  // length of pairs
+    void* block;        // memory block holding entries, radius and removed
+};
+
+#ifdef __cplusplus
 extern "C" {
-#endif @ 
+#endif
 
     
-    double distance_vector(struct Vector2* v1, struct Vector2* v2);
-    void mul_vector(struct Vector2* vec, double const val);
-    void sub_vector(struct Vector2* v1, struct Vector2 const* v2);
-    void add_vector(struct Vector2* v1, struct Vector2 const* v2);
-    void copy_vector(struct Vector2* des, struct Vector2 const* src);
-    int initialize_stars(FILE* data, struct Star **p);
-    void free_stars(const int size, struct Star *stars);
-    void euler(const int size, const double dt, struct Star *stars);
-    void runge_kutta(const int size, const double dt, struct Star *stars);
-    int collision(const int size, const double dt, struct Star *stars);
-
-#ifdef __cplusplus @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ @ 
+    double *allocate_arrays(const int capacity, const int count, void **block, size_t *stride);
+    int allocate_stars(const int capacity, struct Stars *stars);
+    int initialize_stars(FILE* data, struct Stars *stars);
+    void free_stars(struct Stars *stars);
+    int allocate_workspace(const int capacity, struct Workspace *work);
+    void free_workspace(struct Workspace *work);
+    void accelerations(const int size, struct Stars const *stars, struct Workspace *work);
+    void add_external(const int size, struct Stars const *stars, struct Workspace *work);
+    void euler(const int size, const double dt, struct Stars *stars, struct Workspace *work);
+    void runge_kutta(const int size, const double dt, struct Stars *stars, struct Workspace *work);
+    void leapfrog(const int size, const double dt, struct Stars *stars, struct Workspace *work);
+    void yoshida(const int size, const double dt, const int order, struct Stars *stars, struct Workspace *work);
+    int is_collision(struct Stars const *stars, const int a, const int b, double dt);
+    int collision(const int size, const double dt, struct Stars *stars, struct MergeLog *log);
+    int allocate_sweep(const int capacity, struct Sweep *sweep);
+    void free_sweep(struct Sweep *sweep);
+    int collision_excluding(const int size, const double dt, struct Stars *stars, struct MergeLog *log, int const *partner,
+        struct Sweep *sweep);
+    void free_merge_log(struct MergeLog *log);
+
+#ifdef __cplusplus
 }
-#endif @ 
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,9 @@
+/**
+* @brief 4̃G~[g@ƊKwIȌʎԍ
+* 2 {̂3łƋʂ Common/hermite_core.h ɂ
+*/
+#include "hermite1.h"
+#include "force1.h"
+#include "../../Common/pool.h"
+
+#include "../../Common/hermite_core.h"
@@ -0,0 +1,7 @@
+/**
+* @brief lt@C̍ȓǂݍ
+* 2 {̂3łƋʂ Common/loader_core.h ɂ
+*/
+#include "loader1.h"
+
+#include "../../Common/loader_core.h"
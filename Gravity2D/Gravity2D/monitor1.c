@@ -0,0 +1,7 @@
+/**
+* @brief vZƕ\ʂ̃XbhŐi߂
+* 2 {̂3łƋʂ Common/monitor_core.h ɂ
+*/
+#include "monitor1.h"
+
+#include "../../Common/monitor_core.h"
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdio.h>
+#include "gravity1.h"
+
+/**
+* \ɓn񕪂̏. vZ̃Xbh, \̃Xbh͓ǂނ
+*/
+struct MonitorFrame {
+    struct Stars stars; // masses and positions, only the first size elements are used
+    int size;
+    long step;          // step of the state
+    double time;        // simulated time of the state
+    double wall;        // seconds when the state was published
+};
+
+/**
+* vZʂ̃XbhŐi, Ԃ\֓nĎ. gmonitor1.c̒ň
+*/
+struct Monitor;
+
+/**
+* vZ̃XbhJԂĂ1Xebv. Ƃ1 IƂ0Ԃ
+*/
+typedef int (*monitor_step)(void *context);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    struct Monitor* create_monitor(const int capacity);
+    int publish_frame(struct Monitor *monitor, const long step, const double time, const int size, struct Stars const *stars);
+    struct MonitorFrame const* view_frame(struct Monitor *monitor);
+    int start_physics(struct Monitor *monitor, monitor_step step, void *context);
+    int physics_running(struct Monitor *monitor);
+    void stop_physics(struct Monitor *monitor);
+    void report_monitor(FILE *out, struct Monitor const *monitor);
+    void destroy_monitor(struct Monitor *monitor);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+/**
+* @brief ̏W𕡐̃vZXɕČvZMPIł̃ob`s̃Gg|Cg
+* 2 {̂3łƋʂ Common/mpi_core.h ɂ
+*/
+#include "gravity1.h"
+#include "force1.h"
+#include "tree1.h"
+#include "../../Common/pool.h"
+#include "loader1.h"
+#include "stepper1.h"
+#include "diagnostics1.h"
+#include "domain1.h"
+
+#define DOMAIN_NAME "gravity2d"
+
+#include "../../Common/mpi_core.h"
@@ -0,0 +1,7 @@
+/**
+* @brief ߐژA̐
+* 2 {̂3łƋʂ Common/regular_core.h ɂ
+*/
+#include "regular1.h"
+
+#include "../../Common/regular_core.h"
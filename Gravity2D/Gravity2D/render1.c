@@ -0,0 +1,9 @@
+/**
+* @brief ʂg킸ɐ摜֕`ďo
+* 2 {̂3łƋʂ Common/render_core.h ɂ
+*/
+#include "render1.h"
+#include "../../Common/pool.h"
+#include "../../Common/profile.h"
+
+#include "../../Common/render_core.h"
@@ -0,0 +1,7 @@
+/**
+* @brief vZƕsďԂt@C֏o
+* 2 {̂3łƋʂ Common/snapshot_core.h ɂ
+*/
+#include "snapshot1.h"
+
+#include "../../Common/snapshot_core.h"
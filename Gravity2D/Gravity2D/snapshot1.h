@@ -0,0 +1,20 @@
+#pragma once
+#include "gravity1.h"
+#include "loader1.h"
+
+/**
+* 񓯊ɏԂoݖ. gsnapshot1.c̒ň
+*/
+struct SnapshotWriter;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    struct SnapshotWriter* create_writer(const char *prefix, const int capacity);
+    int record_snapshot(struct SnapshotWriter *writer, struct StarsState const *state, const int size, struct Stars const *stars);
+    int destroy_writer(struct SnapshotWriter *writer);
+
+#ifdef __cplusplus
+}
+#endif
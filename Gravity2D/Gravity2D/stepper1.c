@@ -0,0 +1,7 @@
+/**
+* @brief ϕ@𖼑OőI, ĂяoŐi߂
+* 2 {̂3łƋʂ Common/stepper_core.h ɂ
+*/
+#include "stepper1.h"
+
+#include "../../Common/stepper_core.h"
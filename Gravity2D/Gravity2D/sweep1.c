@@ -0,0 +1,13 @@
+/**
+* @brief ̏Ȍn܂Ƃ߂ČvZp[^XC[ṽGg|Cg
+* 2 {̂3łƋʂ Common/sweep_core.h ɂ
+*/
+#include "gravity1.h"
+#include "force1.h"
+#include "../../Common/pool.h"
+#include "loader1.h"
+#include "ensemble1.h"
+
+#define SWEEP_NAME "gravity2d"
+
+#include "../../Common/sweep_core.h"
@@ -0,0 +1,410 @@
+/**
+* @brief Barnes-Hut@őSĂ̐̉xߎvZ
+* 2 (l)
+* @detail
+* ͂ސ`̃ZċAI4, eZ̎ʁEdSEldɃ[g߂.
+* xvZ鐯猩ď\Z͒̐܂Ƃ߂đdɓWJŋߎ,
+* ߂Z͎q̃Z֍~. t̃ZɎcƂ͒ڑaƂ.
+* 1Xebv̌vZʂO(N log N)ɂȂ.
+*  (set_force_softening) PlummerȂ瑽dɂ̋2ɂ eps^2 𑫂, XvCjȂj̔a
+* ߂ZPɎqƂĈ.
+*
+* Jp : Z̕w, Z̏dS܂ł̋d, Z̒SƏdŜ ɂ
+*           d > w/ +  ̂ƂZ̑dɂƂ݂Ȃ.
+*           Ƃ傫قǑȂ萸x. =0 ł͒ڑaƓʂɂȂ.
+*           lz̐20000ɑ΂x̑Ό덷̒l (PɎq / ldɎq܂)
+*             =0.3 : 0.3% / 0.009%
+*             =0.5 : 0.8% / 0.06%
+*             =0.7 : 1.7% / 0.3%
+*             =1.0 : 4%   / 1.1%
+*           =0.5, ldɎq܂ł̂Ƃڑa̖5{(قǍ͊J)
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "force1.h"
+#include "tree1.h"
+#include "../../Common/profile.h"
+
+#define TREE_LEAF_SIZE 8    // max number of stars in a leaf cell
+#define TREE_MAX_DEPTH 48   // stop dividing cells whose stars are at (almost) the same position
+
+extern const double G;
+
+/**
+* @fn l؂\z邽߂̔zmۂ.
+* @param capacity ̐̏
+* @param theta Jp
+* @param order dɓWJ̎ TREE_MONOPOLE܂TREE_QUADRUPOLE
+* @param tree mۂzݒ肷
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_tree(const int capacity, const double theta, const int order, struct Tree *tree) {
+    tree->theta = theta;
+    tree->order = order;
+    tree->capacity = capacity;
+    tree->node_count = 0;
+    //a balanced tree needs about capacity / TREE_LEAF_SIZE * 4/3 nodes, grown on demand
+    tree->node_capacity = capacity / 2 + 16;
+    tree->nodes = ( struct TreeNode * )malloc(sizeof(struct TreeNode) * tree->node_capacity);
+    tree->index = ( int * )malloc(sizeof(int) * capacity * 2);
+    tree->px = ( double * )malloc(sizeof(double) * capacity * 6);
+    if ( tree->nodes == NULL || tree->index == NULL || tree->px == NULL ) {
+        free_tree(tree);
+        return 0;
+    }
+    tree->temp_index = tree->index + capacity;
+    tree->py = tree->px + capacity;
+    tree->pm = tree->px + capacity * 2;
+    tree->temp_x = tree->px + capacity * 3;
+    tree->temp_y = tree->px + capacity * 4;
+    tree->temp_m = tree->px + capacity * 5;
+    return 1;
+}
+
+void free_tree(struct Tree *tree) {
+    free(tree->nodes);
+    free(tree->index);
+    free(tree->px);
+    tree->nodes = NULL;
+    tree->index = NULL;
+    tree->px = NULL;
+    tree->capacity = 0;
+    tree->node_capacity = 0;
+}
+
+/**
+* @fn AZmۂ. ȂΔzL΂
+* @return mۂ擪̃Z̔ԍ sƂ-1
+*/
+static int new_nodes(struct Tree *tree, const int count) {
+    if ( tree->node_count + count > tree->node_capacity ) {
+        int capacity = tree->node_capacity * 2 + count;
+        struct TreeNode *nodes = ( struct TreeNode * )realloc(tree->nodes, sizeof(struct TreeNode) * capacity);
+        if ( nodes == NULL ) {
+            return -1;
+        }
+        tree->nodes = nodes;
+        tree->node_capacity = capacity;
+        PROFILE_COUNT(PROFILE_ALLOCATIONS, 1);
+    }
+    tree->node_count += count;
+    return tree->node_count - count;
+}
+
+/**
+* @fn Z̎ʁEdSEldɃ[g, dɂƂĈ鋗vZ.
+* @param node q̃Z̒l͌vZς݂ł邱
+*/
+static void set_moments(struct Tree *tree, const int node) {
+    struct TreeNode *n = &tree->nodes[node];
+    double m = 0, mx = 0, my = 0;
+    double qxx = 0, qxy = 0, qyy = 0;
+    double delta;
+    int k;
+    if ( n->child < 0 ) {
+        for ( k = n->first; k < n->first + n->count; k++ ) {
+            m += tree->pm[k];
+            mx += tree->pm[k] * tree->px[k];
+            my += tree->pm[k] * tree->py[k];
+        }
+    } else {
+        for ( k = n->child; k < n->child + 4; k++ ) {
+            m += tree->nodes[k].m;
+            mx += tree->nodes[k].m * tree->nodes[k].x;
+            my += tree->nodes[k].m * tree->nodes[k].y;
+        }
+    }
+    n->m = m;
+    if ( m <= 0 ) {
+        return;
+    }
+    n->x = mx / m;
+    n->y = my / m;
+    if ( tree->order >= TREE_QUADRUPOLE ) {
+        //Q = sum m (3 d d^T - |d|^2 I) about the center of mass
+        if ( n->child < 0 ) {
+            for ( k = n->first; k < n->first + n->count; k++ ) {
+                const double dx = tree->px[k] - n->x;
+                const double dy = tree->py[k] - n->y;
+                const double d2 = dx * dx + dy * dy;
+                qxx += tree->pm[k] * ( 3 * dx * dx - d2 );
+                qxy += tree->pm[k] * ( 3 * dx * dy );
+                qyy += tree->pm[k] * ( 3 * dy * dy - d2 );
+            }
+        } else {
+            //parallel axis theorem
+            for ( k = n->child; k < n->child + 4; k++ ) {
+                const struct TreeNode *c = &tree->nodes[k];
+                const double dx = c->x - n->x;
+                const double dy = c->y - n->y;
+                const double d2 = dx * dx + dy * dy;
+                if ( c->m <= 0 ) {
+                    continue;
+                }
+                qxx += c->qxx + c->m * ( 3 * dx * dx - d2 );
+                qxy += c->qxy + c->m * ( 3 * dx * dy );
+                qyy += c->qyy + c->m * ( 3 * dy * dy - d2 );
+            }
+        }
+    }
+    n->qxx = qxx;
+    n->qxy = qxy;
+    n->qyy = qyy;
+    //open the cell unless d > w/theta + delta
+    delta = sqrt(( n->x - n->cx ) * ( n->x - n->cx ) + ( n->y - n->cy ) * ( n->y - n->cy ));
+    if ( tree->theta > 0 ) {
+        const double limit = 2 * n->half / tree->theta + delta;
+        n->limit2 = limit * limit;
+    } else {
+        n->limit2 = HUGE_VAL;
+    }
+}
+
+/**
+* @fn ZċAIɕ.
+* @param node Sƕݒς݂̃Z
+* @param first,count ZɊ܂܂鐯͈̔
+* @return Ƃ1 ZmۂłȂƂ0
+*/
+static int build(struct Tree *tree, const int node, const int first, const int count, const int depth) {
+    struct TreeNode *n = &tree->nodes[node];
+    n->first = first;
+    n->count = count;
+    n->child = -1;
+    if ( count > TREE_LEAF_SIZE && depth < TREE_MAX_DEPTH ) {
+        const double cx = n->cx;
+        const double cy = n->cy;
+        const double quarter = n->half * 0.5;
+        int counts[4] = { 0, 0, 0, 0 };
+        int offsets[4];
+        int k, q, child;
+        //counting sort of the stars by quadrant
+        for ( k = first; k < first + count; k++ ) {
+            counts[( tree->px[k] >= cx ) | ( ( tree->py[k] >= cy ) << 1 )]++;
+        }
+        offsets[0] = first;
+        for ( q = 1; q < 4; q++ ) {
+            offsets[q] = offsets[q - 1] + counts[q - 1];
+        }
+        for ( k = first; k < first + count; k++ ) {
+            const int to = offsets[( tree->px[k] >= cx ) | ( ( tree->py[k] >= cy ) << 1 )]++;
+            tree->temp_x[to] = tree->px[k];
+            tree->temp_y[to] = tree->py[k];
+            tree->temp_m[to] = tree->pm[k];
+            tree->temp_index[to] = tree->index[k];
+        }
+        memcpy(&tree->px[first], &tree->temp_x[first], sizeof(double) * count);
+        memcpy(&tree->py[first], &tree->temp_y[first], sizeof(double) * count);
+        memcpy(&tree->pm[first], &tree->temp_m[first], sizeof(double) * count);
+        memcpy(&tree->index[first], &tree->temp_index[first], sizeof(int) * count);
+
+        child = new_nodes(tree, 4);
+        if ( child < 0 ) {
+            return 0;
+        }
+        //nodes may have been moved by realloc
+        tree->nodes[node].child = child;
+        for ( q = 0, k = first; q < 4; q++ ) {
+            struct TreeNode *c = &tree->nodes[child + q];
+            c->cx = cx + ( q & 1 ? quarter : -quarter );
+            c->cy = cy + ( q & 2 ? quarter : -quarter );
+            c->half = quarter;
+            if ( !build(tree, child + q, k, counts[q], depth + 1) ) {
+                return 0;
+            }
+            k += counts[q];
+        }
+    }
+    set_moments(tree, node);
+    return 1;
+}
+
+/**
+* @fn ̏Wl؂\z.
+* @detail q̃Z͕Ke̔ԍɒu
+* @return Ƃ1 sƂ0
+*/
+int build_tree(struct Tree *tree, const int size, struct Stars const *stars) {
+    double min_x = stars->x[0], max_x = stars->x[0];
+    double min_y = stars->y[0], max_y = stars->y[0];
+    struct TreeNode *root;
+    int i;
+    for ( i = 0; i < size; i++ ) {
+        tree->px[i] = stars->x[i];
+        tree->py[i] = stars->y[i];
+        tree->pm[i] = stars->m[i];
+        tree->index[i] = i;
+        if ( stars->x[i] < min_x ) min_x = stars->x[i];
+        if ( stars->x[i] > max_x ) max_x = stars->x[i];
+        if ( stars->y[i] < min_y ) min_y = stars->y[i];
+        if ( stars->y[i] > max_y ) max_y = stars->y[i];
+    }
+    tree->node_count = 0;
+    root = &tree->nodes[0];
+    new_nodes(tree, 1);
+    root->cx = ( min_x + max_x ) * 0.5;
+    root->cy = ( min_y + max_y ) * 0.5;
+    //enlarge a little so that every star is strictly inside the root cell
+    root->half = ( max_x - min_x > max_y - min_y ? max_x - min_x : max_y - min_y ) * 0.5 * ( 1 + 1e-9 ) + 1e-300;
+    return build(tree, 0, 0, size, 0);
+}
+
+/**
+* @fn ̐̉xl؂ǂČvZ.
+* @param x,y ̈ʒu
+* @param acceleration vZlރxNgIuWFNg
+* @param potential NULLłȂ΃|eV G  m / r 𓯂ŋ߂ď
+*/
+static void walk(struct Tree const *tree, const double x, const double y, struct Vector2 *acceleration, double *potential) {
+    int stack[TREE_MAX_DEPTH * 3 + 4];
+    int top = 0;
+    double ax = 0, ay = 0;
+    double p = 0;
+    long long cells = 0, pairs = 0;
+    struct Softening const *soft = get_force_softening();
+    const double eps2 = soft->eps2;
+    const double h2 = soft->h2;
+    stack[top++] = 0;
+    while ( top > 0 ) {
+        const struct TreeNode *n = &tree->nodes[stack[--top]];
+        double dx, dy, r2;
+        if ( n->m <= 0 ) {
+            continue;
+        }
+        dx = n->x - x;
+        dy = n->y - y;
+        r2 = dx * dx + dy * dy;
+        if ( r2 > n->limit2 && r2 < h2 ) {
+            //far enough but inside the spline kernel : softened monopole only
+            double q = 0;
+            const double s = n->m * soften(soft, r2, &q, NULL);
+            cells++;
+            ax += s * dx;
+            ay += s * dy;
+            if ( potential != NULL ) {
+                p += n->m * q;
+            }
+        } else if ( r2 > n->limit2 ) {
+            //far enough : multipole expansion about the center of mass (Plummer softening adds eps^2 to r^2)
+            cells++;
+            const double inv2 = 1.0 / ( r2 + eps2 );
+            const double inv3 = inv2 * sqrt(inv2);
+            ax += n->m * inv3 * dx;
+            ay += n->m * inv3 * dy;
+            if ( potential != NULL ) {
+                p += n->m * sqrt(inv2);
+            }
+            if ( tree->order >= TREE_QUADRUPOLE ) {
+                //a = -Q d / r^5 + 5/2 (d^T Q d) d / r^7
+                const double inv5 = inv3 * inv2;
+                const double qx = n->qxx * dx + n->qxy * dy;
+                const double qy = n->qxy * dx + n->qyy * dy;
+                const double s = 2.5 * ( dx * qx + dy * qy ) * inv5 * inv2;
+                ax += s * dx - qx * inv5;
+                ay += s * dy - qy * inv5;
+                if ( potential != NULL ) {
+                    //phi = m / r + 1/2 (d^T Q d) / r^5, whose gradient is the acceleration above
+                    p += 0.5 * ( dx * qx + dy * qy ) * inv5;
+                }
+            }
+        } else if ( n->child < 0 ) {
+            int k;
+            pairs += n->count;
+            for ( k = n->first; k < n->first + n->count; k++ ) {
+                const double ex = tree->px[k] - x;
+                const double ey = tree->py[k] - y;
+                const double e2 = ex * ex + ey * ey;
+                //skip the star itself
+                if ( e2 > 0 && e2 < h2 ) {
+                    //inside the spline kernel
+                    double q = 0;
+                    const double s = tree->pm[k] * soften(soft, e2, &q, NULL);
+                    ax += ex * s;
+                    ay += ey * s;
+                    if ( potential != NULL ) {
+                        p += tree->pm[k] * q;
+                    }
+                } else if ( e2 > 0 ) {
+                    const double e2e = e2 + eps2;
+                    const double s = tree->pm[k] / ( e2e * sqrt(e2e) );
+                    ax += ex * s;
+                    ay += ey * s;
+                    if ( potential != NULL ) {
+                        p += tree->pm[k] / sqrt(e2e);
+                    }
+                }
+            }
+        } else {
+            int k;
+            for ( k = n->child; k < n->child + 4; k++ ) {
+                stack[top++] = k;
+            }
+        }
+    }
+    acceleration->x = ax * G;
+    acceleration->y = ay * G;
+    if ( potential != NULL ) {
+        *potential = p * G;
+    }
+    //the leaf holding the star counts it as a pair with itself
+    PROFILE_COUNT(PROFILE_CELLS, cells);
+    PROFILE_COUNT(PROFILE_PAIRS, pairs);
+}
+
+/**
+* @fn \zς݂̖؂ǂĈꕔ̐̉xvZ. ͈͂̈قȂĂяo͕ɎsĂ悢
+* @param tree build_treeō\z
+* @param begin,end xvZ鐯̖؂̏ł͈̔
+* @param ax,ay vZxޔz (̏W̏)
+* @param phi NULLłȂ΃|eVޔz (̏W̏)
+*/
+void tree_accelerations_range(struct Tree const *tree, const int begin, const int end, double *ax, double *ay, double *phi) {
+    struct Vector2 a;
+    int k;
+    //walk in the tree order so that neighbouring stars share the cached cells
+    for ( k = begin; k < end; k++ ) {
+        walk(tree, tree->px[k], tree->py[k], &a, phi != NULL ? &phi[tree->index[k]] : NULL);
+        ax[tree->index[k]] = a.x;
+        ay[tree->index[k]] = a.y;
+    }
+}
+
+/**
+* @fn tree_accelerations_rangeƓ؂ǂĉxvZ. ̏Wł̔ԍlocal̐vZ
+* @param local x߂鐯̐ ԍlocalȏ̐͏d͂yڂ, ̉x͏܂Ȃ
+* @detail ̃vZX󂯎Z𐯂̏W̖ɉĖ؂ƂɎg
+*/
+void tree_accelerations_local(struct Tree const *tree, const int local, const int begin, const int end, double *ax, double *ay, double *phi) {
+    struct Vector2 a;
+    int k;
+    for ( k = begin; k < end; k++ ) {
+        const int i = tree->index[k];
+        if ( i >= local ) {
+            continue;
+        }
+        walk(tree, tree->px[k], tree->py[k], &a, phi != NULL ? &phi[i] : NULL);
+        ax[i] = a.x;
+        ay[i] = a.y;
+    }
+}
+
+/**
+* @fn SĂ̐̉xBarnes-Hut@ŌvZ.
+* @param tree eʂsizeȏ̖
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param ax,ay vZxޔz
+* @detail ؂̍\zɎsƂ͒ڑaŌvZ
+*/
+void tree_accelerations(struct Tree *tree, const int size, struct Stars const *stars, double *ax, double *ay) {
+    if ( size <= 0 ) {
+        return;
+    }
+    if ( !build_tree(tree, size, stars) ) {
+        calc_accelerations(size, stars, ax, ay);
+        return;
+    }
+    tree_accelerations_range(tree, 0, size, ax, ay, NULL);
+}
@@ -0,0 +1,19 @@
+/**
+* @brief ʂg킸ɌvZsob`sp̃Gg|Cg
+* 3 {̂2łƋʂ Common/batch_core.h ɂ
+*/
+#include "gravity3.h"
+#include "force3.h"
+#include "tree3.h"
+#include "fmm3.h"
+#include "loader3.h"
+#include "snapshot3.h"
+#include "stepper3.h"
+#include "diagnostics3.h"
+#include "render3.h"
+#include "escape3.h"
+#include "regular3.h"
+
+#define BATCH_SCREEN 600    // side of the GUI window in pixels, the default size of the frames
+
+#include "../../Common/batch_core.h"
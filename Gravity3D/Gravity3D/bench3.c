@@ -0,0 +1,13 @@
+/**
+* @brief vZ̃J[l̑𑪂x`}[N
+* 3 {̂2łƋʂ Common/bench_core.h ɂ
+*/
+#include "gravity3.h"
+#include "force3.h"
+#include "tree3.h"
+#include "fmm3.h"
+#include "../../Common/pool.h"
+
+#define BENCH_NAME "gravity3d"
+
+#include "../../Common/bench_core.h"
@@ -0,0 +1,7 @@
+/**
+* @brief ۑʂ̐ff
+* 3 {̂2łƋʂ Common/diagnostics_core.h ɂ
+*/
+#include "diagnostics3.h"
+
+#include "../../Common/diagnostics_core.h"
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdio.h>
+#include "gravity3.h"
+
+/**
+* ۑʂ̐ff. ^GlM[, ^, p^ʂmeasure_stateO(N)ŋ,
+* ʒuGlM[͉xƓǧvZŋ߂|eVadd_potential
+*/
+struct Diagnostics {
+    long step;          // step and time of the sample
+    double time;
+    int size;           // number of stars
+    double mass;        // total mass
+    double kinetic;     // kinetic energy
+    double potential;   // potential energy -1/2  m_i phi_i
+    double energy;      // kinetic + potential
+    struct Vector3 momentum;
+    struct Vector3 angular; // angular momentum about the origin
+    struct Vector3 center;  // center of mass
+    int pending;        // 1 while the potential is not added yet
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    void measure_state(const long step, const double time, const int size, struct Stars const *stars, struct Diagnostics *diag);
+    void add_potential(const int size, struct Stars const *stars, double const *phi, struct Diagnostics *diag);
+    void write_diagnostics(FILE *out, struct Diagnostics const *diag, struct Diagnostics const *initial);
+    void write_merges(FILE *out, const long step, const double time, struct MergeLog *log);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,10 @@
+/**
+* @brief ̏W𕡐̃vZXɕČvZ̈敪
+* 3 {̂2łƋʂ Common/domain_core.h ɂ
+*/
+#include <mpi.h>
+#include "domain3.h"
+#include "force3.h"
+#include "../../Common/pool.h"
+
+#include "../../Common/domain_core.h"
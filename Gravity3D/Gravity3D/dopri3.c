@@ -0,0 +1,7 @@
+/**
+* @brief h}EvX@ 5(4) ɂ鍏ݕ̎
+* 3 {̂2łƋʂ Common/dopri_core.h ɂ
+*/
+#include "dopri3.h"
+
+#include "../../Common/dopri_core.h"
@@ -0,0 +1,39 @@
+#pragma once
+#include "gravity3.h"
+
+#define DOPRI_STAGES 7
+#define DOPRI_MAX_REJECTS 50    // accept the step anyway after this many rejections in a row
+
+/**
+* h}EvX@ 5(4) ̏ԂƍƗ̈
+* Փ˂ȂǂŐ̏Wϕ̊OŏƂ, fsal0ɂčŌ̉xg킹Ȃ
+*/
+struct Dopri {
+    double rtol;        // relative tolerance
+    double atol;        // absolute tolerance
+    double dt;          // step size to try next
+    long accepted;      // steps accepted so far
+    long rejected;      // steps rejected and retried with a smaller step
+    long evaluations;   // force evaluations
+    int fsal;           // 1 while ux[0], ax[0] hold the derivative at the current state
+    double* ux[DOPRI_STAGES]; // velocity at each stage, dx/dt
+    double* uy[DOPRI_STAGES];
+    double* uz[DOPRI_STAGES];
+    double* ax[DOPRI_STAGES]; // acceleration at each stage, dv/dt
+    double* ay[DOPRI_STAGES];
+    double* az[DOPRI_STAGES];
+    int capacity;       // length of each array
+    void* block;        // memory block holding all the arrays
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int allocate_dopri(const int capacity, const double rtol, const double atol, const double dt, struct Dopri *dopri);
+    void free_dopri(struct Dopri *dopri);
+    double dormand_prince(const int size, const double limit, struct Stars *stars, struct Workspace *work, struct Dopri *dopri);
+
+#ifdef __cplusplus
+}
+#endif
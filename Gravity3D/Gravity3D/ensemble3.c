@@ -0,0 +1,9 @@
+/**
+* @brief ̏ȌnSIMD[ɕׂēɐi߂
+* 3 {̂2łƋʂ Common/ensemble_core.h ɂ
+*/
+#include "ensemble3.h"
+#include "force3.h"
+#include "../../Common/pool.h"
+
+#include "../../Common/ensemble_core.h"
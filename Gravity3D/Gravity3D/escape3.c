@@ -0,0 +1,7 @@
+/**
+* @brief n甲o̊Ǘ
+* 3 {̂2łƋʂ Common/escape_core.h ɂ
+*/
+#include "escape3.h"
+
+#include "../../Common/escape_core.h"
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdio.h>
+#include "gravity3.h"
+#include "loader3.h"
+
+#define ESCAPE_SECTION "ESCAPE"     // checkpoint section holding the escaped stars at the end of the arrays
+#define ESCAPE_SECTION_VERSION 1
+
+/**
+* n甲o. ̔žɂ܂Ƃ, ͂̌vZƏՓ˂̔肩O
+* c̐(ꂽ)͔z̑O size - count , ϕ@ɂ͂̐n
+*/
+struct Escapers {
+    int count;          // escaped stars, kept at the end of the star arrays
+    double radius;      // distance from the center of mass beyond which an unbound star escapes, <= 0 never
+    double mass;        // total mass of the escaped stars
+    double bound_mass;  // mass, center of mass, its velocity and quadrupole of the bound stars
+    struct Vector3 center;
+    struct Vector3 velocity;
+    double q[3][3];
+    struct ExternalField field; // pull of the escaped stars on the bound ones
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    void init_escapers(const double radius, struct Escapers *esc);
+    int shift_escapers(const int size, const int bound, const int merged, struct Stars *stars);
+    int classify_escapers(const int size, struct Stars *stars, struct Escapers *esc);
+    void prepare_escapers(const int size, struct Stars const *stars, struct Escapers *esc, struct Workspace *work);
+    void propagate_escapers(const int size, const double h, struct Stars *stars, struct Escapers const *esc);
+    int save_escapers(struct Escapers const *esc, struct StarsExtra *extra);
+    int restore_escapers(const int size, struct StarsExtra const *extra, struct Escapers *esc);
+    void write_escapers(FILE *out, const long step, const double time, const int escaped, const int size, struct Escapers const *esc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,594 @@
+/**
+* @brief dɖ@(FMM)őSĂ̐̉xvZ
+* 3
+* @detail
+* Barnes-Hut@Ɠ؂, eZ̏dS܂̑dɓWJt獪֋߂(P2M, M2M).
+* ̃Z̑gdɂǂ, \ꂽgł݂͌̑dɓWJ𑊎̋ǏWJ֕ϊ(M2L),
+* ߂g͑傫̃Zq֕, tǂł͒ڑaƂ(P2P).
+* ŌɋǏWJeqֈڂ(L2L), t̊ëʒuŕ](L2P).
+* ݍpZ̑g̐͐̐ɔႷ̂, 1Xebv̌vZʂO(N)ɂȂ.
+*
+* WJ̓fJgW̑dY n = (nx, ny, nz), |n| = nx + ny + nz  p ŕ\.
+*   dɓWJ M_n =  m (x - z)^n / n!                 z : Z̏dS
+*   ǏWJ   L_k = ^k (z)                          (x) =  m / |x - x_j|
+*   M2L        L_k +=  (-1)^|n| M_n D_{n+k}(zB - zA)   D_n = ^n (1/r)
+*
+* p  : WJł؂鎟. 傫قǐxオ, M2ĽvZʂ͂悻p^6/36ő.
+* Jp: dSԂ̋d, eZ̏dSł܂ł̋rA, rB ɂ
+*          rA + rB < d ̂Ƃ̃Z͏\ĂƂ݂Ȃ.
+* t̃Z: ̐FMM_LEAF_SIZEȉɂȂ܂ŕ̂, ̖WقǍׂZɂȂ.
+*           ̏ȂZ̑gM2LڑaŌvZ.
+* : tǂ̒ڑa set_force_softening ̓g, M2L̓j[g̏d͂̂܂.
+*       ͏\ꂽZ̑g̋\̂Ƃ.
+*
+* lz̐20000ɑ΂x̑Ό덷̒l (=0.3 / 0.5 / 0.7)
+*   p=2 : 1.1e-3 / 4.0e-3 / 8.1e-3
+*   p=4 : 1.7e-5 / 1.9e-4 / 9.3e-4
+*   p=6 : 3.4e-7 / 1.2e-5 / 1.2e-4
+*   p=8 : 4.0e-9 / 5.0e-7 / 1.1e-5
+* vZԂ͐̐ɂقڔႵ, p=4, =0.5̂Ƃ100000Œڑa̖8{.
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "force3.h"
+#include "fmm3.h"
+#include "../../Common/profile.h"
+
+#ifndef FMM_DIRECT_COST
+#define FMM_DIRECT_COST 8   // cost of one pair of direct summation relative to one term of M2L
+#endif
+
+extern const double G;
+
+/**
+* @fn dY̍̔ԍԂ. ̒Ⴂ, łnxny̑傫ɕׂ
+*/
+static int term_index(const int nx, const int ny, const int nz) {
+    const int d = nx + ny + nz;
+    const int e = ny + nz;
+    return d * ( d + 1 ) * ( d + 2 ) / 6 + e * ( e + 1 ) / 2 + nz;
+}
+
+/**
+* @fn WJ̍, WJ̕sړEϊɎgY̑g̕\.
+* @return Ƃ1 sƂ0
+*/
+static int make_tables(struct Fmm *fmm) {
+    const int p = fmm->order;
+    int d, i, j, k, count;
+    fmm->terms = ( struct FmmTerm * )malloc(sizeof(struct FmmTerm) * fmm->ncoef);
+    if ( fmm->terms == NULL ) {
+        return 0;
+    }
+    for ( d = 0; d <= p; d++ ) {
+        int nx, ny;
+        for ( nx = d; nx >= 0; nx-- ) {
+            for ( ny = d - nx; ny >= 0; ny-- ) {
+                struct FmmTerm *t = &fmm->terms[term_index(nx, ny, d - nx - ny)];
+                t->n[0] = nx;
+                t->n[1] = ny;
+                t->n[2] = d - nx - ny;
+                t->degree = d;
+            }
+        }
+    }
+    for ( j = 0; j < fmm->ncoef; j++ ) {
+        struct FmmTerm *t = &fmm->terms[j];
+        for ( i = 0; i < 3; i++ ) {
+            int n[3];
+            n[0] = t->n[0];
+            n[1] = t->n[1];
+            n[2] = t->n[2];
+            n[i]--;
+            t->lower[i] = n[i] >= 0 ? term_index(n[0], n[1], n[2]) : 0;
+            n[i]--;
+            t->lower2[i] = n[i] >= 0 ? term_index(n[0], n[1], n[2]) : 0;
+            n[i] += 3;
+            t->upper[i] = t->degree < p ? term_index(n[0], n[1], n[2]) : -1;
+            if ( t->degree > 0 ) {
+                t->c1[i] = -( 2.0 * t->degree - 1 ) * t->n[i] / t->degree;
+                t->c2[i] = -( t->degree - 1.0 ) * t->n[i] * ( t->n[i] - 1 ) / t->degree;
+            } else {
+                t->c1[i] = 0;
+                t->c2[i] = 0;
+            }
+        }
+    }
+
+    //(n, k, n-k) for every k <= n
+    count = 0;
+    for ( j = 0; j < fmm->ncoef; j++ ) {
+        count += ( fmm->terms[j].n[0] + 1 ) * ( fmm->terms[j].n[1] + 1 ) * ( fmm->terms[j].n[2] + 1 );
+    }
+    fmm->shift = ( int * )malloc(sizeof(int) * count * 3);
+    if ( fmm->shift == NULL ) {
+        return 0;
+    }
+    fmm->shift_count = 0;
+    for ( j = 0; j < fmm->ncoef; j++ ) {
+        for ( k = 0; k < fmm->ncoef; k++ ) {
+            int const *n = fmm->terms[j].n;
+            int const *m = fmm->terms[k].n;
+            if ( m[0] <= n[0] && m[1] <= n[1] && m[2] <= n[2] ) {
+                int *s = &fmm->shift[fmm->shift_count++ * 3];
+                s[0] = j;
+                s[1] = k;
+                s[2] = term_index(n[0] - m[0], n[1] - m[1], n[2] - m[2]);
+            }
+        }
+    }
+
+    //(k, n, n+k) for every |n| + |k| <= p
+    count = 0;
+    for ( k = 0; k < fmm->ncoef; k++ ) {
+        count += term_index(p - fmm->terms[k].degree + 1, 0, 0);
+    }
+    fmm->m2l = ( int * )malloc(sizeof(int) * count * 3);
+    if ( fmm->m2l == NULL ) {
+        return 0;
+    }
+    fmm->m2l_count = 0;
+    for ( k = 0; k < fmm->ncoef; k++ ) {
+        for ( j = 0; j < term_index(p - fmm->terms[k].degree + 1, 0, 0); j++ ) {
+            int const *n = fmm->terms[j].n;
+            int const *m = fmm->terms[k].n;
+            int *s = &fmm->m2l[fmm->m2l_count++ * 3];
+            s[0] = k;
+            s[1] = j;
+            s[2] = term_index(n[0] + m[0], n[1] + m[1], n[2] + m[2]);
+        }
+    }
+    return 1;
+}
+
+/**
+* @fn dɖ@̍Ɨ̈mۂ.
+* @param capacity ̐̏
+* @param theta Jp
+* @param order WJ̎ 1FMM_MAX_ORDER܂
+* @param fmm mۂzݒ肷Ɨ̈
+* @return mۂɐƂ1 sƂ0
+*/
+int allocate_fmm(const int capacity, const double theta, const int order, struct Fmm *fmm) {
+    fmm->theta = theta;
+    fmm->order = order < 1 ? 1 : ( order > FMM_MAX_ORDER ? FMM_MAX_ORDER : order );
+    fmm->ncoef = term_index(fmm->order + 1, 0, 0);
+    fmm->terms = NULL;
+    fmm->shift = NULL;
+    fmm->m2l = NULL;
+    fmm->multipole = NULL;
+    fmm->local = NULL;
+    fmm->radius = NULL;
+    fmm->node_capacity = 0;
+    fmm->fx = NULL;
+    fmm->scratch = NULL;
+    fmm->potential = 0;
+    //the cells are opened by the criterion of this file, not by limit2 of the tree
+    if ( !allocate_tree(capacity, 0, TREE_MONOPOLE, &fmm->tree) ) {
+        return 0;
+    }
+    fmm->tree.leaf_size = FMM_LEAF_SIZE;
+    fmm->fx = ( double * )malloc(sizeof(double) * capacity * 4);
+    fmm->scratch = ( double * )malloc(sizeof(double) * fmm->ncoef * 4);
+    if ( fmm->fx == NULL || fmm->scratch == NULL || !make_tables(fmm) ) {
+        free_fmm(fmm);
+        return 0;
+    }
+    fmm->fy = fmm->fx + capacity;
+    fmm->fz = fmm->fx + capacity * 2;
+    fmm->fp = fmm->fx + capacity * 3;
+    return 1;
+}
+
+void free_fmm(struct Fmm *fmm) {
+    free_tree(&fmm->tree);
+    free(fmm->terms);
+    free(fmm->shift);
+    free(fmm->m2l);
+    free(fmm->multipole);
+    free(fmm->local);
+    free(fmm->radius);
+    free(fmm->fx);
+    free(fmm->scratch);
+    fmm->terms = NULL;
+    fmm->shift = NULL;
+    fmm->m2l = NULL;
+    fmm->multipole = NULL;
+    fmm->local = NULL;
+    fmm->radius = NULL;
+    fmm->fx = NULL;
+    fmm->scratch = NULL;
+    fmm->node_capacity = 0;
+}
+
+/**
+* @fn W̔z񂪖؂̑SẴZێł悤ɂ.
+* @return Ƃ1 sƂ0
+*/
+static int reserve_nodes(struct Fmm *fmm) {
+    const int capacity = fmm->tree.node_capacity;
+    double *multipole, *local, *radius;
+    if ( fmm->tree.node_count <= fmm->node_capacity ) {
+        return 1;
+    }
+    multipole = ( double * )realloc(fmm->multipole, sizeof(double) * fmm->ncoef * capacity);
+    if ( multipole == NULL ) {
+        return 0;
+    }
+    fmm->multipole = multipole;
+    local = ( double * )realloc(fmm->local, sizeof(double) * fmm->ncoef * capacity);
+    if ( local == NULL ) {
+        return 0;
+    }
+    fmm->local = local;
+    radius = ( double * )realloc(fmm->radius, sizeof(double) * capacity);
+    if ( radius == NULL ) {
+        return 0;
+    }
+    fmm->radius = radius;
+    fmm->node_capacity = capacity;
+    PROFILE_COUNT(PROFILE_ALLOCATIONS, 3);
+    return 1;
+}
+
+/**
+* @fn xNgd̊e d^n / n! vZ.
+* @param p vZlޒncoef̔z
+*/
+static void powers(struct Fmm const *fmm, const double dx, const double dy, const double dz, double *p) {
+    const double d[3] = { dx, dy, dz };
+    int j;
+    p[0] = 1;
+    for ( j = 1; j < fmm->ncoef; j++ ) {
+        const struct FmmTerm *t = &fmm->terms[j];
+        const int i = t->n[0] > 0 ? 0 : ( t->n[1] > 0 ? 1 : 2 );
+        p[j] = p[t->lower[i]] * d[i] / t->n[i];
+    }
+}
+
+/**
+* @fn 1/r̕Δ D_n = ^n (1/r) vZ.
+* @detail |n| r^2 D_n = -(2|n|-1)  n_i x_i D_{n-e_i} - (|n|-1)  n_i (n_i-1) D_{n-2e_i}
+* @param d vZlޒncoef̔z
+*/
+static void derivatives(struct Fmm const *fmm, const double dx, const double dy, const double dz, double *d) {
+    const double x[3] = { dx, dy, dz };
+    const double inv2 = 1.0 / ( dx * dx + dy * dy + dz * dz );
+    int j;
+    d[0] = sqrt(inv2);
+    for ( j = 1; j < fmm->ncoef; j++ ) {
+        const struct FmmTerm *t = &fmm->terms[j];
+        //missing lower terms point to D_0 with zero coefficients
+        d[j] = ( t->c1[0] * x[0] * d[t->lower[0]] + t->c2[0] * d[t->lower2[0]]
+            + t->c1[1] * x[1] * d[t->lower[1]] + t->c2[1] * d[t->lower2[1]]
+            + t->c1[2] * x[2] * d[t->lower[2]] + t->c2[2] * d[t->lower2[2]] ) * inv2;
+    }
+}
+
+/**
+* @fn t獪̏ɊeZ̏dS܂̑dɓWJƔavZ(P2M, M2M).
+* @detail q̃Z͐e̔ԍɂ̂, ԍ̑傫ɂǂ΂悢
+*/
+static void upward(struct Fmm *fmm) {
+    struct Tree const *tree = &fmm->tree;
+    double *p = fmm->scratch;
+    int node, j, k;
+    for ( node = tree->node_count - 1; node >= 0; node-- ) {
+        const struct TreeNode *n = &tree->nodes[node];
+        double *m = &fmm->multipole[node * fmm->ncoef];
+        double r2 = 0, radius = 0;
+        memset(m, 0, sizeof(double) * fmm->ncoef);
+        if ( n->m <= 0 ) {
+            fmm->radius[node] = 0;
+            continue;
+        }
+        if ( n->child < 0 ) {
+            for ( k = n->first; k < n->first + n->count; k++ ) {
+                const double dx = tree->px[k] - n->x;
+                const double dy = tree->py[k] - n->y;
+                const double dz = tree->pz[k] - n->z;
+                const double d2 = dx * dx + dy * dy + dz * dz;
+                if ( d2 > r2 ) r2 = d2;
+                powers(fmm, dx, dy, dz, p);
+                for ( j = 0; j < fmm->ncoef; j++ ) {
+                    m[j] += tree->pm[k] * p[j];
+                }
+            }
+            radius = sqrt(r2);
+        } else {
+            for ( k = n->child; k < n->child + 8; k++ ) {
+                const struct TreeNode *c = &tree->nodes[k];
+                double const *mc = &fmm->multipole[k * fmm->ncoef];
+                double dx, dy, dz, d;
+                if ( c->m <= 0 ) {
+                    continue;
+                }
+                dx = c->x - n->x;
+                dy = c->y - n->y;
+                dz = c->z - n->z;
+                d = sqrt(dx * dx + dy * dy + dz * dz) + fmm->radius[k];
+                if ( d > radius ) radius = d;
+                powers(fmm, dx, dy, dz, p);
+                //M_n +=  M'_k d^(n-k) / (n-k)!
+                for ( j = 0; j < fmm->shift_count; j++ ) {
+                    int const *s = &fmm->shift[j * 3];
+                    m[s[0]] += mc[s[1]] * p[s[2]];
+                }
+            }
+        }
+        fmm->radius[node] = radius;
+    }
+}
+
+/**
+* @fn ̗t̃Z̐ǂ̉x𒼐ڑaŉ.
+*/
+static void direct(struct Fmm *fmm, const struct TreeNode *a, const struct TreeNode *b) {
+    struct Tree const *tree = &fmm->tree;
+    struct Softening const *soft = get_force_softening();
+    int i, j;
+    for ( i = a->first; i < a->first + a->count; i++ ) {
+        const double x = tree->px[i], y = tree->py[i], z = tree->pz[i];
+        double fx = 0, fy = 0, fz = 0, fp = 0;
+        for ( j = b->first; j < b->first + b->count; j++ ) {
+            const double dx = tree->px[j] - x;
+            const double dy = tree->py[j] - y;
+            const double dz = tree->pz[j] - z;
+            const double d2 = dx * dx + dy * dy + dz * dz;
+            double s, pot = 0;
+            if ( d2 <= 0 ) {
+                continue;
+            }
+            if ( d2 < soft->h2 ) {
+                //inside the spline kernel
+                s = soften(soft, d2, &pot, NULL);
+            } else {
+                s = 1.0 / ( ( d2 + soft->eps2 ) * sqrt(d2 + soft->eps2) );
+            }
+            fx += tree->pm[j] * s * dx;
+            fy += tree->pm[j] * s * dy;
+            fz += tree->pm[j] * s * dz;
+            fmm->fx[j] -= tree->pm[i] * s * dx;
+            fmm->fy[j] -= tree->pm[i] * s * dy;
+            fmm->fz[j] -= tree->pm[i] * s * dz;
+            if ( fmm->potential ) {
+                const double inv = d2 < soft->h2 ? pot : 1.0 / sqrt(d2 + soft->eps2);
+                fp += tree->pm[j] * inv;
+                fmm->fp[j] += tree->pm[i] * inv;
+            }
+        }
+        fmm->fx[i] += fx;
+        fmm->fy[i] += fy;
+        fmm->fz[i] += fz;
+        fmm->fp[i] += fp;
+    }
+}
+
+/**
+* @fn ̗t̃Z̒̐ǂ̉x𒼐ڑaŉ.
+*/
+static void direct_self(struct Fmm *fmm, const struct TreeNode *a) {
+    struct Tree const *tree = &fmm->tree;
+    struct Softening const *soft = get_force_softening();
+    int i, j;
+    for ( i = a->first; i < a->first + a->count; i++ ) {
+        const double x = tree->px[i], y = tree->py[i], z = tree->pz[i];
+        double fx = 0, fy = 0, fz = 0, fp = 0;
+        for ( j = i + 1; j < a->first + a->count; j++ ) {
+            const double dx = tree->px[j] - x;
+            const double dy = tree->py[j] - y;
+            const double dz = tree->pz[j] - z;
+            const double d2 = dx * dx + dy * dy + dz * dz;
+            double s, pot = 0;
+            if ( d2 <= 0 ) {
+                continue;
+            }
+            if ( d2 < soft->h2 ) {
+                //inside the spline kernel
+                s = soften(soft, d2, &pot, NULL);
+            } else {
+                s = 1.0 / ( ( d2 + soft->eps2 ) * sqrt(d2 + soft->eps2) );
+            }
+            fx += tree->pm[j] * s * dx;
+            fy += tree->pm[j] * s * dy;
+            fz += tree->pm[j] * s * dz;
+            fmm->fx[j] -= tree->pm[i] * s * dx;
+            fmm->fy[j] -= tree->pm[i] * s * dy;
+            fmm->fz[j] -= tree->pm[i] * s * dz;
+            if ( fmm->potential ) {
+                const double inv = d2 < soft->h2 ? pot : 1.0 / sqrt(d2 + soft->eps2);
+                fp += tree->pm[j] * inv;
+                fmm->fp[j] += tree->pm[i] * inv;
+            }
+        }
+        fmm->fx[i] += fx;
+        fmm->fy[i] += fy;
+        fmm->fz[i] += fz;
+        fmm->fp[i] += fp;
+    }
+}
+
+/**
+* @fn قȂ̃Z̊Ԃ̑ݍpvZ.
+* @detail \ĂΌ݂̋ǏWJ֕ϊ, łȂΑ傫̃Zq֕
+*/
+static void interact(struct Fmm *fmm, const int a, const int b) {
+    const struct TreeNode *na = &fmm->tree.nodes[a];
+    const struct TreeNode *nb = &fmm->tree.nodes[b];
+    const double dx = nb->x - na->x;
+    const double dy = nb->y - na->y;
+    const double dz = nb->z - na->z;
+    const double ra = fmm->radius[a], rb = fmm->radius[b];
+    int k;
+    if ( na->m <= 0 || nb->m <= 0 ) {
+        return;
+    }
+    if ( na->count * nb->count * FMM_DIRECT_COST < fmm->m2l_count ) {
+        //direct summation is cheaper than M2L for a few stars
+        direct(fmm, na, nb);
+        PROFILE_COUNT(PROFILE_PAIRS, 2LL * na->count * nb->count);
+    } else if ( ( ra + rb ) * ( ra + rb ) < fmm->theta * fmm->theta * ( dx * dx + dy * dy + dz * dz ) ) {
+        double const *ma = &fmm->multipole[a * fmm->ncoef];
+        double const *mb = &fmm->multipole[b * fmm->ncoef];
+        double *la = &fmm->local[a * fmm->ncoef];
+        double *lb = &fmm->local[b * fmm->ncoef];
+        double *d = fmm->scratch;
+        double *e = fmm->scratch + fmm->ncoef;
+        double *ta = fmm->scratch + fmm->ncoef * 2;
+        double *tb = fmm->scratch + fmm->ncoef * 3;
+        derivatives(fmm, dx, dy, dz, d);
+        //one M2L for each direction
+        PROFILE_COUNT(PROFILE_CELLS, 2);
+        //(-1)^|n| = (-1)^|n+k| (-1)^|k| and D_n(-R) = (-1)^|n| D_n(R), so both directions share
+        //the same derivatives : lb_k += (-1)^|k|  ma_n e_{n+k}, la_k += (-1)^|k|  mb_n d_{n+k}
+        for ( k = 0; k < fmm->ncoef; k++ ) {
+            e[k] = fmm->terms[k].degree & 1 ? -d[k] : d[k];
+            ta[k] = 0;
+            tb[k] = 0;
+        }
+        for ( k = 0; k < fmm->m2l_count; k++ ) {
+            int const *s = &fmm->m2l[k * 3];
+            tb[s[0]] += ma[s[1]] * e[s[2]];
+            ta[s[0]] += mb[s[1]] * d[s[2]];
+        }
+        for ( k = 0; k < fmm->ncoef; k++ ) {
+            if ( fmm->terms[k].degree & 1 ) {
+                la[k] -= ta[k];
+                lb[k] -= tb[k];
+            } else {
+                la[k] += ta[k];
+                lb[k] += tb[k];
+            }
+        }
+    } else if ( na->child < 0 && nb->child < 0 ) {
+        direct(fmm, na, nb);
+        PROFILE_COUNT(PROFILE_PAIRS, 2LL * na->count * nb->count);
+    } else if ( nb->child < 0 || ( na->child >= 0 && ra > rb ) ) {
+        for ( k = na->child; k < na->child + 8; k++ ) {
+            interact(fmm, k, b);
+        }
+    } else {
+        for ( k = nb->child; k < nb->child + 8; k++ ) {
+            interact(fmm, a, k);
+        }
+    }
+}
+
+/**
+* @fn ̃Z̒̑ݍpvZ.
+*/
+static void interact_self(struct Fmm *fmm, const int a) {
+    const struct TreeNode *n = &fmm->tree.nodes[a];
+    int i, j;
+    if ( n->m <= 0 ) {
+        return;
+    }
+    if ( n->child < 0 ) {
+        direct_self(fmm, n);
+        PROFILE_COUNT(PROFILE_PAIRS, ( long long )n->count * ( n->count - 1 ));
+        return;
+    }
+    for ( i = n->child; i < n->child + 8; i++ ) {
+        interact_self(fmm, i);
+        for ( j = i + 1; j < n->child + 8; j++ ) {
+            interact(fmm, i, j);
+        }
+    }
+}
+
+/**
+* @fn t̏ɋǏWJqֈڂ(L2L), t̐̈ʒuŕ](L2P).
+*/
+static void downward(struct Fmm *fmm) {
+    struct Tree const *tree = &fmm->tree;
+    double *p = fmm->scratch;
+    int node, j, k;
+    for ( node = 0; node < tree->node_count; node++ ) {
+        const struct TreeNode *n = &tree->nodes[node];
+        double const *l = &fmm->local[node * fmm->ncoef];
+        if ( n->m <= 0 ) {
+            continue;
+        }
+        if ( n->child >= 0 ) {
+            for ( k = n->child; k < n->child + 8; k++ ) {
+                const struct TreeNode *c = &tree->nodes[k];
+                double *lc = &fmm->local[k * fmm->ncoef];
+                if ( c->m <= 0 ) {
+                    continue;
+                }
+                powers(fmm, c->x - n->x, c->y - n->y, c->z - n->z, p);
+                //L'_k +=  L_n d^(n-k) / (n-k)!
+                for ( j = 0; j < fmm->shift_count; j++ ) {
+                    int const *s = &fmm->shift[j * 3];
+                    lc[s[1]] += l[s[0]] * p[s[2]];
+                }
+            }
+        } else {
+            for ( k = n->first; k < n->first + n->count; k++ ) {
+                double fx = 0, fy = 0, fz = 0;
+                powers(fmm, tree->px[k] - n->x, tree->py[k] - n->y, tree->pz[k] - n->z, p);
+                //ރ =  L_{k+e_i} y^k / k!
+                for ( j = 0; j < fmm->ncoef && fmm->terms[j].degree < fmm->order; j++ ) {
+                    fx += l[fmm->terms[j].upper[0]] * p[j];
+                    fy += l[fmm->terms[j].upper[1]] * p[j];
+                    fz += l[fmm->terms[j].upper[2]] * p[j];
+                }
+                fmm->fx[k] += fx;
+                fmm->fy[k] += fy;
+                fmm->fz[k] += fz;
+                if ( fmm->potential ) {
+                    // =  L_k y^k / k!
+                    double fp = 0;
+                    for ( j = 0; j < fmm->ncoef; j++ ) {
+                        fp += l[j] * p[j];
+                    }
+                    fmm->fp[k] += fp;
+                }
+            }
+        }
+    }
+}
+
+/**
+* @fn SĂ̐̉xdɖ@ŌvZ.
+* @param fmm eʂsizeȏ̍Ɨ̈
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param ax,ay,az vZxޔz
+* @param phi NULLłȂ΃|eV G  m / r ޔz
+* @detail ؂̍\zɎsƂ͒ڑaŌvZ
+*/
+void fmm_accelerations(struct Fmm *fmm, const int size, struct Stars const *stars, double *ax, double *ay, double *az, double *phi) {
+    struct Tree *tree = &fmm->tree;
+    int k;
+    if ( size <= 0 ) {
+        return;
+    }
+    if ( !build_tree(tree, size, stars) || !reserve_nodes(fmm) ) {
+        if ( phi != NULL ) {
+            calc_accelerations_potential_range(size, stars, 0, size, ax, ay, az, phi);
+        } else {
+            calc_accelerations(size, stars, ax, ay, az);
+        }
+        return;
+    }
+    upward(fmm);
+    memset(fmm->local, 0, sizeof(double) * fmm->ncoef * tree->node_count);
+    memset(fmm->fx, 0, sizeof(double) * size);
+    memset(fmm->fy, 0, sizeof(double) * size);
+    memset(fmm->fz, 0, sizeof(double) * size);
+    memset(fmm->fp, 0, sizeof(double) * size);
+    fmm->potential = phi != NULL;
+    interact_self(fmm, 0);
+    downward(fmm);
+    for ( k = 0; k < size; k++ ) {
+        ax[tree->index[k]] = fmm->fx[k] * G;
+        ay[tree->index[k]] = fmm->fy[k] * G;
+        az[tree->index[k]] = fmm->fz[k] * G;
+        if ( phi != NULL ) {
+            phi[tree->index[k]] = fmm->fp[k] * G;
+        }
+    }
+}
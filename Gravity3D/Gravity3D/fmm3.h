@@ -0,0 +1,56 @@
+#pragma once
+#include "tree3.h"
+
+#define FMM_MAX_ORDER 12    // upper limit of the expansion order
+#define FMM_LEAF_SIZE 32    // default max number of stars in a leaf cell
+
+/**
+* fJgW̑dY n = (nx, ny, nz) ŕ\WJ̍
+*/
+struct FmmTerm {
+    int n[3];           // exponents of x, y, z
+    int degree;         // n[0] + n[1] + n[2]
+    int lower[3];       // index of the term n - e_i, 0 if n[i] < 1
+    int lower2[3];      // index of the term n - 2e_i, 0 if n[i] < 2
+    int upper[3];       // index of the term n + e_i, -1 if the degree is the order
+    double c1[3];       // coefficients of the recurrence for the derivatives of 1/r
+    double c2[3];
+};
+
+/**
+* dɖ@̍Ɨ̈. ؂ƊeZ̓WJWێ
+* ̐̏Ŋmۂ, Z̐ƂW̔zL΂
+*/
+struct Fmm {
+    struct Tree tree;   // octree with adaptive leaves
+    double theta;       // opening angle
+    int order;          // expansion order p
+    int ncoef;          // number of the terms of degree <= p
+    struct FmmTerm* terms;
+    int* shift;         // triples (n, k, n-k) for M2M and L2L
+    int shift_count;
+    int* m2l;           // triples (k, n, n+k) with |n| + |k| <= p for M2L
+    int m2l_count;
+    double* multipole;  // ncoef coefficients of each cell
+    double* local;
+    double* radius;     // distance from the center of mass to the farthest star of each cell
+    int node_capacity;  // number of cells the coefficient arrays can hold
+    double* fx;         // acceleration from direct summation (in tree order)
+    double* fy;
+    double* fz;
+    double* fp;         // potential from direct summation and the local expansion (in tree order)
+    int potential;      // nonzero while the current evaluation also sums the potential
+    double* scratch;    // powers, derivatives and sums, 4 * ncoef
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int allocate_fmm(const int capacity, const double theta, const int order, struct Fmm *fmm);
+    void free_fmm(struct Fmm *fmm);
+    void fmm_accelerations(struct Fmm *fmm, const int size, struct Stars const *stars, double *ax, double *ay, double *az, double *phi);
+
+#ifdef __cplusplus
+}
+#endif
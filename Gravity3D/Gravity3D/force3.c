@@ -0,0 +1,1062 @@
+/**
+* @brief SĂ̐̉x𒼐ڑaŌvZJ[l
+* 3
+* @detail
+* j̐FORCE_TILE̃^Cɕ, ^CL1LbVɍڂ܂
+* SĂi̐ɂđݍp𑫂.
+* i̐SIMD[ɕ, j̐u[hLXgēɌvZ.
+* ̋trsqrtߎɃj[g@2Kpċ߂(Ό덷1e-13x).
+* xIԂƑgƂ̍Ƌ̋tfloatŋ(j[g@1), FORCE_FLOAT_BLOCKgƂfloat̘adoubleɑ.
+* Wfloat̏ʂƉʂ̓ɕĎ, ͏ʂǂƉʂǂ̘̍aŋ߂̂, ߂g̍xȂ.
+* float̃[double̔{̂œ̖߂Ŕ{̐𓯎ɌvZ.
+* gp閽߃Zbg͎sCPU𒲂ׂđI.
+* Plummer̓͋2 eps^2 𑫂Ăt߂邾Ȃ̂őSẴJ[lŎg. XvCj̓XJ[ZŌvZ.
+*/
+#include <math.h>
+#include <stdint.h>
+
+#include "force3.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define FORCE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#include <cpuid.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#if !defined(_MSC_VER) || _MSC_VER >= 1911
+#define FORCE_AVX512
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+#define FORCE_TILE 512  // number of j-stars in a tile : 4 arrays * 8 byte * 512 = 16KB
+#define FORCE_FLOAT_BLOCK 64  // pairs summed in float before the sum is added in double, in the mixed precision
+
+const double G = 1.0;  // gravity constant
+
+static int kernel = -1;
+static int precision = FORCE_PRECISION_DOUBLE;
+static struct Softening softening = { FORCE_SOFTENING_PLUMMER, 0, 0, 0, 0 };
+
+/**
+* @fn XJ[ZŉxvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+*/
+static FORCE_INLINE void accelerations_scalar_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const double *m = stars->m;
+    const double *x = stars->x;
+    const double *y = stars->y;
+    const double *z = stars->z;
+    const double eps2 = softening.eps2;
+    int i, j, tile, last;
+    for ( i = begin; i < end; i++ ) {
+        ax[i] = 0;
+        ay[i] = 0;
+        az[i] = 0;
+        if ( phi != NULL ) {
+            phi[i] = 0;
+        }
+    }
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        for ( i = begin; i < end; i++ ) {
+            const double xi = x[i];
+            const double yi = y[i];
+            const double zi = z[i];
+            double sx = 0;
+            double sy = 0;
+            double sz = 0;
+            double sp = 0;
+            for ( j = tile; j < last; j++ ) {
+                const double dx = x[j] - xi;
+                const double dy = y[j] - yi;
+                const double dz = z[j] - zi;
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                //skip the star itself
+                if ( r2 > 0 ) {
+                    const double r2e = r2 + eps2;
+                    const double k = m[j] / ( r2e * sqrt(r2e) );
+                    sx += dx * k;
+                    sy += dy * k;
+                    sz += dz * k;
+                    if ( phi != NULL ) {
+                        sp += m[j] / sqrt(r2e);
+                    }
+                }
+            }
+            ax[i] += sx;
+            ay[i] += sy;
+            az[i] += sz;
+            if ( phi != NULL ) {
+                phi[i] += sp;
+            }
+        }
+    }
+    for ( i = begin; i < end; i++ ) {
+        ax[i] *= G;
+        ay[i] *= G;
+        az[i] *= G;
+        if ( phi != NULL ) {
+            phi[i] *= G;
+        }
+    }
+}
+
+static void accelerations_scalar(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_scalar_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+static void accelerations_scalar_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_scalar_body(size, stars, begin, end, ax, ay, az, phi);
+}
+
+/**
+* @fn XvCjœxXJ[ZŌvZ.
+* @param phi NULLłȂ΃|eV߂ď
+* @detail j̋Ԃŕ򂷂̂SIMDɂ͂, x̎wɂ炸doubleŌvZ
+*/
+static void accelerations_spline(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const double *m = stars->m;
+    const double *x = stars->x;
+    const double *y = stars->y;
+    const double *z = stars->z;
+    int i, j;
+    for ( i = begin; i < end; i++ ) {
+        double sx = 0;
+        double sy = 0;
+        double sz = 0;
+        double sp = 0;
+        for ( j = 0; j < size; j++ ) {
+            const double dx = x[j] - x[i];
+            const double dy = y[j] - y[i];
+            const double dz = z[j] - z[i];
+            const double r2 = dx * dx + dy * dy + dz * dz;
+            //skip the star itself
+            if ( r2 > 0 ) {
+                double p = 0;
+                const double k = m[j] * soften(&softening, r2, phi != NULL ? &p : NULL, NULL);
+                sx += dx * k;
+                sy += dy * k;
+                sz += dz * k;
+                if ( phi != NULL ) {
+                    sp += m[j] * p;
+                }
+            }
+        }
+        ax[i] = sx * G;
+        ay[i] = sy * G;
+        az[i] = sz * G;
+        if ( phi != NULL ) {
+            phi[i] = sp * G;
+        }
+    }
+}
+
+/**
+* x̃J[lgj̐̃^C
+* WdoublefloatɊۂ߂ʂ, ۂ߂̎cfloatɊۂ߂ʂ̓Ŏ (킹48rbgx).
+* gƂ̍͏ʂǂ̍Ɖʂǂ̘̍aŋ߂̂, _⑼̐ǂꂾĂĂ
+* ߂g̍float̑ΐxŋ܂
+*/
+struct FloatTile {
+    float x[FORCE_TILE];    // position rounded to float
+    float y[FORCE_TILE];
+    float z[FORCE_TILE];
+    float lx[FORCE_TILE];   // the rest of the position rounded to float
+    float ly[FORCE_TILE];
+    float lz[FORCE_TILE];
+    float m[FORCE_TILE];
+};
+
+/**
+* @fn j̐̃^Cfloatɕϊ.
+* @param tile, last ^C͈̐̔
+*/
+static void load_tile(struct Stars const *stars, const int tile, const int last, struct FloatTile *t) {
+    int j;
+    for ( j = tile; j < last; j++ ) {
+        t->x[j - tile] = ( float )stars->x[j];
+        t->y[j - tile] = ( float )stars->y[j];
+        t->z[j - tile] = ( float )stars->z[j];
+        t->lx[j - tile] = ( float )( stars->x[j] - t->x[j - tile] );
+        t->ly[j - tile] = ( float )( stars->y[j] - t->y[j - tile] );
+        t->lz[j - tile] = ( float )( stars->z[j] - t->z[j - tile] );
+        t->m[j - tile] = ( float )stars->m[j];
+    }
+}
+
+/**
+* @fn XJ[Z̍xŉxvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+* @detail gƂ̌vZfloat, FORCE_FLOAT_BLOCKgƂfloat̘adoubleɑ
+*/
+static FORCE_INLINE void accelerations_scalar_mixed_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    struct FloatTile t;
+    const float eps2 = ( float )softening.eps2;
+    int i, j, block, stop, tile, last;
+    for ( i = begin; i < end; i++ ) {
+        ax[i] = 0;
+        ay[i] = 0;
+        az[i] = 0;
+        if ( phi != NULL ) {
+            phi[i] = 0;
+        }
+    }
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        load_tile(stars, tile, last, &t);
+        for ( i = begin; i < end; i++ ) {
+            //split the same way as the tile
+            const float xi = ( float )stars->x[i];
+            const float yi = ( float )stars->y[i];
+            const float zi = ( float )stars->z[i];
+            const float lxi = ( float )( stars->x[i] - xi );
+            const float lyi = ( float )( stars->y[i] - yi );
+            const float lzi = ( float )( stars->z[i] - zi );
+            for ( block = 0; block < last - tile; block += FORCE_FLOAT_BLOCK ) {
+                float sx = 0;
+                float sy = 0;
+                float sz = 0;
+                float sp = 0;
+                stop = block + FORCE_FLOAT_BLOCK < last - tile ? block + FORCE_FLOAT_BLOCK : last - tile;
+                for ( j = block; j < stop; j++ ) {
+                    const float dx = ( t.x[j] - xi ) + ( t.lx[j] - lxi );
+                    const float dy = ( t.y[j] - yi ) + ( t.ly[j] - lyi );
+                    const float dz = ( t.z[j] - zi ) + ( t.lz[j] - lzi );
+                    const float r2 = dx * dx + dy * dy + dz * dz;
+                    //skip the star itself
+                    if ( r2 > 0 ) {
+                        const float r2e = r2 + eps2;
+                        const float k = t.m[j] / ( r2e * sqrtf(r2e) );
+                        sx += dx * k;
+                        sy += dy * k;
+                        sz += dz * k;
+                        if ( phi != NULL ) {
+                            sp += t.m[j] / sqrtf(r2e);
+                        }
+                    }
+                }
+                ax[i] += sx;
+                ay[i] += sy;
+                az[i] += sz;
+                if ( phi != NULL ) {
+                    phi[i] += sp;
+                }
+            }
+        }
+    }
+    for ( i = begin; i < end; i++ ) {
+        ax[i] *= G;
+        ay[i] *= G;
+        az[i] *= G;
+        if ( phi != NULL ) {
+            phi[i] *= G;
+        }
+    }
+}
+
+static void accelerations_scalar_mixed(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_scalar_mixed_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+static void accelerations_scalar_mixed_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_scalar_mixed_body(size, stars, begin, end, ax, ay, az, phi);
+}
+
+#ifdef FORCE_X86
+
+/**
+* @fn SSE2ňx2̐̉xvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+*/
+TARGET_SSE2 static FORCE_INLINE void accelerations_sse2_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const double *m = stars->m;
+    const double *x = stars->x;
+    const double *y = stars->y;
+    const double *z = stars->z;
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d three_half = _mm_set1_pd(1.5);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d eps2 = _mm_set1_pd(softening.eps2);
+    const __m128d g = _mm_set1_pd(G);
+    int i, j, tile, last;
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        for ( i = begin; i < end; i += 2 ) {
+            const __m128d xi = _mm_loadu_pd(&x[i]);
+            const __m128d yi = _mm_loadu_pd(&y[i]);
+            const __m128d zi = _mm_loadu_pd(&z[i]);
+            __m128d sx = tile == 0 ? zero : _mm_loadu_pd(&ax[i]);
+            __m128d sy = tile == 0 ? zero : _mm_loadu_pd(&ay[i]);
+            __m128d sz = tile == 0 ? zero : _mm_loadu_pd(&az[i]);
+            __m128d sp = tile == 0 || phi == NULL ? zero : _mm_loadu_pd(&phi[i]);
+            for ( j = tile; j < last; j++ ) {
+                const __m128d dx = _mm_sub_pd(_mm_set1_pd(x[j]), xi);
+                const __m128d dy = _mm_sub_pd(_mm_set1_pd(y[j]), yi);
+                const __m128d dz = _mm_sub_pd(_mm_set1_pd(z[j]), zi);
+                const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+                const __m128d r2e = _mm_add_pd(r2, eps2);
+                //1/sqrt(r2 + eps^2) : approximation in float then 2 Newton steps
+                __m128d inv = _mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(r2e)));
+                __m128d hr2 = _mm_mul_pd(half, r2e);
+                __m128d k, other;
+                inv = _mm_mul_pd(inv, _mm_sub_pd(three_half, _mm_mul_pd(hr2, _mm_mul_pd(inv, inv))));
+                inv = _mm_mul_pd(inv, _mm_sub_pd(three_half, _mm_mul_pd(hr2, _mm_mul_pd(inv, inv))));
+                k = _mm_mul_pd(_mm_set1_pd(m[j]), _mm_mul_pd(inv, _mm_mul_pd(inv, inv)));
+                //skip the star itself (r2 == 0 gives NaN above)
+                other = _mm_cmpgt_pd(r2, zero);
+                k = _mm_and_pd(k, other);
+                sx = _mm_add_pd(sx, _mm_mul_pd(dx, k));
+                sy = _mm_add_pd(sy, _mm_mul_pd(dy, k));
+                sz = _mm_add_pd(sz, _mm_mul_pd(dz, k));
+                if ( phi != NULL ) {
+                    sp = _mm_add_pd(sp, _mm_and_pd(_mm_mul_pd(_mm_set1_pd(m[j]), inv), other));
+                }
+            }
+            if ( last == size ) {
+                sx = _mm_mul_pd(sx, g);
+                sy = _mm_mul_pd(sy, g);
+                sz = _mm_mul_pd(sz, g);
+                sp = _mm_mul_pd(sp, g);
+            }
+            _mm_storeu_pd(&ax[i], sx);
+            _mm_storeu_pd(&ay[i], sy);
+            _mm_storeu_pd(&az[i], sz);
+            if ( phi != NULL ) {
+                _mm_storeu_pd(&phi[i], sp);
+            }
+        }
+    }
+}
+
+TARGET_SSE2 static void accelerations_sse2(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_sse2_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+TARGET_SSE2 static void accelerations_sse2_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_sse2_body(size, stars, begin, end, ax, ay, az, phi);
+}
+
+/**
+* @fn AVX2ňx4̐̉xvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+*/
+TARGET_AVX2 static FORCE_INLINE void accelerations_avx2_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const double *m = stars->m;
+    const double *x = stars->x;
+    const double *y = stars->y;
+    const double *z = stars->z;
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_half = _mm256_set1_pd(1.5);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d eps2 = _mm256_set1_pd(softening.eps2);
+    const __m256d g = _mm256_set1_pd(G);
+    int i, j, tile, last;
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        for ( i = begin; i < end; i += 4 ) {
+            const __m256d xi = _mm256_loadu_pd(&x[i]);
+            const __m256d yi = _mm256_loadu_pd(&y[i]);
+            const __m256d zi = _mm256_loadu_pd(&z[i]);
+            __m256d sx = tile == 0 ? zero : _mm256_loadu_pd(&ax[i]);
+            __m256d sy = tile == 0 ? zero : _mm256_loadu_pd(&ay[i]);
+            __m256d sz = tile == 0 ? zero : _mm256_loadu_pd(&az[i]);
+            __m256d sp = tile == 0 || phi == NULL ? zero : _mm256_loadu_pd(&phi[i]);
+            for ( j = tile; j < last; j++ ) {
+                const __m256d dx = _mm256_sub_pd(_mm256_broadcast_sd(&x[j]), xi);
+                const __m256d dy = _mm256_sub_pd(_mm256_broadcast_sd(&y[j]), yi);
+                const __m256d dz = _mm256_sub_pd(_mm256_broadcast_sd(&z[j]), zi);
+                const __m256d r2 = _mm256_fmadd_pd(dz, dz, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx)));
+                const __m256d r2e = _mm256_add_pd(r2, eps2);
+                //1/sqrt(r2 + eps^2) : approximation in float then 2 Newton steps
+                __m256d inv = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2e)));
+                __m256d hr2 = _mm256_mul_pd(half, r2e);
+                __m256d k, other;
+                inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_half));
+                inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_half));
+                k = _mm256_mul_pd(_mm256_broadcast_sd(&m[j]), _mm256_mul_pd(inv, _mm256_mul_pd(inv, inv)));
+                //skip the star itself (r2 == 0 gives NaN above)
+                other = _mm256_cmp_pd(r2, zero, _CMP_GT_OQ);
+                k = _mm256_and_pd(k, other);
+                sx = _mm256_fmadd_pd(dx, k, sx);
+                sy = _mm256_fmadd_pd(dy, k, sy);
+                sz = _mm256_fmadd_pd(dz, k, sz);
+                if ( phi != NULL ) {
+                    sp = _mm256_add_pd(sp, _mm256_and_pd(_mm256_mul_pd(_mm256_broadcast_sd(&m[j]), inv), other));
+                }
+            }
+            if ( last == size ) {
+                sx = _mm256_mul_pd(sx, g);
+                sy = _mm256_mul_pd(sy, g);
+                sz = _mm256_mul_pd(sz, g);
+                sp = _mm256_mul_pd(sp, g);
+            }
+            _mm256_storeu_pd(&ax[i], sx);
+            _mm256_storeu_pd(&ay[i], sy);
+            _mm256_storeu_pd(&az[i], sz);
+            if ( phi != NULL ) {
+                _mm256_storeu_pd(&phi[i], sp);
+            }
+        }
+    }
+}
+
+TARGET_AVX2 static void accelerations_avx2(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_avx2_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+TARGET_AVX2 static void accelerations_avx2_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_avx2_body(size, stars, begin, end, ax, ay, az, phi);
+}
+
+#ifdef FORCE_AVX512
+/**
+* @fn AVX-512ňx8̐̉xvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+*/
+TARGET_AVX512 static FORCE_INLINE void accelerations_avx512_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const double *m = stars->m;
+    const double *x = stars->x;
+    const double *y = stars->y;
+    const double *z = stars->z;
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_half = _mm512_set1_pd(1.5);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d eps2 = _mm512_set1_pd(softening.eps2);
+    const __m512d g = _mm512_set1_pd(G);
+    int i, j, tile, last;
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        for ( i = begin; i < end; i += 8 ) {
+            const __m512d xi = _mm512_loadu_pd(&x[i]);
+            const __m512d yi = _mm512_loadu_pd(&y[i]);
+            const __m512d zi = _mm512_loadu_pd(&z[i]);
+            __m512d sx = tile == 0 ? zero : _mm512_loadu_pd(&ax[i]);
+            __m512d sy = tile == 0 ? zero : _mm512_loadu_pd(&ay[i]);
+            __m512d sz = tile == 0 ? zero : _mm512_loadu_pd(&az[i]);
+            __m512d sp = tile == 0 || phi == NULL ? zero : _mm512_loadu_pd(&phi[i]);
+            for ( j = tile; j < last; j++ ) {
+                const __m512d dx = _mm512_sub_pd(_mm512_set1_pd(x[j]), xi);
+                const __m512d dy = _mm512_sub_pd(_mm512_set1_pd(y[j]), yi);
+                const __m512d dz = _mm512_sub_pd(_mm512_set1_pd(z[j]), zi);
+                const __m512d r2 = _mm512_fmadd_pd(dz, dz, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx)));
+                const __m512d r2e = _mm512_add_pd(r2, eps2);
+                //skip the star itself
+                const __mmask8 other = _mm512_cmp_pd_mask(r2, zero, _CMP_GT_OQ);
+                //1/sqrt(r2 + eps^2) : 14bit approximation then 2 Newton steps
+                __m512d inv = _mm512_rsqrt14_pd(r2e);
+                __m512d hr2 = _mm512_mul_pd(half, r2e);
+                __m512d k;
+                inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_half));
+                inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_half));
+                k = _mm512_maskz_mul_pd(other, _mm512_set1_pd(m[j]), _mm512_mul_pd(inv, _mm512_mul_pd(inv, inv)));
+                sx = _mm512_fmadd_pd(dx, k, sx);
+                sy = _mm512_fmadd_pd(dy, k, sy);
+                sz = _mm512_fmadd_pd(dz, k, sz);
+                if ( phi != NULL ) {
+                    sp = _mm512_add_pd(sp, _mm512_maskz_mul_pd(other, _mm512_set1_pd(m[j]), inv));
+                }
+            }
+            if ( last == size ) {
+                sx = _mm512_mul_pd(sx, g);
+                sy = _mm512_mul_pd(sy, g);
+                sz = _mm512_mul_pd(sz, g);
+                sp = _mm512_mul_pd(sp, g);
+            }
+            _mm512_storeu_pd(&ax[i], sx);
+            _mm512_storeu_pd(&ay[i], sy);
+            _mm512_storeu_pd(&az[i], sz);
+            if ( phi != NULL ) {
+                _mm512_storeu_pd(&phi[i], sp);
+            }
+        }
+    }
+}
+
+TARGET_AVX512 static void accelerations_avx512(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_avx512_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+TARGET_AVX512 static void accelerations_avx512_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_avx512_body(size, stars, begin, end, ax, ay, az, phi);
+}
+#endif
+
+/**
+* @fn 4doubleload_tileƓfloat̏ʂƉʂɕ.
+*/
+TARGET_SSE2 static FORCE_INLINE void split_sse2(double const *p, __m128 *high, __m128 *low) {
+    const __m128d a = _mm_loadu_pd(p);
+    const __m128d b = _mm_loadu_pd(p + 2);
+    const __m128 h = _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b));
+    *high = h;
+    *low = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(a, _mm_cvtps_pd(h))), _mm_cvtpd_ps(_mm_sub_pd(b, _mm_cvtps_pd(_mm_movehl_ps(h, h)))));
+}
+
+/**
+* @fn SSE2̍xňx4̐̉xvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+*/
+TARGET_SSE2 static FORCE_INLINE void accelerations_sse2_mixed_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 three_half = _mm_set1_ps(1.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 eps2 = _mm_set1_ps(( float )softening.eps2);
+    const __m128d g = _mm_set1_pd(G);
+    struct FloatTile t;
+    int i, j, block, stop, tile, last;
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        load_tile(stars, tile, last, &t);
+        for ( i = begin; i < end; i += 4 ) {
+            __m128 xi, yi, zi, lxi, lyi, lzi;
+            __m128d ax_lo = _mm_setzero_pd(), ax_hi = _mm_setzero_pd();
+            __m128d ay_lo = _mm_setzero_pd(), ay_hi = _mm_setzero_pd();
+            __m128d az_lo = _mm_setzero_pd(), az_hi = _mm_setzero_pd();
+            __m128d phi_lo = _mm_setzero_pd(), phi_hi = _mm_setzero_pd();
+            split_sse2(&stars->x[i], &xi, &lxi);
+            split_sse2(&stars->y[i], &yi, &lyi);
+            split_sse2(&stars->z[i], &zi, &lzi);
+            for ( block = 0; block < last - tile; block += FORCE_FLOAT_BLOCK ) {
+                __m128 sx = zero;
+                __m128 sy = zero;
+                __m128 sz = zero;
+                __m128 sp = zero;
+                stop = block + FORCE_FLOAT_BLOCK < last - tile ? block + FORCE_FLOAT_BLOCK : last - tile;
+                for ( j = block; j < stop; j++ ) {
+                    const __m128 dx = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(t.x[j]), xi), _mm_sub_ps(_mm_set1_ps(t.lx[j]), lxi));
+                    const __m128 dy = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(t.y[j]), yi), _mm_sub_ps(_mm_set1_ps(t.ly[j]), lyi));
+                    const __m128 dz = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(t.z[j]), zi), _mm_sub_ps(_mm_set1_ps(t.lz[j]), lzi));
+                    const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    const __m128 r2e = _mm_add_ps(r2, eps2);
+                    //1/sqrt(r2 + eps^2) : 12bit approximation then 1 Newton step
+                    __m128 inv = _mm_rsqrt_ps(r2e);
+                    __m128 k;
+                    inv = _mm_mul_ps(inv, _mm_sub_ps(three_half, _mm_mul_ps(_mm_mul_ps(half, r2e), _mm_mul_ps(inv, inv))));
+                    k = _mm_mul_ps(_mm_set1_ps(t.m[j]), _mm_mul_ps(inv, _mm_mul_ps(inv, inv)));
+                    //skip the star itself (r2 == 0 gives NaN above)
+                    k = _mm_and_ps(k, _mm_cmpgt_ps(r2, zero));
+                    sx = _mm_add_ps(sx, _mm_mul_ps(dx, k));
+                    sy = _mm_add_ps(sy, _mm_mul_ps(dy, k));
+                    sz = _mm_add_ps(sz, _mm_mul_ps(dz, k));
+                    if ( phi != NULL ) {
+                        sp = _mm_add_ps(sp, _mm_and_ps(_mm_mul_ps(_mm_set1_ps(t.m[j]), inv), _mm_cmpgt_ps(r2, zero)));
+                    }
+                }
+                //add the sums of the block in double
+#define ADD_BLOCK_SSE2(s, lo, hi) \
+                lo = _mm_add_pd(lo, _mm_cvtps_pd(s)); \
+                hi = _mm_add_pd(hi, _mm_cvtps_pd(_mm_movehl_ps(s, s)));
+                ADD_BLOCK_SSE2(sx, ax_lo, ax_hi)
+                ADD_BLOCK_SSE2(sy, ay_lo, ay_hi)
+                ADD_BLOCK_SSE2(sz, az_lo, az_hi)
+                if ( phi != NULL ) {
+                    ADD_BLOCK_SSE2(sp, phi_lo, phi_hi)
+                }
+#undef ADD_BLOCK_SSE2
+            }
+#define STORE_TILE_SSE2(lo, hi, a) \
+            if ( tile > 0 ) { \
+                lo = _mm_add_pd(lo, _mm_loadu_pd(&a[i])); \
+                hi = _mm_add_pd(hi, _mm_loadu_pd(&a[i + 2])); \
+            } \
+            if ( last == size ) { \
+                lo = _mm_mul_pd(lo, g); \
+                hi = _mm_mul_pd(hi, g); \
+            } \
+            _mm_storeu_pd(&a[i], lo); \
+            _mm_storeu_pd(&a[i + 2], hi);
+            STORE_TILE_SSE2(ax_lo, ax_hi, ax)
+            STORE_TILE_SSE2(ay_lo, ay_hi, ay)
+            STORE_TILE_SSE2(az_lo, az_hi, az)
+            if ( phi != NULL ) {
+                STORE_TILE_SSE2(phi_lo, phi_hi, phi)
+            }
+#undef STORE_TILE_SSE2
+        }
+    }
+}
+
+TARGET_SSE2 static void accelerations_sse2_mixed(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_sse2_mixed_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+TARGET_SSE2 static void accelerations_sse2_mixed_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_sse2_mixed_body(size, stars, begin, end, ax, ay, az, phi);
+}
+
+/**
+* @fn 8doubleload_tileƓfloat̏ʂƉʂɕ.
+*/
+TARGET_AVX2 static FORCE_INLINE void split_avx2(double const *p, __m256 *high, __m256 *low) {
+    const __m256d a = _mm256_loadu_pd(p);
+    const __m256d b = _mm256_loadu_pd(p + 4);
+    const __m128 ha = _mm256_cvtpd_ps(a);
+    const __m128 hb = _mm256_cvtpd_ps(b);
+    *high = _mm256_set_m128(hb, ha);
+    *low = _mm256_set_m128(_mm256_cvtpd_ps(_mm256_sub_pd(b, _mm256_cvtps_pd(hb))), _mm256_cvtpd_ps(_mm256_sub_pd(a, _mm256_cvtps_pd(ha))));
+}
+
+/**
+* @fn AVX2̍xňx8̐̉xvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+*/
+TARGET_AVX2 static FORCE_INLINE void accelerations_avx2_mixed_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_half = _mm256_set1_ps(1.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps2 = _mm256_set1_ps(( float )softening.eps2);
+    const __m256d g = _mm256_set1_pd(G);
+    struct FloatTile t;
+    int i, j, block, stop, tile, last;
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        load_tile(stars, tile, last, &t);
+        for ( i = begin; i < end; i += 8 ) {
+            __m256 xi, yi, zi, lxi, lyi, lzi;
+            __m256d ax_lo = _mm256_setzero_pd(), ax_hi = _mm256_setzero_pd();
+            __m256d ay_lo = _mm256_setzero_pd(), ay_hi = _mm256_setzero_pd();
+            __m256d az_lo = _mm256_setzero_pd(), az_hi = _mm256_setzero_pd();
+            __m256d phi_lo = _mm256_setzero_pd(), phi_hi = _mm256_setzero_pd();
+            split_avx2(&stars->x[i], &xi, &lxi);
+            split_avx2(&stars->y[i], &yi, &lyi);
+            split_avx2(&stars->z[i], &zi, &lzi);
+            for ( block = 0; block < last - tile; block += FORCE_FLOAT_BLOCK ) {
+                __m256 sx = zero;
+                __m256 sy = zero;
+                __m256 sz = zero;
+                __m256 sp = zero;
+                stop = block + FORCE_FLOAT_BLOCK < last - tile ? block + FORCE_FLOAT_BLOCK : last - tile;
+                for ( j = block; j < stop; j++ ) {
+                    const __m256 dx = _mm256_add_ps(_mm256_sub_ps(_mm256_broadcast_ss(&t.x[j]), xi), _mm256_sub_ps(_mm256_broadcast_ss(&t.lx[j]), lxi));
+                    const __m256 dy = _mm256_add_ps(_mm256_sub_ps(_mm256_broadcast_ss(&t.y[j]), yi), _mm256_sub_ps(_mm256_broadcast_ss(&t.ly[j]), lyi));
+                    const __m256 dz = _mm256_add_ps(_mm256_sub_ps(_mm256_broadcast_ss(&t.z[j]), zi), _mm256_sub_ps(_mm256_broadcast_ss(&t.lz[j]), lzi));
+                    const __m256 r2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+                    const __m256 r2e = _mm256_add_ps(r2, eps2);
+                    //1/sqrt(r2 + eps^2) : 12bit approximation then 1 Newton step
+                    __m256 inv = _mm256_rsqrt_ps(r2e);
+                    __m256 k;
+                    inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2e), _mm256_mul_ps(inv, inv), three_half));
+                    k = _mm256_mul_ps(_mm256_broadcast_ss(&t.m[j]), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)));
+                    //skip the star itself (r2 == 0 gives NaN above)
+                    k = _mm256_and_ps(k, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ));
+                    sx = _mm256_fmadd_ps(dx, k, sx);
+                    sy = _mm256_fmadd_ps(dy, k, sy);
+                    sz = _mm256_fmadd_ps(dz, k, sz);
+                    if ( phi != NULL ) {
+                        sp = _mm256_fmadd_ps(_mm256_broadcast_ss(&t.m[j]), _mm256_and_ps(inv, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ)), sp);
+                    }
+                }
+                //add the sums of the block in double
+#define ADD_BLOCK_AVX2(s, lo, hi) \
+                lo = _mm256_add_pd(lo, _mm256_cvtps_pd(_mm256_castps256_ps128(s))); \
+                hi = _mm256_add_pd(hi, _mm256_cvtps_pd(_mm256_extractf128_ps(s, 1)));
+                ADD_BLOCK_AVX2(sx, ax_lo, ax_hi)
+                ADD_BLOCK_AVX2(sy, ay_lo, ay_hi)
+                ADD_BLOCK_AVX2(sz, az_lo, az_hi)
+                if ( phi != NULL ) {
+                    ADD_BLOCK_AVX2(sp, phi_lo, phi_hi)
+                }
+#undef ADD_BLOCK_AVX2
+            }
+#define STORE_TILE_AVX2(lo, hi, a) \
+            if ( tile > 0 ) { \
+                lo = _mm256_add_pd(lo, _mm256_loadu_pd(&a[i])); \
+                hi = _mm256_add_pd(hi, _mm256_loadu_pd(&a[i + 4])); \
+            } \
+            if ( last == size ) { \
+                lo = _mm256_mul_pd(lo, g); \
+                hi = _mm256_mul_pd(hi, g); \
+            } \
+            _mm256_storeu_pd(&a[i], lo); \
+            _mm256_storeu_pd(&a[i + 4], hi);
+            STORE_TILE_AVX2(ax_lo, ax_hi, ax)
+            STORE_TILE_AVX2(ay_lo, ay_hi, ay)
+            STORE_TILE_AVX2(az_lo, az_hi, az)
+            if ( phi != NULL ) {
+                STORE_TILE_AVX2(phi_lo, phi_hi, phi)
+            }
+#undef STORE_TILE_AVX2
+        }
+    }
+}
+
+TARGET_AVX2 static void accelerations_avx2_mixed(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_avx2_mixed_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+TARGET_AVX2 static void accelerations_avx2_mixed_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_avx2_mixed_body(size, stars, begin, end, ax, ay, az, phi);
+}
+
+#ifdef FORCE_AVX512
+/**
+* @fn 16doubleload_tileƓfloat̏ʂƉʂɕ.
+* @param upper 0̂Ƃ㔼8͓ǂ܂0Ƃ
+*/
+TARGET_AVX512 static FORCE_INLINE void split_avx512(double const *p, const int upper, __m512 *high, __m512 *low) {
+    const __m512d a = _mm512_loadu_pd(p);
+    const __m512d b = upper ? _mm512_loadu_pd(p + 8) : _mm512_setzero_pd();
+    const __m256 ha = _mm512_cvtpd_ps(a);
+    const __m256 hb = _mm512_cvtpd_ps(b);
+    const __m256 la = _mm512_cvtpd_ps(_mm512_sub_pd(a, _mm512_cvtps_pd(ha)));
+    const __m256 lb = _mm512_cvtpd_ps(_mm512_sub_pd(b, _mm512_cvtps_pd(hb)));
+#define JOIN_AVX512(lo, hi) _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(lo)), _mm256_castps_pd(hi), 1))
+    *high = JOIN_AVX512(ha, hb);
+    *low = JOIN_AVX512(la, lb);
+#undef JOIN_AVX512
+}
+
+/**
+* @fn AVX-512̍xňx16̐̉xvZ.
+* @param phi NULLłȂΓǧvZŃ|eV G  m_j / r_ij ߂ď
+* @detail Ō8̐͌㔼̃[gȂ
+*/
+TARGET_AVX512 static FORCE_INLINE void accelerations_avx512_mixed_body(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 three_half = _mm512_set1_ps(1.5f);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 eps2 = _mm512_set1_ps(( float )softening.eps2);
+    const __m512d g = _mm512_set1_pd(G);
+    struct FloatTile t;
+    int i, j, block, stop, tile, last;
+    for ( tile = 0; tile < size; tile += FORCE_TILE ) {
+        last = tile + FORCE_TILE < size ? tile + FORCE_TILE : size;
+        load_tile(stars, tile, last, &t);
+        for ( i = begin; i < end; i += 16 ) {
+            const int upper = i + 8 < end;
+            __m512 xi, yi, zi, lxi, lyi, lzi;
+            __m512d ax_lo = _mm512_setzero_pd(), ax_hi = _mm512_setzero_pd();
+            __m512d ay_lo = _mm512_setzero_pd(), ay_hi = _mm512_setzero_pd();
+            __m512d az_lo = _mm512_setzero_pd(), az_hi = _mm512_setzero_pd();
+            __m512d phi_lo = _mm512_setzero_pd(), phi_hi = _mm512_setzero_pd();
+            split_avx512(&stars->x[i], upper, &xi, &lxi);
+            split_avx512(&stars->y[i], upper, &yi, &lyi);
+            split_avx512(&stars->z[i], upper, &zi, &lzi);
+            for ( block = 0; block < last - tile; block += FORCE_FLOAT_BLOCK ) {
+                __m512 sx = zero;
+                __m512 sy = zero;
+                __m512 sz = zero;
+                __m512 sp = zero;
+                stop = block + FORCE_FLOAT_BLOCK < last - tile ? block + FORCE_FLOAT_BLOCK : last - tile;
+                for ( j = block; j < stop; j++ ) {
+                    const __m512 dx = _mm512_add_ps(_mm512_sub_ps(_mm512_set1_ps(t.x[j]), xi), _mm512_sub_ps(_mm512_set1_ps(t.lx[j]), lxi));
+                    const __m512 dy = _mm512_add_ps(_mm512_sub_ps(_mm512_set1_ps(t.y[j]), yi), _mm512_sub_ps(_mm512_set1_ps(t.ly[j]), lyi));
+                    const __m512 dz = _mm512_add_ps(_mm512_sub_ps(_mm512_set1_ps(t.z[j]), zi), _mm512_sub_ps(_mm512_set1_ps(t.lz[j]), lzi));
+                    const __m512 r2 = _mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)));
+                    const __m512 r2e = _mm512_add_ps(r2, eps2);
+                    //skip the star itself
+                    const __mmask16 other = _mm512_cmp_ps_mask(r2, zero, _CMP_GT_OQ);
+                    //1/sqrt(r2 + eps^2) : 14bit approximation then 1 Newton step
+                    __m512 inv = _mm512_rsqrt14_ps(r2e);
+                    __m512 k;
+                    inv = _mm512_mul_ps(inv, _mm512_fnmadd_ps(_mm512_mul_ps(half, r2e), _mm512_mul_ps(inv, inv), three_half));
+                    k = _mm512_maskz_mul_ps(other, _mm512_set1_ps(t.m[j]), _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv)));
+                    sx = _mm512_fmadd_ps(dx, k, sx);
+                    sy = _mm512_fmadd_ps(dy, k, sy);
+                    sz = _mm512_fmadd_ps(dz, k, sz);
+                    if ( phi != NULL ) {
+                        sp = _mm512_add_ps(sp, _mm512_maskz_mul_ps(other, _mm512_set1_ps(t.m[j]), inv));
+                    }
+                }
+                //add the sums of the block in double
+#define ADD_BLOCK_AVX512(s, lo, hi) \
+                lo = _mm512_add_pd(lo, _mm512_cvtps_pd(_mm512_castps512_ps256(s))); \
+                hi = _mm512_add_pd(hi, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(s), 1))));
+                ADD_BLOCK_AVX512(sx, ax_lo, ax_hi)
+                ADD_BLOCK_AVX512(sy, ay_lo, ay_hi)
+                ADD_BLOCK_AVX512(sz, az_lo, az_hi)
+                if ( phi != NULL ) {
+                    ADD_BLOCK_AVX512(sp, phi_lo, phi_hi)
+                }
+#undef ADD_BLOCK_AVX512
+            }
+#define STORE_TILE_AVX512(lo, hi, a) \
+            if ( tile > 0 ) { \
+                lo = _mm512_add_pd(lo, _mm512_loadu_pd(&a[i])); \
+                hi = upper ? _mm512_add_pd(hi, _mm512_loadu_pd(&a[i + 8])) : hi; \
+            } \
+            if ( last == size ) { \
+                lo = _mm512_mul_pd(lo, g); \
+                hi = _mm512_mul_pd(hi, g); \
+            } \
+            _mm512_storeu_pd(&a[i], lo); \
+            if ( upper ) { \
+                _mm512_storeu_pd(&a[i + 8], hi); \
+            }
+            STORE_TILE_AVX512(ax_lo, ax_hi, ax)
+            STORE_TILE_AVX512(ay_lo, ay_hi, ay)
+            STORE_TILE_AVX512(az_lo, az_hi, az)
+            if ( phi != NULL ) {
+                STORE_TILE_AVX512(phi_lo, phi_hi, phi)
+            }
+#undef STORE_TILE_AVX512
+        }
+    }
+}
+
+TARGET_AVX512 static void accelerations_avx512_mixed(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    accelerations_avx512_mixed_body(size, stars, begin, end, ax, ay, az, NULL);
+}
+
+TARGET_AVX512 static void accelerations_avx512_mixed_potential(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    accelerations_avx512_mixed_body(size, stars, begin, end, ax, ay, az, phi);
+}
+#endif
+
+static void cpuid(int leaf, int sub, unsigned int reg[4]) {
+#ifdef _MSC_VER
+    __cpuidex(( int * )reg, leaf, sub);
+#else
+    __cpuid_count(leaf, sub, reg[0], reg[1], reg[2], reg[3]);
+#endif
+}
+
+static unsigned long long xgetbv(void) {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+    return ( ( unsigned long long )edx << 32 ) | eax;
+#endif
+}
+
+#endif
+
+/**
+* @fn sCPUOSΉł̍LJ[l𒲂ׂ.
+* @return FORCE_KERNEL_*̂ꂩ
+*/
+int detect_force_kernel(void) {
+    int result = FORCE_KERNEL_SCALAR;
+#ifdef FORCE_X86
+    unsigned int reg[4];
+    unsigned long long xcr0 = 0;
+    cpuid(0, 0, reg);
+    const unsigned int max_leaf = reg[0];
+    cpuid(1, 0, reg);
+    if ( reg[3] & ( 1u << 26 ) ) {
+        result = FORCE_KERNEL_SSE2;
+    }
+    //OSXSAVE : the OS saves the extended registers on context switch
+    if ( !( reg[2] & ( 1u << 27 ) ) || max_leaf < 7 ) {
+        return result;
+    }
+    xcr0 = xgetbv();
+    const int fma = ( reg[2] & ( 1u << 12 ) ) != 0;
+    cpuid(7, 0, reg);
+    if ( fma && ( reg[1] & ( 1u << 5 ) ) && ( xcr0 & 0x06 ) == 0x06 ) {
+        result = FORCE_KERNEL_AVX2;
+    }
+#ifdef FORCE_AVX512
+    if ( ( reg[1] & ( 1u << 16 ) ) && ( xcr0 & 0xe6 ) == 0xe6 ) {
+        result = FORCE_KERNEL_AVX512;
+    }
+#endif
+#endif
+    return result;
+}
+
+/**
+* @fn x̌vZɎgJ[lw肷.
+* @param request gJ[l CPUΉĂȂΑΉł̍L̂ɗƂ
+* @return ۂɑIꂽJ[l
+*/
+int set_force_kernel(const int request) {
+    const int available = detect_force_kernel();
+    kernel = request < available ? request : available;
+    return kernel;
+}
+
+int get_force_kernel(void) {
+    if ( kernel < 0 ) {
+        kernel = detect_force_kernel();
+    }
+    return kernel;
+}
+
+const char* force_kernel_name(const int kind) {
+    switch ( kind ) {
+    case FORCE_KERNEL_SSE2:
+        return "sse2";
+    case FORCE_KERNEL_AVX2:
+        return "avx2";
+    case FORCE_KERNEL_AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+/**
+* @fn x̌vZ̐xw肷.
+* @param request FORCE_PRECISION_DOUBLE:Sdouble FORCE_PRECISION_MIXED:gƂ̌vZ64g̘afloat, Ŝ̘adouble
+* @return ۂɑIꂽx
+*/
+int set_force_precision(const int request) {
+    precision = request == FORCE_PRECISION_MIXED ? FORCE_PRECISION_MIXED : FORCE_PRECISION_DOUBLE;
+    return precision;
+}
+
+int get_force_precision(void) {
+    return precision;
+}
+
+const char* force_precision_name(const int kind) {
+    return kind == FORCE_PRECISION_MIXED ? "mixed" : "double";
+}
+
+/**
+* @fn d͂̓w肷. , FMM̋ߖT, G~[g@̑ǧvZɂ
+* @param kind FORCE_SOFTENING_PLUMMER  FORCE_SOFTENING_SPLINE
+* @param length  eps. 0ȉȂȂ
+* @return ۂɑIꂽj
+*/
+int set_force_softening(const int kind, const double length) {
+    softening.kind = kind == FORCE_SOFTENING_SPLINE ? FORCE_SOFTENING_SPLINE : FORCE_SOFTENING_PLUMMER;
+    softening.eps = length > 0 ? length : 0;
+    softening.eps2 = softening.kind == FORCE_SOFTENING_PLUMMER ? softening.eps * softening.eps : 0;
+    softening.h = softening.kind == FORCE_SOFTENING_SPLINE ? softening.eps * SOFTENING_SPLINE_SCALE : 0;
+    softening.h2 = softening.h * softening.h;
+    return softening.kind;
+}
+
+struct Softening const* get_force_softening(void) {
+    return &softening;
+}
+
+const char* force_softening_name(const int kind) {
+    return kind == FORCE_SOFTENING_SPLINE ? "spline" : "plummer";
+}
+
+/**
+* @fn ꕔ̐̉xvZ. ͈͂̈قȂĂяo͕ɎsĂ悢
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param begin,end xvZ鐯͈̔. begin8̔{, end8̔{sizeł邱
+* @param ax,ay,az vZxޔz
+*              SIMD̕ɍ킹end8̔{ɐ؂グ܂ŏނ̂
+*              STARS_ALIGNMENTPʂŊmۂzn
+*/
+void calc_accelerations_range(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az) {
+    if ( softening.h > 0 ) {
+        accelerations_spline(size, stars, begin, end, ax, ay, az, NULL);
+        return;
+    }
+    if ( precision == FORCE_PRECISION_MIXED ) {
+        switch ( get_force_kernel() ) {
+#ifdef FORCE_X86
+#ifdef FORCE_AVX512
+        case FORCE_KERNEL_AVX512:
+            accelerations_avx512_mixed(size, stars, begin, end, ax, ay, az);
+            return;
+#endif
+        case FORCE_KERNEL_AVX2:
+            accelerations_avx2_mixed(size, stars, begin, end, ax, ay, az);
+            return;
+        case FORCE_KERNEL_SSE2:
+            accelerations_sse2_mixed(size, stars, begin, end, ax, ay, az);
+            return;
+#endif
+        default:
+            accelerations_scalar_mixed(size, stars, begin, end, ax, ay, az);
+            return;
+        }
+    }
+    switch ( get_force_kernel() ) {
+#ifdef FORCE_X86
+#ifdef FORCE_AVX512
+    case FORCE_KERNEL_AVX512:
+        accelerations_avx512(size, stars, begin, end, ax, ay, az);
+        break;
+#endif
+    case FORCE_KERNEL_AVX2:
+        accelerations_avx2(size, stars, begin, end, ax, ay, az);
+        break;
+    case FORCE_KERNEL_SSE2:
+        accelerations_sse2(size, stars, begin, end, ax, ay, az);
+        break;
+#endif
+    default:
+        accelerations_scalar(size, stars, begin, end, ax, ay, az);
+        break;
+    }
+}
+
+
+/**
+* @fn ꕔ̐̉xƃ|eV𓯂ǧvZŋ߂.
+* @param phi |eV G  m_j / r_ij ޔz (̒l. ʒuGlM[ -1/2  m_i phi_i)
+* @detail ̈calc_accelerations_rangeƓ. |eV͉xƓx̓ǧvZŋ߂.
+*         x̂Ƃ̓|eVgƂfloatŋ, FORCE_FLOAT_BLOCKgƂ̘adoubleɑނ̂,
+*         Ό덷͉xƓ1e-7xɂȂ
+*/
+void calc_accelerations_potential_range(const int size, struct Stars const *stars, const int begin, const int end, double *ax, double *ay, double *az, double *phi) {
+    if ( softening.h > 0 ) {
+        accelerations_spline(size, stars, begin, end, ax, ay, az, phi);
+        return;
+    }
+    if ( precision == FORCE_PRECISION_MIXED ) {
+        switch ( get_force_kernel() ) {
+#ifdef FORCE_X86
+#ifdef FORCE_AVX512
+        case FORCE_KERNEL_AVX512:
+            accelerations_avx512_mixed_potential(size, stars, begin, end, ax, ay, az, phi);
+            return;
+#endif
+        case FORCE_KERNEL_AVX2:
+            accelerations_avx2_mixed_potential(size, stars, begin, end, ax, ay, az, phi);
+            return;
+        case FORCE_KERNEL_SSE2:
+            accelerations_sse2_mixed_potential(size, stars, begin, end, ax, ay, az, phi);
+            return;
+#endif
+        default:
+            accelerations_scalar_mixed_potential(size, stars, begin, end, ax, ay, az, phi);
+            return;
+        }
+    }
+    switch ( get_force_kernel() ) {
+#ifdef FORCE_X86
+#ifdef FORCE_AVX512
+    case FORCE_KERNEL_AVX512:
+        accelerations_avx512_potential(size, stars, begin, end, ax, ay, az, phi);
+        break;
+#endif
+    case FORCE_KERNEL_AVX2:
+        accelerations_avx2_potential(size, stars, begin, end, ax, ay, az, phi);
+        break;
+    case FORCE_KERNEL_SSE2:
+        accelerations_sse2_potential(size, stars, begin, end, ax, ay, az, phi);
+        break;
+#endif
+    default:
+        accelerations_scalar_potential(size, stars, begin, end, ax, ay, az, phi);
+        break;
+    }
+}
+/**
+* @fn SĂ̐̉xvZ.
+* @param size SĂ̐̐
+* @param stars ̏W
+* @param ax,ay,az vZxޔz
+*              SIMD̕ɍ킹Ēsize8̔{ɐ؂グނ̂
+*              STARS_ALIGNMENTPʂŊmۂzn
+*/
+void calc_accelerations(const int size, struct Stars const *stars, double *ax, double *ay, double *az) {
+    calc_accelerations_range(size, stars, 0, size, ax, ay, az);
+}
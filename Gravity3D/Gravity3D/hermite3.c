@@ -0,0 +1,9 @@
+/**
+* @brief 4̃G~[g@ƊKwIȌʎԍ
+* 3 {̂2łƋʂ Common/hermite_core.h ɂ
+*/
+#include "hermite3.h"
+#include "force3.h"
+#include "../../Common/pool.h"
+
+#include "../../Common/hermite_core.h"
@@ -0,0 +1,55 @@
+#pragma once
+#include "gravity3.h"
+
+#define HERMITE_MAX_LEVEL 30    // the shortest step is dt / 2^30
+#define HERMITE_ETA 0.02        // accuracy parameter of the step size criterion
+#define HERMITE_ETA_START 0.01  // the same for the first step, which has no higher derivatives yet
+
+/**
+* 4̃G~[g@ƊKwIȌʎԍ݂̏ԂƍƗ̈
+* Ƃ݂̍1Xebv̕dt2ׂ̂Ŋ̂, ̒ilevelɎ.
+* dt / 2^HERMITE_MAX_LEVEL PʂƂ鐮Ő̂, ۂߌ덷Ȃɑ.
+* Փ˂ȂǂŐ̏Wϕ̊OŏƂ, ready0ɂĉxƍ݂ߒ邱
+*/
+struct Hermite {
+    double eta;         // accuracy parameter, smaller for shorter steps
+    long blocks;        // block steps, each moving the stars sharing the earliest next time
+    long evaluations;   // forces evaluated on a single star
+    int ready;          // 1 while ax and jx hold the derivatives at the current state
+    double* ax;         // acceleration of each star at its own time
+    double* ay;
+    double* az;
+    double* jx;         // jerk, the time derivative of the acceleration
+    double* jy;
+    double* jz;
+    double* ax1;        // acceleration just evaluated at the block time, only for the active stars
+    double* ay1;
+    double* az1;
+    double* jx1;        // jerk just evaluated
+    double* jy1;
+    double* jz1;
+    double* px;         // position predicted to the current block time
+    double* py;
+    double* pz;
+    double* pvx;        // velocity predicted to the current block time
+    double* pvy;
+    double* pvz;
+    int* level;         // the step of each star is dt / 2^level
+    int* tick;          // time of each star since the beginning of the step
+    int* active;        // stars moved in the current block step
+    int capacity;       // length of each array
+    void* block;        // memory block holding the double arrays
+    void* indices;      // memory block holding the int arrays
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int allocate_hermite(const int capacity, const double eta, struct Hermite *hermite);
+    void free_hermite(struct Hermite *hermite);
+    void block_hermite(const int size, const double dt, struct Stars *stars, struct Workspace *work, struct Hermite *hermite);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,7 @@
+/**
+* @brief lt@C̍ȓǂݍ
+* 3 {̂2łƋʂ Common/loader_core.h ɂ
+*/
+#include "loader3.h"
+
+#include "../../Common/loader_core.h"
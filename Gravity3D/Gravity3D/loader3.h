@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+
+#include "gravity3.h"
+
+#define STARS_FILE_MAGIC "GRAVSTAR" // first 8 bytes of a binary initial-condition file
+#define STARS_FILE_VERSION 1
+#define STARS_FILE_ORDER 0x01020304u // byte order mark written in the native order
+
+/**
+* oCi`̏lt@C̐擪64oCg
+* m, x, y, z, vx, vy, vz̔z񂪂̏stridevf. ez̖0Ŗ߂
+* `FbN|Cgł͔žɐϕ̏Ԃ (StarsSection) Ƃĕׂ. ԂmȂǂݎ͓ǂݔ΂
+* strideSTARS_ALIGNMENToCg̔{Ȃ̂, t@C蓖ĂΊez񂪂̂܂܋Eɑ
+*/
+struct StarsFileHeader {
+    char magic[8];      // STARS_FILE_MAGIC without the terminator
+    uint32_t version;   // STARS_FILE_VERSION
+    uint32_t order;     // STARS_FILE_ORDER, differs if written on a machine of the other endianness
+    uint32_t dimension; // 3
+    uint32_t precision; // bytes per value, 8 for double or 4 for float
+    int64_t count;      // number of stars
+    int64_t stride;     // values from the beginning of an array to the next one
+    double time;        // simulated time of the state, 0 for initial conditions
+    int64_t step;       // step number of the state
+    double dt;          // time step that produced the state, 0 if unknown
+};
+
+/**
+* t@CɋL^vZ̐i݋. ĊJƂɓǂݒ
+*/
+struct StarsState {
+    long step;
+    double time;
+    double dt;
+};
+
+#define STARS_SECTION_ALIGNMENT 8 // contents of each section are padded to this many bytes
+
+/**
+* `FbN|Cg̔žɑԂ̌o. bytesoCg̒g
+* ǧ`͖OƔłŌ܂. ǂݎ͒mȂOł̋Ԃ𖳎, ̏Ԃŏ蒼
+*/
+struct StarsSection {
+    char name[8];       // name padded with zeros
+    uint32_t version;   // layout of the contents
+    uint32_t reserved;  // 0
+    int64_t bytes;      // length of the contents without the padding
+};
+
+/**
+* `FbN|Cgɐƈꏏɏoϕ̏. oƒgׂt@Ĉ̖
+*/
+struct StarsExtra {
+    char* data;         // sections, each a StarsSection followed by its padded contents
+    size_t size;        // bytes in use
+    size_t capacity;    // bytes allocated
+};
+
+struct ThreadPool;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int load_stars(const char *path, struct Stars *stars, struct ThreadPool *pool, struct StarsState *state);
+    int load_checkpoint(const char *path, struct Stars *stars, struct ThreadPool *pool, struct StarsState *state, struct StarsExtra *extra);
+    int detach_stars(const int size, struct Stars *stars);
+    int save_stars(const char *path, const int size, struct Stars const *stars, struct StarsState const *state);
+    int save_checkpoint(const char *path, const int size, struct Stars const *stars, struct StarsState const *state,
+        struct StarsExtra const *extra);
+    void* add_section(struct StarsExtra *extra, const char *name, const uint32_t version, const size_t bytes);
+    const void* find_section(struct StarsExtra const *extra, const char *name, const uint32_t version, size_t *bytes);
+    void free_extra(struct StarsExtra *extra);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     Simulator *s = new Simulator(__argc, __argv, screenWidth, screenHeight, screenHeight);
     while ( CanLoop() && s->Update() ) {
         //`ʑΏۂȂ܂esc{^܂Ń[v
+        //vZ͕ʂ̃XbhŐiނ̂, ł͎󂯎ŐV̏Ԃ`
     }
     delete s;
     DxLib_End();    // DXCuI
@@ -0,0 +1,7 @@
+/**
+* @brief vZƕ\ʂ̃XbhŐi߂
+* 3 {̂2łƋʂ Common/monitor_core.h ɂ
+*/
+#include "monitor3.h"
+
+#include "../../Common/monitor_core.h"
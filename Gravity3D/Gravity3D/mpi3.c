@@ -0,0 +1,16 @@
+/**
+* @brief ̏W𕡐̃vZXɕČvZMPIł̃ob`s̃Gg|Cg
+* 3 {̂2łƋʂ Common/mpi_core.h ɂ
+*/
+#include "gravity3.h"
+#include "force3.h"
+#include "tree3.h"
+#include "../../Common/pool.h"
+#include "loader3.h"
+#include "stepper3.h"
+#include "diagnostics3.h"
+#include "domain3.h"
+
+#define DOMAIN_NAME "gravity3d"
+
+#include "../../Common/mpi_core.h"
@@ -0,0 +1,7 @@
+/**
+* @brief ߐژA̐
+* 3 {̂2łƋʂ Common/regular_core.h ɂ
+*/
+#include "regular3.h"
+
+#include "../../Common/regular_core.h"
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdio.h>
+#include "gravity3.h"
+#include "loader3.h"
+
+#define BINARY_SECTION "BINARY"     // checkpoint section holding the pairs of the last step
+#define BINARY_SECTION_VERSION 1
+
+/**
+* ĐϕߐژA g. Xebv̊Ԃ͐iɏdS, jɎ0̈u
+*/
+struct Binary {
+    int i;              // row holding the center of mass while the step advances
+    int j;              // row left massless at the center of mass while the step advances
+    double mi;          // masses of the members
+    double mj;
+    double r[3];        // relative position x_i - x_j and velocity at the start of the step
+    double v[3];
+    double t[3][3];     // tidal tensor of the other stars at the center of mass
+};
+
+/**
+* ǍT|ɎgxW
+*/
+struct BinaryKey {
+    double x;
+    int index;
+};
+
+/**
+* ߂, ݂ɑꂽ̑g. ߂ɘAɂ
+*/
+struct BinaryCandidate {
+    int i;
+    int j;
+    double r2;          // squared distance
+    int kept;           // 1 if the pair was regularized in the previous step
+};
+
+/**
+* ߐژȀW. gƂ̑Ή^Kustaanheimo-StiefelϊWŐϕ
+*/
+struct Binaries {
+    double radius;      // pairs closer than this are regularized, <= 0 never
+    int count;          // pairs in the current step
+    int capacity;       // length of partner and keys
+    struct Binary *pairs; // capacity / 2 + 1 pairs
+    int *partner;       // the other member of the pair of each star, -1 if none
+    struct BinaryKey *keys; // stars sorted along x for the sweep
+    struct BinaryCandidate *candidates; // close bound pairs found by the sweep
+    int candidate_capacity;
+    long formed;        // pairs formed and dissolved so far
+    long dissolved;
+    long substeps;      // Kepler drifts between the tidal kicks so far
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int allocate_binaries(const int capacity, const double radius, struct Binaries *bin);
+    void free_binaries(struct Binaries *bin);
+    void forget_binaries(struct Binaries *bin);
+    int select_binaries(const int size, struct Stars const *stars, struct Binaries *bin);
+    void prepare_binaries(struct Stars *stars, struct Workspace const *work, struct Binaries *bin);
+    void propagate_binaries(const double h, struct Stars *stars, struct Binaries *bin);
+    int save_binaries(struct Binaries const *bin, struct StarsExtra *extra);
+    int restore_binaries(const int size, struct StarsExtra const *extra, struct Binaries *bin);
+    void write_binaries(FILE *out, const long step, const double time, struct Binaries const *bin);
+
+#ifdef __cplusplus
+}
+#endif
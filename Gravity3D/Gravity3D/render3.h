@@ -0,0 +1,36 @@
+#pragma once
+#include "gravity3.h"
+
+// image formats of the frame files
+#define RENDER_PPM 0        // binary portable pixmap (P6)
+#define RENDER_PNG 1        // PNG, uncompressed
+
+/**
+* ʂg킸ɕ`摜̐ݒ. eSimulator̕\Ɠ
+* 3 Ƃēe, sׂĎŐAetŕ`
+*/
+struct RenderOptions {
+    int width, height;  // size of the image in pixels, the window size of the GUI is 600x600
+    double unit;        // pixels per unit length, as --unit of the GUI
+    int format;         // RENDER_* of the frame files
+    const char* prefix; // prefix of the frame files, NULL when piped
+    const char* pipe;   // command to write a stream of PPM frames to, NULL to write files
+    int threads;        // threads to draw a frame with
+};
+
+/**
+* vZƕsĉ摜`ďo`. grender3.c̒ň
+*/
+struct FrameRenderer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    struct FrameRenderer* create_renderer(struct RenderOptions const *options, const int capacity);
+    int render_frame(struct FrameRenderer *renderer, const long step, const int size, struct Stars const *stars);
+    int destroy_renderer(struct FrameRenderer *renderer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,7 @@
+/**
+* @brief vZƕsďԂt@C֏o
+* 3 {̂2łƋʂ Common/snapshot_core.h ɂ
+*/
+#include "snapshot3.h"
+
+#include "../../Common/snapshot_core.h"
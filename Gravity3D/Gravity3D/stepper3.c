@@ -0,0 +1,7 @@
+/**
+* @brief ϕ@𖼑OőI, ĂяoŐi߂
+* 3 {̂2łƋʂ Common/stepper_core.h ɂ
+*/
+#include "stepper3.h"
+
+#include "../../Common/stepper_core.h"
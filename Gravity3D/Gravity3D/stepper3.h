@@ -0,0 +1,57 @@
+#pragma once
+#include <stdio.h>
+#include "gravity3.h"
+#include "dopri3.h"
+#include "hermite3.h"
+#include "loader3.h"
+
+// integration methods selectable with --method
+#define METHOD_RK4 0        // Runge-Kutta with a fixed step
+#define METHOD_DOPRI 1      // Dormand-Prince with step size control
+#define METHOD_HERMITE 2    // Hermite with individual block steps
+#define METHOD_EULER 3      // explicit Euler
+#define METHOD_LEAPFROG 4   // kick-drift-kick leapfrog
+#define METHOD_YOSHIDA4 5   // Yoshida's 4th order composition of leapfrog
+#define METHOD_YOSHIDA6 6   // Yoshida's 6th order composition of leapfrog
+#define METHOD_COUNT 7
+
+#define STEPPER_SECTION "STEPPER"   // checkpoint section holding the values carried over to the next step
+#define STEPPER_SECTION_VERSION 1
+
+/**
+* ϕ@̋ʂ̑. @Ƃ̏ԂƍƗ̈܂Ƃ߂Ď, Ăяo1Xebvi߂
+* Փ˂̔stepper_collisionʂ, ̏WςƂɕ@Ƃ̏Ԃ̂Ă
+*/
+struct Stepper {
+    int method;         // METHOD_*
+    double dt;          // time step, the first step to try for Dormand-Prince
+    int ready;          // 1 while work->ax holds the acceleration at the current state, for leapfrog and Yoshida
+    long evaluations;   // force evaluations, Dormand-Prince and Hermite count their own
+    struct MergeLog* merges; // stepper_collision records the merges here unless NULL
+    int const* partner; // stepper_collision never merges star i with partner[i] unless NULL
+    struct Sweep sweep; // buffers of the collision sweep, reused every step
+    struct Dopri dopri;
+    struct Hermite hermite;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int find_method(const char *name);
+    const char* method_name(const int method);
+    int allocate_stepper(const int capacity, const int method, const double dt, const double rtol, const double atol, const double eta,
+        struct Stepper *stepper);
+    void free_stepper(struct Stepper *stepper);
+    int stepper_collision(const int size, struct Stars *stars, struct Stepper *stepper);
+    void stepper_discard(struct Stepper *stepper);
+    int save_stepper(const int size, struct Stepper const *stepper, struct Workspace const *work, struct StarsExtra *extra);
+    int restore_stepper(const int size, struct StarsExtra const *extra, struct Stepper *stepper, struct Workspace *work);
+    int stepper_potential(const int size, struct Stars *stars, struct Workspace *work, struct Stepper *stepper);
+    double advance(const int size, const double limit, struct Stars *stars, struct Workspace *work, struct Stepper *stepper);
+    double next_dt(struct Stepper const *stepper);
+    void report_stepper(FILE *out, const int size, const long steps, struct Stepper const *stepper);
+
+#ifdef __cplusplus
+}
+#endif
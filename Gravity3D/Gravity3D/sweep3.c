@@ -0,0 +1,13 @@
+/**
+* @brief ̏Ȍn܂Ƃ߂ČvZp[^XC[ṽGg|Cg
+* 3 {̂2łƋʂ Common/sweep_core.h ɂ
+*/
+#include "gravity3.h"
+#include "force3.h"
+#include "../../Common/pool.h"
+#include "loader3.h"
+#include "ensemble3.h"
+
+#define SWEEP_NAME "gravity3d"
+
+#include "../../Common/sweep_core.h"
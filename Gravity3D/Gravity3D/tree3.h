@@ -0,0 +1,61 @@
+#pragma once
+#include "gravity3.h"
+
+// order of the multipole expansion of a cell
+#define TREE_MONOPOLE 0
+#define TREE_QUADRUPOLE 2
+
+#define TREE_LEAF_SIZE 8    // default max number of stars in a leaf cell
+
+/**
+* ؂̃Z
+*/
+struct TreeNode {
+    double cx, cy, cz;  // center of the cell
+    double half;        // half of the width of the cell
+    double m;           // total mass
+    double x, y, z;     // center of mass
+    double qxx, qxy, qxz, qyy, qyz, qzz;// quadrupole moment about the center of mass
+    double limit2;      // squared distance beyond which the cell is treated as a multipole
+    int child;          // index of the first of 8 children, -1 for a leaf
+    int first, count;   // range of the stars in the cell (in tree order)
+};
+
+/**
+* Barnes-Hut@̔. ̈ʒuƎʂ؂̏ɕבւzŕێ
+* z͐̐̏ňxmۂ, XebvƂɖ؂蒼
+*/
+struct Tree {
+    double theta;       // opening angle
+    int order;          // TREE_MONOPOLE or TREE_QUADRUPOLE
+    int leaf_size;      // cells with more stars than this are divided
+    struct TreeNode* nodes;
+    int node_count;
+    int node_capacity;
+    int* index;         // index of the star in struct Stars (in tree order)
+    double* px;         // position and mass (in tree order)
+    double* py;
+    double* pz;
+    double* pm;
+    int* temp_index;    // buffers for sorting
+    double* temp_x;
+    double* temp_y;
+    double* temp_z;
+    double* temp_m;
+    int capacity;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    int allocate_tree(const int capacity, const double theta, const int order, struct Tree *tree);
+    void free_tree(struct Tree *tree);
+    int build_tree(struct Tree *tree, const int size, struct Stars const *stars);
+    void tree_accelerations_range(struct Tree const *tree, const int begin, const int end, double *ax, double *ay, double *az, double *phi);
+    void tree_accelerations_local(struct Tree const *tree, const int local, const int begin, const int end, double *ax, double *ay, double *az, double *phi);
+    void tree_accelerations(struct Tree *tree, const int size, struct Stars const *stars, double *ax, double *ay, double *az);
+
+#ifdef __cplusplus
+}
+#endif